@@ -0,0 +1,152 @@
+/*
+ * schedr_calendar_bench.c
+ *
+ * Finds the next time random calendars fire at, with the bit scans of
+ * schedr_calendar_next(), and compares it to stepping through the local time
+ * minute by minute until the calendar matches. The calendars go from every
+ * hour to a few days a year, the sparse ones are what a search minute by
+ * minute is slow at. Stepping minute by minute is only timed on a sample of
+ * them, it takes too long to do for all. The two only disagree on calendars
+ * that fire in an hour the clocks skip, which schedr_calendar_next() fires at
+ * the instant the clocks are put forward.
+ *
+ * Usage: schedr_calendar_bench [number of calendars]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi(), rand(), srand()
+#include <stdio.h>          // printf()
+#include <stdint.h>         // int64_t, uint64_t, uint32_t
+#include <stdbool.h>        // bool
+#include <time.h>           // clock_gettime(), time_t, struct tm, localtime_r()
+
+#include "schedr_calendar.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_CALENDARS 1000000
+#define MAX_SAMPLE 1000
+#define MAX_SEARCH_MINUTES (60 * 24 * 366 * 8)
+#define NANOSECS_PER_SEC 1000000000LL
+#define SECS_PER_MINUTE 60
+#define START_TIME 1792281600 // 2026-10-18 00:00 UTC
+
+/*
+ * Returns random bits, each set with a probability of one in 'one_in'.
+ */
+static uint64_t random_bits(int bits, int first, int one_in)
+{
+    uint64_t set = 0;
+
+    for (int i = first; i < first + bits; i++) { set |= (rand() % one_in == 0) ? 1ULL << i : 0; }
+
+    return (set != 0) ? set : 1ULL << (first + rand() % bits);
+}
+
+/*
+ * Sets up a random calendar: a few times a day on some days of some months,
+ * the days as days of the month, weekdays or both.
+ */
+static void random_calendar(Calendar *calendar)
+{
+    do
+    {
+        schedr_calendar_init(calendar);
+        calendar->minutes = random_bits(60, 0, 30);
+        calendar->hours = (rand() % 8 == 0) ? SCHEDR_CALENDAR_ALL_HOURS : (uint32_t)random_bits(24, 0, 12);
+        calendar->days = (rand() % 2 == 0) ? SCHEDR_CALENDAR_ALL_DAYS : (uint32_t)random_bits(31, 1, 15);
+        calendar->months = (rand() % 2 == 0) ? SCHEDR_CALENDAR_ALL_MONTHS : (uint16_t)random_bits(12, 1, 6);
+        calendar->weekdays = (rand() % 2 == 0) ? SCHEDR_CALENDAR_ALL_WEEKDAYS : (uint8_t)random_bits(7, 0, 3);
+    }
+    while (schedr_calendar_compile(calendar) != SCHEDR_SUCCESS);
+}
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+/*
+ * Finds the next time 'calendar' fires at by checking every minute after
+ * 'after', the way it is done without the bitsets.
+ */
+static time_t next_minute_by_minute(const Calendar *calendar, time_t after)
+{
+    struct tm local;
+    time_t minute = after - after % SECS_PER_MINUTE + SECS_PER_MINUTE;
+
+    for (int i = 0; i < MAX_SEARCH_MINUTES; i++, minute += SECS_PER_MINUTE)
+    {
+        localtime_r(&minute, &local);
+
+        if (((calendar->minutes >> local.tm_min) & 1) && ((calendar->hours >> local.tm_hour) & 1) &&
+            ((calendar->days >> local.tm_mday) & 1) && ((calendar->months >> (local.tm_mon + 1)) & 1) &&
+            ((calendar->weekdays >> local.tm_wday) & 1))
+        {
+            return minute;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int calendars_len = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_CALENDARS;
+
+    if (calendars_len <= 0) { return EXIT_FAILURE; }
+
+    Calendar *calendars = malloc(sizeof (*calendars) * (size_t)calendars_len);
+
+    if (calendars == NULL) { return EXIT_FAILURE; }
+
+    srand(1);
+
+    for (int i = 0; i < calendars_len; i++) { random_calendar(&(calendars[i])); }
+
+    int sample_len = (calendars_len < MAX_SAMPLE) ? calendars_len : MAX_SAMPLE;
+    int failed = 0;
+    int disagreed = 0;
+    time_t next;
+    time_t latest = 0;
+    int64_t started_ns = now_ns();
+
+    for (int i = 0; i < calendars_len; i++)
+    {
+        if (schedr_calendar_next(&(calendars[i]), START_TIME + i % 86400, &next) != SCHEDR_SUCCESS) { failed++; }
+        else if (next > latest) { latest = next; }
+    }
+
+    int64_t bitset_ns = now_ns() - started_ns;
+
+    started_ns = now_ns();
+
+    for (int i = 0; i < sample_len; i++)
+    {
+        time_t expected = next_minute_by_minute(&(calendars[i]), START_TIME + i % 86400);
+
+        if (expected != 0 && (schedr_calendar_next(&(calendars[i]), START_TIME + i % 86400, &next) != SCHEDR_SUCCESS ||
+                              next != expected))
+        {
+            disagreed++;
+        }
+    }
+
+    int64_t minute_ns = now_ns() - started_ns;
+
+    printf("Finding the next time %d random calendars fire at, in %s\n", calendars_len, (getenv("TZ") != NULL) ? getenv("TZ") : "local time");
+    printf("%16s %12s %14s %12s\n", "search", "calendars", "next/s", "ns/next");
+    printf("%16s %12d %14.0f %12.1f\n", "bitsets", calendars_len, (double)calendars_len * NANOSECS_PER_SEC / (double)bitset_ns,
+           (double)bitset_ns / (double)calendars_len);
+    printf("%16s %12d %14.0f %12.1f\n", "minute by minute", sample_len, (double)sample_len * NANOSECS_PER_SEC / (double)minute_ns,
+           (double)minute_ns / (double)sample_len);
+    printf("The bitsets are %.0fx faster, the latest time found is %.1f days away\n",
+           ((double)minute_ns / sample_len) / ((double)bitset_ns / calendars_len), (double)(latest - START_TIME) / 86400.0);
+
+    if (failed > 0) { printf("%d calendars failed\n", failed); }
+    if (disagreed > 0) { printf("%d of the sample disagreed with the search minute by minute\n", disagreed); }
+
+    free(calendars);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+ * schedr_log_bench.c
+ *
+ * Measures how fast the output of a thousand chatty jobs is written to the
+ * log, and how the jobs are held back when the writer can not keep up. Every
+ * job writes a thousand lines per run, and runs again as soon as it has
+ * finished. The event loop runs the jobs like the daemon does, with a large
+ * buffer, the smallest buffer allowed and with the file rotated every MB.
+ *
+ * Usage: schedr_log_bench [jobs] [seconds] [log directory]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi()
+#include <stdio.h>          // printf(), snprintf()
+#include <string.h>         // strlen()
+#include <stdint.h>         // int64_t
+#include <unistd.h>         // fork(), unlink()
+#include <time.h>           // clock_gettime(), timer_create()
+#include <signal.h>         // struct sigevent, SIGTERM
+#include <sys/wait.h>       // waitpid()
+#include <sys/resource.h>   // setrlimit()
+
+#include "schedr_scheduler.h"
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+#include "schedr_log.h"
+#include "schedr_job.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_JOBS 1000
+#define DEFAULT_SECONDS 5
+#define DEFAULT_LOG_DIR "/tmp"
+#define NANOSECS_PER_SEC 1000000000LL
+#define BYTES_PER_MB (1024.0 * 1024.0)
+#define CHATTY_COMMAND "yes 'a chatty job writing a line of a typical length to its output' | head -n 1000"
+
+struct BenchConfig
+{
+    const char *name;
+    size_t buffer_len;
+    size_t max_file_len;
+};
+
+typedef struct BenchConfig BenchConfig;
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+static void remove_logs(const char *log_path)
+{
+    char rotated_path[4096];
+
+    unlink(log_path);
+
+    for (int i = 1; i <= SCHEDR_LOG_DEFAULT_KEEP; i++)
+    {
+        if (snprintf(rotated_path, sizeof (rotated_path), "%s.%d", log_path, i) < (int)sizeof (rotated_path)) { unlink(rotated_path); }
+    }
+}
+
+/*
+ * Runs the jobs for 'seconds' in a process of its own, so every configuration
+ * starts with a fresh scheduler, and prints what was written.
+ */
+static void run_config(const BenchConfig *const config, int jobs_len, int seconds, const char *log_path)
+{
+    // Otherwise the child prints what is buffered again
+    fflush(stdout);
+
+    if (fork() != 0)
+    {
+        wait(NULL);
+        return;
+    }
+
+    Job *jobs = (Job *)malloc(sizeof (Job) * (size_t)jobs_len);
+    LogRotation rotation = { .max_file_len = config->max_file_len, .max_age_ns = 0, .keep = SCHEDR_LOG_DEFAULT_KEEP };
+    LogStats stats;
+
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    schedr_scheduler_set_mode(EventLoop);
+    remove_logs(log_path);
+
+    if (schedr_log_open(log_path, &rotation, config->buffer_len) != SCHEDR_SUCCESS) { exit(EXIT_FAILURE); }
+
+    for (int i = 0; i < jobs_len; i++)
+    {
+        char name[32];
+        int name_len = snprintf(name, sizeof (name), "chatty-%d", i);
+
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_name(&(jobs[i]), name, (size_t)name_len);
+        schedr_job_set_command(&(jobs[i]), CHATTY_COMMAND, strlen(CHATTY_COMMAND));
+        schedr_job_set_interval(&(jobs[i]), 1);
+        schedr_scheduler_start_job(&(jobs[i]));
+    }
+
+    // The loop runs until the timer sends the termination signal the daemon stops on
+    struct sigevent stop_event = { .sigev_notify = SIGEV_SIGNAL, .sigev_signo = SIGTERM };
+    struct itimerspec stop_at = { .it_interval = { 0, 0 }, .it_value = { seconds, 0 } };
+    timer_t stop_timer;
+    int64_t start = now_ns();
+
+    timer_create(CLOCK_MONOTONIC, &stop_event, &stop_timer);
+    timer_settime(stop_timer, 0, &stop_at, NULL);
+    schedr_scheduler_run();
+
+    schedr_log_get_stats(&stats);
+
+    double elapsed_secs = (double)(now_ns() - start) / NANOSECS_PER_SEC;
+    double avg_batch_kb = (stats.batches > 0) ? (double)stats.bytes_written / stats.batches / 1024.0 : 0;
+
+    printf("%-22s %12.1f %10llu %16.1f %10llu %10llu\n", config->name, (double)stats.bytes_written / BYTES_PER_MB / elapsed_secs,
+           (unsigned long long)stats.batches, avg_batch_kb, (unsigned long long)stats.stalls, (unsigned long long)stats.rotations);
+
+    for (int i = 0; i < jobs_len; i++) { schedr_scheduler_stop_job(&(jobs[i])); }
+
+    schedr_log_close();
+    schedr_zygote_stop();
+    remove_logs(log_path);
+    free(jobs);
+
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[])
+{
+    int jobs_len = (argc > 1) ? atoi(argv[1]) : DEFAULT_JOBS;
+    int seconds = (argc > 2) ? atoi(argv[2]) : DEFAULT_SECONDS;
+    const char *log_dir = (argc > 3) ? argv[3] : DEFAULT_LOG_DIR;
+    char log_path[4096];
+    struct rlimit fd_limit;
+
+    // Every running command has two pipes
+    getrlimit(RLIMIT_NOFILE, &fd_limit);
+    fd_limit.rlim_cur = fd_limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &fd_limit);
+
+    snprintf(log_path, sizeof (log_path), "%s/schedr_log_bench.log", log_dir);
+
+    BenchConfig configs[] = {
+        { "1 MB buffer",        SCHEDR_LOG_DEFAULT_BUFFER_LEN,  0 },
+        { "16 KB buffer",       SCHEDR_LOG_MIN_BUFFER_LEN,      0 },
+        { "rotate every 1 MB",  SCHEDR_LOG_DEFAULT_BUFFER_LEN,  1024 * 1024 },
+    };
+
+    printf("%d jobs for %d s, logging to %s\n", jobs_len, seconds, log_path);
+    printf("%-22s %12s %10s %16s %10s %10s\n", "config", "MB/s", "batches", "avg batch KB", "stalls", "rotations");
+
+    for (size_t i = 0; i < sizeof (configs) / sizeof (configs[0]); i++) { run_config(&(configs[i]), jobs_len, seconds, log_path); }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*
+ * schedr_loop_bench.c
+ *
+ * Counts the system calls the event loop makes per executed job, with the
+ * epoll and the io_uring backend. Every job runs a command that writes a line
+ * every 10 ms, through the zygote, so every run is timed, reaped and has its
+ * output read by the loop. The loop runs in a process of its own, which the
+ * bench traces with ptrace from the moment the jobs are started until it
+ * exits. The zygote and the commands are not traced.
+ *
+ * Usage: schedr_loop_bench [jobs] [seconds]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi()
+#include <stdio.h>          // printf(), open_memstream()
+#include <string.h>         // strlen()
+#include <stdint.h>         // uint64_t
+#include <unistd.h>         // fork(), pipe(), read(), write()
+#include <time.h>           // timer_create()
+#include <signal.h>         // struct sigevent, SIGTERM
+#include <sys/mman.h>       // mmap()
+#include <sys/wait.h>       // waitpid()
+#include <sys/ptrace.h>     // ptrace()
+
+#include "schedr_scheduler.h"
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+#include "schedr_output.h"
+#include "schedr_job.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_JOBS 100
+#define DEFAULT_SECONDS 5
+#define JOB_INTERVAL_NS 10000000LL
+#define OUTPUT_LEN (64 * 1024)
+#define COMMAND "echo x"
+
+/*
+ * Counts the lines every job has written, one per run.
+ */
+static uint64_t count_runs(const Job *jobs, int jobs_len)
+{
+    uint64_t runs = 0;
+
+    for (int i = 0; i < jobs_len; i++)
+    {
+        const OutputRing *ring = schedr_scheduler_get_output(&(jobs[i]));
+        char *written = NULL;
+        size_t written_len = 0;
+        FILE *fp = open_memstream(&written, &written_len);
+
+        if (ring != NULL) { schedr_output_write(ring, fp); }
+
+        fclose(fp);
+
+        for (size_t j = 0; j < written_len; j++) { runs += (written[j] == '\n') ? 1 : 0; }
+
+        free(written);
+    }
+
+    return runs;
+}
+
+/*
+ * Runs the jobs with 'backend' for 'seconds', once 'go' is readable, and
+ * stores how many runs were executed in 'runs'.
+ */
+static void run_loop(LoopBackend backend, int jobs_len, int seconds, int ready, int go, uint64_t *runs)
+{
+    Job *jobs = (Job *)malloc(sizeof (Job) * (size_t)jobs_len);
+    char byte = 0;
+
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_set_output_len(OUTPUT_LEN);
+
+    if (schedr_scheduler_set_loop_backend(backend) != SCHEDR_SUCCESS) { exit(EXIT_FAILURE); }
+
+    for (int i = 0; i < jobs_len; i++)
+    {
+        char name[32];
+        int name_len = snprintf(name, sizeof (name), "job-%d", i);
+
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_name(&(jobs[i]), name, (size_t)name_len);
+        schedr_job_set_command(&(jobs[i]), COMMAND, strlen(COMMAND));
+        schedr_job_set_interval(&(jobs[i]), JOB_INTERVAL_NS);
+        schedr_scheduler_start_job(&(jobs[i]));
+    }
+
+    // The tracer attaches now
+    write(ready, &byte, 1);
+    read(go, &byte, 1);
+
+    // The loop runs until the timer sends the termination signal the daemon stops on
+    struct sigevent stop_event = { .sigev_notify = SIGEV_SIGNAL, .sigev_signo = SIGTERM };
+    struct itimerspec stop_at = { .it_interval = { 0, 0 }, .it_value = { seconds, 0 } };
+    timer_t stop_timer;
+
+    timer_create(CLOCK_MONOTONIC, &stop_event, &stop_timer);
+    timer_settime(stop_timer, 0, &stop_at, NULL);
+    schedr_scheduler_run();
+
+    *runs = count_runs(jobs, jobs_len);
+
+    for (int i = 0; i < jobs_len; i++) { schedr_scheduler_stop_job(&(jobs[i])); }
+
+    schedr_zygote_stop();
+    free(jobs);
+
+    exit(EXIT_SUCCESS);
+}
+
+/*
+ * Counts the system calls 'pid' enters until it exits. Signals it receives
+ * are passed on.
+ */
+static uint64_t count_syscalls(pid_t pid, int go)
+{
+    uint64_t syscalls = 0;
+    int status;
+    char byte = 0;
+
+    ptrace(PTRACE_SEIZE, pid, NULL, (void *)PTRACE_O_TRACESYSGOOD);
+    ptrace(PTRACE_INTERRUPT, pid, NULL, NULL);
+    write(go, &byte, 1);
+
+    while (waitpid(pid, &status, 0) == pid && WIFSTOPPED(status))
+    {
+        int signal = WSTOPSIG(status);
+
+        if (signal == (SIGTRAP | 0x80))
+        {
+            struct __ptrace_syscall_info info;
+
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, pid, (void *)sizeof (info), &info) > 0 && info.op == PTRACE_SYSCALL_INFO_ENTRY)
+            {
+                syscalls++;
+            }
+
+            signal = 0;
+        }
+        else if ((status >> 16) == PTRACE_EVENT_STOP) { signal = 0; }
+
+        ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(intptr_t)signal);
+    }
+
+    return syscalls;
+}
+
+static void bench_backend(const char *name, LoopBackend backend, int jobs_len, int seconds)
+{
+    uint64_t *runs = (uint64_t *)mmap(NULL, sizeof (uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    int ready[2], go[2];
+    char byte;
+
+    *runs = 0;
+    pipe(ready);
+    pipe(go);
+
+    // Otherwise the child prints what is buffered again
+    fflush(stdout);
+
+    pid_t pid = fork();
+
+    if (pid == 0) { run_loop(backend, jobs_len, seconds, ready[1], go[0], runs); }
+
+    uint64_t syscalls = 0;
+
+    // The child exits right away if the backend is not supported
+    if (read(ready[0], &byte, 1) == 1) { syscalls = count_syscalls(pid, go[1]); }
+    else { waitpid(pid, NULL, 0); }
+
+    if (*runs == 0) { printf("%-10s %12s\n", name, "not supported"); }
+    else
+    {
+        printf("%-10s %12llu %12llu %16.2f\n", name, (unsigned long long)*runs, (unsigned long long)syscalls,
+               (double)syscalls / (double)*runs);
+    }
+
+    close(ready[0]);
+    close(ready[1]);
+    close(go[0]);
+    close(go[1]);
+    munmap(runs, sizeof (uint64_t));
+}
+
+int main(int argc, char *argv[])
+{
+    int jobs_len = (argc > 1) ? atoi(argv[1]) : DEFAULT_JOBS;
+    int seconds = (argc > 2) ? atoi(argv[2]) : DEFAULT_SECONDS;
+
+    printf("%d jobs every 10 ms for %d s\n", jobs_len, seconds);
+    printf("%-10s %12s %12s %16s\n", "backend", "runs", "syscalls", "syscalls per run");
+
+    bench_backend("epoll", LoopEpoll, jobs_len, seconds);
+    bench_backend("io_uring", LoopUring, jobs_len, seconds);
+
+    return EXIT_SUCCESS;
+}
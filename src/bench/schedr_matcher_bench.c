@@ -0,0 +1,131 @@
+/*
+ * schedr_matcher_bench.c
+ *
+ * Compares matching the lines of a monitor against the patterns of many jobs
+ * with the matcher, which scans every line once, to running the regular
+ * expression of every job on every line. The lines look like the output of
+ * ``journalctl -f``, and every job watches one unit for failures, so few
+ * lines match and most patterns are ruled out by their literal.
+ *
+ * Usage: schedr_matcher_bench [number of lines]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi(), rand(), srand()
+#include <stdio.h>          // printf(), snprintf()
+#include <stdint.h>         // int64_t
+#include <string.h>         // strlen()
+#include <regex.h>          // regcomp(), regexec(), regfree()
+#include <time.h>           // clock_gettime()
+
+#include "schedr_matcher.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_LINES 10000
+#define MAX_PATTERNS 1000
+#define LINE_LEN 160
+#define UNITS 2000
+#define NANOSECS_PER_SEC 1000000000LL
+
+static long matches;
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+static void count_match(void *data) { matches++; }
+
+/*
+ * Writes a journal line of a random unit, a tenth of them about a failure.
+ */
+static void write_line(char *line, int i)
+{
+    static const char *MESSAGES[] = { "Started", "Stopped", "Reloading", "Consumed 1.2s CPU time", "Deactivated successfully" };
+
+    int unit = rand() % UNITS;
+
+    if (rand() % 10 == 0)
+    {
+        snprintf(line, LINE_LEN, "Oct 18 12:%02d:%02d host systemd[1]: unit-%d.service: Failed with result 'exit-code'.", i / 60 % 60,
+                 i % 60, unit);
+    }
+    else
+    {
+        snprintf(line, LINE_LEN, "Oct 18 12:%02d:%02d host systemd[1]: unit-%d.service: %s", i / 60 % 60, i % 60, unit,
+                 MESSAGES[rand() % 5]);
+    }
+}
+
+/*
+ * Matches 'lines' against 'patterns_len' patterns both ways and prints the
+ * lines per second of each.
+ */
+static void bench(char (*lines)[LINE_LEN], int lines_len, int patterns_len)
+{
+    static regex_t regexes[MAX_PATTERNS];
+
+    Matcher matcher;
+    char pattern[64];
+
+    schedr_matcher_init(&matcher);
+
+    for (int i = 0; i < patterns_len; i++)
+    {
+        snprintf(pattern, sizeof (pattern), "unit-%d\\.service: Failed with result", i);
+        regcomp(&(regexes[i]), pattern, REG_EXTENDED | REG_NOSUB);
+        schedr_matcher_add(&matcher, pattern, NULL);
+    }
+
+    long naive_matches = 0;
+    int64_t started_ns = now_ns();
+
+    for (int i = 0; i < lines_len; i++)
+    {
+        for (int j = 0; j < patterns_len; j++) { naive_matches += (regexec(&(regexes[j]), lines[i], 0, NULL, 0) == 0) ? 1 : 0; }
+    }
+
+    int64_t naive_ns = now_ns() - started_ns;
+
+    matches = 0;
+    started_ns = now_ns();
+
+    for (int i = 0; i < lines_len; i++) { schedr_matcher_match(&matcher, lines[i], strlen(lines[i]), count_match); }
+
+    int64_t matcher_ns = now_ns() - started_ns;
+
+    printf("%8d %16.0f %16.0f %10.1fx %10ld\n", patterns_len, (double)lines_len * NANOSECS_PER_SEC / (double)naive_ns,
+           (double)lines_len * NANOSECS_PER_SEC / (double)matcher_ns, (double)naive_ns / (double)matcher_ns, matches);
+
+    if (matches != naive_matches) { printf("The matcher found %ld matches, regexec %ld\n", matches, naive_matches); }
+
+    for (int i = 0; i < patterns_len; i++) { regfree(&(regexes[i])); }
+
+    schedr_matcher_destroy(&matcher);
+}
+
+int main(int argc, char *argv[])
+{
+    int lines_len = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_LINES;
+    int patterns_lens[] = { 1, 10, 100, 1000 };
+
+    if (lines_len <= 0) { return EXIT_FAILURE; }
+
+    char (*lines)[LINE_LEN] = malloc(sizeof (*lines) * (size_t)lines_len);
+
+    if (lines == NULL) { return EXIT_FAILURE; }
+
+    srand(1);
+
+    for (int i = 0; i < lines_len; i++) { write_line(lines[i], i); }
+
+    printf("Matching %d journal lines\n", lines_len);
+    printf("%8s %16s %16s %11s %10s\n", "patterns", "regexec lines/s", "matcher lines/s", "speedup", "matches");
+
+    for (int i = 0; i < 4; i++) { bench(lines, lines_len, patterns_lens[i]); }
+
+    free(lines);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/*
+ * schedr_monitor_bench.c
+ *
+ * Measures how long it takes from a monitor writing a matching line until the
+ * command of the triggered job has started, with the line written on its own
+ * and written after a burst of lines that do not match. The loop runs in a
+ * daemon process of its own. The monitor is ``cat`` reading a FIFO the bench
+ * writes to, and the job sends SIGUSR1 back to the bench with /bin/kill,
+ * without a shell, so the times include starting the command.
+ *
+ * Usage: schedr_monitor_bench [number of triggers]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi(), qsort(), setenv()
+#include <stdio.h>          // printf(), snprintf(), fflush()
+#include <stdint.h>         // int64_t
+#include <string.h>         // strlen()
+#include <unistd.h>         // fork(), getpid(), unlink(), write(), close()
+#include <fcntl.h>          // open()
+#include <signal.h>         // sigwaitinfo(), kill(), SIGUSR1, SIGTERM
+#include <sys/stat.h>       // mkfifo()
+#include <sys/wait.h>       // waitpid()
+#include <time.h>           // clock_gettime()
+
+#include "schedr_job.h"
+#include "schedr_scheduler.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_TRIGGERS 1000
+#define NOISE_LINES 200
+#define NANOSECS_PER_SEC 1000000000LL
+#define NANOSECS_PER_MICROSEC 1000.0
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+    int64_t lhs = *(const int64_t *)a;
+    int64_t rhs = *(const int64_t *)b;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static void write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(fd, buf, len);
+
+        if (written <= 0) { return; }
+
+        buf += written;
+        len -= (size_t)written;
+    }
+}
+
+/*
+ * Runs a job that signals the bench whenever 'cat fifo_path' writes a
+ * matching line, until the daemon is sent SIGTERM.
+ */
+static void run_daemon(const char *fifo_path, pid_t bench_pid)
+{
+    char monitor[96];
+    char command[64];
+    Job job;
+
+    snprintf(monitor, sizeof (monitor), "exec cat %s", fifo_path);
+    snprintf(command, sizeof (command), "/bin/kill -USR1 %d", (int)bench_pid);
+
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Triggered", strlen("Triggered"));
+    schedr_job_set_command(&job, command, strlen(command));
+    schedr_job_compile_command(&job);
+    schedr_job_set_overlap(&job, OverlapQueue, 1);
+    schedr_job_set_trigger(&job, monitor, strlen(monitor), "^wlan0: connected$", strlen("^wlan0: connected$"));
+    schedr_scheduler_set_mode(EventLoop);
+
+    if (schedr_scheduler_start_job(&job) != SCHEDR_SUCCESS) { exit(EXIT_FAILURE); }
+
+    schedr_scheduler_run();
+    schedr_scheduler_stop_job(&job);
+
+    exit(EXIT_SUCCESS);
+}
+
+/*
+ * Writes 'noise' lines that do not match and then one that does to 'fd', and
+ * waits for the job to signal. Returns the time it took in ns.
+ */
+static int64_t trigger(int fd, int noise, const sigset_t *usr1)
+{
+    static const char NOISE[] = "wlan0: connecting (getting IP configuration)\n";
+    static const char HIT[] = "wlan0: connected\n";
+
+    for (int i = 0; i < noise; i++) { write_all(fd, NOISE, sizeof (NOISE) - 1); }
+
+    int64_t started_ns = now_ns();
+
+    write_all(fd, HIT, sizeof (HIT) - 1);
+    sigwaitinfo(usr1, NULL);
+
+    return now_ns() - started_ns;
+}
+
+static void print_latencies(const char *label, int64_t *latencies, int len)
+{
+    qsort(latencies, (size_t)len, sizeof (int64_t), compare_ns);
+
+    printf("%-24s %10.1f %10.1f %10.1f\n", label, (double)latencies[len / 2] / NANOSECS_PER_MICROSEC,
+           (double)latencies[len * 99 / 100] / NANOSECS_PER_MICROSEC, (double)latencies[len - 1] / NANOSECS_PER_MICROSEC);
+}
+
+int main(int argc, char *argv[])
+{
+    int number_of_triggers = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_TRIGGERS;
+    char fifo_path[64];
+    sigset_t usr1;
+
+    if (number_of_triggers <= 0) { return EXIT_FAILURE; }
+
+    int64_t *latencies = (int64_t *)malloc(sizeof (int64_t) * (size_t)number_of_triggers);
+
+    if (latencies == NULL) { return EXIT_FAILURE; }
+
+    snprintf(fifo_path, sizeof (fifo_path), "/tmp/schedr_monitor_bench_%d", (int)getpid());
+    setenv("SHELL", "/bin/sh", 0);
+
+    if (mkfifo(fifo_path, 0600) != 0) { return EXIT_FAILURE; }
+
+    // The signals of the job are waited for, so they must not kill the bench
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &usr1, NULL);
+
+    fflush(stdout);
+
+    pid_t bench_pid = getpid();
+    pid_t daemon_pid = fork();
+
+    if (daemon_pid == 0) { run_daemon(fifo_path, bench_pid); }
+
+    // Blocks until the monitor has opened the FIFO
+    int fd = open(fifo_path, O_WRONLY);
+
+    if (fd == -1) { return EXIT_FAILURE; }
+
+    printf("Running a job %d times on a line written by its monitor\n", number_of_triggers);
+    printf("%-24s %10s %10s %10s\n", "", "p50 us", "p99 us", "max us");
+
+    for (int i = 0; i < number_of_triggers; i++) { latencies[i] = trigger(fd, 0, &usr1); }
+
+    print_latencies("matching line", latencies, number_of_triggers);
+
+    for (int i = 0; i < number_of_triggers; i++) { latencies[i] = trigger(fd, NOISE_LINES, &usr1); }
+
+    print_latencies("after 200 other lines", latencies, number_of_triggers);
+
+    close(fd);
+    kill(daemon_pid, SIGTERM);
+    waitpid(daemon_pid, NULL, 0);
+    unlink(fifo_path);
+    free(latencies);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*
+ * schedr_reload_bench.c
+ *
+ * Measures how long reloading the config file takes with a large number of
+ * jobs, from parsing the file to having started, updated and stopped the jobs
+ * that changed, when nothing has changed and when a hundredth of the jobs has
+ * been changed, added or removed.
+ *
+ * Usage: schedr_reload_bench [number of jobs]
+ */
+#include <stdlib.h>         // free(), atoi()
+#include <stdio.h>          // printf(), fopen(), fprintf(), snprintf()
+#include <stdint.h>         // int64_t
+#include <stdbool.h>        // bool
+#include <unistd.h>         // getpid(), unlink()
+#include <time.h>           // clock_gettime()
+
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+#include "schedr_config_parser.h"
+#include "schedr_reload.h"
+#include "schedr_scheduler.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_JOBS 50000
+#define NANOSECS_PER_SEC 1000000000LL
+#define NANOSECS_PER_MILLISEC 1000000.0
+#define CHANGED_EVERY 100
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+/*
+ * Writes a config of 'number_of_jobs' jobs. With 'changed' every hundredth job
+ * runs another command, and the jobs after it are renamed, so the last ones
+ * are removed and new ones take their place.
+ */
+static int write_config(const char *path, int number_of_jobs, bool changed)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) { return -1; }
+
+    for (int i = 0; i < number_of_jobs; i++)
+    {
+        bool touched = changed && i % CHANGED_EVERY == 0;
+        bool renamed = changed && i % CHANGED_EVERY == 1;
+
+        fprintf(fp, "Job \"%s %d\" run `/bin/echo %s` every %d min\n", renamed ? "renamed" : "job", i,
+                touched ? "changed" : "hello", 1 + i % 60);
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+/*
+ * Loads the config at 'path' and applies it to 'index', printing how long it took.
+ */
+static void reload(JobIndex *index, const char *path, const char *label)
+{
+    Settings settings;
+    Job *jobs = NULL;
+    int number_of_jobs = 0;
+    ReloadStats stats;
+
+    int64_t started_ns = now_ns();
+
+    if (schedr_config_load(&settings, &jobs, &number_of_jobs, path) != SCHEDR_SUCCESS) { return; }
+
+    int64_t parsed_ns = now_ns();
+
+    schedr_reload_apply(index, jobs, number_of_jobs, &stats);
+
+    int64_t applied_ns = now_ns();
+
+    free(jobs);
+
+    printf("%-12s %10.1f %10.1f %10.1f   %d started, %d removed, %d updated, %d unchanged\n", label,
+           (double)(parsed_ns - started_ns) / NANOSECS_PER_MILLISEC, (double)(applied_ns - parsed_ns) / NANOSECS_PER_MILLISEC,
+           (double)(applied_ns - started_ns) / NANOSECS_PER_MILLISEC, stats.started, stats.removed, stats.updated,
+           stats.unchanged);
+}
+
+int main(int argc, char *argv[])
+{
+    int number_of_jobs = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_JOBS;
+    char path[64];
+    JobIndex index;
+
+    if (number_of_jobs <= 0) { return EXIT_FAILURE; }
+
+    snprintf(path, sizeof (path), "/tmp/schedr_reload_bench_%d.conf", (int)getpid());
+    schedr_job_index_init(&index);
+    schedr_scheduler_set_mode(EventLoop);
+
+    printf("Reloading a config of %d jobs\n", number_of_jobs);
+    printf("%-12s %10s %10s %10s\n", "", "parse ms", "apply ms", "total ms");
+
+    if (write_config(path, number_of_jobs, false) != 0) { return EXIT_FAILURE; }
+
+    reload(&index, path, "first load");
+    reload(&index, path, "unchanged");
+
+    if (write_config(path, number_of_jobs, true) != 0) { return EXIT_FAILURE; }
+
+    reload(&index, path, "1% changed");
+
+    for (int i = 0; i < index.len; i++) { schedr_scheduler_stop_job(schedr_job_index_at(&index, i)); }
+
+    schedr_job_index_destroy(&index);
+    unlink(path);
+
+    return EXIT_SUCCESS;
+}
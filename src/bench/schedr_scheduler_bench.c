@@ -0,0 +1,181 @@
+/*
+ * schedr_scheduler_bench.c
+ *
+ * Measures the number of processes and the memory used by the scheduler when
+ * it has a large number of idle jobs, in Supervised and EventLoop mode.
+ *
+ * Usage: schedr_scheduler_bench [number of jobs]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi(), setenv()
+#include <stdio.h>          // printf(), fopen(), snprintf()
+#include <stdbool.h>        // bool, true, false
+#include <string.h>         // strncmp()
+#include <unistd.h>         // fork(), usleep(), pause(), setpgid()
+#include <signal.h>         // kill()
+#include <sys/wait.h>       // waitpid()
+#include <dirent.h>         // opendir(), readdir()
+
+#include "schedr_job.h"
+#include "schedr_scheduler.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_JOBS 10000
+#define SAMPLE_INTERVAL_MICROSECS 500000
+#define MIN_SETTLE_SAMPLES 4
+
+struct ProcTreeUsage
+{
+    int processes;
+    long rss_kb;
+    long pss_kb;
+};
+
+typedef struct ProcTreeUsage ProcTreeUsage;
+
+static pid_t parent_of(pid_t pid)
+{
+    char path[64];
+    snprintf(path, sizeof (path), "/proc/%d/stat", pid);
+    
+    FILE *fp = fopen(path, "r");
+    
+    if (fp == NULL) { return -1; }
+    
+    int ppid = -1;
+    
+    // The command name can contain spaces, so skip past its closing parenthesis
+    if (fscanf(fp, "%*d (%*[^)]) %*c %d", &ppid) != 1) { ppid = -1; }
+    
+    fclose(fp);
+    
+    return ppid;
+}
+
+static long read_kb_field(const char *path, const char *field)
+{
+    FILE *fp = fopen(path, "r");
+    
+    if (fp == NULL) { return 0; }
+    
+    char line[256];
+    long kb = 0;
+    size_t field_len = strlen(field);
+    
+    while (fgets(line, sizeof (line), fp) != NULL)
+    {
+        if (strncmp(line, field, field_len) == 0)
+        {
+            kb = atol(line + field_len);
+            break;
+        }
+    }
+    
+    fclose(fp);
+    
+    return kb;
+}
+
+static bool is_in_tree(pid_t pid, pid_t root)
+{
+    while (pid > 1)
+    {
+        if (pid == root) { return true; }
+        
+        pid = parent_of(pid);
+    }
+    
+    return false;
+}
+
+static ProcTreeUsage measure_tree(pid_t root)
+{
+    ProcTreeUsage usage = { .processes = 0, .rss_kb = 0, .pss_kb = 0 };
+    DIR *proc = opendir("/proc");
+    struct dirent *entry;
+    char path[64];
+    
+    while ((entry = readdir(proc)) != NULL)
+    {
+        pid_t pid = atoi(entry->d_name);
+        
+        if (pid <= 0 || !is_in_tree(pid, root)) { continue; }
+        
+        usage.processes++;
+        
+        snprintf(path, sizeof (path), "/proc/%d/status", pid);
+        usage.rss_kb += read_kb_field(path, "VmRSS:");
+        
+        snprintf(path, sizeof (path), "/proc/%d/smaps_rollup", pid);
+        usage.pss_kb += read_kb_field(path, "Pss:");
+    }
+    
+    closedir(proc);
+    
+    return usage;
+}
+
+static void daemon_proc(SchedulerMode mode, int number_of_jobs)
+{
+    Job *jobs = (Job *)malloc(sizeof (Job) * number_of_jobs);
+    
+    setpgid(0, 0);
+    schedr_scheduler_set_mode(mode);
+    
+    for (int i = 0; i < number_of_jobs; i++)
+    {
+        schedr_job_init(&(jobs[i]));
+        snprintf(jobs[i].name, sizeof (jobs[i].name), "job %d", i);
+        schedr_job_set_command(&(jobs[i]), "true", 4);
+        schedr_job_set_interval(&(jobs[i]), 3600LL * 1000000000LL);
+        
+        if (schedr_scheduler_start_job(&(jobs[i])) != SCHEDR_SUCCESS) { _exit(EXIT_FAILURE); }
+    }
+    
+    if (mode == EventLoop) { schedr_scheduler_run(); }
+    else { pause(); }
+    
+    _exit(EXIT_SUCCESS);
+}
+
+static ProcTreeUsage bench_mode(SchedulerMode mode, int number_of_jobs)
+{
+    pid_t daemon_pid = fork();
+    
+    if (daemon_pid == 0) { daemon_proc(mode, number_of_jobs); }
+    
+    // Wait until every first run has finished and the process count is stable
+    ProcTreeUsage usage = measure_tree(daemon_pid);
+    int stable_samples = 0;
+    
+    while (stable_samples < MIN_SETTLE_SAMPLES)
+    {
+        usleep(SAMPLE_INTERVAL_MICROSECS);
+        
+        ProcTreeUsage sample = measure_tree(daemon_pid);
+        stable_samples = (sample.processes == usage.processes) ? stable_samples + 1 : 0;
+        usage = sample;
+    }
+    
+    kill(-daemon_pid, SIGKILL);
+    waitpid(daemon_pid, NULL, 0);
+    
+    return usage;
+}
+
+int main(int argc, char *argv[])
+{
+    int number_of_jobs = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_JOBS;
+    
+    setenv("SHELL", "/bin/sh", false);
+    
+    printf("%d idle jobs (interval 1 hour)\n", number_of_jobs);
+    printf("%-12s %10s %14s %14s\n", "mode", "processes", "RSS sum (kB)", "PSS sum (kB)");
+    
+    ProcTreeUsage supervised = bench_mode(Supervised, number_of_jobs);
+    printf("%-12s %10d %14ld %14ld\n", "Supervised", supervised.processes, supervised.rss_kb, supervised.pss_kb);
+    
+    ProcTreeUsage event_loop = bench_mode(EventLoop, number_of_jobs);
+    printf("%-12s %10d %14ld %14ld\n", "EventLoop", event_loop.processes, event_loop.rss_kb, event_loop.pss_kb);
+    
+    return EXIT_SUCCESS;
+}
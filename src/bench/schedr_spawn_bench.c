@@ -0,0 +1,133 @@
+/*
+ * schedr_spawn_bench.c
+ *
+ * Measures how many commands per second each spawn backend can start and
+ * wait for, as the resident memory of the daemon grows. The zygote is started
+ * before the memory grows, like the daemon does before it loads its config.
+ * The last column starts commands with limits through the zygote, in a cgroup
+ * leaf if cgroup v2 is delegated to the bench and with setrlimit() otherwise.
+ *
+ * Usage: schedr_spawn_bench [largest daemon size in MB]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi()
+#include <stdio.h>          // printf(), fopen()
+#include <string.h>         // memset(), strncmp()
+#include <stdint.h>         // int64_t
+#include <time.h>           // clock_gettime()
+#include <sys/wait.h>       // waitpid()
+#include <poll.h>           // poll()
+
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+#include "schedr_limits.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_MAX_BALLAST_MB 2048
+#define RUN_NS 2000000000LL
+#define BYTES_PER_MB (1024 * 1024)
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static long rss_mb()
+{
+    FILE *fp = fopen("/proc/self/status", "r");
+    char line[256];
+    long kb = 0;
+
+    while (fgets(line, sizeof (line), fp) != NULL)
+    {
+        if (strncmp(line, "VmRSS:", 6) == 0) { kb = atol(line + 6); }
+    }
+
+    fclose(fp);
+
+    return kb / 1024;
+}
+
+/*
+ * Waits for 'pid' the way the event loop does, through the zygote socket if
+ * the zygote started it.
+ */
+static void wait_for(SpawnBackend backend, pid_t pid)
+{
+    struct pollfd zygote = { .fd = schedr_spawn_event_fd(), .events = POLLIN };
+    struct rusage usage;
+    pid_t reaped = 0;
+    int status;
+
+    if (backend != Zygote)
+    {
+        waitpid(pid, NULL, 0);
+        return;
+    }
+
+    while (schedr_spawn_reap(&reaped, &status, &usage) == SCHEDR_SUCCESS && reaped != pid) { poll(&zygote, 1, -1); }
+}
+
+static double spawns_per_sec(SpawnBackend backend, const Limits *limits, int cgroup_fd)
+{
+    char *argv[] = { "/bin/true", NULL };
+    int spawns = 0;
+    int64_t start = now_ns();
+    int64_t elapsed;
+
+    schedr_spawn_set_backend(backend);
+
+    do
+    {
+        pid_t pid;
+
+        if (schedr_spawn_limited(argv[0], argv, NULL, limits, cgroup_fd, &pid) != SCHEDR_SUCCESS) { return -1; }
+
+        wait_for(backend, pid);
+        spawns++;
+        elapsed = now_ns() - start;
+    } while (elapsed < RUN_NS);
+
+    return (double)spawns / ((double)elapsed / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_ballast_mb = (argc > 1) ? atoi(argv[1]) : DEFAULT_MAX_BALLAST_MB;
+    char *ballast = NULL;
+
+    Limits limits = { .memory_bytes = 512LL * BYTES_PER_MB, .pids = 4096 };
+    CgroupLeaf leaf = { .fd = -1 };
+
+    if (schedr_zygote_start() != SCHEDR_SUCCESS) { return EXIT_FAILURE; }
+
+    if (schedr_limits_open_cgroup(NULL) == SCHEDR_SUCCESS) { schedr_limits_create_leaf(&leaf, "bench", &limits); }
+
+    printf("%-14s %20s %20s %20s %20s\n", "daemon RSS MB", "ForkExec spawns/s", "PosixSpawn spawns/s", "Zygote spawns/s",
+           (leaf.fd != -1) ? "In cgroup spawns/s" : "Rlimited spawns/s");
+
+    for (int ballast_mb = 0; ballast_mb <= max_ballast_mb; ballast_mb = (ballast_mb == 0) ? 64 : ballast_mb * 4)
+    {
+        free(ballast);
+        ballast = (char *)malloc((size_t)ballast_mb * BYTES_PER_MB + 1);
+
+        // Touch every page so it is resident and has to be mapped in a forked child
+        memset(ballast, 1, (size_t)ballast_mb * BYTES_PER_MB + 1);
+
+        double fork_exec = spawns_per_sec(ForkExec, NULL, -1);
+        double posix_spawn = spawns_per_sec(PosixSpawn, NULL, -1);
+        double zygote = spawns_per_sec(Zygote, NULL, -1);
+        double limited = spawns_per_sec(Zygote, &limits, leaf.fd);
+
+        printf("%-14ld %20.0f %20.0f %20.0f %20.0f\n", rss_mb(), fork_exec, posix_spawn, zygote, limited);
+    }
+
+    free(ballast);
+    schedr_limits_remove_leaf(&leaf);
+    schedr_limits_close_cgroup();
+    schedr_zygote_stop();
+
+    return EXIT_SUCCESS;
+}
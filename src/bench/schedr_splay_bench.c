@@ -0,0 +1,131 @@
+/*
+ * schedr_splay_bench.c
+ *
+ * Measures how many commands the daemon runs at the same time right after it
+ * has started a large number of jobs, with and without a splay spreading out
+ * their first runs.
+ *
+ * Usage: schedr_splay_bench [number of jobs]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi()
+#include <stdio.h>          // printf(), fopen(), snprintf()
+#include <string.h>         // strlen()
+#include <stdint.h>         // int64_t
+#include <unistd.h>         // fork(), usleep(), _exit()
+#include <signal.h>         // kill()
+#include <time.h>           // clock_gettime()
+#include <sys/wait.h>       // waitpid()
+
+#include "schedr_job.h"
+#include "schedr_scheduler.h"
+#include "schedr_spawn.h"
+#include "schedr_splay.h"
+#include "schedr_status_codes.h"
+
+#define DEFAULT_NUMBER_OF_JOBS 500
+#define NANOSECS_PER_SEC 1000000000LL
+#define SPLAY_NS (2 * NANOSECS_PER_SEC)
+#define SAMPLE_INTERVAL_MICROSECS 1000
+#define COMMAND "sleep 0.1"
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+/*
+ * Counts the commands the daemon is running, from the children listed by the kernel.
+ */
+static int count_children(pid_t daemon_pid)
+{
+    char path[64];
+    snprintf(path, sizeof (path), "/proc/%d/task/%d/children", daemon_pid, daemon_pid);
+
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) { return 0; }
+
+    int children = 0;
+    int pid;
+
+    while (fscanf(fp, "%d", &pid) == 1) { children++; }
+
+    fclose(fp);
+
+    return children;
+}
+
+/*
+ * Starts a daemon running the jobs with the given splay, and samples how many
+ * commands it runs at once until every job should have run once.
+ */
+static int peak_concurrent_cmds(Job *jobs, int number_of_jobs, int64_t splay_ns)
+{
+    for (int i = 0; i < number_of_jobs; i++) { schedr_job_set_splay(&(jobs[i]), splay_ns); }
+
+    schedr_splay_assign_offsets(jobs, number_of_jobs, SplayHashed, NULL);
+
+    pid_t daemon_pid = fork();
+
+    if (daemon_pid < 0) { return -1; }
+
+    if (daemon_pid == 0)
+    {
+        schedr_scheduler_set_mode(EventLoop);
+        schedr_spawn_set_backend(PosixSpawn);
+
+        for (int i = 0; i < number_of_jobs; i++) { schedr_scheduler_start_job(&(jobs[i])); }
+
+        schedr_scheduler_run();
+        _exit(EXIT_SUCCESS);
+    }
+
+    int peak = 0;
+    int64_t end_ns = now_ns() + splay_ns + NANOSECS_PER_SEC;
+
+    while (now_ns() < end_ns)
+    {
+        int children = count_children(daemon_pid);
+
+        if (children > peak) { peak = children; }
+
+        usleep(SAMPLE_INTERVAL_MICROSECS);
+    }
+
+    kill(daemon_pid, SIGTERM);
+    waitpid(daemon_pid, NULL, 0);
+
+    return peak;
+}
+
+int main(int argc, char *argv[])
+{
+    int number_of_jobs = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_JOBS;
+    Job *jobs = (Job *)malloc(sizeof (Job) * number_of_jobs);
+
+    if (jobs == NULL || number_of_jobs <= 0) { return EXIT_FAILURE; }
+
+    for (int i = 0; i < number_of_jobs; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof (name), "job %d", i);
+
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_name(&(jobs[i]), name, strlen(name));
+        schedr_job_set_command(&(jobs[i]), COMMAND, strlen(COMMAND));
+        schedr_job_compile_command(&(jobs[i]));
+        schedr_job_set_interval(&(jobs[i]), 3600LL * NANOSECS_PER_SEC);
+    }
+
+    printf("%d jobs running '%s', started at once\n", number_of_jobs, COMMAND);
+    printf("%-16s %28s\n", "splay", "peak concurrent commands");
+    printf("%-16s %28d\n", "none", peak_concurrent_cmds(jobs, number_of_jobs, 0));
+    printf("%-16s %28d\n", "2 s (hashed)", peak_concurrent_cmds(jobs, number_of_jobs, SPLAY_NS));
+
+    free(jobs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*
+ * schedr_timer_bench.c
+ *
+ * Compares the timing wheel in schedr_timer.c with a binary heap, for
+ * inserting, cancelling and expiring a large number of timers.
+ *
+ * Usage: schedr_timer_bench [number of timers]
+ */
+#include <stdlib.h>         // malloc(), free(), atoi(), rand()
+#include <stdio.h>          // printf()
+#include <stdint.h>         // int64_t
+#include <stdbool.h>        // true
+#include <time.h>           // clock_gettime()
+
+#include "schedr_timer.h"
+
+#define DEFAULT_NUMBER_OF_TIMERS 1000000
+#define TICK_NS 1000000LL
+#define SPREAD_NS (3600LL * 1000000000LL)
+#define EXPIRE_BATCHES 1000
+
+struct HeapTimer
+{
+    int64_t expires_ns;
+    int index;
+};
+
+typedef struct HeapTimer HeapTimer;
+
+struct Heap
+{
+    HeapTimer **timers;
+    int len;
+};
+
+typedef struct Heap Heap;
+
+static int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void heap_swap(Heap *heap, int a, int b)
+{
+    HeapTimer *tmp = heap->timers[a];
+    heap->timers[a] = heap->timers[b];
+    heap->timers[b] = tmp;
+    heap->timers[a]->index = a;
+    heap->timers[b]->index = b;
+}
+
+static void heap_sift_up(Heap *heap, int index)
+{
+    while (index > 0 && heap->timers[(index - 1) / 2]->expires_ns > heap->timers[index]->expires_ns)
+    {
+        heap_swap(heap, index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+}
+
+static void heap_sift_down(Heap *heap, int index)
+{
+    while (true)
+    {
+        int smallest = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+
+        if (left < heap->len && heap->timers[left]->expires_ns < heap->timers[smallest]->expires_ns) { smallest = left; }
+        if (right < heap->len && heap->timers[right]->expires_ns < heap->timers[smallest]->expires_ns) { smallest = right; }
+        if (smallest == index) { return; }
+
+        heap_swap(heap, index, smallest);
+        index = smallest;
+    }
+}
+
+static void heap_add(Heap *heap, HeapTimer *timer)
+{
+    timer->index = heap->len;
+    heap->timers[heap->len++] = timer;
+    heap_sift_up(heap, timer->index);
+}
+
+static void heap_cancel(Heap *heap, HeapTimer *timer)
+{
+    int index = timer->index;
+
+    heap->len--;
+
+    if (index != heap->len)
+    {
+        heap_swap(heap, index, heap->len);
+        heap_sift_down(heap, index);
+        heap_sift_up(heap, index);
+    }
+}
+
+static int heap_expire(Heap *heap, int64_t now)
+{
+    int expired = 0;
+
+    while (heap->len > 0 && heap->timers[0]->expires_ns <= now)
+    {
+        heap_cancel(heap, heap->timers[0]);
+        expired++;
+    }
+
+    return expired;
+}
+
+static double per_sec(int operations, int64_t elapsed_ns)
+{
+    return (double)operations / ((double)elapsed_ns / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    int number_of_timers = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUMBER_OF_TIMERS;
+    int64_t *deadlines = (int64_t *)malloc(sizeof (int64_t) * number_of_timers);
+
+    srand(1);
+
+    for (int i = 0; i < number_of_timers; i++)
+    {
+        deadlines[i] = ((int64_t)rand() * RAND_MAX + rand()) % SPREAD_NS;
+    }
+
+    // Timing wheel
+    TimerWheel *wheel = (TimerWheel *)malloc(sizeof (TimerWheel));
+    Timer *timers = (Timer *)malloc(sizeof (Timer) * number_of_timers);
+    schedr_timer_wheel_init(wheel, TICK_NS, 0);
+
+    int64_t start = now_ns();
+    for (int i = 0; i < number_of_timers; i++)
+    {
+        schedr_timer_init(&(timers[i]), NULL);
+        schedr_timer_add(wheel, &(timers[i]), deadlines[i]);
+    }
+    int64_t wheel_insert = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < number_of_timers; i += 2) { schedr_timer_cancel(wheel, &(timers[i])); }
+    int64_t wheel_cancel = now_ns() - start;
+
+    int wheel_expired = 0;
+    start = now_ns();
+    for (int batch = 1; batch <= EXPIRE_BATCHES; batch++)
+    {
+        Timer *expired = NULL;
+        schedr_timer_advance(wheel, SPREAD_NS / EXPIRE_BATCHES * batch, &expired);
+
+        for (; expired != NULL; expired = expired->next) { wheel_expired++; }
+    }
+    int64_t wheel_expire = now_ns() - start;
+
+    // Binary heap
+    Heap heap = { .timers = (HeapTimer **)malloc(sizeof (HeapTimer *) * number_of_timers), .len = 0 };
+    HeapTimer *heap_timers = (HeapTimer *)malloc(sizeof (HeapTimer) * number_of_timers);
+
+    start = now_ns();
+    for (int i = 0; i < number_of_timers; i++)
+    {
+        heap_timers[i].expires_ns = deadlines[i];
+        heap_add(&heap, &(heap_timers[i]));
+    }
+    int64_t heap_insert = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < number_of_timers; i += 2) { heap_cancel(&heap, &(heap_timers[i])); }
+    int64_t heap_cancel_time = now_ns() - start;
+
+    int heap_expired = 0;
+    start = now_ns();
+    for (int batch = 1; batch <= EXPIRE_BATCHES; batch++)
+    {
+        heap_expired += heap_expire(&heap, SPREAD_NS / EXPIRE_BATCHES * batch);
+    }
+    int64_t heap_expire_time = now_ns() - start;
+
+    int cancelled = (number_of_timers + 1) / 2;
+
+    printf("%d timers spread over 1 hour, expired in %d batches\n", number_of_timers, EXPIRE_BATCHES);
+    printf("%-8s %16s %16s %16s %14s\n", "", "insert/s", "cancel/s", "expire/s", "memory (kB)");
+    printf("%-8s %16.0f %16.0f %16.0f %14zu\n", "wheel",
+           per_sec(number_of_timers, wheel_insert), per_sec(cancelled, wheel_cancel),
+           per_sec(wheel_expired, wheel_expire),
+           (sizeof (TimerWheel) + sizeof (Timer) * number_of_timers) / 1024);
+    printf("%-8s %16.0f %16.0f %16.0f %14zu\n", "heap",
+           per_sec(number_of_timers, heap_insert), per_sec(cancelled, heap_cancel_time),
+           per_sec(heap_expired, heap_expire_time),
+           ((sizeof (HeapTimer) + sizeof (HeapTimer *)) * number_of_timers) / 1024);
+
+    free(deadlines);
+    free(wheel);
+    free(timers);
+    free(heap.timers);
+    free(heap_timers);
+
+    return EXIT_SUCCESS;
+}
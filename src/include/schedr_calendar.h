@@ -0,0 +1,119 @@
+/*
+ * schedr_calendar.h
+ *
+ * Calendar schedules, like "every friday at 12 am" or "every 1st, 15th at
+ * 9:30". A calendar is compiled once, when the jobs are loaded, into a set of
+ * bits per field: the minutes of the hour, the hours of the day, the days of
+ * the month, the months of the year and the days of the week it fires on. The
+ * next time it fires is found field by field, from the month down to the
+ * minute, by masking off the bits before the current value and taking the
+ * lowest bit left. When a field has no bit left the field above it is moved
+ * on, so the search takes a handful of bit scans however sparse the calendar
+ * is, instead of a step per minute.
+ *
+ * A calendar fires on the days that are both in 'days' and on one of
+ * 'weekdays', so "every friday 13th" fires on every friday the 13th. Which days
+ * of a month those are only depends on the weekday the month starts on, so the
+ * days are compiled for all seven of them.
+ *
+ * Calendars are in the local time of the daemon, as set by TZ. When the clocks
+ * are put forward and a time the calendar fires at does not exist that day, it
+ * fires at the instant the clocks are put forward instead. When the clocks are
+ * put back and a time happens twice, it fires the first time only. Calendars
+ * that fire every hour are the exception, like in cron: they skip the hour
+ * that does not exist and fire in both of the hours that happen twice.
+ */
+#ifndef SCHEDR_CALENDAR_H
+#define SCHEDR_CALENDAR_H
+
+#include <stdint.h>     // uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdbool.h>    // bool
+#include <time.h>       // time_t
+
+#include "schedr_status_codes.h"
+
+// The Gregorian calendar repeats itself every 400 years, a calendar that fires at all fires within them
+#define SCHEDR_CALENDAR_MAX_YEARS 400
+#define SCHEDR_CALENDAR_ALL_MINUTES ((1ULL << 60) - 1)
+#define SCHEDR_CALENDAR_ALL_HOURS ((1U << 24) - 1)
+#define SCHEDR_CALENDAR_ALL_DAYS (((1U << 31) - 1) << 1)
+#define SCHEDR_CALENDAR_ALL_MONTHS (((1U << 12) - 1) << 1)
+#define SCHEDR_CALENDAR_ALL_WEEKDAYS ((1U << 7) - 1)
+
+/*
+ * The fields of a calendar, a bit for every value it fires on.
+ *
+ * minutes:                 bit m for minute m of the hour, 0 if there is no calendar
+ * hours:                   bit h for hour h of the day
+ * days:                    bit d for day d of the month, from 1
+ * months:                  bit m for month m of the year, from 1 for january
+ * weekdays:                bit w for weekday w, from 0 for sunday
+ * days_by_first_weekday:   the days in 'days' that are on one of 'weekdays', by the weekday of the 1st of the month,
+ *                          set by schedr_calendar_compile()
+ */
+struct Calendar
+{
+    uint64_t minutes;
+    uint32_t hours;
+    uint32_t days;
+    uint16_t months;
+    uint8_t weekdays;
+    uint32_t days_by_first_weekday[7];
+};
+
+typedef struct Calendar Calendar;
+
+/*
+ * schedr_calendar_init
+ *
+ * Initializes a calendar that never fires, the calendar of a job without one.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'calendar' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_calendar_init(Calendar *const calendar);
+
+/*
+ * schedr_calendar_is_set
+ *
+ * Tells if 'calendar' fires at all, false if it is NULL.
+ */
+bool schedr_calendar_is_set(const Calendar *const calendar);
+
+/*
+ * schedr_calendar_equal
+ *
+ * Tells if two calendars fire at the same times, field by field. Calendars
+ * that are NULL are equal only to each other.
+ */
+bool schedr_calendar_equal(const Calendar *const calendar, const Calendar *const other);
+
+/*
+ * schedr_calendar_compile
+ *
+ * Checks the fields of a calendar and fills in 'days_by_first_weekday' from
+ * 'days' and 'weekdays'. A calendar has to be compiled before the next time
+ * it fires at can be found.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'calendar' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if a field has no bits or bits out of its range set, or there is no day in
+ *                                        the months of the calendar it could fire on, like "february 30th",
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_calendar_compile(Calendar *const calendar);
+
+/*
+ * schedr_calendar_next
+ *
+ * Finds the first time after 'after' that a compiled calendar fires at, in
+ * seconds since the epoch, and sets 'next' to it.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'calendar' or 'next' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the calendar is not set,
+ *          SCHEDR_FAILURE if the local time could not be found or the calendar does not fire in the
+ *                         SCHEDR_CALENDAR_MAX_YEARS years after 'after',
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_calendar_next(const Calendar *const calendar, time_t after, time_t *next);
+
+#endif /* SCHEDR_CALENDAR_H */
@@ -2,14 +2,36 @@
  * schedr_config_parser.h
  *
  * Responsible for loading and parsing the configuration files containing 
- * information about the jobs to be run.
+ * information about the jobs to be run, and the settings of the scheduler 
+ * running them.
  */
 #ifndef SCHEDR_CONFIG_PARSER_H
 #define SCHEDR_CONFIG_PARSER_H
 
+#include <stdint.h>     // int64_t
+#include <stddef.h>     // size_t
+
 #include "schedr_job.h"
+#include "schedr_splay.h"
+#include "schedr_output.h"
+#include "schedr_log.h"
+#include "schedr_scheduler.h"
 #include "schedr_status_codes.h"
 
+struct Settings
+{
+    int max_concurrent;     // Slots of the run queue, 0 if the number of commands running at the same time is unlimited
+    int64_t splay_ns;       // Splay of the jobs that do not have one of their own
+    SplayMode splay_mode;
+    size_t output_len;      // Bytes of output kept of every job
+    LogRotation log_rotation;
+    LoopBackend loop_backend;
+    Limits daemon_limits;   // The CPUs the daemon and the zygote run on, none set if they may run on any
+    int metrics_port;       // Port of 127.0.0.1 the metrics are also served on, 0 if they are only served on their socket
+};
+
+typedef struct Settings Settings;
+
 #ifdef TEST
 void schedr_config_set_allocator(void *(*alloc_func)(size_t bytes));
 void schedr_config_reset_allocator();
@@ -24,7 +46,7 @@ void schedr_config_remove_on_number_of_jobs_found_hook();
  * dynamically allocated array of the Jobs that was loaded.
  *
  * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'jobs' is NOT NULL,
- *          SCHEDR_ERROR_CONFIG_FORMAT if the loaded config file has incorrect formatting,
+ *          SCHEDR_ERROR_CONFIG_FORMAT if the loaded config file has incorrect formatting or two jobs with the same name,
  *          SCHEDR_ERROR_FILE_NOT_FOUND if the file at 'filepath' could not be found,
  *          SCHEDR_ERROR_PERMISSION_DENIED if the program did not have permission to open the file at 'filepath',
  *          SCHEDR_ERROR_ALLOCATION_FAILED if allocation of resources failed,
@@ -33,4 +55,31 @@ void schedr_config_remove_on_number_of_jobs_found_hook();
  */
 Status schedr_config_load_jobs(Job *jobs[], int *loaded_jobs, const char *filepath);
 
+/*
+ * schedr_config_load
+ * 
+ * Works like schedr_config_load_jobs(), but also fills 'settings' with the
+ * settings of the configuration file. Settings that are not in the file get
+ * their default values.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'settings' is NULL,
+ *          the same as schedr_config_load_jobs() otherwise
+ */
+Status schedr_config_load(Settings *const settings, Job *jobs[], int *loaded_jobs, const char *filepath);
+
+/*
+ * schedr_config_parse_job
+ *
+ * Parses a single job from 'text', written the same way as in a configuration
+ * file, into 'job_p'. The text may be on a single line. Settings in the text
+ * are ignored, and the job gets the default splay.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'text' is NULL,
+ *          SCHEDR_ERROR_CONFIG_FORMAT if 'text' is not formatted correctly, does not hold exactly one job, 
+ *              or the job lacks a command or both an interval and a trigger,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if allocation of resources failed,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_config_parse_job(Job *const job_p, const char *text);
+
 #endif /* SCHEDR_CONFIG_PARSER_H */
@@ -0,0 +1,79 @@
+/*
+ * schedr_control.h
+ *
+ * The control socket of the daemon, a Unix socket other schedr processes
+ * connect to in order to ask the running daemon something. A request is a
+ * single line, a command followed by its argument. The response is a line
+ * with the status code of the request, followed by what the command printed,
+ * after which the daemon closes the connection.
+ *
+ * The daemon serves the requests from schedr_scheduler_run(), without ever
+ * blocking on a connection, so slow clients do not delay the jobs.
+ *
+ * Commands:
+ *  tail <job name>     the output kept of the job, see schedr_output.h
+ *  status <job name>   the state of the job, its last exit status, its failures and how it is retried
+ *  latency [<job name>] percentiles of how late the runs of the job, or of every job, were started, how long
+ *                      starting their commands took and how long they ran, see schedr_scheduler_get_latency()
+ *  list                the state and the name of every job
+ *  add <job>           adds the job, written as in the configuration file, and starts it
+ *  remove <job name>   stops the job and forgets about it
+ *  pause <job name>    stops starting runs of the job until it is resumed, see schedr_scheduler_pause_job()
+ *  resume <job name>   lets a paused job run again on its interval
+ *  run <job name>      runs the job right away, see schedr_scheduler_run_job_now()
+ *
+ * The jobs are looked up by name in a JobIndex, so no request takes longer
+ * the more jobs there are.
+ */
+#ifndef SCHEDR_CONTROL_H
+#define SCHEDR_CONTROL_H
+
+#include <stdio.h>      // FILE
+
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+#include "schedr_status_codes.h"
+
+#define SCHEDR_CONTROL_MAX_REQUEST_LEN (SCHEDR_JOB_MAX_NAME_LEN + SCHEDR_JOB_MAX_CMD_LEN + 512)
+
+/*
+ * schedr_control_open
+ *
+ * Creates the control socket at 'socket_path', replacing any socket a daemon
+ * that did not shut down cleanly left behind, and serves the requests about
+ * the jobs in 'jobs' from schedr_scheduler_run(). Jobs are added to and
+ * removed from 'jobs' by the requests. 'prepare_job', unless it is NULL, is
+ * called with every added job before it is started. Only the user running the
+ * daemon may connect to the socket.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'socket_path' or 'jobs' is NULL,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'socket_path' is too long for a Unix socket,
+ *          SCHEDR_ERROR_PERMISSION_DENIED if the program did not have permission to create the socket,
+ *          SCHEDR_FAILURE if the socket could not be created for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_control_open(const char *socket_path, JobIndex *const jobs, void (*prepare_job)(Job *job_p));
+
+/*
+ * schedr_control_close
+ *
+ * Closes the control socket and every connection to it, and removes the
+ * socket file.
+ */
+void schedr_control_close();
+
+/*
+ * schedr_control_request
+ *
+ * Sends 'request' to the daemon listening on 'socket_path' and waits for the
+ * response. What the command printed is written to 'out' if the request
+ * succeeded, or to 'err' otherwise.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'request' is longer than SCHEDR_CONTROL_MAX_REQUEST_LEN,
+ *          SCHEDR_FAILURE if the daemon could not be reached, in which case a message is written to 'err',
+ *          the status code of the request otherwise
+ */
+Status schedr_control_request(const char *socket_path, const char *request, FILE *out, FILE *err);
+
+#endif /* SCHEDR_CONTROL_H */
@@ -0,0 +1,189 @@
+/*
+ * schedr_hash.h
+ *
+ * A hash map from 64-bit integer keys, such as pids or pointers, to pointers.
+ * Looking up, adding and removing a key takes constant time on average. The
+ * map grows as keys are added, so there is no limit on how many keys it holds.
+ *
+ * Keys are stored with open addressing and linear probing. Removed keys are
+ * not replaced by tombstones, the keys after them are moved back instead, so
+ * lookups stay fast no matter how many keys have been removed.
+ *
+ * Strings and other bytes are hashed into keys with FNV-1a. A StringHashMap
+ * is keyed by strings themselves: the strings with the same hash are chained
+ * under it and told apart by comparing them.
+ */
+#ifndef SCHEDR_HASH_H
+#define SCHEDR_HASH_H
+
+#include <stddef.h>     // size_t
+#include <stdint.h>     // uint64_t
+#include <stdbool.h>    // bool
+
+#include "schedr_status_codes.h"
+
+// The FNV-1a hash of no bytes, which schedr_hash_bytes() continues from
+#define SCHEDR_HASH_EMPTY 0xcbf29ce484222325ULL
+
+struct HashEntry
+{
+    uint64_t key;
+    void *value;
+    bool used;
+};
+
+typedef struct HashEntry HashEntry;
+
+struct HashMap
+{
+    HashEntry *entries;
+    size_t capacity;
+    size_t count;
+};
+
+typedef struct HashMap HashMap;
+
+/*
+ * A string key and its value, with the next key of the same hash.
+ */
+struct StringHashEntry
+{
+    const char *key;
+    void *value;
+    struct StringHashEntry *next;
+};
+
+typedef struct StringHashEntry StringHashEntry;
+
+/*
+ * by_hash: the first entry of the chain of every hash
+ * count:   the number of keys in the map
+ */
+struct StringHashMap
+{
+    HashMap by_hash;
+    size_t count;
+};
+
+typedef struct StringHashMap StringHashMap;
+
+#ifdef TEST
+void schedr_hash_set_allocator(void *(*calloc_func)(size_t count, size_t bytes));
+void schedr_hash_reset_allocator();
+void schedr_hash_set_string_hash(uint64_t (*hash_func)(const char *str));
+void schedr_hash_reset_string_hash();
+#endif
+
+/*
+ * schedr_hash_init
+ *
+ * Initializes an empty map. No memory is allocated until a key is added.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_init(HashMap *const map);
+
+/*
+ * schedr_hash_destroy
+ *
+ * Frees the memory of a map, leaving it empty. The values are not freed.
+ */
+void schedr_hash_destroy(HashMap *const map);
+
+/*
+ * schedr_hash_put
+ *
+ * Associates 'value' with 'key', replacing any value the key already had.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' is NULL,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the map had to grow but could not,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_put(HashMap *const map, uint64_t key, void *value);
+
+/*
+ * schedr_hash_get
+ *
+ * Gives the value associated with 'key', or NULL if the key is not in the map.
+ */
+void *schedr_hash_get(const HashMap *const map, uint64_t key);
+
+/*
+ * schedr_hash_remove
+ *
+ * Removes 'key' and its value from the map, if it is in the map.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_remove(HashMap *const map, uint64_t key);
+
+/*
+ * schedr_hash_bytes
+ *
+ * Continues the FNV-1a hash 'hash' over 'len' bytes, so values can be hashed
+ * one after the other, starting from SCHEDR_HASH_EMPTY.
+ */
+uint64_t schedr_hash_bytes(uint64_t hash, const void *bytes, size_t len);
+
+/*
+ * schedr_hash_string
+ *
+ * Hashes a string with FNV-1a, followed by the finalizer of splitmix64 so
+ * strings that share a prefix or differ in their last character only, like
+ * the names of jobs, get hashes far apart.
+ */
+uint64_t schedr_hash_string(const char *str);
+
+/*
+ * schedr_hash_strings_init
+ *
+ * Initializes an empty map from strings. No memory is allocated until a key
+ * is added.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_strings_init(StringHashMap *const map);
+
+/*
+ * schedr_hash_strings_destroy
+ *
+ * Frees the memory of a map from strings, leaving it empty. The keys and
+ * values are not freed.
+ */
+void schedr_hash_strings_destroy(StringHashMap *const map);
+
+/*
+ * schedr_hash_strings_put
+ *
+ * Associates 'value' with 'key', replacing any value an equal key already
+ * had. The key is not copied, it has to stay as it is while it is in the map.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' or 'key' is NULL,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the key could not be added,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_strings_put(StringHashMap *const map, const char *key, void *value);
+
+/*
+ * schedr_hash_strings_get
+ *
+ * Gives the value associated with a key equal to 'key', or NULL if there is
+ * none or an argument is NULL.
+ */
+void *schedr_hash_strings_get(const StringHashMap *const map, const char *key);
+
+/*
+ * schedr_hash_strings_remove
+ *
+ * Removes the key equal to 'key' and its value from the map, if it is in the
+ * map.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'map' or 'key' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_hash_strings_remove(StringHashMap *const map, const char *key);
+
+#endif /* SCHEDR_HASH_H */
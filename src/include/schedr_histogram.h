@@ -0,0 +1,139 @@
+/*
+ * schedr_histogram.h
+ *
+ * A histogram of durations in nanoseconds, in the manner of HdrHistogram: the
+ * values are counted in buckets whose width grows with the value, so every
+ * recorded value is known to within 1/SCHEDR_HISTOGRAM_SUB_BUCKETS of itself,
+ * from a nanosecond up to about 19 hours. Longer values are counted in the
+ * last bucket, but the maximum is kept exactly.
+ *
+ * The buckets are part of the histogram, so recording a value never allocates
+ * and takes a handful of instructions: the bucket is found from the position
+ * of the highest bit of the value. A histogram is meant to be recorded and
+ * read by one thread, it takes no locks.
+ *
+ * The module also keeps the latencies of the runs the event loop makes of
+ * every job, in a JobLatency per job and one for the runs of all jobs.
+ */
+#ifndef SCHEDR_HISTOGRAM_H
+#define SCHEDR_HISTOGRAM_H
+
+#include <stdint.h>     // int64_t, uint64_t
+
+#include "schedr_status_codes.h"
+#include "schedr_job.h"
+
+#define SCHEDR_HISTOGRAM_SUB_BUCKET_BITS 4
+#define SCHEDR_HISTOGRAM_SUB_BUCKETS (1 << SCHEDR_HISTOGRAM_SUB_BUCKET_BITS)
+#define SCHEDR_HISTOGRAM_MAX_EXPONENT 45
+#define SCHEDR_HISTOGRAM_BUCKETS ((SCHEDR_HISTOGRAM_MAX_EXPONENT - SCHEDR_HISTOGRAM_SUB_BUCKET_BITS + 2) * SCHEDR_HISTOGRAM_SUB_BUCKETS)
+
+/*
+ * count:   the values recorded
+ * sum_ns:  their sum, for the mean, INT64_MAX once it no longer fits
+ * min_ns:  the smallest value recorded, 0 if there is none
+ * max_ns:  the largest value recorded, 0 if there is none
+ */
+struct Histogram
+{
+    uint64_t count;
+    int64_t sum_ns;
+    int64_t min_ns;
+    int64_t max_ns;
+    uint64_t buckets[SCHEDR_HISTOGRAM_BUCKETS];
+};
+
+typedef struct Histogram Histogram;
+
+/*
+ * How the runs of a job went, recorded by the event loop.
+ *
+ * lag:     from when a run was due until its command was started, the time it waited in the run queue included
+ * spawn:   how long starting the command took, which for every spawn backend but ForkExec is until it was executed
+ * runtime: from the start of the command until it was reaped
+ */
+struct JobLatency
+{
+    Histogram lag;
+    Histogram spawn;
+    Histogram runtime;
+};
+
+typedef struct JobLatency JobLatency;
+
+/*
+ * schedr_histogram_init
+ *
+ * Initializes an empty histogram.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'histogram' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_histogram_init(Histogram *const histogram);
+
+/*
+ * schedr_histogram_record
+ *
+ * Counts 'value_ns' in 'histogram'. A negative value is counted as 0. Does
+ * nothing if 'histogram' is NULL.
+ */
+void schedr_histogram_record(Histogram *const histogram, int64_t value_ns);
+
+/*
+ * schedr_histogram_percentile
+ *
+ * Gives the value 'percent' percent of the recorded values are at or below,
+ * as the largest value of the bucket it was counted in, but no larger than
+ * the maximum.
+ *
+ * returns  the value, or 0 if 'histogram' is NULL or empty
+ */
+int64_t schedr_histogram_percentile(const Histogram *const histogram, double percent);
+
+/*
+ * schedr_histogram_count_at_or_below
+ *
+ * Fills 'counts' with how many of the recorded values are at or below each of
+ * the 'bounds_len' values of 'bounds_ns', which have to be in ascending order,
+ * in a single pass over the buckets. A value counts as at or below a bound if
+ * the bucket it was counted in ends at or below it, or if the bound is at or
+ * above the maximum. Every count is 0 if 'histogram' is NULL.
+ */
+void schedr_histogram_count_at_or_below(const Histogram *const histogram, const int64_t bounds_ns[], int bounds_len, 
+                                        uint64_t counts[]);
+
+/*
+ * schedr_histogram_record_start
+ *
+ * Records how late a run of a job was started and how long starting its
+ * command took, for the job and for every job. The histograms of the job are
+ * allocated by its first start, a job whose histograms can not be allocated
+ * is only counted for every job.
+ */
+void schedr_histogram_record_start(const Job *const job_p, int64_t lag_ns, int64_t spawn_ns);
+
+/*
+ * schedr_histogram_record_runtime
+ *
+ * Records how long a run of a job ran, for the job and for every job.
+ */
+void schedr_histogram_record_runtime(const Job *const job_p, int64_t runtime_ns);
+
+/*
+ * schedr_histogram_get_latency
+ *
+ * Gives the latencies recorded for a job, or for every job if 'job_p' is NULL.
+ *
+ * returns  the latencies, or NULL if no start of the job has been recorded
+ */
+const JobLatency *schedr_histogram_get_latency(const Job *const job_p);
+
+/*
+ * schedr_histogram_forget_latency
+ *
+ * Frees the latencies of a job, or of every job and the ones for every job if
+ * 'job_p' is NULL.
+ */
+void schedr_histogram_forget_latency(const Job *const job_p);
+
+#endif /* SCHEDR_HISTOGRAM_H */
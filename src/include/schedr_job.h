@@ -2,34 +2,128 @@
  * schedr_job.h
  *
  * Describes an instance of a job. A job has a name, a command to run,
- * an interval in seconds for how often it is to run and a state, indicating
- * if it is currently running or stopped.
+ * an interval in nanoseconds for how often it is to run and a state, indicating
+ * if it is currently running, paused or stopped. A paused job is still started
+ * but does not run until it is resumed.
+ *
+ * The timing of a job decides what the interval is measured from. With
+ * FixedDelay the next run is due 'interval_ns' after the previous run
+ * finished. With FixedRate the runs are due on a fixed grid, 'interval_ns'
+ * apart from the first run, no matter how long every run takes. Runs that 
+ * would have started while the previous run was still going are skipped.
+ *
+ * The outcome of the last run of a job, its exit status and how long it
+ * took, is filled in by the scheduler when the command has been reaped.
+ *
+ * The overlap policy of a job decides what happens when a run is due while
+ * the previous one is still going. With OverlapWait, the default, the next
+ * run is not timed until the previous one has finished. With the other 
+ * policies the runs are due on their interval whatever the running ones do.
+ * OverlapSkip drops the runs that are due while a run is going, OverlapQueue
+ * holds one of them until the run has finished and OverlapParallel runs up to
+ * 'max_parallel' commands of the job at the same time, dropping the runs due
+ * beyond that. The dropped and held runs are counted in the job.
+ *
+ * The first run of a job with a splay is delayed by 'splay_offset_ns', which
+ * is less than 'splay_ns', so jobs started at the same time do not all run at
+ * once. The offset is assigned when the jobs are loaded.
+ *
+ * The weight of a job is the number of slots its command occupies in the run
+ * queue of the scheduler while it runs, when the number of commands allowed
+ * to run at the same time is limited.
+ *
+ * A job whose command fails is retried according to its retry policy, see
+ * schedr_retry.h. The failures and the backoff of the job are kept in
+ * 'retry_state' by the scheduler.
+ *
+ * The resources the commands of a job may use are limited by its limits, see
+ * schedr_limits.h.
+ *
+ * Simple commands can also be compiled into an executable and a list of 
+ * arguments, so they can be executed without starting a shell.
+ *
+ * A job with a trigger runs whenever a line written by its monitor, a command
+ * that keeps running for as long as the job is started, matches 'pattern', a
+ * POSIX extended regular expression, see schedr_monitor.h. A triggered job 
+ * without an interval runs only then.
+ *
+ * A job with a calendar runs at the times of its calendar, see 
+ * schedr_calendar.h, instead of on an interval. The splay delays every run of
+ * such a job, not only the first.
  */
 #ifndef SCHEDR_JOB_H
 #define SCHEDR_JOB_H
 
 #include <stddef.h> // size_t
+#include <stdint.h> // int64_t
 
 #include "schedr_status_codes.h" // Status
+#include "schedr_retry.h"        // RetryPolicy, RetryState
+#include "schedr_limits.h"       // Limits
+#include "schedr_calendar.h"     // Calendar
 
 #define SCHEDR_JOB_MAX_NAME_LEN 100
 #define SCHEDR_JOB_MAX_CMD_LEN 1000
-#define SCHEDR_JOB_STATE_VALUES 2
+#define SCHEDR_JOB_MAX_PATH_LEN 255
+#define SCHEDR_JOB_MAX_ARGS 32
+#define SCHEDR_JOB_MAX_PATTERN_LEN 255
+#define SCHEDR_JOB_STATE_VALUES 3
+#define SCHEDR_JOB_TIMING_VALUES 2
+#define SCHEDR_JOB_OVERLAP_VALUES 4
 
 enum JobState
 {
     Running = 0,
-    Stopped = 1
+    Stopped = 1,
+    Paused = 2
 };
 
 typedef enum JobState JobState;
 
+enum JobTiming
+{
+    FixedDelay = 0,
+    FixedRate = 1
+};
+
+typedef enum JobTiming JobTiming;
+
+enum OverlapPolicy
+{
+    OverlapWait = 0,
+    OverlapSkip = 1,
+    OverlapQueue = 2,
+    OverlapParallel = 3
+};
+
+typedef enum OverlapPolicy OverlapPolicy;
+
 struct Job 
 {
     char name[SCHEDR_JOB_MAX_NAME_LEN + 1];
     char command[SCHEDR_JOB_MAX_CMD_LEN + 1];
-    int interval_seconds;
+    int64_t interval_ns;
     JobState state;
+    JobTiming timing;
+    int weight;                                         // Run queue slots occupied while running
+    OverlapPolicy overlap;
+    int max_parallel;                                   // Commands allowed to run at the same time with OverlapParallel
+    uint64_t skipped_runs;                              // Runs dropped since they were due while the job was running
+    uint64_t queued_runs;                               // Runs held until the running command had finished
+    int64_t splay_ns;                                   // The first run is delayed by up to this much
+    int64_t splay_offset_ns;                            // How much the first run is delayed
+    int argc;                                           // 0 if the command has to be run by a shell
+    char exec_path[SCHEDR_JOB_MAX_PATH_LEN + 1];
+    char args[SCHEDR_JOB_MAX_CMD_LEN + 1];              // 'argc' words, each terminated by '\0'
+    int last_exit_status;                               // 128 + the signal number if killed, -1 if never run
+    int64_t last_duration_ns;                           // Wall clock time of the last run
+    int64_t last_cpu_ns;                                // User and system CPU time of the last run
+    RetryPolicy retry;
+    RetryState retry_state;
+    Limits limits;
+    char monitor[SCHEDR_JOB_MAX_CMD_LEN + 1];           // "" if the job has no trigger
+    char pattern[SCHEDR_JOB_MAX_PATTERN_LEN + 1];
+    Calendar calendar;                                  // Never fires if the job runs on its interval
 };
 
 typedef struct Job Job;
@@ -38,7 +132,10 @@ typedef struct Job Job;
  * Initializes a job to default values. 
  *
  * Default values are: 
- * name: "", command: "", interval_seconds: 0, state: Stopped
+ * name: "", command: "", interval_ns: 0, state: Stopped, timing: FixedDelay, weight: 1, overlap: OverlapWait, 
+ * max_parallel: 1, skipped_runs: 0, queued_runs: 0, splay_ns: 0, splay_offset_ns: 0, argc: 0,
+ * last_exit_status: -1, last_duration_ns: 0, last_cpu_ns: 0, retry: no retries, see schedr_retry_init(), 
+ * retry_state: no failures, limits: none, monitor: "", pattern: "", calendar: never fires
  *
  * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
  *          SCHEDR_SUCCESS otherwise
@@ -56,7 +153,7 @@ Status schedr_job_init(Job *const job_p);
 Status schedr_job_set_name(Job *const job_p, const char *name, size_t name_len);
 
 /*
- * Sets the command of a job.
+ * Sets the command of a job. Any previously compiled command is discarded.
  *
  * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'name' is NULL,
  *          SCHEDR_ERROR_INVALID_ARGUMENT if 'command' is empty or 'cmd_len' is 0,
@@ -66,14 +163,14 @@ Status schedr_job_set_name(Job *const job_p, const char *name, size_t name_len);
 Status schedr_job_set_command(Job *const job_p, const char *command, size_t cmd_len);
 
 /*
- * Sets the interval, in seconds, of a job. The interval specifies how often the command associated with a job 
+ * Sets the interval, in nanoseconds, of a job. The interval specifies how often the command associated with a job 
  * should be executed.
  *
  * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
  *          SCHEDR_ERROR_INVALID_ARGUMENT if interval is < 0
  *          SCHEDR_SUCCESS, otherwise
  */
-Status schedr_job_set_interval(Job *const job_p, int interval);
+Status schedr_job_set_interval(Job *const job_p, int64_t interval_ns);
 
 /*
  * Sets the state of a job.
@@ -84,4 +181,124 @@ Status schedr_job_set_interval(Job *const job_p, int interval);
  */
 Status schedr_job_set_state(Job *const job_p, JobState state);
 
+/*
+ * Sets the timing of a job, which decides if the interval is measured from the
+ * end of the previous run (FixedDelay) or from the start of the first run (FixedRate).
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if timing is < 0 or >= SCHEDR_JOB_TIMING_VALUES
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_timing(Job *const job_p, JobTiming timing);
+
+/*
+ * Sets the weight of a job, the number of run queue slots its command occupies
+ * while it runs.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if weight is < 1
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_weight(Job *const job_p, int weight);
+
+/*
+ * Sets the overlap policy of a job, and how many of its commands may run at
+ * the same time with OverlapParallel. 'max_parallel' has to be 1 for the other
+ * policies.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if overlap is < 0 or >= SCHEDR_JOB_OVERLAP_VALUES,
+ *              if max_parallel is < 1 or if max_parallel is not 1 and overlap is not OverlapParallel
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_overlap(Job *const job_p, OverlapPolicy overlap, int max_parallel);
+
+/*
+ * Sets the splay, in nanoseconds, of a job. The first run of the job is 
+ * delayed by an offset less than the splay. Any assigned offset is discarded.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if splay is < 0
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_splay(Job *const job_p, int64_t splay_ns);
+
+/*
+ * Sets the retry policy of a job, which decides when the job runs again after
+ * its command has failed. The failures recorded so far are kept.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'policy' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the policy is invalid, see schedr_retry_validate(),
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_retry(Job *const job_p, const RetryPolicy *const policy);
+
+/*
+ * Sets the limits of the resources the commands of a job may use.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'limits' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the limits are invalid, see schedr_limits_validate(),
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_limits(Job *const job_p, const Limits *const limits);
+
+/*
+ * Makes a job run whenever a line written by the command 'monitor' matches
+ * the extended regular expression 'pattern'.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p', 'monitor' or 'pattern' is NULL,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'monitor_len' > SCHEDR_JOB_MAX_CMD_LEN or 
+ *                                       'pattern_len' > SCHEDR_JOB_MAX_PATTERN_LEN,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'monitor' or 'pattern' is empty, or 'pattern' is not a valid regular expression,
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_trigger(Job *const job_p, const char *monitor, size_t monitor_len, const char *pattern, size_t pattern_len);
+
+/*
+ * Makes a job run at the times of 'calendar', which is compiled when it is
+ * set. The interval of the job is not used while it has a calendar.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'calendar' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the calendar is invalid, see schedr_calendar_compile(),
+ *          SCHEDR_SUCCESS, otherwise
+ */
+Status schedr_job_set_calendar(Job *const job_p, const Calendar *const calendar);
+
+/*
+ * Compiles the command of a job so it can be executed directly, without a 
+ * shell. The command is split into words on blanks and the first word is
+ * looked up in $PATH. 
+ *
+ * Commands using any shell syntax (quoting, variables, redirection, pipes, 
+ * globbing, ...), commands with more than SCHEDR_JOB_MAX_ARGS words and 
+ * commands whose executable can not be found are left to the shell, in which
+ * case 'argc' is set to 0.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_job_compile_command(Job *const job_p);
+
+/*
+ * Fills 'argv' with pointers to the words of a compiled command, followed by
+ * NULL. The pointers are valid for as long as the job is not changed.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' or 'argv' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the command of the job is not compiled,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_job_get_argv(const Job *const job_p, char *argv[SCHEDR_JOB_MAX_ARGS + 1]);
+
+/*
+ * Hashes what the configuration of a job decides: its name, command,
+ * interval, timing, weight, overlap policy, splay, retry policy, limits,
+ * trigger and calendar.
+ * Jobs configured the same way have the same fingerprint whatever their
+ * state, counters and last run, so it tells which jobs of a reloaded 
+ * configuration have changed.
+ *
+ * returns  the fingerprint, or 0 if 'job_p' is NULL
+ */
+uint64_t schedr_job_fingerprint(const Job *const job_p);
+
 #endif /* SCHEDR_JOB_H */
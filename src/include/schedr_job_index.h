@@ -0,0 +1,100 @@
+/*
+ * schedr_job_index.h
+ *
+ * The jobs of the daemon by name. Finding, adding and removing a job takes
+ * constant time on average, so the control socket can change the jobs while
+ * the daemon runs without holding up the loop however many there are. The
+ * jobs are also kept in an array, in no particular order, to go through all of
+ * them.
+ *
+ * The jobs are looked up by their names, see StringHashMap in schedr_hash.h.
+ */
+#ifndef SCHEDR_JOB_INDEX_H
+#define SCHEDR_JOB_INDEX_H
+
+#include <stdbool.h>    // bool
+
+#include "schedr_job.h"
+#include "schedr_hash.h"
+#include "schedr_status_codes.h"
+
+/*
+ * job:     the job, which is not copied
+ * owned:   whether the index frees the job when it is removed
+ */
+struct IndexedJob
+{
+    Job *job;
+    bool owned;
+    int position;       // In 'jobs' of the index
+};
+
+typedef struct IndexedJob IndexedJob;
+
+struct JobIndex
+{
+    StringHashMap by_name;
+    IndexedJob **jobs;
+    int len;
+    int capacity;
+};
+
+typedef struct JobIndex JobIndex;
+
+/*
+ * schedr_job_index_init
+ *
+ * Initializes an empty index. No memory is allocated until a job is added.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'index' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_job_index_init(JobIndex *const index);
+
+/*
+ * schedr_job_index_destroy
+ *
+ * Frees the memory of an index and the jobs it owns, leaving it empty.
+ */
+void schedr_job_index_destroy(JobIndex *const index);
+
+/*
+ * schedr_job_index_add
+ *
+ * Adds 'job_p' to the index under its name. If 'owned' is true the job has
+ * been allocated with malloc() and is freed by the index once it is removed.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'index' or 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if a job with the same name is indexed already,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the job could not be added,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_job_index_add(JobIndex *const index, Job *const job_p, bool owned);
+
+/*
+ * schedr_job_index_find
+ *
+ * returns  the job named 'name', or NULL if there is none or an argument is NULL
+ */
+Job *schedr_job_index_find(const JobIndex *const index, const char *name);
+
+/*
+ * schedr_job_index_remove
+ *
+ * Removes 'job_p' from the index, and frees it if the index owns it. The job
+ * that was last in the array takes its place.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'index' or 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job is not in the index,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_job_index_remove(JobIndex *const index, Job *const job_p);
+
+/*
+ * schedr_job_index_at
+ *
+ * returns  the job at 'position' of the array, or NULL if 'position' is < 0 or >= the number of jobs
+ */
+Job *schedr_job_index_at(const JobIndex *const index, int position);
+
+#endif /* SCHEDR_JOB_INDEX_H */
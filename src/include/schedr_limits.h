@@ -0,0 +1,289 @@
+/*
+ * schedr_limits.h
+ *
+ * Limits the resources the commands of a job may use, so one runaway job can
+ * not starve the rest of the machine.
+ *
+ * Where cgroup v2 is available and the cgroup of the daemon is delegated to it,
+ * every run slot of a job gets a leaf cgroup of its own, with the limits of the
+ * job written to its cpu.max, memory.max, io.weight and pids.max. The leaves
+ * are created the first time a slot runs and kept for the runs after it, and
+ * commands are cloned straight into their leaf with CLONE_INTO_CGROUP, so the
+ * limits cost nothing when a command is started. The daemon and the zygote
+ * are moved into a leaf of their own, named "daemon", since a cgroup with
+ * controllers enabled for its children can not hold any processes itself.
+ *
+ * Without cgroups the memory and pids limits are set with setrlimit() in the
+ * command before it is executed, as RLIMIT_AS and RLIMIT_NPROC. The latter
+ * counts every process of the user, not only those of the command. The cpu
+ * and io limits have no counterpart and are not applied.
+ *
+ * Limits also place the commands of a job: on the CPUs they may run on, with
+ * their memory on a NUMA node, and at a nice value and io priority of their
+ * own. These are set in the command between clone() and execve(), whether it
+ * is started in a cgroup or not. A command that can not be placed is still
+ * executed, where it would have run otherwise.
+ */
+#ifndef SCHEDR_LIMITS_H
+#define SCHEDR_LIMITS_H
+
+#include <stdint.h>         // int64_t
+#include <stdbool.h>        // bool
+#include <sys/types.h>      // pid_t
+
+#include "schedr_status_codes.h"
+
+#define SCHEDR_LIMITS_MAX_CPU_PERCENT (100 * 1024)
+#define SCHEDR_LIMITS_MAX_IO_WEIGHT 10000
+#define SCHEDR_LIMITS_MAX_LEAF_NAME_LEN 63
+#define SCHEDR_LIMITS_MAX_CPUS 1024
+#define SCHEDR_LIMITS_MAX_NUMA_NODES 64
+#define SCHEDR_LIMITS_MIN_NICE (-20)
+#define SCHEDR_LIMITS_MAX_NICE 19
+#define SCHEDR_LIMITS_MAX_IO_PRIORITY_LEVEL 7
+
+/*
+ * The io scheduling classes, numbered like the kernel numbers them. Only
+ * commands of root may be given IoPriorityRealtime.
+ */
+enum IoPriorityClass
+{
+    IoPriorityNone = 0,
+    IoPriorityRealtime = 1,
+    IoPriorityBestEffort = 2,
+    IoPriorityIdle = 3
+};
+
+typedef enum IoPriorityClass IoPriorityClass;
+
+/*
+ * The limits of a job, 0 where there is none.
+ *
+ * cpu_percent:         the share of a CPU the commands may use, over 100 for more than one CPU
+ * memory_bytes:        the memory the commands may use
+ * io_weight:           the share of the disks the commands get when they are contended, 1 to 10000
+ * pids:                the processes and threads the commands may have
+ * cpus:                a bit per CPU the commands may run on, none set if they may run on any
+ * numa_nodes:          a bit per NUMA node the memory of the commands is taken from
+ * nice_set, nice:      the nice value of the commands, -20 to 19, if 'nice_set'
+ * io_priority_class:   the io scheduling class of the commands
+ * io_priority_level:   their priority within a realtime or best effort class, 0 (highest) to 7
+ */
+struct Limits
+{
+    int cpu_percent;
+    int64_t memory_bytes;
+    int io_weight;
+    int pids;
+    uint64_t cpus[SCHEDR_LIMITS_MAX_CPUS / 64];
+    uint64_t numa_nodes;
+    bool nice_set;
+    int nice;
+    IoPriorityClass io_priority_class;
+    int io_priority_level;
+};
+
+typedef struct Limits Limits;
+
+/*
+ * A leaf cgroup the commands of one run slot are started in. 'fd' is -1 if
+ * the leaf has not been created.
+ */
+struct CgroupLeaf
+{
+    int fd;
+    char name[SCHEDR_LIMITS_MAX_LEAF_NAME_LEN + 1];
+};
+
+typedef struct CgroupLeaf CgroupLeaf;
+
+#ifdef TEST
+void schedr_limits_set_node_dir(const char *dir);
+void schedr_limits_reset_node_dir();
+#endif
+
+/*
+ * schedr_limits_init
+ *
+ * Initializes limits that do not limit anything.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_init(Limits *const limits);
+
+/*
+ * schedr_limits_validate
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if a limit is < 0, 'cpu_percent' is > SCHEDR_LIMITS_MAX_CPU_PERCENT,
+ *              'io_weight' is > SCHEDR_LIMITS_MAX_IO_WEIGHT, 'nice' is out of range or the io priority
+ *              is not a class and level,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_validate(const Limits *const limits);
+
+/*
+ * schedr_limits_are_set
+ *
+ * returns  true if 'limits' limits the resources of the commands, false otherwise or if
+ *          'limits' is NULL
+ */
+bool schedr_limits_are_set(const Limits *const limits);
+
+/*
+ * schedr_limits_equal
+ *
+ * returns  true if 'a' and 'b' limit and place the commands the same way or are both NULL,
+ *          false otherwise
+ */
+bool schedr_limits_equal(const Limits *const a, const Limits *const b);
+
+/*
+ * schedr_limits_have_placement
+ *
+ * returns  true if 'limits' places the commands on CPUs or a NUMA node, or sets their nice
+ *          value or io priority, false otherwise or if 'limits' is NULL
+ */
+bool schedr_limits_have_placement(const Limits *const limits);
+
+/*
+ * schedr_limits_have_cpus
+ *
+ * returns  true if 'limits' keeps the commands to some CPUs, false otherwise or if 'limits'
+ *          is NULL
+ */
+bool schedr_limits_have_cpus(const Limits *const limits);
+
+/*
+ * schedr_limits_set_cpus
+ *
+ * Sets the CPUs in 'limits' to those in 'list', numbers and ranges of numbers
+ * separated by commas, like "0-3,8". Replaces any CPUs set before.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'list' is not a list of CPUs below SCHEDR_LIMITS_MAX_CPUS,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_set_cpus(Limits *const limits, const char *list);
+
+/*
+ * schedr_limits_set_numa_node
+ *
+ * Takes the memory of the commands from NUMA node 'node', and runs them on
+ * the CPUs of the node unless CPUs have been set in 'limits' already.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if there is no node 'node',
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_set_numa_node(Limits *const limits, int node);
+
+/*
+ * schedr_limits_get_cpus
+ *
+ * Sets the CPUs in 'limits' to those the calling thread may run on.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_FAILURE if they could not be read,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_get_cpus(Limits *const limits);
+
+/*
+ * schedr_limits_open_cgroup
+ *
+ * Takes over the cgroup v2 subtree at 'path', or the cgroup of the daemon if
+ * 'path' is NULL: moves the processes in it to its "daemon" leaf, enables the
+ * cpu, memory, io and pids controllers, those that are available, for its
+ * children and removes the empty leaves left by an earlier daemon. Does
+ * nothing if a subtree has already been opened.
+ *
+ * returns  SCHEDR_FAILURE if 'path' is not a cgroup v2 the daemon may manage, or
+ *              the kernel can not clone processes into a cgroup,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_open_cgroup(const char *path);
+
+/*
+ * schedr_limits_close_cgroup
+ *
+ * Removes the leaves that have been given back and forgets the subtree. The
+ * daemon stays in its leaf. Does nothing if no subtree is open.
+ */
+void schedr_limits_close_cgroup();
+
+/*
+ * schedr_limits_have_cgroup
+ *
+ * returns  true if a cgroup v2 subtree is open, false otherwise
+ */
+bool schedr_limits_have_cgroup();
+
+/*
+ * schedr_limits_create_leaf
+ *
+ * Creates a leaf cgroup for a run slot of the job named 'job_name', with the
+ * limits in 'limits', and opens it into 'leaf'. The name of the leaf is made
+ * up of the job name, with any character other than letters, digits, '-' and
+ * '_' replaced, and a number that keeps it unique.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_FAILURE if no subtree is open or the leaf could not be created,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_create_leaf(CgroupLeaf *const leaf, const char *job_name, const Limits *const limits);
+
+/*
+ * schedr_limits_remove_leaf
+ *
+ * Closes 'leaf' and removes it. A leaf that still holds processes, a command
+ * that is being stopped or processes it left behind, is removed later, once
+ * they have exited. Does nothing if the leaf has not been created.
+ */
+void schedr_limits_remove_leaf(CgroupLeaf *const leaf);
+
+/*
+ * schedr_limits_clone
+ *
+ * Works like fork(), but the child starts in the cgroup 'cgroup_fd' is open
+ * on, unless it is -1. With 'vfork', the caller is suspended until the child
+ * has executed another program or exited, like with vfork(), though the child
+ * gets a copy of the memory of the caller. The child may only call async
+ * signal safe functions before it executes another program.
+ *
+ * returns  the pid of the child in the caller and 0 in the child, or -1 with
+ *          errno set if no child could be created
+ */
+pid_t schedr_limits_clone(int cgroup_fd, bool vfork);
+
+/*
+ * schedr_limits_apply
+ *
+ * Sets the memory and pids limits in 'limits' with setrlimit(), for commands
+ * that are not started in a cgroup. Meant to be called in the child, before
+ * executing the command. Async signal safe.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_FAILURE if a limit could not be set,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_apply(const Limits *const limits);
+
+/*
+ * schedr_limits_place
+ *
+ * Moves the process 'pid', or the calling thread if it is 0, to the CPUs in
+ * 'limits' and sets its nice value and io priority. The NUMA nodes are only
+ * set for the calling thread, the memory policy of another process can not
+ * be changed. Threads started after inherit the placement. Meant to be called
+ * in the child, before executing the command, or by the daemon on itself.
+ * Async signal safe.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'limits' is NULL,
+ *          SCHEDR_FAILURE if any of it could not be set, the rest is set still,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_limits_place(pid_t pid, const Limits *const limits);
+
+#endif /* SCHEDR_LIMITS_H */
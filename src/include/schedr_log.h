@@ -0,0 +1,191 @@
+/*
+ * schedr_log.h
+ *
+ * Writes the output of every job to a single log file on disk. The event loop
+ * only copies the output into a buffer in memory, a writer thread of its own
+ * writes the buffer to the file in batches, so a slow disk never delays the
+ * jobs. Every line in the file is prefixed with the local time it was
+ * received, the name of its job and 'out' or 'err'.
+ *
+ * The file is rotated once it grows too large or too old: the current file is
+ * renamed to <path>.1, the one before it to <path>.2 and so on, and a new file
+ * is started. The jobs keep running while the file is rotated.
+ *
+ * When the disk can not keep up and the buffer is full, schedr_log_append()
+ * refuses more output until the writer has emptied the buffer, after which
+ * the descriptor of schedr_log_event_fd() becomes readable.
+ *
+ * schedr_log_append_lines() keeps the start of an unfinished line of a pipe
+ * back until the rest of it has been read, so the lines of commands running at
+ * the same time are not mixed up in the log.
+ */
+#ifndef SCHEDR_LOG_H
+#define SCHEDR_LOG_H
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool
+#include <sys/types.h>      // ssize_t
+#include <sys/uio.h>        // struct iovec
+
+#include "schedr_output.h"
+#include "schedr_status_codes.h"
+
+#define SCHEDR_LOG_DEFAULT_MAX_FILE_LEN (10 * 1024 * 1024)
+#define SCHEDR_LOG_DEFAULT_MAX_AGE_NS (24 * 3600 * 1000000000LL)
+#define SCHEDR_LOG_DEFAULT_KEEP 5
+#define SCHEDR_LOG_DEFAULT_BUFFER_LEN (1024 * 1024)
+#define SCHEDR_LOG_MIN_BUFFER_LEN (16 * 1024)
+
+// How long output may wait in the buffer before it is written
+#define SCHEDR_LOG_FLUSH_INTERVAL_NS 100000000LL
+
+// Lines kept back by schedr_log_append_lines() are written in pieces of this length at most
+#define SCHEDR_LOG_MAX_LINE_LEN 4096
+
+/*
+ * When the log file is rotated. A file is rotated once writing the next batch
+ * would make it larger than 'max_file_len' bytes, or once it was started
+ * 'max_age_ns' or more ago. 0 turns either limit off. 'keep' rotated files are
+ * kept, older ones are removed.
+ */
+struct LogRotation
+{
+    size_t max_file_len;
+    int64_t max_age_ns;
+    int keep;
+};
+
+typedef struct LogRotation LogRotation;
+
+struct LogStats
+{
+    uint64_t bytes_written;
+    uint64_t batches;           // Times the buffer was written to the file
+    uint64_t rotations;
+    uint64_t stalls;            // Times output was refused because the buffer was full
+    uint64_t write_errors;      // Batches that could not be written, their output is lost
+};
+
+typedef struct LogStats LogStats;
+
+/*
+ * The start of a line of output that has not been written to the log yet.
+ * 'kept' is allocated once a line is first kept back, and is up to the owner
+ * to free.
+ */
+struct LogLine
+{
+    char *kept;
+    size_t kept_len;
+};
+
+typedef struct LogLine LogLine;
+
+#ifdef TEST
+void schedr_log_set_writer(ssize_t (*writev_func)(int fd, const struct iovec *iov, int iovcnt));
+void schedr_log_reset_writer();
+#endif
+
+/*
+ * schedr_log_open
+ *
+ * Opens the log file at 'path' for appending, creating it if it does not
+ * exist, and starts the writer thread. Up to 'buffer_len' bytes of output are
+ * held in memory while waiting to be written.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'path' or 'rotation' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the log is already open, 'rotation' has a negative limit or
+ *                                        'buffer_len' is < SCHEDR_LOG_MIN_BUFFER_LEN,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'path' is too long to add the number of a rotated file to,
+ *          SCHEDR_ERROR_PERMISSION_DENIED if the program did not have permission to open the file,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the buffers could not be allocated,
+ *          SCHEDR_FAILURE if the file could not be opened or the thread started for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_log_open(const char *path, const LogRotation *const rotation, size_t buffer_len);
+
+/*
+ * schedr_log_close
+ *
+ * Writes what is left in the buffer, stops the writer thread and closes the
+ * log file.
+ */
+void schedr_log_close();
+
+bool schedr_log_is_open();
+
+/*
+ * schedr_log_append
+ *
+ * Copies 'len' bytes of output 'job_name' wrote to 'stream' at 'time_ns',
+ * nanoseconds since the epoch, into the buffer. The output should end at the
+ * end of a line, or the rest of the line ends up on a line of its own, since
+ * the lines of the other jobs are written in between.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_name' or 'data' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the log is not open or 'stream' is not OutputStdout or OutputStderr,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if the buffer does not have room for the output, in which case
+ *                                       nothing is copied,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_log_append(const char *job_name, OutputStream stream, int64_t time_ns, const char *data, size_t len);
+
+/*
+ * schedr_log_append_lines
+ *
+ * Appends the whole lines of the start of 'line' followed by 'len' bytes at
+ * 'data', and keeps the rest in 'line' until the line is finished. A line
+ * reaching SCHEDR_LOG_MAX_LINE_LEN is appended in pieces. The
+ * SCHEDR_LOG_MAX_LINE_LEN bytes before 'data' have to be free, the start of
+ * the line is put there so the output is only copied into the buffer. A line
+ * that can not be kept for lack of memory is lost to the log. Does nothing if
+ * the log is not open.
+ */
+void schedr_log_append_lines(LogLine *const line, const char *job_name, OutputStream stream, int64_t time_ns, char *data, 
+                             size_t len);
+
+/*
+ * schedr_log_finish_lines
+ *
+ * Appends the start of a line kept in 'line' as it is, once the pipe it was
+ * read from is closed.
+ */
+void schedr_log_finish_lines(LogLine *const line, const char *job_name, OutputStream stream, int64_t time_ns);
+
+/*
+ * schedr_log_has_room
+ *
+ * Tells whether the buffer has room for 'len' more bytes of output of a job
+ * with a name of 'name_len' characters. If it does not, it counts as a stall,
+ * and the descriptor of schedr_log_event_fd() becomes readable once the
+ * buffer has been emptied.
+ */
+bool schedr_log_has_room(size_t name_len, size_t len);
+
+/*
+ * schedr_log_event_fd
+ *
+ * Returns a descriptor that becomes readable when the buffer has room again
+ * after it was full, or -1 if the log is not open. It is read by
+ * schedr_log_clear_event().
+ */
+int schedr_log_event_fd();
+void schedr_log_clear_event();
+
+/*
+ * schedr_log_flush
+ *
+ * Waits until the writer has written everything appended so far.
+ */
+void schedr_log_flush();
+
+/*
+ * schedr_log_get_stats
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'stats' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_log_get_stats(LogStats *const stats);
+
+#endif /* SCHEDR_LOG_H */
@@ -0,0 +1,121 @@
+/*
+ * schedr_matcher.h
+ *
+ * Matches lines against many POSIX extended regular expressions at once,
+ * scanning every line a single time however many patterns there are. Every
+ * pattern is searched for the longest run of literal characters that any
+ * line it matches has to contain, like "wlan0: " in
+ * "wlan0: (connected|disconnected)$". The literals of all patterns are
+ * compiled into one Aho-Corasick automaton, which finds every literal in a
+ * line in one pass, and only the patterns whose literal is in the line are
+ * confirmed with regexec(). Patterns without such a literal, like "a|b" or
+ * "[0-9]+", are confirmed on every line.
+ *
+ * The automaton is built again the first time a line is matched after
+ * patterns have been added or removed, so adding many patterns in a row costs
+ * a single build.
+ */
+#ifndef SCHEDR_MATCHER_H
+#define SCHEDR_MATCHER_H
+
+#include <stddef.h>     // size_t
+#include <stdint.h>     // uint8_t, uint32_t
+#include <stdbool.h>    // bool
+#include <regex.h>      // regex_t
+
+#include "schedr_status_codes.h"
+
+#define SCHEDR_MATCHER_MAX_PATTERN_LEN 255
+
+struct MatcherPattern
+{
+    regex_t regex;
+    void *data;
+    size_t literal_len;                                 // 0 if the pattern is confirmed on every line
+    char literal[SCHEDR_MATCHER_MAX_PATTERN_LEN + 1];
+    int next_at_state;                                  // Next pattern whose literal ends in the same state, or -1
+    uint32_t seen_line;                                 // Last line the pattern was confirmed on
+};
+
+typedef struct MatcherPattern MatcherPattern;
+
+struct Matcher
+{
+    MatcherPattern *patterns;
+    int len;
+    int capacity;
+    bool stale;                 // The automaton has to be built again
+    int states;
+    int classes;                // Bytes used in the literals get a class of their own, every other byte is class 0
+    uint8_t class_of[256];
+    int *transitions;           // 'classes' next states for every state
+    int *first_pattern;         // The first pattern whose literal ends in every state, or -1
+    int *output_link;           // The nearest state a literal ends in, by failure links, for every state, or -1
+    int *unanchored;            // The patterns without a literal
+    int unanchored_len;
+    uint32_t line;
+};
+
+typedef struct Matcher Matcher;
+
+#ifdef TEST
+size_t schedr_matcher_literal_of(const char *pattern, char literal[SCHEDR_MATCHER_MAX_PATTERN_LEN + 1]);
+#endif
+
+/*
+ * schedr_matcher_init
+ *
+ * Initializes a matcher without patterns.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'matcher' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_matcher_init(Matcher *const matcher);
+
+/*
+ * schedr_matcher_destroy
+ *
+ * Frees the patterns and the automaton of a matcher, leaving it without
+ * patterns.
+ */
+void schedr_matcher_destroy(Matcher *const matcher);
+
+/*
+ * schedr_matcher_add
+ *
+ * Adds 'pattern' to the matcher, which gives 'data' to the handler of
+ * schedr_matcher_match() for the lines the pattern matches.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'matcher' or 'pattern' is NULL,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'pattern' is longer than SCHEDR_MATCHER_MAX_PATTERN_LEN,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'pattern' is not a valid extended regular expression,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if there was no room for the pattern,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_matcher_add(Matcher *const matcher, const char *pattern, void *data);
+
+/*
+ * schedr_matcher_remove
+ *
+ * Removes every pattern added with 'data' from the matcher.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'matcher' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if no pattern was added with 'data',
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_matcher_remove(Matcher *const matcher, const void *data);
+
+/*
+ * schedr_matcher_match
+ *
+ * Calls 'handler' with the data of every pattern that matches 'line', once
+ * per pattern, in no particular order. 'line' is 'line_len' characters long
+ * and ends with a '\0'. The handler must not add or remove patterns.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if an argument is NULL,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the automaton could not be built,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_matcher_match(Matcher *const matcher, const char *line, size_t line_len, void (*handler)(void *data));
+
+#endif /* SCHEDR_MATCHER_H */
@@ -0,0 +1,82 @@
+/*
+ * schedr_metrics.h
+ *
+ * Serves the metrics of the daemon in the Prometheus text exposition format,
+ * over HTTP on a Unix socket, and on a port of the loopback interface if one
+ * is given. Every request is answered with the metrics, whatever its path,
+ * after which the daemon closes the connection, so the socket can be scraped
+ * with
+ *
+ *     curl --unix-socket $HOME/.config/schedr/metrics.sock http://localhost/metrics
+ *
+ * The requests are served from schedr_scheduler_run() like those of the
+ * control socket. A scrape is rendered from what the loop already keeps in
+ * memory, and connections are read from and written to without ever blocking,
+ * so a slow or stuck scraper does not delay the jobs. At most
+ * SCHEDR_METRICS_MAX_CONNECTIONS are served at the same time, further ones are
+ * closed right away.
+ *
+ * Metrics:
+ *  schedr_job_runs_total{job}              commands started
+ *  schedr_job_failures_total{job}          runs that failed
+ *  schedr_job_skipped_runs_total{job}      runs dropped since they were due while the job was running
+ *  schedr_job_queued_runs_total{job}       runs held until the running command had finished
+ *  schedr_job_lag_seconds{job}             histogram of how late the runs were started
+ *  schedr_job_spawn_seconds{job}           histogram of how long starting the commands took
+ *  schedr_job_runtime_seconds{job}         histogram of how long the commands ran
+ *  schedr_commands_in_flight               commands running
+ *  schedr_run_queue_depth                  runs waiting for a free slot
+ *  process_resident_memory_bytes           resident set size of the daemon
+ *  process_open_fds                        file descriptors open in the daemon
+ */
+#ifndef SCHEDR_METRICS_H
+#define SCHEDR_METRICS_H
+
+#include <stdio.h>      // FILE
+
+#include "schedr_job_index.h"
+#include "schedr_status_codes.h"
+
+#define SCHEDR_METRICS_MAX_CONNECTIONS 16
+#define SCHEDR_METRICS_MAX_REQUEST_LEN 4096
+#define SCHEDR_METRICS_MAX_PORT 65535
+
+/*
+ * schedr_metrics_open
+ *
+ * Creates the metrics socket at 'socket_path', replacing any socket a daemon
+ * that did not shut down cleanly left behind, and also listens on 'port' of
+ * 127.0.0.1 unless 'port' is 0. Serves the metrics of the jobs in 'jobs', as
+ * they are at the time of every scrape, from schedr_scheduler_run(). Only the
+ * user running the daemon may connect to the Unix socket.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'socket_path' or 'jobs' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'port' is < 0 or > SCHEDR_METRICS_MAX_PORT,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'socket_path' is too long for a Unix socket,
+ *          SCHEDR_ERROR_PERMISSION_DENIED if the program did not have permission to create the socket or bind the port,
+ *          SCHEDR_FAILURE if the socket could not be created or the port not bound for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_metrics_open(const char *socket_path, int port, const JobIndex *const jobs);
+
+/*
+ * schedr_metrics_close
+ *
+ * Closes the metrics socket, the port and every connection to them, and
+ * removes the socket file.
+ */
+void schedr_metrics_close();
+
+/*
+ * schedr_metrics_write
+ *
+ * Writes the metrics of the jobs in 'jobs' and of the daemon to 'out', in the
+ * Prometheus text exposition format.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'jobs' or 'out' is NULL,
+ *          SCHEDR_FAILURE if the metrics could not be written,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_metrics_write(const JobIndex *const jobs, FILE *out);
+
+#endif /* SCHEDR_METRICS_H */
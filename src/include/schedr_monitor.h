@@ -0,0 +1,78 @@
+/*
+ * schedr_monitor.h
+ *
+ * Runs the monitors of jobs with a trigger, see schedr_job.h. A monitor is a
+ * command that keeps running, like ``nmcli device monitor``, whose output is
+ * read by schedr_scheduler_run() without ever blocking and split into lines.
+ * Every line is matched against the pattern of the job, which is compiled
+ * once when the monitor is started, and the job is run right away on a match,
+ * see schedr_scheduler_run_job_now(), unless it is paused or stopped.
+ *
+ * Jobs with the same monitor command share a single monitor, which is started
+ * with the first of them and killed once the last one is stopped. The
+ * patterns of all of them are matched together, see schedr_matcher.h, so
+ * every line is scanned once however many jobs it may trigger.
+ *
+ * The monitor is read as soon as it has written something, so the job is
+ * started within the same iteration of the loop as the line was read in,
+ * however many lines the monitor writes. Lines longer than
+ * SCHEDR_MONITOR_MAX_LINE_LEN are matched on their first
+ * SCHEDR_MONITOR_MAX_LINE_LEN characters.
+ *
+ * A monitor that exits is started again right away, unless it exited within
+ * SCHEDR_MONITOR_MIN_UPTIME_NS of being started. Then it is started again
+ * after a backoff that doubles every time it exits right away, see
+ * schedr_retry.h, and every few minutes once it has done so a few times in a
+ * row. Meanwhile the job only runs on its interval, if it has one.
+ */
+#ifndef SCHEDR_MONITOR_H
+#define SCHEDR_MONITOR_H
+
+#include <stdbool.h>    // bool
+#include <stdint.h>     // int64_t
+
+#include "schedr_job.h"
+#include "schedr_status_codes.h"
+
+#define SCHEDR_MONITOR_MAX_LINE_LEN 4096
+#define SCHEDR_MONITOR_MIN_UPTIME_NS 1000000000LL
+
+#ifdef TEST
+int schedr_monitor_count();
+void schedr_monitor_set_restart_backoff(int64_t backoff_ns);
+void schedr_monitor_reset_restart_backoff();
+#endif
+
+/*
+ * schedr_monitor_start
+ *
+ * Starts the monitor of 'job_p', unless another job has started the same
+ * monitor command already, and reads it from schedr_scheduler_run(). The
+ * job has to be started in EventLoop mode for the matches to run it.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job has no trigger, its pattern does not compile or its monitor is
+ *                                        started already,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the job could not be added to the monitor,
+ *          SCHEDR_FAILURE if the monitor could not be started or allocated,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_monitor_start(Job *const job_p);
+
+/*
+ * schedr_monitor_stop
+ *
+ * Stops matching the output of the monitor of 'job_p' for the job. The
+ * monitor is sent SIGTERM and no longer read once no other job shares it.
+ * Does nothing if the job has no monitor started.
+ */
+void schedr_monitor_stop(const Job *const job_p);
+
+/*
+ * schedr_monitor_is_running
+ *
+ * returns  true if the monitor of 'job_p' is running, false otherwise
+ */
+bool schedr_monitor_is_running(const Job *const job_p);
+
+#endif /* SCHEDR_MONITOR_H */
@@ -0,0 +1,202 @@
+/*
+ * schedr_output.h
+ *
+ * Keeps the latest output of a job in memory. The output is stored line by
+ * line in a ring buffer of a fixed size, together with when each line was
+ * received and whether it was written to stdout or stderr. The oldest lines
+ * are dropped to make room for new ones, so a ring never grows however much
+ * its job writes.
+ *
+ * The module also reads the pipes the commands of the event loop write to,
+ * into the ring of their job and the log. They are read as they become
+ * readable, or through the io_uring of LoopUring once it has been handed over
+ * with schedr_output_start_ring(). While the log is full they are not read,
+ * which slows the commands down to the pace of the disk.
+ */
+#ifndef SCHEDR_OUTPUT_H
+#define SCHEDR_OUTPUT_H
+
+#include <stddef.h>     // size_t
+#include <stdbool.h>    // bool
+#include <stdint.h>     // int64_t, uint64_t
+#include <stdio.h>      // FILE
+
+#include "schedr_status_codes.h"
+#include "schedr_job.h"
+#include "schedr_uring.h"
+
+#define SCHEDR_OUTPUT_DEFAULT_RING_LEN (16 * 1024)
+#define SCHEDR_OUTPUT_MIN_RING_LEN 1024
+
+enum OutputStream
+{
+    OutputStdout = 0,
+    OutputStderr = 1
+};
+
+typedef enum OutputStream OutputStream;
+
+/*
+ * 'used' bytes of records are kept in 'data', starting with the oldest one at
+ * 'start' and wrapping around at 'capacity'. The newest record starts at
+ * 'last', and is continued by the next output if 'line_open' is set.
+ */
+struct OutputRing
+{
+    char *data;
+    size_t capacity;
+    size_t start;
+    size_t used;
+    size_t last;
+    bool line_open;
+    uint64_t dropped_bytes;     // Output dropped to make room for newer output
+};
+
+typedef struct OutputRing OutputRing;
+
+/*
+ * schedr_output_init
+ *
+ * Allocates a ring keeping up to 'capacity' bytes of output, bookkeeping
+ * included.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'capacity' is < SCHEDR_OUTPUT_MIN_RING_LEN,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the buffer could not be allocated,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_output_init(OutputRing *const ring, size_t capacity);
+
+/*
+ * schedr_output_destroy
+ *
+ * Frees the buffer of the ring.
+ */
+void schedr_output_destroy(OutputRing *const ring);
+
+/*
+ * schedr_output_append
+ *
+ * Stores 'len' bytes of output written to 'stream' at 'time_ns', nanoseconds
+ * since the epoch, dropping the oldest output that no longer fits. Every line
+ * is stored on its own, a line that is not finished is continued by the next
+ * output. Only the end of a line longer than the ring is kept.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' or 'data' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'stream' is not OutputStdout or OutputStderr,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_output_append(OutputRing *const ring, OutputStream stream, int64_t time_ns, const char *data, size_t len);
+
+/*
+ * schedr_output_write
+ *
+ * Writes the output kept in the ring to 'fp', oldest first, one line at a
+ * time prefixed with the local time it was received and 'out' or 'err'.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' or 'fp' is NULL,
+ *          SCHEDR_FAILURE if the output could not be written,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_output_write(const OutputRing *const ring, FILE *fp);
+
+/*
+ * schedr_output_open_pipes
+ *
+ * Creates the pipes stdout and stderr of a command are connected to. 'fds' is
+ * filled with the descriptors the command gets and 'read_fds' with the read
+ * ends of the pipes, which do not block unless they are read through the ring.
+ *
+ * returns  false if the pipes could not be created, the command then writes to the stdout and stderr
+ *          of the daemon, true otherwise
+ */
+bool schedr_output_open_pipes(int fds[3], int read_fds[2]);
+
+/*
+ * schedr_output_watch_pipe
+ *
+ * Reads the read end 'fd' of a pipe of a command of 'job_p' whenever the
+ * command has written to it, until every process writing to it has closed it.
+ *
+ * returns  false if it can not be watched, the pipe is closed then, true otherwise
+ */
+bool schedr_output_watch_pipe(Job *const job_p, OutputStream stream, int fd);
+
+/*
+ * schedr_output_drain_pipe
+ *
+ * Reads what a command that has just been reaped left in the pipe 'fd'. A
+ * command that writes less than a pipe holds may well finish before the loop
+ * gets to its pipes, and the next run of its job would be started while the
+ * output of this one is still waiting. Does nothing with the ring, which has
+ * a read in flight on every pipe that completes with what is left.
+ */
+void schedr_output_drain_pipe(int fd);
+
+bool schedr_output_has_pipes();
+
+/*
+ * schedr_output_is_paused
+ *
+ * Tells whether pipes are not read because the log is full. No commands
+ * should be started until it has room again.
+ */
+bool schedr_output_is_paused();
+
+/*
+ * schedr_output_start_ring
+ *
+ * Reads the pipes watched from now on through 'ring', with every buffer of
+ * the pool they read into handed to the kernel.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if a ring has been started already or pipes are watched,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the pool could not be allocated,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_output_start_ring(Uring *const ring);
+
+/*
+ * schedr_output_stop_ring
+ *
+ * Submits the pipes queued to be closed and waits for the reads of the pipes
+ * closed while they were in flight, which read into the pool, before freeing
+ * it. The ring can be taken down after.
+ */
+void schedr_output_stop_ring();
+
+/*
+ * schedr_output_read_completed
+ *
+ * Handles a completion of the ring whose 'user_data' is SCHEDR_URING_TAGS or
+ * more, which are the reads of the pipes, and reads the pipe again.
+ */
+void schedr_output_read_completed(uint64_t user_data, int res, unsigned flags);
+
+/*
+ * schedr_output_set_len
+ *
+ * Sets the length of the rings created for jobs from now on.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'len' is < SCHEDR_OUTPUT_MIN_RING_LEN,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_output_set_len(size_t len);
+
+/*
+ * schedr_output_of
+ *
+ * returns  the ring of a job, or NULL if none of its commands has written anything
+ */
+const OutputRing *schedr_output_of(const Job *const job_p);
+
+/*
+ * schedr_output_remove_job
+ *
+ * Logs the rest of the output of the pipes of a job, closes them and frees
+ * its ring. If 'job_p' is NULL, does so for every job, stops waiting for the
+ * log and sets the length of the rings back to the default.
+ */
+void schedr_output_remove_job(const Job *const job_p);
+
+#endif /* SCHEDR_OUTPUT_H */
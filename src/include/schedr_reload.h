@@ -0,0 +1,88 @@
+/*
+ * schedr_reload.h
+ *
+ * Applies a reloaded configuration to the jobs the daemon is running, instead
+ * of restarting it. Every job of the configuration is matched with the running
+ * job of the same name and their fingerprints are compared, see
+ * schedr_job_fingerprint(), so only the jobs that changed are touched:
+ *
+ *  - a job that is not running yet is started,
+ *  - a running job that is no longer configured is removed, its running
+ *    commands are sent SIGTERM,
+ *  - a job that changed is updated where it runs, keeping its timer, its
+ *    running commands and its counters, see schedr_scheduler_update_job(), or
+ *    started again if its limits or the number of commands it may run at the
+ *    same time changed,
+ *  - a job that did not change is left alone.
+ *
+ * Matching goes through the index of the jobs, so a reload takes time in
+ * proportion to the number of jobs and not to its square.
+ *
+ * The reload is triggered by SIGHUP, see
+ * schedr_scheduler_set_reload_handler(), or when the configuration file is
+ * written, which is watched with inotify from schedr_scheduler_run().
+ */
+#ifndef SCHEDR_RELOAD_H
+#define SCHEDR_RELOAD_H
+
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+#include "schedr_status_codes.h"
+
+/*
+ * What a reload did to the jobs.
+ */
+struct ReloadStats
+{
+    int started;        // Jobs that were not running before
+    int removed;        // Jobs that are no longer configured
+    int updated;        // Jobs that changed and were updated where they run
+    int restarted;      // Jobs that changed and were started again
+    int unchanged;
+    int failed;         // Jobs that could not be started or indexed
+};
+
+typedef struct ReloadStats ReloadStats;
+
+/*
+ * schedr_reload_apply
+ *
+ * Makes the jobs in 'index' the 'jobs_len' jobs in 'jobs', which are
+ * prepared to be started, splay offsets and all. Jobs that are started or
+ * started again are copied into jobs of their own owned by the index, so
+ * 'jobs' may be freed afterwards. A job of 'jobs' whose name is taken by an
+ * earlier one is ignored. Jobs removed from the index that it does not own
+ * are not freed. The jobs have to be started in EventLoop mode.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'index', 'jobs' or 'stats' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'jobs_len' is < 0 or two jobs have the same name, no job is touched then,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the jobs could not be matched,
+ *          SCHEDR_FAILURE if a job could not be started or indexed, in which case the other jobs are reloaded,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_reload_apply(JobIndex *const index, const Job jobs[], int jobs_len, ReloadStats *const stats);
+
+/*
+ * schedr_reload_watch
+ *
+ * Makes schedr_scheduler_run() call 'reload' whenever the file at
+ * 'config_path' has been written or replaced. The directory of the file is
+ * watched, so editors that save to a new file and rename it over the old one
+ * are noticed too.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if an argument is NULL,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if 'config_path' is longer than PATH_MAX,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'config_path' does not end with a file name,
+ *          SCHEDR_FAILURE if the directory could not be watched,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_reload_watch(const char *config_path, void (*reload)());
+
+/*
+ * schedr_reload_unwatch
+ *
+ * Stops watching the configuration file. Does nothing if it is not watched.
+ */
+void schedr_reload_unwatch();
+
+#endif /* SCHEDR_RELOAD_H */
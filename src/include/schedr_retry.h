@@ -0,0 +1,109 @@
+/*
+ * schedr_retry.h
+ *
+ * Decides when a job whose command failed runs again, so a job does not die
+ * on its first failure, nor hammer a dependency that is down.
+ *
+ * A failed run is retried after a backoff that starts at 'backoff_ns' and
+ * doubles with every failure in a row, up to 'max_backoff_ns'. A random part
+ * of up to 'jitter_percent' is taken off every backoff, so jobs failing on the
+ * same dependency do not retry in lockstep. Once 'max_attempts' retries in a
+ * row have failed, the circuit breaker opens: the job is left alone for
+ * 'cooldown_ns', after which a single trial run is made. A run that succeeds
+ * closes the breaker and starts the backoff over, a failed trial opens it
+ * again. Without a cooldown the job is given up on instead of opening the
+ * breaker, so the default policy, without any retries, gives up on the first
+ * failure.
+ */
+#ifndef SCHEDR_RETRY_H
+#define SCHEDR_RETRY_H
+
+#include <stdint.h>     // int64_t, uint64_t
+#include <stdbool.h>    // bool
+
+#include "schedr_status_codes.h"
+
+#define SCHEDR_RETRY_ACTION_VALUES 4
+#define SCHEDR_RETRY_DEFAULT_BACKOFF_NS 1000000000LL
+#define SCHEDR_RETRY_DEFAULT_MAX_BACKOFF_NS (300 * 1000000000LL)
+#define SCHEDR_RETRY_DEFAULT_JITTER_PERCENT 20
+
+/*
+ * What to do after a run has been recorded.
+ *
+ * RetryOnSchedule:     the run succeeded, the job runs again according to its timing.
+ * RetryAfterBackoff:   the run failed and is retried after the backoff.
+ * RetryAfterCooldown:  the breaker is open, a trial run is made after the cooldown.
+ * RetryGiveUp:         the job is to be stopped.
+ */
+enum RetryAction
+{
+    RetryOnSchedule = 0,
+    RetryAfterBackoff = 1,
+    RetryAfterCooldown = 2,
+    RetryGiveUp = 3
+};
+
+typedef enum RetryAction RetryAction;
+
+struct RetryPolicy
+{
+    int max_attempts;           // Retries in a row before the breaker opens
+    int64_t backoff_ns;         // Backoff after the first failure
+    int64_t max_backoff_ns;
+    int jitter_percent;
+    int64_t cooldown_ns;        // 0 if the job is given up on instead of opening the breaker
+};
+
+typedef struct RetryPolicy RetryPolicy;
+
+struct RetryState
+{
+    uint64_t failures;          // Failed runs in total
+    int failures_in_row;        // Failed runs since the last one that succeeded
+    int64_t backoff_ns;         // How long the job waits before it runs again, 0 if it runs on its schedule
+    bool breaker_open;          // Set from when the breaker opens until a trial run succeeds
+    uint64_t breaker_trips;     // Times the breaker has opened after a run of failed retries
+};
+
+typedef struct RetryState RetryState;
+
+#ifdef TEST
+void schedr_retry_set_random(uint64_t (*random_func)(void));
+void schedr_retry_reset_random();
+#endif
+
+/*
+ * schedr_retry_init
+ *
+ * Initializes a policy that gives up on the first failure, with the default
+ * backoff, cap and jitter for when retries are added, and a state without
+ * any failures.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'policy' or 'state' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_retry_init(RetryPolicy *const policy, RetryState *const state);
+
+/*
+ * schedr_retry_validate
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'policy' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'max_attempts' or 'cooldown_ns' is < 0, 'backoff_ns' is < 1,
+ *              'max_backoff_ns' is < 'backoff_ns' or 'jitter_percent' is < 0 or > 100,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_retry_validate(const RetryPolicy *const policy);
+
+/*
+ * schedr_retry_record
+ *
+ * Records the outcome of a run in 'state', and decides what to do next.
+ * 'delay_ns' is set to how long the job waits before it runs again with
+ * RetryAfterBackoff and RetryAfterCooldown, and to 0 otherwise.
+ *
+ * returns  the action to take, RetryGiveUp if any argument is NULL
+ */
+RetryAction schedr_retry_record(const RetryPolicy *const policy, RetryState *const state, bool failed, int64_t *delay_ns);
+
+#endif /* SCHEDR_RETRY_H */
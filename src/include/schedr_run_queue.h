@@ -0,0 +1,153 @@
+/*
+ * schedr_run_queue.h
+ *
+ * A first in, first out queue of runs waiting for a free slot. The queue has
+ * a number of slots, and every run occupies as many of them as its weight
+ * while it is running. A run only leaves the queue once every run queued
+ * before it has left and there are enough free slots for it, so heavy runs
+ * are not starved by lighter ones.
+ *
+ * Nodes are allocated by the caller, so queueing and dequeueing never
+ * allocates. The queue keeps statistics on how deep it gets and how long runs
+ * wait in it, to help choosing the number of slots.
+ */
+#ifndef SCHEDR_RUN_QUEUE_H
+#define SCHEDR_RUN_QUEUE_H
+
+#include <stdint.h>     // int64_t, uint64_t
+#include <stdbool.h>    // bool
+
+#include "schedr_status_codes.h"
+
+struct RunQueueNode
+{
+    struct RunQueueNode *next;
+    struct RunQueueNode *prev;
+    int weight;
+    int64_t queued_at_ns;
+    bool queued;
+    void *data;
+};
+
+typedef struct RunQueueNode RunQueueNode;
+
+struct RunQueueStats
+{
+    int depth;                  // Runs currently waiting
+    int max_depth;              // Most runs that have been waiting at the same time
+    int slots_in_use;
+    int max_slots;              // 0 if the number of slots is unlimited
+    uint64_t runs_admitted;     // Runs that have left the queue
+    int64_t total_wait_ns;      // Time the admitted runs have waited, in total
+    int64_t max_wait_ns;        // Longest time an admitted run has waited
+};
+
+typedef struct RunQueueStats RunQueueStats;
+
+struct RunQueue
+{
+    RunQueueNode head;
+    RunQueueStats stats;
+};
+
+typedef struct RunQueue RunQueue;
+
+/*
+ * schedr_run_queue_init
+ *
+ * Initializes an empty queue with 'max_slots' slots, or an unlimited number of
+ * slots if 'max_slots' is 0.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'max_slots' is < 0,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_init(RunQueue *const queue, int max_slots);
+
+/*
+ * schedr_run_queue_set_max_slots
+ *
+ * Changes the number of slots. Runs that already occupy slots keep them.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'max_slots' is < 0,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_set_max_slots(RunQueue *const queue, int max_slots);
+
+/*
+ * schedr_run_queue_node_init
+ *
+ * Initializes a node that is not queued, carrying 'data' for the caller.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'node' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_node_init(RunQueueNode *const node, void *data);
+
+/*
+ * schedr_run_queue_push
+ *
+ * Puts 'node' last in the queue, as a run that needs 'weight' slots and became
+ * due at 'now_ns'. A weight larger than the number of slots is lowered to it,
+ * so the run can still start once it has every slot.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' or 'node' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'node' is already queued or 'weight' is < 1,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_push(RunQueue *const queue, RunQueueNode *const node, int weight, int64_t now_ns);
+
+/*
+ * schedr_run_queue_pop
+ *
+ * Takes the first node out of the queue if there are enough free slots for it,
+ * and marks its slots as used until they are released.
+ *
+ * returns  the node, or NULL if the queue is empty or the first run has to wait
+ */
+RunQueueNode *schedr_run_queue_pop(RunQueue *const queue, int64_t now_ns);
+
+/*
+ * schedr_run_queue_requeue
+ *
+ * Puts a node that was just popped back first in the queue and frees its
+ * slots, for a run that could not be started after all. The time it has
+ * waited is kept.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' or 'node' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'node' is queued,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_requeue(RunQueue *const queue, RunQueueNode *const node);
+
+/*
+ * schedr_run_queue_release
+ *
+ * Frees the 'slots' slots of a run that has finished, which is the weight of
+ * its node once it has been popped.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'slots' is < 0,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_release(RunQueue *const queue, int slots);
+
+/*
+ * schedr_run_queue_remove
+ *
+ * Takes 'node' out of the queue without running it, if it is queued.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'queue' or 'node' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_run_queue_remove(RunQueue *const queue, RunQueueNode *const node);
+
+/*
+ * schedr_run_queue_can_pop
+ *
+ * Tells if schedr_run_queue_pop() would return a node.
+ */
+bool schedr_run_queue_can_pop(const RunQueue *const queue);
+
+#endif /* SCHEDR_RUN_QUEUE_H */
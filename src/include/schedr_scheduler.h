@@ -8,38 +8,312 @@
 
 #include <schedr_job.h>
 #include <schedr_status_codes.h>
+#include <schedr_run_queue.h>
+#include <schedr_output.h>
+#include <schedr_histogram.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCHEDR_SCHEDULER_MODE_VALUES 2
+#define SCHEDR_SCHEDULER_LOOP_BACKEND_VALUES 2
 
 extern char **environ;
 
+/*
+ * Supervised: every job gets a process of its own which runs the command and 
+ *             sleeps between the runs.
+ * EventLoop:  a single process, running schedr_scheduler_run(), keeps track of 
+ *             when every job is due and only forks to run the commands.
+ */
+enum SchedulerMode
+{
+    Supervised = 0,
+    EventLoop = 1
+};
+
+typedef enum SchedulerMode SchedulerMode;
+
+/*
+ * How the EventLoop waits.
+ *
+ * LoopEpoll: the loop waits in epoll for its timer, signals and pipes, and 
+ *            reads each of them that is ready with a system call of its own.
+ * LoopUring: the loop keeps reads of its signals and pipes, and a timeout at
+ *            the next deadline, in flight on an io_uring, and submits and
+ *            waits for them in a single system call per iteration. Requires 
+ *            Linux 5.7 or later.
+ */
+enum LoopBackend
+{
+    LoopEpoll = 0,
+    LoopUring = 1
+};
+
+typedef enum LoopBackend LoopBackend;
+
 #ifdef TEST
 #include <sys/types.h>
+#include <stdbool.h>
+#include <time.h>
 
 void schedr_scheduler_set_exec(int (*exec_func)(const char *fn, char *const argv[], char *const envp[]));
 void schedr_scheduler_reset_exec();
 void schedr_scheduler_set_forker(int (*fork_func)(void));
 void schedr_scheduler_reset_forker();
-void schedr_scheduler_set_sleeper(unsigned int (*sleep_func)(unsigned int seconds));
+void schedr_scheduler_set_sleeper(int (*sleep_func)(clockid_t clock_id, int flags, 
+                                                   const struct timespec *request, 
+                                                   struct timespec *remain));
 void schedr_scheduler_reset_sleeper();
 void schedr_scheduler_kill_children();
 void schedr_scheduler_associate_pid_with_jod(Job *const job, pid_t pid);
+bool schedr_scheduler_job_is_started(const Job *const job);
+Status schedr_scheduler_run_once();
 #endif
 
+/*
+ * schedr_scheduler_set_mode
+ *
+ * Sets how started jobs are run. Defaults to Supervised. The mode can not be 
+ * changed while there are started jobs.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'mode' is < 0 or >= SCHEDR_SCHEDULER_MODE_VALUES 
+ *              or if there are started jobs,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_set_mode(SchedulerMode mode);
+
+/*
+ * schedr_scheduler_set_loop_backend
+ *
+ * Sets how the EventLoop waits. Defaults to LoopEpoll. The backend can not be
+ * changed while there are started jobs or commands whose output is still read.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'backend' is < 0 or >= SCHEDR_SCHEDULER_LOOP_BACKEND_VALUES 
+ *              or if there are started jobs or output pipes,
+ *          SCHEDR_ERROR_NOT_IMPLEMENTED if the kernel does not support io_uring, the loop stays on LoopEpoll then,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the buffers of the ring could not be allocated,
+ *          SCHEDR_FAILURE if the ring could not be set up for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_set_loop_backend(LoopBackend backend);
+
 /*
  * schedr_scheduler_start_job
  *
  * Starts a new process that manages the provided job, executing it with the
- * interval provided in the job.
+ * interval and timing provided in the job. The first run is delayed by the splay offset
+ * of the job. In EventLoop mode the job is instead scheduled 
+ * to run on the next iteration of schedr_scheduler_run(), and its runs follow the overlap
+ * policy of the job. A supervised job always waits for its running command. In
+ * both modes a failed run is retried according to the retry policy of the job,
+ * and the job is stopped once the policy gives up on it. A job with a trigger
+ * has its monitor started too, see schedr_monitor.h, and only runs on a timer
+ * if it has an interval. Triggers need EventLoop mode.
  *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if the job is already started, or has a trigger and is not started in
+ *                                        EventLoop mode,
+ *          SCHEDR_ERROR_FORK_FAILED if the process managing the job could not be started,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the job could not be registered,
+ *          SCHEDR_FAILURE if the monitor of the job could not be started,
+ *          SCHEDR_SUCCESS otherwise
  */
 Status schedr_scheduler_start_job(Job *const job_p);
 
 /*
  * schedr_scheduler_stop_job
  *
- * Stops the provided job if it is running.
+ * Stops the provided job if it is running. In EventLoop mode a running 
+ * command is sent SIGTERM and reaped by the loop later on, instead of being 
+ * waited for.
  */
 Status schedr_scheduler_stop_job(Job *const job_p);
 
+/*
+ * schedr_scheduler_pause_job
+ *
+ * Stops a job started in EventLoop mode from running until it is resumed,
+ * setting its state to Paused. Commands of the job that are running are left
+ * to finish, and runs already waiting in the run queue are still started. A
+ * held run, and a retry the job was waiting for, are dropped.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job is not started in EventLoop mode,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_pause_job(Job *const job_p);
+
+/*
+ * schedr_scheduler_resume_job
+ *
+ * Lets a paused job run again, on its interval from the time it is resumed.
+ * Resuming a job that is not paused does nothing.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job is not started in EventLoop mode,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_resume_job(Job *const job_p);
+
+/*
+ * schedr_scheduler_run_job_now
+ *
+ * Makes a job started in EventLoop mode due right away, paused or not, as if
+ * its interval had passed. The run follows the overlap policy of the job if
+ * it is already running. A job that waits for its command is timed from the
+ * end of this run.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'job_p' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job is not started in EventLoop mode,
+ *          SCHEDR_FAILURE if the run was dropped since the job is already running,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_run_job_now(Job *const job_p);
+
+/*
+ * schedr_scheduler_update_job
+ *
+ * Changes the command, interval, timing, overlap policy, weight, splay and
+ * retry policy of a job started in EventLoop mode to those of 'updated',
+ * without stopping it. The commands it is running keep running and its
+ * counters are kept. A run that is waited for is timed on the new interval,
+ * counted from the run before it. The splay offset of 'updated' replaces the
+ * one of the job, moving a first run that has not started yet and every run of
+ * a calendar. The name, state, limits and trigger of the job are not changed.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if an argument is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if the job is not started in EventLoop mode, or 'updated' has other limits,
+ *                                        another trigger or may run another number of commands at the same time, in which case
+ *                                        the job has to be started again,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_update_job(Job *const job_p, const Job *const updated);
+
+/*
+ * schedr_scheduler_remove_job
+ *
+ * Stops a job like schedr_scheduler_stop_job(), and forgets its output and
+ * latencies. The output its commands are still writing is no longer read, so
+ * the job may be freed once this function returns.
+ */
+void schedr_scheduler_remove_job(Job *const job_p);
+
+/*
+ * schedr_scheduler_run
+ *
+ * Runs the started jobs from the calling process when they are due, until 
+ * SIGTERM or SIGINT is received. The signals are blocked and handled by the 
+ * loop, so jobs can be stopped cleanly once this function returns.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if the scheduler is not in EventLoop mode,
+ *          SCHEDR_ERROR_FORK_FAILED if a command could not be started,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if a started command could not be registered,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_run();
+
+/*
+ * schedr_scheduler_set_max_concurrent
+ *
+ * Limits how many commands schedr_scheduler_run() lets run at the same time,
+ * counting every command as many times as the weight of its job. Runs that
+ * are due while the limit is reached wait in a first in, first out queue 
+ * until enough running commands have finished. 0, the default, means no 
+ * limit. Supervised jobs are not limited.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'max_concurrent' is < 0,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_set_max_concurrent(int max_concurrent);
+
+/*
+ * schedr_scheduler_get_run_queue_stats
+ *
+ * Fills 'stats' with the current depth of the run queue and how long runs have
+ * waited in it.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'stats' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_get_run_queue_stats(RunQueueStats *const stats);
+
+/*
+ * schedr_scheduler_get_cmds_in_flight
+ *
+ * returns  the number of commands schedr_scheduler_run() has started and not
+ *          reaped yet
+ */
+int schedr_scheduler_get_cmds_in_flight();
+
+/*
+ * schedr_scheduler_set_output_len
+ *
+ * Sets how many bytes of output are kept of every job, see schedr_output.h.
+ * Applies to the jobs whose commands have not written anything yet. Defaults
+ * to SCHEDR_OUTPUT_DEFAULT_RING_LEN.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'len' is < SCHEDR_OUTPUT_MIN_RING_LEN,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_set_output_len(size_t len);
+
+/*
+ * schedr_scheduler_get_output
+ *
+ * Gives the latest output of the commands schedr_scheduler_run() has run for
+ * a job. Their stdout and stderr are connected to pipes, which the loop reads
+ * without blocking. Commands of Supervised jobs write to the stdout and 
+ * stderr of the daemon instead.
+ *
+ * returns  the output of the job, or NULL if none of its commands has written anything
+ */
+const OutputRing *schedr_scheduler_get_output(const Job *const job_p);
+
+/*
+ * schedr_scheduler_get_latency
+ *
+ * Gives how late the runs schedr_scheduler_run() has made of a job started,
+ * how long starting their commands took and how long they ran, or the same
+ * for the runs of every job if 'job_p' is NULL. The histograms of a job are
+ * allocated when its first command is started, recording a run after that
+ * only counts it. Runs of Supervised jobs are not recorded.
+ *
+ * returns  the latencies, or NULL if no command of the job has been started
+ */
+const JobLatency *schedr_scheduler_get_latency(const Job *const job_p);
+
+/*
+ * schedr_scheduler_set_reload_handler
+ *
+ * Makes schedr_scheduler_run() call 'handler' between two iterations of the
+ * loop when the daemon receives SIGHUP, so the handler may start, update and
+ * stop jobs. Without a handler, or if 'handler' is NULL, SIGHUP terminates
+ * the loop like SIGTERM.
+ */
+void schedr_scheduler_set_reload_handler(void (*handler)());
+
+/*
+ * schedr_scheduler_watch_fd
+ *
+ * Makes schedr_scheduler_run() call 'handler' with 'fd' and 'data' whenever
+ * 'fd' can be read from, or written to if 'for_writing' is true, without 
+ * blocking. Watching a descriptor that is already watched replaces its 
+ * handler. The handler must not block.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'handler' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'fd' is < 0,
+ *          SCHEDR_ERROR_ALLOCATION_FAILED if the handler could not be stored,
+ *          SCHEDR_FAILURE if 'fd' could not be watched,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_scheduler_watch_fd(int fd, bool for_writing, void (*handler)(int fd, void *data), void *data);
+
+/*
+ * schedr_scheduler_unwatch_fd
+ *
+ * Stops watching 'fd', if it is watched. The descriptor is not closed.
+ */
+void schedr_scheduler_unwatch_fd(int fd);
+
 void schedr_scheduler_set_path();
 
 #endif /* SCHEDR_SCHEDULER_H */
@@ -0,0 +1,127 @@
+/*
+ * schedr_spawn.h
+ *
+ * Responsible for starting the processes that run job commands. A command
+ * can be started with fork() followed by execve(), or with posix_spawn()
+ * which does not copy the page tables of the daemon and therefore stays fast
+ * as the daemon grows. With the Zygote backend, commands are started by the
+ * zygote, see schedr_zygote.h, which keeps the cost of starting one the same
+ * however large the daemon grows. Commands started through the zygote are not
+ * children of the daemon, so they have to be collected with schedr_spawn_reap().
+ *
+ * Spawned processes start with an empty signal mask and the default action
+ * for every signal the daemon handles itself.
+ *
+ * Commands with resource limits or a placement, see schedr_limits.h, are
+ * cloned instead of spawned with posix_spawn(), which can neither start a
+ * process in a cgroup, set its limits nor place it on CPUs. Through the zygote
+ * that costs no more than spawning.
+ */
+#ifndef SCHEDR_SPAWN_H
+#define SCHEDR_SPAWN_H
+
+#include <sys/types.h>      // pid_t
+#include <spawn.h>          // posix_spawn_file_actions_t, posix_spawnattr_t
+#include <sys/resource.h>   // struct rusage
+
+#include "schedr_status_codes.h"
+#include "schedr_limits.h"
+
+#define SCHEDR_SPAWN_BACKEND_VALUES 3
+
+enum SpawnBackend
+{
+    ForkExec = 0,
+    PosixSpawn = 1,
+    Zygote = 2
+};
+
+typedef enum SpawnBackend SpawnBackend;
+
+#ifdef TEST
+void schedr_spawn_set_exec(int (*exec_func)(const char *fn, char *const argv[], char *const envp[]));
+void schedr_spawn_reset_exec();
+void schedr_spawn_set_forker(int (*fork_func)(void));
+void schedr_spawn_reset_forker();
+void schedr_spawn_set_spawner(int (*spawn_func)(pid_t *pid, const char *path,
+                                                const posix_spawn_file_actions_t *file_actions,
+                                                const posix_spawnattr_t *attr,
+                                                char *const argv[], char *const envp[]));
+void schedr_spawn_reset_spawner();
+#endif
+
+/*
+ * schedr_spawn_set_backend
+ *
+ * Sets how processes are started. Defaults to ForkExec. The Zygote backend
+ * falls back on PosixSpawn while no zygote started by this process is running.
+ *
+ * returns  SCHEDR_ERROR_INVALID_ARGUMENT if 'backend' is < 0 or >= SCHEDR_SPAWN_BACKEND_VALUES,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_spawn_set_backend(SpawnBackend backend);
+
+/*
+ * schedr_spawn
+ *
+ * Starts a process executing the file at 'path' with the arguments in the
+ * NULL terminated 'argv' and the environment of the daemon. The pid of the
+ * process is stored in 'pid'. The process is not waited for.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'path', 'argv' or 'pid' is NULL,
+ *          SCHEDR_ERROR_FORK_FAILED if the system could not create a new process,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if the arguments and environment are too long to send to the zygote,
+ *          SCHEDR_FAILURE if the process was created but 'path' could not be executed
+ *              (only reported by the PosixSpawn and Zygote backends, the ForkExec
+ *              process exits with EXIT_FAILURE instead),
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_spawn(const char *path, char *const argv[], pid_t *pid);
+
+/*
+ * schedr_spawn_redirected
+ *
+ * Works like schedr_spawn(), but the process gets 'fds[0]', 'fds[1]' and
+ * 'fds[2]' as its stdin, stdout and stderr. If 'fds' is NULL, the process
+ * gets those of the daemon. The descriptors should be close-on-exec, so they
+ * are not left open in the process under their original numbers.
+ *
+ * returns  the same as schedr_spawn()
+ */
+Status schedr_spawn_redirected(const char *path, char *const argv[], const int fds[3], pid_t *pid);
+
+/*
+ * schedr_spawn_limited
+ *
+ * Works like schedr_spawn_redirected(), but the process starts in the cgroup
+ * 'cgroup_fd' is open on or, if it is -1, with the limits in 'limits' set with
+ * setrlimit(). Either way it is placed as 'limits' says before it is executed.
+ * 'limits' may be NULL if the process is not limited that way.
+ *
+ * returns  the same as schedr_spawn()
+ */
+Status schedr_spawn_limited(const char *path, char *const argv[], const int fds[3], const Limits *limits, int cgroup_fd, pid_t *pid);
+
+/*
+ * schedr_spawn_event_fd
+ *
+ * returns  a file descriptor that becomes readable when a command started
+ *          through the zygote has exited, or -1 if no zygote is running.
+ *          Other commands are signalled with SIGCHLD as usual.
+ */
+int schedr_spawn_event_fd();
+
+/*
+ * schedr_spawn_reap
+ *
+ * Collects a command that has exited, whichever backend started it, without
+ * blocking. Its pid, exit status, as reported by waitpid(), and resource usage
+ * are stored in 'pid', 'status' and 'usage'. 0 is stored in 'pid' if no
+ * command has exited. Other children of the daemon are collected as well.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_spawn_reap(pid_t *pid, int *status, struct rusage *usage);
+
+#endif /* SCHEDR_SPAWN_H */
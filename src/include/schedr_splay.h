@@ -0,0 +1,67 @@
+/*
+ * schedr_splay.h
+ *
+ * Spreads the first runs of jobs out over their splay, so restarting the
+ * daemon does not run every job at the same time. Every job with a splay gets
+ * an offset for its first run, from 0 up to, but not including, the splay.
+ *
+ * SplayHashed derives the offset from the name of the job, so it is the same
+ * every time the daemon starts. SplayRandom draws the offsets at random and
+ * saves them in a state file, where they are read back from on the next start
+ * for as long as they fit in the splay of their job.
+ */
+#ifndef SCHEDR_SPLAY_H
+#define SCHEDR_SPLAY_H
+
+#include <stdint.h>     // uint64_t
+
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+#include "schedr_status_codes.h"
+
+#define SCHEDR_SPLAY_MODE_VALUES 2
+
+enum SplayMode
+{
+    SplayHashed = 0,
+    SplayRandom = 1
+};
+
+typedef enum SplayMode SplayMode;
+
+#ifdef TEST
+void schedr_splay_set_random(uint64_t (*random_func)(void));
+void schedr_splay_reset_random();
+#endif
+
+/*
+ * schedr_splay_assign_offsets
+ *
+ * Sets 'splay_offset_ns' of every job in 'jobs' according to its splay. With
+ * SplayRandom the offsets are read from and saved to the file at 'state_path',
+ * unless it is NULL. A missing state file is not an error. The offsets are
+ * assigned even when the state file can not be saved.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'jobs' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'jobs_len' is < 0 or 'mode' is < 0 or >= SCHEDR_SPLAY_MODE_VALUES,
+ *          SCHEDR_ERROR_PERMISSION_DENIED if the program did not have permission to save the state file,
+ *          SCHEDR_FAILURE if the state file could not be saved for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_splay_assign_offsets(Job jobs[], int jobs_len, SplayMode mode, const char *state_path);
+
+/*
+ * schedr_splay_reassign_offsets
+ *
+ * Like schedr_splay_assign_offsets(), for the jobs of a reloaded config. A job
+ * with the name and splay of a job in 'running' keeps the offset of that job,
+ * only added jobs and jobs whose splay changed get a new one. The state file
+ * is only saved when the offsets in it would change.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'jobs' or 'running' is NULL,
+ *          otherwise the same as schedr_splay_assign_offsets()
+ */
+Status schedr_splay_reassign_offsets(Job jobs[], int jobs_len, SplayMode mode, const JobIndex *const running,
+                                     const char *state_path);
+
+#endif /* SCHEDR_SPLAY_H */
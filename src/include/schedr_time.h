@@ -0,0 +1,34 @@
+/*
+ * schedr_time.h
+ *
+ * Reads the clocks the daemon keeps time by, in nanoseconds.
+ */
+#ifndef SCHEDR_TIME_H
+#define SCHEDR_TIME_H
+
+#include <stdint.h>     // int64_t
+
+#define SCHEDR_TIME_NANOSECS_PER_SEC 1000000000LL
+
+#ifdef TEST
+#include <time.h>       // clockid_t, struct timespec
+
+void schedr_time_set_clock(int (*clock_func)(clockid_t clock_id, struct timespec *now));
+void schedr_time_reset_clock();
+#endif
+
+/*
+ * schedr_time_monotonic_ns
+ *
+ * returns  the time of CLOCK_MONOTONIC, which only ever goes forward
+ */
+int64_t schedr_time_monotonic_ns();
+
+/*
+ * schedr_time_realtime_ns
+ *
+ * returns  the time of CLOCK_REALTIME, since the epoch
+ */
+int64_t schedr_time_realtime_ns();
+
+#endif
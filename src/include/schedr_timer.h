@@ -0,0 +1,115 @@
+/*
+ * schedr_timer.h
+ *
+ * A hierarchical timing wheel keeping track of pending deadlines. Adding and
+ * cancelling a timer takes constant time and every timer that is due is
+ * expired in one batch when the wheel is advanced.
+ *
+ * Timers are allocated by the caller, so the wheel itself has a fixed size
+ * no matter how many timers are pending.
+ */
+#ifndef SCHEDR_TIMER_H
+#define SCHEDR_TIMER_H
+
+#include <stdint.h>     // int64_t, uint64_t, uint32_t
+#include <stdbool.h>    // bool
+
+#include "schedr_status_codes.h"
+
+#define SCHEDR_TIMER_LEVELS 6
+#define SCHEDR_TIMER_SLOT_BITS 6
+#define SCHEDR_TIMER_SLOTS (1 << SCHEDR_TIMER_SLOT_BITS)
+
+struct Timer
+{
+    struct Timer *next;
+    struct Timer *prev;
+    uint64_t expires_tick;
+    unsigned char level;
+    unsigned char slot;
+    bool pending;
+    void *data;
+};
+
+typedef struct Timer Timer;
+
+struct TimerWheel
+{
+    int64_t tick_ns;
+    uint64_t now_tick;
+    uint64_t pending;
+    uint64_t occupied[SCHEDR_TIMER_LEVELS];
+    Timer slots[SCHEDR_TIMER_LEVELS][SCHEDR_TIMER_SLOTS];
+    Timer overdue;      // Timers added after their tick was passed
+};
+
+typedef struct TimerWheel TimerWheel;
+
+/*
+ * schedr_timer_wheel_init
+ *
+ * Initializes an empty wheel with a resolution of 'tick_ns' nanoseconds,
+ * starting at the time 'now_ns'. Deadlines are rounded up to whole ticks, so
+ * a timer never expires early.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'wheel' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'tick_ns' is <= 0 or 'now_ns' is < 0,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_timer_wheel_init(TimerWheel *const wheel, int64_t tick_ns, int64_t now_ns);
+
+/*
+ * schedr_timer_init
+ *
+ * Initializes a timer that is not pending, carrying 'data' for the caller.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'timer' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_timer_init(Timer *const timer, void *data);
+
+/*
+ * schedr_timer_add
+ *
+ * Makes 'timer' expire at 'expires_ns'. A deadline that has already passed
+ * expires on the next call to schedr_timer_advance().
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'wheel' or 'timer' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'timer' is already pending,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_timer_add(TimerWheel *const wheel, Timer *const timer, int64_t expires_ns);
+
+/*
+ * schedr_timer_cancel
+ *
+ * Removes 'timer' from the wheel if it is pending.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'wheel' or 'timer' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_timer_cancel(TimerWheel *const wheel, Timer *const timer);
+
+/*
+ * schedr_timer_advance
+ *
+ * Moves the wheel forward to 'now_ns' and hands every timer that has expired
+ * to the caller as a list, linked through 'next' and ending with NULL. The
+ * expired timers are no longer pending and can be added again right away.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'wheel' or 'expired' is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_timer_advance(TimerWheel *const wheel, int64_t now_ns, Timer **expired);
+
+/*
+ * schedr_timer_next_deadline
+ *
+ * Gives the earliest time, in nanoseconds, at which schedr_timer_advance()
+ * may expire a timer, or -1 if no timer is pending. The wheel might need to
+ * be advanced at that time only to move far away timers closer, in which
+ * case nothing expires.
+ */
+int64_t schedr_timer_next_deadline(const TimerWheel *const wheel);
+
+#endif /* SCHEDR_TIMER_H */
@@ -0,0 +1,195 @@
+/*
+ * schedr_uring.h
+ *
+ * A minimal io_uring, set up with the system calls themselves so schedr does
+ * not depend on liburing. Requests are queued in the submission queue with
+ * schedr_uring_get_sqe(), and all of them are submitted, and completions
+ * waited for, in a single system call by schedr_uring_submit(). Completions
+ * are read straight from the completion queue the kernel shares with the
+ * process, without any system call.
+ *
+ * The schedr_uring_queue_*() functions queue the requests schedr makes. Each
+ * completes with the 'user_data' it was queued with, SCHEDR_URING_IGNORED for
+ * requests nobody waits for.
+ *
+ * Requires Linux 5.7 or later, which polls files that are not ready instead
+ * of failing the request and supports buffers selected by the kernel.
+ */
+#ifndef SCHEDR_URING_H
+#define SCHEDR_URING_H
+
+#include <stddef.h>             // size_t
+#include <stdint.h>             // uint64_t
+#include <stdbool.h>            // bool
+#include <linux/io_uring.h>     // struct io_uring_sqe, struct io_uring_cqe, struct io_uring_params
+
+#include "schedr_status_codes.h"
+
+#define SCHEDR_URING_MAX_ENTRIES 4096
+
+// How many completions the completion queue holds for every entry of the submission queue
+#define SCHEDR_URING_CQ_FACTOR 4
+
+// User data below SCHEDR_URING_TAGS is never a valid address, so it tags requests rather than pointing at what they are for
+#define SCHEDR_URING_IGNORED 1
+#define SCHEDR_URING_TAGS 16
+
+struct Uring
+{
+    int fd;
+    unsigned sq_entries;
+    unsigned sqe_tail;              // Past the last queued request, the kernel sees them once 'sq_tail' is moved here
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_flags;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *rings;                    // The submission and completion queues share a mapping
+    size_t rings_len;
+    size_t sqes_len;
+};
+
+typedef struct Uring Uring;
+
+#ifdef TEST
+void schedr_uring_set_setup(int (*setup_func)(unsigned entries, struct io_uring_params *params));
+void schedr_uring_reset_setup();
+#endif
+
+/*
+ * schedr_uring_init
+ *
+ * Sets up a ring with room for 'entries' queued requests and
+ * SCHEDR_URING_CQ_FACTOR times as many completions. Completions that do not
+ * fit are held back by the kernel rather than lost.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if 'entries' is 0 or > SCHEDR_URING_MAX_ENTRIES,
+ *          SCHEDR_ERROR_NOT_IMPLEMENTED if the kernel does not support io_uring, has it turned off or
+ *                                       lacks a feature the ring relies on,
+ *          SCHEDR_FAILURE if the ring could not be set up for any other reason,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_uring_init(Uring *const ring, unsigned entries);
+
+/*
+ * schedr_uring_destroy
+ *
+ * Closes the ring, which cancels the requests still in flight. Memory those
+ * requests read into must not be freed until they have completed.
+ */
+void schedr_uring_destroy(Uring *const ring);
+
+/*
+ * schedr_uring_get_sqe
+ *
+ * Gives a zeroed entry at the end of the submission queue for the caller to
+ * fill in. When the queue is full, the queued requests are submitted first.
+ *
+ * returns  the entry, or NULL if the queue is full and could not be submitted
+ */
+struct io_uring_sqe *schedr_uring_get_sqe(Uring *const ring);
+
+/*
+ * schedr_uring_submit
+ *
+ * Submits the queued requests and, if 'wait' is true, waits until at least
+ * one completion is in the completion queue.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if 'ring' is NULL,
+ *          SCHEDR_FAILURE if the requests could not be submitted, other than for lack of room for their
+ *                         completions or a signal, in which case they are submitted on the next call,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_uring_submit(Uring *const ring, bool wait);
+
+/*
+ * schedr_uring_peek
+ *
+ * returns  the oldest completion that has not been marked as seen, or NULL if there is none
+ */
+struct io_uring_cqe *schedr_uring_peek(Uring *const ring);
+
+/*
+ * schedr_uring_seen
+ *
+ * Hands the completion returned by schedr_uring_peek() back to the kernel.
+ */
+void schedr_uring_seen(Uring *const ring);
+
+/*
+ * schedr_uring_queue_read
+ *
+ * Queues a read of up to 'len' bytes of 'fd' into 'buf', or into a buffer the
+ * kernel picks from 'buffer_group' if it is not 0. A descriptor that blocks
+ * is waited for by the kernel rather than failing the read.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_queue_read(Uring *const ring, int fd, void *buf, unsigned len, int buffer_group, uint64_t user_data);
+
+/*
+ * schedr_uring_queue_poll
+ *
+ * Queues a request that completes once 'fd' is readable.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_queue_poll(Uring *const ring, int fd, uint64_t user_data);
+
+/*
+ * schedr_uring_queue_close
+ *
+ * Queues closing 'fd', whose completion is ignored.
+ *
+ * returns  false if the request could not be queued, 'fd' is still open then, true otherwise
+ */
+bool schedr_uring_queue_close(Uring *const ring, int fd);
+
+/*
+ * schedr_uring_queue_cancel
+ *
+ * Queues cancelling the request in flight with the user data 'target', whose
+ * completion is ignored.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_queue_cancel(Uring *const ring, uint64_t target);
+
+/*
+ * schedr_uring_provide_buffer
+ *
+ * Queues handing the 'len' bytes at 'buf' to the kernel as buffer 'id' of
+ * 'buffer_group', to be picked by a read of the group. Its completion is
+ * ignored.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_provide_buffer(Uring *const ring, void *buf, unsigned len, int id, int buffer_group);
+
+/*
+ * schedr_uring_queue_timeout
+ *
+ * Queues a timeout that completes with -ETIME once CLOCK_MONOTONIC reaches
+ * 'deadline', which has to stay where it is until then.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_queue_timeout(Uring *const ring, const struct __kernel_timespec *deadline, uint64_t user_data);
+
+/*
+ * schedr_uring_remove_timeout
+ *
+ * Queues removing the timeout in flight with the user data 'target', whose
+ * completion is ignored.
+ *
+ * returns  false if the request could not be queued, true otherwise
+ */
+bool schedr_uring_remove_timeout(Uring *const ring, uint64_t target);
+
+#endif /* SCHEDR_URING_H */
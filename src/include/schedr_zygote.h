@@ -0,0 +1,125 @@
+/*
+ * schedr_zygote.h
+ *
+ * A small helper process, the zygote, that starts commands on behalf of the
+ * daemon. It is forked before the config is loaded, while the daemon is still
+ * small, so the cost of starting a command stays the same however large the
+ * daemon grows.
+ *
+ * The daemon sends the path, arguments and environment of a command over a
+ * Unix socket, along with the file descriptors the command gets as its stdin,
+ * stdout and stderr. The zygote replies with the pid of the command and later,
+ * whenever one of its commands exits, with the pid and exit status of it.
+ *
+ * The commands are children of the zygote, not of the daemon. The daemon is
+ * made a child subreaper, so commands still running when the zygote exits are
+ * handed over to the daemon and can be waited for as usual.
+ *
+ * Commands with resource limits or a placement are cloned by the zygote, into
+ * the cgroup sent along with their descriptors. Since the zygote is small,
+ * that costs about as much as posix_spawn().
+ */
+#ifndef SCHEDR_ZYGOTE_H
+#define SCHEDR_ZYGOTE_H
+
+#include <stdbool.h>        // bool
+#include <sys/types.h>      // pid_t
+#include <sys/resource.h>   // struct rusage
+
+#include "schedr_status_codes.h"
+#include "schedr_limits.h"
+
+// The largest request, path, arguments and environment included, that can be sent to the zygote
+#define SCHEDR_ZYGOTE_MAX_REQUEST_LEN (64 * 1024)
+
+/*
+ * schedr_zygote_start
+ *
+ * Forks the zygote. Does nothing if this process has already started one
+ * that is still running.
+ *
+ * returns  SCHEDR_ERROR_FORK_FAILED if the zygote could not be forked,
+ *          SCHEDR_FAILURE if the socket to the zygote could not be created,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_zygote_start();
+
+/*
+ * schedr_zygote_stop
+ *
+ * Closes the socket to the zygote and waits for it to exit. Commands still
+ * running are handed over to this process. Does nothing if no zygote is
+ * running.
+ */
+void schedr_zygote_stop();
+
+/*
+ * schedr_zygote_is_running
+ *
+ * returns  true if this process started a zygote that is still running,
+ *          false otherwise. Processes forked by the one that started the
+ *          zygote can not use it.
+ */
+bool schedr_zygote_is_running();
+
+/*
+ * schedr_zygote_fd
+ *
+ * returns  the socket the zygote reports finished commands on, which becomes
+ *          readable as soon as one has exited, or -1 if no zygote is running
+ */
+int schedr_zygote_fd();
+
+/*
+ * schedr_zygote_pid
+ *
+ * returns  the pid of the zygote, or 0 if no zygote is running
+ */
+pid_t schedr_zygote_pid();
+
+/*
+ * schedr_zygote_spawn
+ *
+ * Has the zygote start a process executing the file at 'path' with the
+ * arguments in the NULL terminated 'argv' and the environment in the NULL
+ * terminated 'envp'. The process gets 'fds[0]', 'fds[1]' and 'fds[2]' as its
+ * stdin, stdout and stderr. Waits only until the zygote has replied with the
+ * pid of the process, which is stored in 'pid'.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_ERROR_INVALID_ARGUMENT if a file descriptor in 'fds' is < 0,
+ *          SCHEDR_ERROR_BUFFER_OVERFLOW if the request is longer than SCHEDR_ZYGOTE_MAX_REQUEST_LEN,
+ *          SCHEDR_ERROR_FORK_FAILED if the system could not create a new process,
+ *          SCHEDR_FAILURE if no zygote is running, the zygote could not be reached
+ *              or 'path' could not be executed,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_zygote_spawn(const char *path, char *const argv[], char *const envp[], const int fds[3], pid_t *pid);
+
+/*
+ * schedr_zygote_spawn_limited
+ *
+ * Works like schedr_zygote_spawn(), but the process starts in the cgroup
+ * 'cgroup_fd' is open on or, if it is -1, with the limits in 'limits' set with
+ * setrlimit(). Either way it is placed as 'limits' says before it is executed.
+ * 'limits' may be NULL if the process is not limited that way.
+ *
+ * returns  the same as schedr_zygote_spawn()
+ */
+Status schedr_zygote_spawn_limited(const char *path, char *const argv[], char *const envp[], const int fds[3],
+                                   const Limits *limits, int cgroup_fd, pid_t *pid);
+
+/*
+ * schedr_zygote_reap
+ *
+ * Collects a command started by the zygote that has exited, without blocking.
+ * Its pid, exit status, as reported by waitpid(), and resource usage are
+ * stored in 'pid', 'status' and 'usage'. 0 is stored in 'pid' if no command
+ * has exited since the last call.
+ *
+ * returns  SCHEDR_ERROR_NULL_ARGUMENT if any argument is NULL,
+ *          SCHEDR_SUCCESS otherwise
+ */
+Status schedr_zygote_reap(pid_t *pid, int *status, struct rusage *usage);
+
+#endif /* SCHEDR_ZYGOTE_H */
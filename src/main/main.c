@@ -4,40 +4,186 @@
 #include <stdbool.h>
 #include <signal.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "schedr_job.h"
 #include "schedr_scheduler.h"
 #include "schedr_config_parser.h"
+#include "schedr_spawn.h"
+#include "schedr_splay.h"
+#include "schedr_zygote.h"
+#include "schedr_control.h"
+#include "schedr_job_index.h"
+#include "schedr_reload.h"
+#include "schedr_metrics.h"
+#include "schedr_log.h"
+#include "schedr_limits.h"
+#include "schedr_time.h"
+
+#define CONTROL_SOCKET_PATH "/.config/schedr/schedr.sock"
+#define METRICS_SOCKET_PATH "/.config/schedr/metrics.sock"
+#define LOG_PATH "/.config/schedr/jobs.log"
 #include "schedr_status_codes.h"
 
-static char *get_config_path()
+static const char *const COMMANDS[] = { "tail", "status", "latency", "list", "add", "remove", "pause", "resume", "run" };
+
+// The CPUs the daemon could run on before it was moved to its own, if it was moved
+static Limits unpinned;
+static bool daemon_pinned = false;
+
+// The jobs of the daemon by name, those of the config file and those added through the control socket
+static JobIndex daemon_jobs;
+static char *config_path = NULL;
+static char *splay_state_path = NULL;
+static SplayMode splay_mode = SplayHashed;
+
+static char *get_home_path(const char *file_rel)
 {
-    const char config_file_rel[] = "/.config/schedr/schedr.conf";
     char *home = getenv("HOME");
-    int len = sizeof (config_file_rel) + strlen(home);
-    char *config_path = (char *)malloc(sizeof (char) * len);
+    int len = strlen(file_rel) + strlen(home) + 1;
+    char *path = (char *)malloc(sizeof (char) * len);
+    
+    strcpy(path, home);
+    strcat(path, file_rel);
+    
+    return path;
+}
+
+/*
+ * Sends the command given on the command line to the running daemon, and 
+ * prints its response. The arguments after the command are joined with
+ * spaces, so the config of a job to add does not have to be quoted as a whole.
+ */
+static int send_command(int argc, char *argv[])
+{
+    char request[SCHEDR_CONTROL_MAX_REQUEST_LEN];
+    bool known = false;
+    
+    for (size_t i = 0; i < sizeof (COMMANDS) / sizeof (COMMANDS[0]); i++) { known = known || strcmp(argv[1], COMMANDS[i]) == 0; }
+    
+    if (!known)
+    {
+        fprintf(stderr, "Usage: %s [tail|status|pause|resume|run|remove <job name>|latency [<job name>]|list|add <job>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    int len = snprintf(request, sizeof (request), "%s", argv[1]);
+    
+    for (int i = 2; i < argc && len < (int)sizeof (request); i++)
+    {
+        len += snprintf(request + len, sizeof (request) - len, " %s", argv[i]);
+    }
+    
+    if (len >= (int)sizeof (request))
+    {
+        fprintf(stderr, "Command too long\n");
+        return EXIT_FAILURE;
+    }
+    
+    char *socket_path = get_home_path(CONTROL_SOCKET_PATH);
+    Status status = schedr_control_request(socket_path, request, stdout, stderr);
+    
+    free(socket_path);
+    
+    return (status == SCHEDR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * Gives a job added through the control socket the CPUs a job of the config
+ * file without CPUs of its own gets.
+ */
+static void prepare_added_job(Job *job_p)
+{
+    Limits limits = job_p->limits;
+    
+    if (!daemon_pinned || schedr_limits_have_cpus(&limits)) { return; }
+    
+    memcpy(limits.cpus, unpinned.cpus, sizeof (limits.cpus));
+    schedr_job_set_limits(job_p, &limits);
+}
+
+/*
+ * Loads the config file again and starts, updates and stops only the jobs
+ * that changed. Called from the event loop on SIGHUP or when the file has been
+ * written.
+ */
+static void reload()
+{
+    int64_t started_ns = schedr_time_monotonic_ns();
+    Settings settings;
+    Job *jobs = NULL;
+    int number_of_jobs = 0;
+    ReloadStats stats;
+    Status status = schedr_config_load(&settings, &jobs, &number_of_jobs, config_path);
+    
+    if (status != SCHEDR_SUCCESS)
+    {
+        printf("Could not reload config files, the jobs are left as they are. Error code: %d\n", status);
+        return;
+    }
     
-    strcpy(config_path, home);
-    strncat(config_path, config_file_rel, sizeof (config_file_rel) - 1);
-    config_path[len] = '\0';
+    // The running jobs keep their offsets, unless the offsets are now assigned another way
+    if (settings.splay_mode == splay_mode) { status = schedr_splay_reassign_offsets(jobs, number_of_jobs, splay_mode, &daemon_jobs, splay_state_path); }
+    else { status = schedr_splay_assign_offsets(jobs, number_of_jobs, settings.splay_mode, splay_state_path); }
     
-    return config_path;
+    if (status != SCHEDR_SUCCESS)
+    {
+        printf("Could not save splay offsets, they will change on the next start. Error code: %d\n", status);
+    }
+    
+    splay_mode = settings.splay_mode;
+    
+    bool limited = false;
+    
+    for (int i = 0; i < number_of_jobs; i++)
+    {
+        prepare_added_job(&(jobs[i]));
+        limited = limited || schedr_limits_are_set(&(jobs[i].limits));
+    }
+    
+    if (limited && !schedr_limits_have_cgroup()) { schedr_limits_open_cgroup(NULL); }
+    
+    status = schedr_reload_apply(&daemon_jobs, jobs, number_of_jobs, &stats);
+    free(jobs);
+    
+    schedr_scheduler_set_max_concurrent(settings.max_concurrent);
+    
+    printf("Reloaded %d jobs in %.3f ms: %d started, %d removed, %d updated, %d restarted, %d unchanged, %d failed\n",
+           number_of_jobs, (double)(schedr_time_monotonic_ns() - started_ns) / 1000000.0, stats.started, stats.removed,
+           stats.updated, stats.restarted, stats.unchanged, stats.failed);
+    
+    if (status != SCHEDR_SUCCESS && status != SCHEDR_FAILURE)
+    {
+        printf("Could not reload the jobs. Error code: %d\n", status);
+    }
 }
 
 int main(int argc, char *argv[])
 {
-    char *config_path = get_config_path();
+    // Commands are sent to the daemon that is already running
+    if (argc > 1) { return send_command(argc, argv); }
+    
+    Settings settings;
     Job *jobs = NULL;
     int number_of_jobs = 0;
     Status status;
     
+    config_path = get_home_path("/.config/schedr/schedr.conf");
+    splay_state_path = get_home_path("/.config/schedr/splay.state");
+    
+    // Fork the process that starts the commands while the daemon is still small, so starting
+    // a command costs the same however many jobs are loaded
+    if ((status = schedr_zygote_start()) != SCHEDR_SUCCESS)
+    {
+        printf("Could not start the zygote, commands are started by the daemon. Error code: %d\n", status);
+    }
+    
     // Append $HOME/.config/schedr/bin to PATH so user defined scripts can be executed
     // without using absolute paths
     schedr_scheduler_set_path();
     
     // Load jobs from config file
-    status = schedr_config_load_jobs(&jobs, &number_of_jobs, config_path);
-    free(config_path);
+    status = schedr_config_load(&settings, &jobs, &number_of_jobs, config_path);
     
     if (status != SCHEDR_SUCCESS)
     {
@@ -45,9 +191,88 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
     
-    // Start the jobs
+    // Spread the first runs out, so the jobs do not all run at once on every start
+    if ((status = schedr_splay_assign_offsets(jobs, number_of_jobs, settings.splay_mode, splay_state_path)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not save splay offsets, they will change on the next start. Error code: %d\n", status);
+    }
+    
+    splay_mode = settings.splay_mode;
+    
+    // Keep the daemon and the zygote on the housekeeping CPUs, before any thread is started so they stay there too
+    if (schedr_limits_have_cpus(&(settings.daemon_limits)))
+    {
+        schedr_limits_init(&unpinned);
+        schedr_limits_get_cpus(&unpinned);
+        daemon_pinned = true;
+        
+        if ((status = schedr_limits_place(0, &(settings.daemon_limits))) != SCHEDR_SUCCESS ||
+            (schedr_zygote_pid() != 0 && (status = schedr_limits_place(schedr_zygote_pid(), &(settings.daemon_limits))) != SCHEDR_SUCCESS))
+        {
+            printf("Could not move the daemon to its CPUs, it runs on any of them. Error code: %d\n", status);
+        }
+        
+        // The commands of jobs without CPUs of their own still run on every CPU the daemon could run on before
+        for (int i = 0; i < number_of_jobs; i++)
+        {
+            Limits limits = jobs[i].limits;
+            
+            if (schedr_limits_have_cpus(&limits)) { continue; }
+            
+            memcpy(limits.cpus, unpinned.cpus, sizeof (limits.cpus));
+            schedr_job_set_limits(&(jobs[i]), &limits);
+        }
+    }
+    
+    // Run every job from this process instead of one supervising process per job
+    schedr_scheduler_set_mode(EventLoop);
+    
+    // Hold due runs in the run queue while the configured number of commands are running
+    schedr_scheduler_set_max_concurrent(settings.max_concurrent);
+    
+    // Keep the latest output of every job in memory, so it can be shown by 'schedr tail'
+    schedr_scheduler_set_output_len(settings.output_len);
+    
+    // Write the output of every job to the log file from a thread of its own
+    char *log_path = get_home_path(LOG_PATH);
+    
+    if ((status = schedr_log_open(log_path, &(settings.log_rotation), SCHEDR_LOG_DEFAULT_BUFFER_LEN)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not open the log file, the output of the jobs is not written to disk. Error code: %d\n", status);
+    }
+    
+    free(log_path);
+    
+    // Wait for timers, child exits and output pipes through io_uring if configured, epoll is kept if the kernel lacks it
+    if (settings.loop_backend != LoopEpoll && (status = schedr_scheduler_set_loop_backend(settings.loop_backend)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not set up io_uring, the event loop uses epoll. Error code: %d\n", status);
+    }
+    
+    // Start commands through the zygote, or without copying the page tables of the daemon if it is not running
+    schedr_spawn_set_backend(Zygote);
+    
+    // Start the commands of jobs with limits in cgroups of their own, or set their limits with setrlimit() without cgroups
+    bool limited = false;
+    
+    for (int i = 0; i < number_of_jobs; i++) { limited = limited || schedr_limits_are_set(&(jobs[i].limits)); }
+    
+    if (limited && (status = schedr_limits_open_cgroup(NULL)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not set up cgroup v2, only the memory and pids limits are applied. Error code: %d\n", status);
+    }
+    
+    // Start the jobs, and index them by name so jobs can be looked up, added and removed through the control socket
+    schedr_job_index_init(&daemon_jobs);
+    
     for (int i = 0; i < number_of_jobs; i++)
     {
+        if ((status = schedr_job_index_add(&daemon_jobs, &(jobs[i]), false)) != SCHEDR_SUCCESS)
+        {
+            printf("Could not index job nr %d. Error code: %d\n", i + 1, status);
+            exit(EXIT_FAILURE);
+        }
+        
         if ((status = schedr_scheduler_start_job(&(jobs[i]))) != SCHEDR_SUCCESS) 
         {
             printf("Could not start job nr %d. Error code: %d\n", i + 1, status);
@@ -55,7 +280,43 @@ int main(int argc, char *argv[])
         }
     }
     
-    pause();    // Wait for termination signal
+    // Serve 'schedr tail' and other commands from the event loop
+    char *socket_path = get_home_path(CONTROL_SOCKET_PATH);
+    
+    if ((status = schedr_control_open(socket_path, &daemon_jobs, prepare_added_job)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not open the control socket, commands can not be sent to the daemon. Error code: %d\n", status);
+    }
+    
+    free(socket_path);
+    
+    // Serve the metrics to Prometheus from the event loop too
+    char *metrics_path = get_home_path(METRICS_SOCKET_PATH);
+    
+    if ((status = schedr_metrics_open(metrics_path, settings.metrics_port, &daemon_jobs)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not open the metrics socket, the metrics can not be scraped. Error code: %d\n", status);
+    }
+    
+    free(metrics_path);
+    
+    // Reload the config file on SIGHUP or as soon as it has been written, touching only the jobs that changed
+    schedr_scheduler_set_reload_handler(reload);
+    
+    if ((status = schedr_reload_watch(config_path, reload)) != SCHEDR_SUCCESS)
+    {
+        printf("Could not watch the config file, it is only reloaded on SIGHUP. Error code: %d\n", status);
+    }
+    
+    // Run the jobs until a termination signal is received
+    if ((status = schedr_scheduler_run()) != SCHEDR_SUCCESS)
+    {
+        printf("Scheduler stopped unexpectedly. Error code: %d\n", status);
+    }
+    
+    schedr_control_close();
+    schedr_metrics_close();
+    schedr_reload_unwatch();
     
     // Stop the jobs before terminating
     for (int i = 0; i < number_of_jobs; i++)
@@ -67,5 +328,20 @@ int main(int argc, char *argv[])
         }
     }
     
+    // and those added through the control socket or by a reload
+    for (int i = 0; i < daemon_jobs.len; i++)
+    {
+        if (daemon_jobs.jobs[i]->owned) { schedr_scheduler_stop_job(daemon_jobs.jobs[i]->job); }
+    }
+    
+    schedr_job_index_destroy(&daemon_jobs);
+    free(config_path);
+    free(splay_state_path);
+    
+    // Write what is left of the output before terminating
+    schedr_log_close();
+    
+    schedr_limits_close_cgroup();
+    
     return SCHEDR_SUCCESS;
 }
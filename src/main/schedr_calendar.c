@@ -0,0 +1,370 @@
+#include <stddef.h>         // NULL
+#include <stdint.h>         // int64_t, uint32_t, uint64_t
+#include <stdbool.h>        // bool
+#include <string.h>         // memset()
+#include <time.h>           // time_t, struct tm, localtime_r()
+
+#include "schedr_calendar.h"
+
+#define SECS_PER_MINUTE 60
+#define SECS_PER_HOUR 3600
+#define SECS_PER_DAY 86400
+#define DAYS_PER_WEEK 7
+
+// Offsets from UTC are within 14 hours of it, so both offsets in effect around a local time are found this far from it
+#define OFFSET_WINDOW_SECS (15 * SECS_PER_HOUR)
+
+static const int MONTH_LENS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+static int64_t floor_div(int64_t value, int64_t divisor);
+static uint32_t bits_from(int bit);
+static int64_t days_from_civil(int64_t year, int month, int day);
+static void civil_from_days(int64_t days, int64_t *year, int *month, int *day);
+static int month_len(int64_t year, int month);
+static bool offset_at(time_t instant, long *offset);
+static bool next_local_time(const Calendar *const calendar, int64_t from, int64_t *local);
+static bool instant_of(int64_t local, time_t after, time_t *instant, bool *skipped);
+
+Status schedr_calendar_init(Calendar *const calendar)
+{
+    if (calendar == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    memset(calendar, 0, sizeof (*calendar));
+
+    return SCHEDR_SUCCESS;
+}
+
+bool schedr_calendar_is_set(const Calendar *const calendar)
+{
+    return calendar != NULL && calendar->minutes != 0;
+}
+
+bool schedr_calendar_equal(const Calendar *const calendar, const Calendar *const other)
+{
+    if (calendar == NULL || other == NULL) { return calendar == other; }
+
+    return calendar->minutes == other->minutes && calendar->hours == other->hours && calendar->days == other->days &&
+           calendar->months == other->months && calendar->weekdays == other->weekdays;
+}
+
+Status schedr_calendar_compile(Calendar *const calendar)
+{
+    if (calendar == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    if (calendar->minutes == 0 || (calendar->minutes & ~SCHEDR_CALENDAR_ALL_MINUTES) != 0 ||
+        calendar->hours == 0 || (calendar->hours & ~SCHEDR_CALENDAR_ALL_HOURS) != 0 ||
+        calendar->days == 0 || (calendar->days & ~SCHEDR_CALENDAR_ALL_DAYS) != 0 ||
+        calendar->months == 0 || (calendar->months & ~SCHEDR_CALENDAR_ALL_MONTHS) != 0 ||
+        calendar->weekdays == 0 || (calendar->weekdays & ~SCHEDR_CALENDAR_ALL_WEEKDAYS) != 0)
+    {
+        return SCHEDR_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (int first_weekday = 0; first_weekday < DAYS_PER_WEEK; first_weekday++)
+    {
+        uint32_t days = 0;
+
+        for (int day = 1; day <= 31; day++)
+        {
+            if ((calendar->weekdays >> ((first_weekday + day - 1) % DAYS_PER_WEEK)) & 1) { days |= 1U << day; }
+        }
+
+        calendar->days_by_first_weekday[first_weekday] = calendar->days & days;
+    }
+
+    // Every day of a month is on every weekday in some year, february 29th included, so only the lengths of the months matter
+    for (int month = 1; month <= 12; month++)
+    {
+        int longest = (month == 2) ? 29 : MONTH_LENS[month - 1];
+
+        if (((calendar->months >> month) & 1) && (calendar->days & ~bits_from(longest + 1)) != 0) { return SCHEDR_SUCCESS; }
+    }
+
+    return SCHEDR_ERROR_INVALID_ARGUMENT;
+}
+
+Status schedr_calendar_next(const Calendar *const calendar, time_t after, time_t *next)
+{
+    if (calendar == NULL || next == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (!schedr_calendar_is_set(calendar)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    bool hourly = calendar->hours == SCHEDR_CALENDAR_ALL_HOURS;
+    bool skipped = false;
+    long offset;
+    long instant_offset;
+    int64_t local;
+    time_t instant = 0;
+
+    if (!offset_at(after, &offset)) { return SCHEDR_FAILURE; }
+
+    // Local times are searched from the minute after the one 'after' is in
+    int64_t from = (floor_div((int64_t)after + offset, SECS_PER_MINUTE) + 1) * SECS_PER_MINUTE;
+
+    do
+    {
+        if (!next_local_time(calendar, from, &local) || !instant_of(local, after, &instant, &skipped)) { return SCHEDR_FAILURE; }
+
+        // An hourly calendar goes on from the local time the clocks were put forward to
+        if (skipped && hourly)
+        {
+            if (!offset_at(instant, &instant_offset)) { return SCHEDR_FAILURE; }
+
+            from = (floor_div((int64_t)instant + instant_offset - 1, SECS_PER_MINUTE) + 1) * SECS_PER_MINUTE;
+        }
+    }
+    while (skipped && hourly);
+
+    if (hourly && offset_at(instant, &instant_offset) && instant_offset < offset)
+    {
+        // The clocks are put back before 'instant', the local times in between happen again and an hourly calendar fires
+        // at them a second time. Those before the clocks are put back are not valid with the offset after it.
+        from = (floor_div((int64_t)after + instant_offset, SECS_PER_MINUTE) + 1) * SECS_PER_MINUTE;
+
+        while (next_local_time(calendar, from, &local) && local - instant_offset < instant)
+        {
+            long local_offset;
+
+            if (offset_at((time_t)(local - instant_offset), &local_offset) && local_offset == instant_offset)
+            {
+                instant = (time_t)(local - instant_offset);
+                break;
+            }
+
+            from = local + SECS_PER_MINUTE;
+        }
+    }
+
+    *next = instant;
+
+    return SCHEDR_SUCCESS;
+}
+
+static int64_t floor_div(int64_t value, int64_t divisor)
+{
+    int64_t quotient = value / divisor;
+
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+/*
+ * Returns a mask of bit 'bit' and the bits above it, 0 from bit 32 on.
+ */
+static uint32_t bits_from(int bit)
+{
+    return (bit >= 32) ? 0 : ~0U << bit;
+}
+
+/*
+ * Returns the number of days from 1970-01-01 to a date of the proleptic
+ * Gregorian calendar, after the algorithm of Howard Hinnant.
+ */
+static int64_t days_from_civil(int64_t year, int month, int day)
+{
+    year -= (month <= 2) ? 1 : 0;
+
+    int64_t era = ((year >= 0) ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+    return era * 146097 + day_of_era - 719468;
+}
+
+/*
+ * The inverse of days_from_civil().
+ */
+static void civil_from_days(int64_t days, int64_t *year, int *month, int *day)
+{
+    days += 719468;
+
+    int64_t era = ((days >= 0) ? days : days - 146096) / 146097;
+    int64_t day_of_era = days - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t shifted_month = (5 * day_of_year + 2) / 153;
+
+    *day = (int)(day_of_year - (153 * shifted_month + 2) / 5 + 1);
+    *month = (int)((shifted_month < 10) ? shifted_month + 3 : shifted_month - 9);
+    *year = year_of_era + era * 400 + ((*month <= 2) ? 1 : 0);
+}
+
+static int month_len(int64_t year, int month)
+{
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+
+    return (month == 2 && leap) ? 29 : MONTH_LENS[month - 1];
+}
+
+/*
+ * Finds the offset of local time from UTC, in seconds, at 'instant'.
+ */
+static bool offset_at(time_t instant, long *offset)
+{
+    struct tm local;
+
+    if (localtime_r(&instant, &local) == NULL) { return false; }
+
+    *offset = local.tm_gmtoff;
+
+    return true;
+}
+
+/*
+ * Finds the first local time at or after 'from', a whole minute, that the
+ * calendar fires at. Local times are counted in seconds since the epoch, as
+ * if local time were UTC. When a field has no value left, the field above it
+ * is moved on and the fields below it start over from their first value.
+ */
+static bool next_local_time(const Calendar *const calendar, int64_t from, int64_t *local)
+{
+    int64_t days = floor_div(from, SECS_PER_DAY);
+    int64_t secs = from - days * SECS_PER_DAY;
+    int hour = (int)(secs / SECS_PER_HOUR);
+    int minute = (int)(secs % SECS_PER_HOUR / SECS_PER_MINUTE);
+    int64_t year;
+    int month;
+    int day;
+
+    civil_from_days(days, &year, &month, &day);
+
+    int64_t last_year = year + SCHEDR_CALENDAR_MAX_YEARS;
+
+    while (year <= last_year)
+    {
+        uint32_t months = calendar->months & bits_from(month);
+
+        if (months == 0)
+        {
+            year++;
+            month = day = 1;
+            hour = minute = 0;
+            continue;
+        }
+
+        if (__builtin_ctz(months) != month)
+        {
+            month = __builtin_ctz(months);
+            day = 1;
+            hour = minute = 0;
+        }
+
+        days = days_from_civil(year, month, 1);
+
+        int first_weekday = (int)((days % DAYS_PER_WEEK + DAYS_PER_WEEK + 4) % DAYS_PER_WEEK);  // 1970-01-01 was a thursday
+        uint32_t days_left = calendar->days_by_first_weekday[first_weekday] & bits_from(day) & ~bits_from(month_len(year, month) + 1);
+
+        if (days_left == 0)
+        {
+            month++;
+            day = 1;
+            hour = minute = 0;
+            continue;
+        }
+
+        if (__builtin_ctz(days_left) != day)
+        {
+            day = __builtin_ctz(days_left);
+            hour = minute = 0;
+        }
+
+        uint32_t hours = calendar->hours & bits_from(hour);
+
+        if (hours == 0)
+        {
+            day++;
+            hour = minute = 0;
+            continue;
+        }
+
+        if (__builtin_ctz(hours) != hour)
+        {
+            hour = __builtin_ctz(hours);
+            minute = 0;
+        }
+
+        uint64_t minutes = calendar->minutes & (~0ULL << minute);
+
+        if (minutes == 0)
+        {
+            hour++;
+            minute = 0;
+            continue;
+        }
+
+        minute = __builtin_ctzll(minutes);
+        *local = (days + day - 1) * SECS_PER_DAY + hour * SECS_PER_HOUR + minute * SECS_PER_MINUTE;
+
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Finds the earliest instant after 'after' that the local time 'local' is at.
+ * Around a change of the clocks a local time is at an instant for every
+ * offset that is in effect at that instant: two when the clocks were put back
+ * and none when they were put forward past it. In the latter case 'skipped'
+ * is set and 'instant' is the instant the clocks were put forward.
+ */
+static bool instant_of(int64_t local, time_t after, time_t *instant, bool *skipped)
+{
+    long early_offset;
+    long late_offset;
+
+    *skipped = false;
+
+    if (!offset_at((time_t)(local - OFFSET_WINDOW_SECS), &early_offset) || !offset_at((time_t)(local + OFFSET_WINDOW_SECS), &late_offset))
+    {
+        return false;
+    }
+
+    if (early_offset == late_offset)
+    {
+        *instant = (time_t)(local - early_offset);
+        return true;
+    }
+
+    time_t early = (time_t)(local - early_offset);
+    time_t late = (time_t)(local - late_offset);
+    long offset;
+    bool early_valid = offset_at(early, &offset) && offset == early_offset;
+    bool late_valid = offset_at(late, &offset) && offset == late_offset;
+
+    bool found = false;
+
+    if (early_valid && early > after)
+    {
+        *instant = early;
+        found = true;
+    }
+
+    if (late_valid && late > after && (!found || late < *instant))
+    {
+        *instant = late;
+        found = true;
+    }
+
+    if (found || early_valid || late_valid) { return found; }
+    else
+    {
+        // 'late' is before the clocks were put forward and 'early' after, the instant they were put forward is in between
+        time_t before = late;
+        time_t since = early;
+
+        while (since - before > 1)
+        {
+            time_t middle = before + (since - before) / 2;
+
+            if (!offset_at(middle, &offset)) { return false; }
+
+            if (offset == early_offset) { before = middle; }
+            else { since = middle; }
+        }
+
+        *instant = since;
+        *skipped = true;
+    }
+
+    return true;
+}
@@ -6,19 +6,114 @@
 #include <sys/stat.h>               // fstat()
 #include <errno.h>                  // errno
 #include <ctype.h>                  // tolower()
+#include <strings.h>                // strcasecmp()
+#include <stdint.h>                 // int64_t, INT64_MAX
+#include <limits.h>                 // INT_MAX
 
 #include "schedr_config_parser.h"
+#include "schedr_metrics.h"
 #include "schedr_job.h"
+#include "schedr_hash.h"
 
 static void (*on_number_of_jobs_found_hook)(int expected_jobs) = NULL;
 
 static void *(*allocator)(size_t bytes) = malloc;
 
-static bool is_unit(const char *str);
+struct IntervalUnit
+{
+    const char *name;
+    int64_t nanoseconds;
+};
+
+static const struct IntervalUnit INTERVAL_UNITS[] = {
+    { "us", 1000LL }, { "usec", 1000LL }, { "microsecond", 1000LL }, { "microseconds", 1000LL },
+    { "ms", 1000000LL }, { "msec", 1000000LL }, { "millisecond", 1000000LL }, { "milliseconds", 1000000LL },
+    { "s", 1000000000LL }, { "sec", 1000000000LL }, { "second", 1000000000LL }, { "seconds", 1000000000LL },
+    { "m", 60000000000LL }, { "min", 60000000000LL }, { "minute", 60000000000LL }, { "minutes", 60000000000LL },
+    { "h", 3600000000000LL }, { "hour", 3600000000000LL }, { "hours", 3600000000000LL },
+    { NULL, 0 }
+};
+
+#define MAX_CALENDAR_TIMES 64
+#define CALENDAR_WEEKDAYS ((1U << 1) | (1U << 2) | (1U << 3) | (1U << 4) | (1U << 5))
+#define CALENDAR_WEEKEND ((1U << 0) | (1U << 6))
+
+/*
+ * A field of a calendar written as a list of values, by name or as ordinals
+ * if 'names' is NULL. Ranges of fields that wrap may run past the last value
+ * and on from the first, like "friday-monday".
+ */
+struct CalendarField
+{
+    const char *const *names;
+    int min;
+    int max;
+    bool wraps;
+};
+
+static const char *const WEEKDAY_NAMES[] = { "sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday" };
+static const char *const MONTH_NAMES[] = { "january", "february", "march", "april", "may", "june", "july", "august", 
+                                           "september", "october", "november", "december" };
+
+static const struct CalendarField CALENDAR_WEEKDAY_FIELD = { WEEKDAY_NAMES, 0, 6, true };
+static const struct CalendarField CALENDAR_MONTH_FIELD = { MONTH_NAMES, 1, 12, true };
+static const struct CalendarField CALENDAR_DAY_FIELD = { NULL, 1, 31, false };
+
+/*
+ * A time of day after "at", as it was written. 'meridiem' is 'a' or 'p' after
+ * "am" or "pm" and '\0' on a 24 hour clock. Named times, "noon" and 
+ * "midnight", take no meridiem.
+ */
+struct TimeOfDay
+{
+    int hour;
+    int minute;
+    char meridiem;
+    bool named;
+};
+
+static int64_t unit_to_ns(const char *str);
 static bool is_digit(const char *str);
+static void init_settings(Settings *const settings);
 static Status find_number_of_jobs(FILE *fp, char **file_contents, size_t *number_of_jobs);
-static Status parse_file_contents(char *file_contents, Job **loaded_jobs, int *jobs_count, int expected_jobs_len);
-static bool str_equals_ign_case(const char *str_1, const char *str2);
+static Status parse_file_contents(char *file_contents, Settings *settings, Job **loaded_jobs, int *jobs_count, int expected_jobs_len);
+static bool parse_positive_int(const char *str, int *value);
+static bool parse_duration(const char *delim, int64_t *duration_ns);
+static bool parse_duration_from(char *tok, const char *delim, int64_t *duration_ns);
+/*
+ * Jobs are controlled and reloaded by their names, so no two jobs may share one.
+ */
+static Status check_names_are_unique(const Job jobs[], int jobs_len)
+{
+    StringHashMap names;
+    Status status = SCHEDR_SUCCESS;
+
+    schedr_hash_strings_init(&names);
+
+    for (int i = 0; i < jobs_len && status == SCHEDR_SUCCESS; i++)
+    {
+        if (schedr_hash_strings_get(&names, jobs[i].name) != NULL) { status = SCHEDR_ERROR_CONFIG_FORMAT; }
+        else if (schedr_hash_strings_put(&names, jobs[i].name, (void *)&(jobs[i])) != SCHEDR_SUCCESS) { status = SCHEDR_ERROR_ALLOCATION_FAILED; }
+    }
+
+    schedr_hash_strings_destroy(&names);
+
+    return status;
+}
+
+static int calendar_value_of(const struct CalendarField *field, const char *item, size_t item_len);
+static bool is_calendar_list(const char *word, const struct CalendarField *field);
+static bool parse_calendar_list(char *tok, const char *delim, const struct CalendarField *field, uint64_t *bits);
+static bool parse_time_of_day(const char *item, size_t item_len, bool hourly, struct TimeOfDay *time);
+static bool parse_times(const char *delim, bool hourly, Calendar *const calendar, char **next_word);
+static bool parse_calendar(char *period, const char *delim, Calendar *const calendar, char **next_word);
+static bool parse_percent(const char *str, int max, int *value);
+static bool parse_bytes(const char *str, int64_t *value);
+static bool parse_int_in_range(const char *str, int min, int max, int *value);
+static bool is_placement(const char *word);
+static bool parse_placement(const char *word, const char *delim, Limits *const limits);
+static Status parse_overlap(Job *const job_p, char *policy);
+static Status check_names_are_unique(const Job jobs[], int jobs_len);
 
 #ifdef TEST
 void schedr_config_set_allocator(void *(*alloc_func)(size_t bytes)) { allocator = alloc_func; }
@@ -29,6 +124,15 @@ void schedr_config_remove_on_number_of_jobs_found_hook() { on_number_of_jobs_fou
 
 Status schedr_config_load_jobs(Job *jobs[], int *loaded_jobs_count, const char *filepath)
 {
+    Settings settings;
+
+    return schedr_config_load(&settings, jobs, loaded_jobs_count, filepath);
+}
+
+Status schedr_config_load(Settings *const settings, Job *jobs[], int *loaded_jobs_count, const char *filepath)
+{
+    if (settings == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
     if (*jobs != NULL)
     {
         return SCHEDR_ERROR_INVALID_ARGUMENT;
@@ -68,10 +172,13 @@ Status schedr_config_load_jobs(Job *jobs[], int *loaded_jobs_count, const char *
         return SCHEDR_ERROR_ALLOCATION_FAILED;
     }
 
-    status = parse_file_contents(file_contents, &loaded_jobs, &jobs_count, expected_jobs_len);
+    init_settings(settings);
+    status = parse_file_contents(file_contents, settings, &loaded_jobs, &jobs_count, expected_jobs_len);
     
     free(file_contents);
     
+    if (status == SCHEDR_SUCCESS) { status = check_names_are_unique(loaded_jobs, jobs_count); }
+    
     if (status == SCHEDR_SUCCESS)
     {
         *jobs = loaded_jobs;
@@ -85,27 +192,559 @@ Status schedr_config_load_jobs(Job *jobs[], int *loaded_jobs_count, const char *
     return status;
 }
 
-static bool is_unit(const char *str)
+Status schedr_config_parse_job(Job *const job_p, const char *text)
 {
-    if (str_equals_ign_case("s", str) || str_equals_ign_case("sec", str)
-        || str_equals_ign_case("second", str) || str_equals_ign_case("seconds", str))
+    if (job_p == NULL || text == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    Job parsed;
+    Job *parsed_p = &parsed;
+    int jobs_count = 0;
+    Settings settings;
+    char *contents = strdup(text);
+
+    if (contents == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    init_settings(&settings);
+
+    Status status = parse_file_contents(contents, &settings, &parsed_p, &jobs_count, 1);
+
+    free(contents);
+
+    if (status != SCHEDR_SUCCESS) { return status; }
+    if (jobs_count != 1 || parsed.command[0] == '\0') { return SCHEDR_ERROR_CONFIG_FORMAT; }
+    if (parsed.interval_ns <= 0 && parsed.monitor[0] == '\0' && !schedr_calendar_is_set(&(parsed.calendar)))
     {
-        return true;
+        return SCHEDR_ERROR_CONFIG_FORMAT;
     }
-    else if (str_equals_ign_case("m", str) || str_equals_ign_case("min", str)
-        || str_equals_ign_case("minute", str) || str_equals_ign_case("minutes", str))
+
+    *job_p = parsed;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void init_settings(Settings *const settings)
+{
+    settings->max_concurrent = 0;
+    settings->splay_ns = 0;
+    settings->splay_mode = SplayHashed;
+    settings->output_len = SCHEDR_OUTPUT_DEFAULT_RING_LEN;
+    settings->log_rotation.max_file_len = SCHEDR_LOG_DEFAULT_MAX_FILE_LEN;
+    settings->log_rotation.max_age_ns = SCHEDR_LOG_DEFAULT_MAX_AGE_NS;
+    settings->log_rotation.keep = SCHEDR_LOG_DEFAULT_KEEP;
+    settings->loop_backend = LoopEpoll;
+    schedr_limits_init(&(settings->daemon_limits));
+    settings->metrics_port = 0;
+}
+
+/*
+ * Returns the number of nanoseconds in the interval unit 'str', or 0 if 'str'
+ * is not a unit. 
+ */
+static int64_t unit_to_ns(const char *str)
+{
+    for (int i = 0; INTERVAL_UNITS[i].name != NULL; i++)
     {
-        return true;
+        if (strcasecmp(INTERVAL_UNITS[i].name, str) == 0) { return INTERVAL_UNITS[i].nanoseconds; }
     }
-    else if (str_equals_ign_case("h", str) || str_equals_ign_case("hour", str) 
-        || str_equals_ign_case("hours", str))
+
+    return 0;
+}
+
+/*
+ * Parses a number >= 1 that fits in an int, returning false if 'str' is not one.
+ */
+static bool parse_positive_int(const char *str, int *value)
+{
+    if (str == NULL || !is_digit(str)) { return false; }
+
+    errno = 0;
+    long parsed = strtol(str, NULL, 10);
+
+    if (errno == ERANGE || parsed < 1 || parsed > INT_MAX) { return false; }
+
+    *value = (int)parsed;
+
+    return true;
+}
+
+/*
+ * Parses the duration in the next words, '[<value>] <unit>', where the value
+ * defaults to 1.
+ */
+static bool parse_duration(const char *delim, int64_t *duration_ns)
+{
+    return parse_duration_from(strtok(NULL, delim), delim, duration_ns);
+}
+
+/*
+ * Parses a duration like parse_duration(), starting with the word 'tok'.
+ */
+static bool parse_duration_from(char *tok, const char *delim, int64_t *duration_ns)
+{
+    long long value = 1;
+    int64_t unit_ns = 0;
+
+    if (tok == NULL) { return false; }
+    else if (is_digit(tok))
     {
+        errno = 0;
+        value = strtoll(tok, NULL, 10);
+        tok = strtok(NULL, delim);
+
+        if (tok == NULL || errno == ERANGE) { return false; }
+    }
+
+    unit_ns = unit_to_ns(tok);
+
+    if (unit_ns == 0 || value > INT64_MAX / unit_ns) { return false; }
+
+    *duration_ns = value * unit_ns;
+
+    return true;
+}
+
+/*
+ * Parses a percentage written as '<value>%', from 0 up to 'max'.
+ */
+static bool parse_percent(const char *str, int max, int *value)
+{
+    if (str == NULL || !isdigit((unsigned char)str[0])) { return false; }
+
+    char *end;
+    errno = 0;
+    long parsed = strtol(str, &end, 10);
+
+    if (strcmp(end, "%") != 0 || errno == ERANGE || parsed > max) { return false; }
+
+    *value = (int)parsed;
+
+    return true;
+}
+
+/*
+ * Parses a size written as '<value>[K|M|G]', optionally followed by a 'B',
+ * into a number of bytes >= 1.
+ */
+static bool parse_bytes(const char *str, int64_t *value)
+{
+    static const char UNITS[] = "KMG";
+
+    if (str == NULL || !isdigit((unsigned char)str[0])) { return false; }
+
+    char *end;
+    errno = 0;
+    long long parsed = strtoll(str, &end, 10);
+    const char *unit_char = (*end != '\0') ? strchr(UNITS, toupper((unsigned char)*end)) : NULL;
+    int64_t unit = 1;
+
+    if (unit_char != NULL)
+    {
+        for (const char *c = UNITS; c <= unit_char; c++) { unit *= 1024; }
+
+        end++;
+    }
+
+    if (toupper((unsigned char)*end) == 'B') { end++; }
+
+    if (*end != '\0' || errno == ERANGE || parsed < 1 || parsed > INT64_MAX / unit) { return false; }
+
+    *value = parsed * unit;
+
+    return true;
+}
+
+/*
+ * Parses a number from 'min' up to 'max', which may be negative.
+ */
+static bool parse_int_in_range(const char *str, int min, int max, int *value)
+{
+    if (str == NULL) { return false; }
+
+    const char *digits = (str[0] == '-') ? str + 1 : str;
+
+    if (digits[0] == '\0' || !is_digit(digits)) { return false; }
+
+    errno = 0;
+    long parsed = strtol(str, NULL, 10);
+
+    if (errno == ERANGE || parsed < min || parsed > max) { return false; }
+
+    *value = (int)parsed;
+
+    return true;
+}
+
+static bool is_placement(const char *word)
+{
+    return strcasecmp(word, "cpus") == 0 || strcasecmp(word, "numa") == 0 ||
+           strcasecmp(word, "nice") == 0 || strcasecmp(word, "ioprio") == 0;
+}
+
+/*
+ * Parses the placement named by 'word' from the next words into 'limits', one
+ * of 'cpus <list>', 'numa node <n>', 'nice <n>', 'ioprio idle',
+ * 'ioprio best-effort <level>' or 'ioprio realtime <level>'.
+ */
+static bool parse_placement(const char *word, const char *delim, Limits *const limits)
+{
+    char *tok = strtok(NULL, delim);
+
+    if (word == NULL || tok == NULL) { return false; }
+
+    if (strcasecmp(word, "cpus") == 0) { return schedr_limits_set_cpus(limits, tok) == SCHEDR_SUCCESS; }
+
+    if (strcasecmp(word, "numa") == 0)
+    {
+        int node;
+
+        return strcasecmp(tok, "node") == 0 &&
+               parse_int_in_range(strtok(NULL, delim), 0, SCHEDR_LIMITS_MAX_NUMA_NODES - 1, &node) &&
+               schedr_limits_set_numa_node(limits, node) == SCHEDR_SUCCESS;
+    }
+
+    if (strcasecmp(word, "nice") == 0)
+    {
+        limits->nice_set = parse_int_in_range(tok, SCHEDR_LIMITS_MIN_NICE, SCHEDR_LIMITS_MAX_NICE, &(limits->nice));
+
+        return limits->nice_set;
+    }
+
+    if (strcasecmp(word, "ioprio") != 0) { return false; }
+
+    if (strcasecmp(tok, "idle") == 0)
+    {
+        limits->io_priority_class = IoPriorityIdle;
+        limits->io_priority_level = 0;
+
         return true;
     }
 
+    if (strcasecmp(tok, "best-effort") == 0) { limits->io_priority_class = IoPriorityBestEffort; }
+    else if (strcasecmp(tok, "realtime") == 0) { limits->io_priority_class = IoPriorityRealtime; }
+    else { return false; }
+
+    return parse_int_in_range(strtok(NULL, delim), 0, SCHEDR_LIMITS_MAX_IO_PRIORITY_LEVEL, &(limits->io_priority_level));
+}
+
+/*
+ * Sets the overlap policy named by 'policy', one of wait, skip, queue or 
+ * parallel(<N>).
+ */
+static Status parse_overlap(Job *const job_p, char *policy)
+{
+    static const char PARALLEL[] = "parallel(";
+
+    if (policy == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+    if (strcasecmp(policy, "wait") == 0) { return schedr_job_set_overlap(job_p, OverlapWait, 1); }
+    if (strcasecmp(policy, "skip") == 0) { return schedr_job_set_overlap(job_p, OverlapSkip, 1); }
+    if (strcasecmp(policy, "queue") == 0) { return schedr_job_set_overlap(job_p, OverlapQueue, 1); }
+
+    size_t len = strlen(policy);
+    int max_parallel;
+
+    if (strncasecmp(policy, PARALLEL, sizeof (PARALLEL) - 1) != 0 || policy[len - 1] != ')') { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+    policy[len - 1] = '\0';
+
+    if (!parse_positive_int(policy + sizeof (PARALLEL) - 1, &max_parallel)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+    return schedr_job_set_overlap(job_p, OverlapParallel, max_parallel);
+}
+
+/*
+ * Returns the value of a field of a calendar written as 'item', a name or its
+ * first three letters, or an ordinal like "1st" or "22nd", or -1 if it is not
+ * one.
+ */
+static int calendar_value_of(const struct CalendarField *field, const char *item, size_t item_len)
+{
+    if (field->names != NULL)
+    {
+        for (int value = field->min; value <= field->max; value++)
+        {
+            const char *name = field->names[value - field->min];
+
+            if ((item_len == strlen(name) || item_len == 3) && strncasecmp(name, item, item_len) == 0) { return value; }
+        }
+
+        return -1;
+    }
+
+    int value = 0;
+    size_t i = 0;
+
+    for (; i < item_len && i < 2 && isdigit((unsigned char)item[i]); i++) { value = value * 10 + (item[i] - '0'); }
+
+    if (i == 0 || item_len - i != 2 || value < field->min || value > field->max) { return -1; }
+
+    // 1st, 2nd, 3rd, 4th, ..., 11th, 12th, 13th, ..., 21st
+    const char *suffix = "th";
+
+    if (value % 10 == 1 && value != 11) { suffix = "st"; }
+    else if (value % 10 == 2 && value != 12) { suffix = "nd"; }
+    else if (value % 10 == 3 && value != 13) { suffix = "rd"; }
+
+    return (strncasecmp(item + i, suffix, 2) == 0) ? value : -1;
+}
+
+/*
+ * Tells if 'word' starts a list of values of 'field'.
+ */
+static bool is_calendar_list(const char *word, const struct CalendarField *field)
+{
+    return calendar_value_of(field, word, strcspn(word, ",-")) >= 0;
+}
+
+/*
+ * Parses a list of values of a field of a calendar starting with the word
+ * 'tok', like "monday-wednesday, friday", setting a bit in 'bits' for every
+ * value in it. The list goes on in the next word for as long as the words end
+ * with a comma.
+ */
+static bool parse_calendar_list(char *tok, const char *delim, const struct CalendarField *field, uint64_t *bits)
+{
+    *bits = 0;
+
+    for (; tok != NULL; tok = strtok(NULL, delim))
+    {
+        bool goes_on = false;
+
+        for (const char *item = tok; *item != '\0'; item += goes_on ? 1 : 0)
+        {
+            size_t item_len = strcspn(item, ",");
+            const char *dash = memchr(item, '-', item_len);
+            int first = calendar_value_of(field, item, (dash != NULL) ? (size_t)(dash - item) : item_len);
+            int last = (dash != NULL) ? calendar_value_of(field, dash + 1, item_len - (size_t)(dash + 1 - item)) : first;
+
+            if (first < 0 || last < 0 || (last < first && !field->wraps)) { return false; }
+
+            for (int value = first; ; value = (value == field->max) ? field->min : value + 1)
+            {
+                *bits |= 1ULL << value;
+
+                if (value == last) { break; }
+            }
+
+            item += item_len;
+            goes_on = *item == ',';
+        }
+
+        if (!goes_on) { return true; }
+    }
+
     return false;
 }
 
+/*
+ * Parses a time of day, like "9", "9:30", "9:30pm", "noon" or "midnight", or
+ * only the minutes, like ":15", for a calendar that fires every hour.
+ */
+static bool parse_time_of_day(const char *item, size_t item_len, bool hourly, struct TimeOfDay *time)
+{
+    size_t i = 0;
+
+    time->hour = time->minute = 0;
+    time->meridiem = '\0';
+    time->named = !hourly && ((item_len == 4 && strncasecmp(item, "noon", 4) == 0) || 
+                              (item_len == 8 && strncasecmp(item, "midnight", 8) == 0));
+
+    if (time->named)
+    {
+        time->hour = (item_len == 4) ? 12 : 0;
+        return true;
+    }
+
+    for (; i < item_len && i < 2 && isdigit((unsigned char)item[i]); i++) { time->hour = time->hour * 10 + (item[i] - '0'); }
+
+    // The hours are given by the calendar of an hourly job, and its minutes have to be
+    if ((i == 0) != hourly || (hourly && (i == item_len || item[i] != ':'))) { return false; }
+
+    if (i < item_len && item[i] == ':')
+    {
+        if (item_len - i < 3 || !isdigit((unsigned char)item[i + 1]) || !isdigit((unsigned char)item[i + 2])) { return false; }
+
+        time->minute = (item[i + 1] - '0') * 10 + (item[i + 2] - '0');
+        i += 3;
+    }
+
+    if (!hourly && item_len - i == 2 && (strncasecmp(item + i, "am", 2) == 0 || strncasecmp(item + i, "pm", 2) == 0))
+    {
+        time->meridiem = (char)tolower(item[i]);
+        i += 2;
+    }
+
+    return i == item_len && time->minute < 60;
+}
+
+/*
+ * Parses the times of day after "at" into the hours and minutes of
+ * 'calendar', like "noon", "12 am" or "9, 17:00". A meridiem may follow a time
+ * as a word of its own. A calendar fires at every pair of its hours and
+ * minutes, so the times have to be all those pairs: "9:00, 17:30" is an error,
+ * since the calendar would fire at 9:30 and 17:00 too. The first word after
+ * the times is left in 'next_word'.
+ */
+static bool parse_times(const char *delim, bool hourly, Calendar *const calendar, char **next_word)
+{
+    struct TimeOfDay times[MAX_CALENDAR_TIMES];
+    int times_len = 0;
+    bool time_expected = true;
+    char *word;
+
+    for (word = strtok(NULL, delim); word != NULL; word = strtok(NULL, delim))
+    {
+        size_t word_len = strlen(word);
+        bool goes_on = word[word_len - 1] == ',';
+        size_t meridiem_len = word_len - (goes_on ? 1 : 0);
+
+        if (!time_expected && meridiem_len == 2 && (strncasecmp(word, "am", 2) == 0 || strncasecmp(word, "pm", 2) == 0))
+        {
+            struct TimeOfDay *last = &(times[times_len - 1]);
+
+            if (hourly || last->named || last->meridiem != '\0') { return false; }
+
+            last->meridiem = (char)tolower(word[0]);
+        }
+        else if (!time_expected) { break; }
+        else
+        {
+            for (const char *item = word; *item != '\0'; )
+            {
+                size_t item_len = strcspn(item, ",");
+
+                if (times_len == MAX_CALENDAR_TIMES || !parse_time_of_day(item, item_len, hourly, &(times[times_len]))) { return false; }
+
+                times_len++;
+                item += item_len + ((item[item_len] == ',') ? 1 : 0);
+            }
+        }
+
+        time_expected = goes_on;
+    }
+
+    if (time_expected) { return false; }
+
+    uint64_t minutes_by_hour[24] = { 0 };
+    int pairs = 0;
+
+    calendar->hours = hourly ? SCHEDR_CALENDAR_ALL_HOURS : 0;
+    calendar->minutes = 0;
+
+    for (int i = 0; i < times_len; i++)
+    {
+        int hour = times[i].hour;
+
+        if (times[i].meridiem != '\0' && (hour < 1 || hour > 12)) { return false; }
+        if (times[i].meridiem != '\0') { hour = hour % 12 + ((times[i].meridiem == 'p') ? 12 : 0); }
+        if (hour > 23) { return false; }
+
+        if (!hourly)
+        {
+            pairs += ((minutes_by_hour[hour] >> times[i].minute) & 1) ? 0 : 1;
+            minutes_by_hour[hour] |= 1ULL << times[i].minute;
+            calendar->hours |= 1U << hour;
+        }
+
+        calendar->minutes |= 1ULL << times[i].minute;
+    }
+
+    *next_word = word;
+
+    return hourly || pairs == __builtin_popcount(calendar->hours) * __builtin_popcountll(calendar->minutes);
+}
+
+/*
+ * Parses a calendar from its period, the word after "every", and the options
+ * after it: the months after "in", the times after "at" and the days of the
+ * week or month it is narrowed to. The period is "day", "weekday", "weekend",
+ * "month", "hour", a list of days of the week or a list of days of the month.
+ * Without times the calendar fires at midnight, or on the hour if it fires
+ * every hour. A bare "hour" is an interval, which leaves the calendar unset.
+ * The first word that is not an option is left in 'next_word'.
+ */
+static bool parse_calendar(char *period, const char *delim, Calendar *const calendar, char **next_word)
+{
+    bool hourly = strcasecmp(period, "hour") == 0;
+    bool weekdays_given;
+    bool days_given;
+    bool months_given = false;
+    bool times_given = false;
+    uint64_t bits;
+    char *word;
+
+    schedr_calendar_init(calendar);
+    calendar->minutes = 1ULL << 0;
+    calendar->hours = hourly ? SCHEDR_CALENDAR_ALL_HOURS : (1U << 0);
+    calendar->days = SCHEDR_CALENDAR_ALL_DAYS;
+    calendar->months = SCHEDR_CALENDAR_ALL_MONTHS;
+    calendar->weekdays = SCHEDR_CALENDAR_ALL_WEEKDAYS;
+
+    if (strcasecmp(period, "weekday") == 0 || strcasecmp(period, "weekdays") == 0) { calendar->weekdays = CALENDAR_WEEKDAYS; }
+    else if (strcasecmp(period, "weekend") == 0 || strcasecmp(period, "weekends") == 0) { calendar->weekdays = CALENDAR_WEEKEND; }
+    else if (strcasecmp(period, "month") == 0) { calendar->days = 1U << 1; }
+    else if (is_calendar_list(period, &CALENDAR_WEEKDAY_FIELD))
+    {
+        if (!parse_calendar_list(period, delim, &CALENDAR_WEEKDAY_FIELD, &bits)) { return false; }
+
+        calendar->weekdays = (uint8_t)bits;
+    }
+    else if (is_calendar_list(period, &CALENDAR_DAY_FIELD))
+    {
+        if (!parse_calendar_list(period, delim, &CALENDAR_DAY_FIELD, &bits)) { return false; }
+
+        calendar->days = (uint32_t)bits;
+    }
+    else if (!hourly && strcasecmp(period, "day") != 0) { return false; }
+
+    // A period of days of the week may be narrowed to days of the month, like "friday 13th", and the other way around
+    weekdays_given = calendar->weekdays != SCHEDR_CALENDAR_ALL_WEEKDAYS;
+    days_given = calendar->days != SCHEDR_CALENDAR_ALL_DAYS;
+    word = strtok(NULL, delim);
+
+    while (word != NULL)
+    {
+        if (strcasecmp(word, "at") == 0 && !times_given)
+        {
+            // The word after the times has been read already
+            if (!parse_times(delim, hourly, calendar, &word)) { return false; }
+
+            times_given = true;
+            continue;
+        }
+
+        if (strcasecmp(word, "in") == 0 && !months_given)
+        {
+            if (!parse_calendar_list(strtok(NULL, delim), delim, &CALENDAR_MONTH_FIELD, &bits)) { return false; }
+
+            calendar->months = (uint16_t)bits;
+            months_given = true;
+        }
+        else if (!weekdays_given && is_calendar_list(word, &CALENDAR_WEEKDAY_FIELD))
+        {
+            if (!parse_calendar_list(word, delim, &CALENDAR_WEEKDAY_FIELD, &bits)) { return false; }
+
+            calendar->weekdays = (uint8_t)bits;
+            weekdays_given = true;
+        }
+        else if (!days_given && is_calendar_list(word, &CALENDAR_DAY_FIELD))
+        {
+            if (!parse_calendar_list(word, delim, &CALENDAR_DAY_FIELD, &bits)) { return false; }
+
+            calendar->days = (uint32_t)bits;
+            days_given = true;
+        }
+        else { break; }
+
+        word = strtok(NULL, delim);
+    }
+
+    if (hourly && !weekdays_given && !days_given && !months_given && !times_given) { schedr_calendar_init(calendar); }
+
+    *next_word = word;
+
+    return true;
+}
+
 static bool is_digit(const char *str)
 {
     for (int i = 0; str[i]; i++)
@@ -143,20 +782,21 @@ static Status find_number_of_jobs(FILE *fp, char **file_contents, size_t *number
     fclose(fp);
     (*file_contents)[file_len] = '\0';
     
-    static const char NEW_LINE[] = "\r\n";
+    static const char DEFAULT_DELIM[] = " \t\r\n\v\f";
 
     size_t result = 0;
 
     strncpy(cpy, *file_contents, file_len + 1);
     cpy[file_len] = '\0';
 
-    char *line = strtok(cpy, NEW_LINE);
+    // Every word "Job" is counted, those in names and commands too, so there is room for every job however it is written
+    char *word = strtok(cpy, DEFAULT_DELIM);
 
-    while (line != NULL)
+    while (word != NULL)
     {
-        if (str_equals_ign_case("Job", line)) { result++; }
+        if (strcasecmp("Job", word) == 0) { result++; }
 
-        line = strtok(NULL, NEW_LINE);
+        word = strtok(NULL, DEFAULT_DELIM);
     }
 
     free(cpy);
@@ -171,7 +811,7 @@ static Status find_number_of_jobs(FILE *fp, char **file_contents, size_t *number
     return SCHEDR_SUCCESS;
 }
 
-static Status parse_file_contents(char *file_contents, Job **loaded_jobs, int *jobs_count, int expected_jobs_len)
+static Status parse_file_contents(char *file_contents, Settings *settings, Job **loaded_jobs, int *jobs_count, int expected_jobs_len)
 {
     static const char DEFAULT_DELIM[] = " \t\r\n\v\f";
     static const char NAME_DELIM[] = "\"";
@@ -183,15 +823,13 @@ static Status parse_file_contents(char *file_contents, Job **loaded_jobs, int *j
 
     while (word != NULL)
     {
-        if (*jobs_count > expected_jobs_len)
+        if (strcasecmp("Job", word) == 0)
         {
-            return SCHEDR_ERROR_CONFIG_FORMAT;
-        }
+            if (*jobs_count >= expected_jobs_len) { return SCHEDR_ERROR_CONFIG_FORMAT; }
 
-        if (str_equals_ign_case("Job", word))
-        {
             current_job = &(job_list[*jobs_count]);
             schedr_job_init(current_job);
+            schedr_job_set_splay(current_job, settings->splay_ns);
             (*jobs_count)++;
 
             word = strtok(NULL, NAME_DELIM); 
@@ -200,64 +838,273 @@ static Status parse_file_contents(char *file_contents, Job **loaded_jobs, int *j
             else { schedr_job_set_name(current_job, word, strlen(word)); }
         }
 
-        else if (str_equals_ign_case("run", word))
+        else if (strcasecmp("run", word) == 0)
         {
             if (current_job != NULL)
             {
                 word = strtok(NULL, CMD_DELIM);
                 
                 if (word == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
-                else { schedr_job_set_command(current_job, word, strlen(word)); }
+                else 
+                { 
+                    schedr_job_set_command(current_job, word, strlen(word)); 
+                    schedr_job_compile_command(current_job);
+                }
             }
         }
-        // TODO: Refactor crap code below 
-        else if (str_equals_ign_case("every", word))
+        else if (strcasecmp("every", word) == 0)
         {
             if (current_job != NULL)
             {
-                int seconds = 0;
                 char *tok = strtok(NULL, DEFAULT_DELIM);
-                char val[12];
-                char unit[20];
+                int64_t interval_ns;
+                Calendar calendar;
 
                 if (tok == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
-                else if (is_unit(tok)) 
+
+                // A number or a unit is an interval, anything else a calendar, which may be followed by options
+                if (is_digit(tok) || (unit_to_ns(tok) > 0 && strcasecmp(tok, "hour") != 0))
                 {
-                    strncpy(unit, tok, sizeof (unit) - 1);
-                    strncpy(val, "1", 2);
+                    if (!parse_duration_from(tok, DEFAULT_DELIM, &interval_ns)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                    schedr_job_set_interval(current_job, interval_ns);
+                    schedr_calendar_init(&(current_job->calendar));
                 }
-                else if (is_digit(tok))
+                else
                 {
-                    strncpy(val, tok, sizeof (val) - 1);
-                    tok = strtok(NULL, DEFAULT_DELIM);
+                    if (!parse_calendar(tok, DEFAULT_DELIM, &calendar, &word)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                    if (!schedr_calendar_is_set(&calendar)) { schedr_job_set_interval(current_job, unit_to_ns(tok)); }
+                    else if (schedr_job_set_calendar(current_job, &calendar) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+                    else { schedr_job_set_interval(current_job, 0); }
 
-                    if (tok == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
-                    else if (is_unit(tok)) { strncpy(unit, tok, sizeof (unit) - 1); }
-                    else { return SCHEDR_ERROR_CONFIG_FORMAT; }
+                    continue;
                 }
+            }
+        }
+        else if (strcasecmp("when", word) == 0)
+        {
+            if (current_job == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *monitor = strtok(NULL, CMD_DELIM);
+            char *tok = (monitor != NULL) ? strtok(NULL, DEFAULT_DELIM) : NULL;
+
+            if (tok == NULL || strcasecmp(tok, "outputs") != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *pattern = strtok(NULL, NAME_DELIM);
+
+            if (pattern == NULL || schedr_job_set_trigger(current_job, monitor, strlen(monitor), pattern, strlen(pattern)) != SCHEDR_SUCCESS)
+            {
+                return SCHEDR_ERROR_CONFIG_FORMAT;
+            }
+        }
+        else if (strcasecmp("splay", word) == 0)
+        {
+            int64_t splay_ns;
+
+            if (!parse_duration(DEFAULT_DELIM, &splay_ns)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            if (current_job != NULL) { schedr_job_set_splay(current_job, splay_ns); }
+            else
+            {
+                // The splay before the first job is the default of every job, optionally followed by how it is spread
+                settings->splay_ns = splay_ns;
+                word = strtok(NULL, DEFAULT_DELIM);
+
+                if (word != NULL && strcasecmp(word, "hashed") == 0) { settings->splay_mode = SplayHashed; }
+                else if (word != NULL && strcasecmp(word, "random") == 0) { settings->splay_mode = SplayRandom; }
+                else { continue; }
+            }
+        }
+        else if (strcasecmp("fixed", word) == 0)
+        {
+            if (current_job != NULL)
+            {
+                char *tok = strtok(NULL, DEFAULT_DELIM);
+
+                if (tok == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+                else if (strcasecmp("rate", tok) == 0) { schedr_job_set_timing(current_job, FixedRate); }
+                else if (strcasecmp("delay", tok) == 0) { schedr_job_set_timing(current_job, FixedDelay); }
                 else { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            }
+        }
+        else if (strcasecmp("weight", word) == 0)
+        {
+            if (current_job != NULL)
+            {
+                int weight;
+
+                if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &weight)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                schedr_job_set_weight(current_job, weight);
+            }
+        }
+        else if (strcasecmp("on", word) == 0)
+        {
+            if (current_job != NULL)
+            {
+                char *tok = strtok(NULL, DEFAULT_DELIM);
+
+                if (tok == NULL || strcasecmp("overlap", tok) != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+                if (parse_overlap(current_job, strtok(NULL, DEFAULT_DELIM)) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            }
+        }
+        else if (strcasecmp("retry", word) == 0)
+        {
+            if (current_job == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
 
-                seconds = atoi(val);
+            RetryPolicy policy = current_job->retry;
+            bool max_given = false;
 
-                if (str_equals_ign_case("s", unit) || str_equals_ign_case("sec", unit) 
-                    || str_equals_ign_case("second", unit) || str_equals_ign_case("seconds", unit))
+            if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &(policy.max_attempts))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            // The options may follow in any order, the first word that is not one of them is the next keyword
+            for (word = strtok(NULL, DEFAULT_DELIM); word != NULL; word = strtok(NULL, DEFAULT_DELIM))
+            {
+                if (strcasecmp(word, "backoff") == 0)
                 {
-                    seconds = seconds * 1;
+                    if (!parse_duration(DEFAULT_DELIM, &(policy.backoff_ns))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
                 }
-                else if (str_equals_ign_case("m", unit) || str_equals_ign_case("min", unit) 
-                    || str_equals_ign_case("minute", unit) || str_equals_ign_case("minutes", unit))
+                else if (strcasecmp(word, "max") == 0)
                 {
-                    seconds = seconds * 60;
+                    if (!parse_duration(DEFAULT_DELIM, &(policy.max_backoff_ns))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                    max_given = true;
                 }
-                else if (str_equals_ign_case("h", unit) || str_equals_ign_case("hour", unit) 
-                    || str_equals_ign_case("hours", unit))
+                else if (strcasecmp(word, "jitter") == 0)
                 {
-                    seconds = seconds * 3600;
+                    if (!parse_percent(strtok(NULL, DEFAULT_DELIM), 100, &(policy.jitter_percent))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
                 }
-                else { return SCHEDR_ERROR_CONFIG_FORMAT; }
+                else { break; }
+            }
+
+            // A first backoff longer than the default cap is not cut short
+            if (!max_given && policy.max_backoff_ns < policy.backoff_ns) { policy.max_backoff_ns = policy.backoff_ns; }
+
+            if (schedr_job_set_retry(current_job, &policy) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            continue;
+        }
+        else if (strcasecmp("cooldown", word) == 0)
+        {
+            if (current_job == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            RetryPolicy policy = current_job->retry;
+
+            if (!parse_duration(DEFAULT_DELIM, &(policy.cooldown_ns))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            if (schedr_job_set_retry(current_job, &policy) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (is_placement(word))
+        {
+            if (current_job == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            Limits limits = current_job->limits;
+
+            if (!parse_placement(word, DEFAULT_DELIM, &limits) || schedr_job_set_limits(current_job, &limits) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("daemon", word) == 0)
+        {
+            // The CPUs the daemon itself runs on come before the first job
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            word = strtok(NULL, DEFAULT_DELIM);
+
+            if (word == NULL || strcasecmp(word, "cpus") != 0 || !parse_placement(word, DEFAULT_DELIM, &(settings->daemon_limits))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("cpu", word) == 0 || strcasecmp("memory", word) == 0 || 
+                 strcasecmp("io", word) == 0 || strcasecmp("pids", word) == 0)
+        {
+            if (current_job == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
 
-                schedr_job_set_interval(current_job, seconds);
+            Limits limits = current_job->limits;
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+            bool parsed;
+
+            if (strcasecmp("cpu", word) == 0) { parsed = parse_percent(tok, SCHEDR_LIMITS_MAX_CPU_PERCENT, &(limits.cpu_percent)); }
+            else if (strcasecmp("memory", word) == 0) { parsed = parse_bytes(tok, &(limits.memory_bytes)); }
+            else if (strcasecmp("pids", word) == 0) { parsed = parse_positive_int(tok, &(limits.pids)); }
+            else
+            {
+                parsed = (tok != NULL && strcasecmp("weight", tok) == 0 && 
+                          parse_positive_int(strtok(NULL, DEFAULT_DELIM), &(limits.io_weight)));
             }
+
+            if (!parsed || schedr_job_set_limits(current_job, &limits) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("max", word) == 0)
+        {
+            // Settings of the scheduler come before the first job
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+
+            if (tok == NULL || strcasecmp("concurrent", tok) != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &(settings->max_concurrent))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("output", word) == 0)
+        {
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+            int output_kb;
+
+            if (tok == NULL || strcasecmp("buffer", tok) != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &output_kb)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            tok = strtok(NULL, DEFAULT_DELIM);
+
+            if (tok == NULL || strcasecmp(tok, "KB") != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            settings->output_len = (size_t)output_kb * 1024;
+
+            if (settings->output_len < SCHEDR_OUTPUT_MIN_RING_LEN) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("metrics", word) == 0)
+        {
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+
+            if (tok == NULL || strcasecmp("port", tok) != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            if (!parse_int_in_range(strtok(NULL, DEFAULT_DELIM), 1, SCHEDR_METRICS_MAX_PORT, &(settings->metrics_port))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("loop", word) == 0)
+        {
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+
+            if (tok != NULL && strcasecmp(tok, "io_uring") == 0) { settings->loop_backend = LoopUring; }
+            else if (tok != NULL && strcasecmp(tok, "epoll") == 0) { settings->loop_backend = LoopEpoll; }
+            else { return SCHEDR_ERROR_CONFIG_FORMAT; }
+        }
+        else if (strcasecmp("log", word) == 0)
+        {
+            if (current_job != NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+            char *tok = strtok(NULL, DEFAULT_DELIM);
+            int value;
+
+            if (tok == NULL) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            else if (strcasecmp("size", tok) == 0)
+            {
+                if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &value)) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                tok = strtok(NULL, DEFAULT_DELIM);
+
+                if (tok == NULL || strcasecmp(tok, "MB") != 0) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+
+                settings->log_rotation.max_file_len = (size_t)value * 1024 * 1024;
+            }
+            else if (strcasecmp("age", tok) == 0)
+            {
+                if (!parse_duration(DEFAULT_DELIM, &(settings->log_rotation.max_age_ns))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            }
+            else if (strcasecmp("keep", tok) == 0)
+            {
+                if (!parse_positive_int(strtok(NULL, DEFAULT_DELIM), &(settings->log_rotation.keep))) { return SCHEDR_ERROR_CONFIG_FORMAT; }
+            }
+            else { return SCHEDR_ERROR_CONFIG_FORMAT; }
         }
         else { return SCHEDR_ERROR_CONFIG_FORMAT; }
 
@@ -269,15 +1116,3 @@ static Status parse_file_contents(char *file_contents, Job **loaded_jobs, int *j
     return SCHEDR_SUCCESS;
 }
 
-static bool str_equals_ign_case(const char *str_1, const char *str_2)
-{
-    for (int i = 0; str_1[i]; i++)
-    {
-        if (tolower(str_1[i]) != tolower(str_2[i]))
-        {
-            return false;
-        }
-    }
-    
-    return true;
-}
@@ -0,0 +1,545 @@
+#define _GNU_SOURCE             // accept4()
+
+#include <stdlib.h>             // malloc(), free(), strtol()
+#include <stdio.h>              // FILE, open_memstream(), fprintf()
+#include <string.h>             // strlen(), strcmp(), strchr(), memchr()
+#include <stdbool.h>            // bool
+#include <unistd.h>             // close(), unlink(), write(), read()
+#include <errno.h>              // errno, EAGAIN, EINTR, EACCES
+#include <sys/socket.h>         // socket(), bind(), listen(), accept4(), connect()
+#include <sys/stat.h>           // umask()
+#include <sys/un.h>             // struct sockaddr_un
+
+#include "schedr_control.h"
+#include "schedr_scheduler.h"
+#include "schedr_output.h"
+#include "schedr_histogram.h"
+#include "schedr_config_parser.h"
+#include "schedr_monitor.h"
+
+#define READ_LEN 4096
+#define NANOSECS_PER_SEC 1000000000LL
+#define MAX_STATUS_LINE_LEN 16
+
+/*
+ * A client connected to the control socket. The request is read until its end
+ * of line, after which the response is written and the connection is closed.
+ */
+struct Connection
+{
+    int fd;
+    char request[SCHEDR_CONTROL_MAX_REQUEST_LEN + 1];
+    size_t request_len;
+    char *response;
+    size_t response_len;
+    size_t sent;
+    struct Connection *next;
+    struct Connection *prev;
+};
+
+typedef struct Connection Connection;
+
+static int listen_fd = -1;
+static char listen_path[sizeof (((struct sockaddr_un *)NULL)->sun_path)];
+
+static JobIndex *control_jobs = NULL;
+static void (*prepare_added_job)(Job *job_p) = NULL;
+
+static Connection connections = { .next = &connections, .prev = &connections };
+
+static void accept_connections(int fd, void *data);
+static void read_request(int fd, void *data);
+static void write_response(int fd, void *data);
+
+static Status init_address(struct sockaddr_un *addr, const char *socket_path)
+{
+    memset(addr, 0, sizeof (*addr));
+    addr->sun_family = AF_UNIX;
+
+    if (strlen(socket_path) >= sizeof (addr->sun_path)) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    strcpy(addr->sun_path, socket_path);
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_control_open(const char *socket_path, JobIndex *const jobs, void (*prepare_job)(Job *job_p))
+{
+    if (socket_path == NULL || jobs == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    struct sockaddr_un addr;
+
+    if (init_address(&addr, socket_path) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    schedr_control_close();
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd == -1) { return SCHEDR_FAILURE; }
+
+    // A daemon that was killed leaves its socket behind, which would keep the address taken
+    unlink(socket_path);
+
+    mode_t old_mask = umask(0077);
+    int bound = bind(fd, (struct sockaddr *)&addr, sizeof (addr));
+
+    umask(old_mask);
+
+    if (bound != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        Status status = (errno == EACCES) ? SCHEDR_ERROR_PERMISSION_DENIED : SCHEDR_FAILURE;
+
+        close(fd);
+
+        return status;
+    }
+
+    Status status = schedr_scheduler_watch_fd(fd, false, accept_connections, NULL);
+
+    if (status != SCHEDR_SUCCESS)
+    {
+        close(fd);
+        unlink(socket_path);
+
+        return status;
+    }
+
+    listen_fd = fd;
+    strcpy(listen_path, socket_path);
+    control_jobs = jobs;
+    prepare_added_job = prepare_job;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void close_connection(Connection *conn)
+{
+    schedr_scheduler_unwatch_fd(conn->fd);
+    close(conn->fd);
+
+    conn->prev->next = conn->next;
+    conn->next->prev = conn->prev;
+
+    free(conn->response);
+    free(conn);
+}
+
+void schedr_control_close()
+{
+    while (connections.next != &connections) { close_connection(connections.next); }
+
+    if (listen_fd == -1) { return; }
+
+    schedr_scheduler_unwatch_fd(listen_fd);
+    close(listen_fd);
+    unlink(listen_path);
+
+    listen_fd = -1;
+    control_jobs = NULL;
+    prepare_added_job = NULL;
+}
+
+static void accept_connections(int fd, void *data)
+{
+    int conn_fd;
+
+    while ((conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        Connection *conn = (Connection *)malloc(sizeof (Connection));
+
+        if (conn == NULL || schedr_scheduler_watch_fd(conn_fd, false, read_request, conn) != SCHEDR_SUCCESS)
+        {
+            close(conn_fd);
+            free(conn);
+            continue;
+        }
+
+        conn->fd = conn_fd;
+        conn->request_len = 0;
+        conn->response = NULL;
+        conn->response_len = 0;
+        conn->sent = 0;
+        conn->next = &connections;
+        conn->prev = connections.prev;
+        connections.prev->next = conn;
+        connections.prev = conn;
+    }
+}
+
+/*
+ * Looks up the job named 'job_name', printing why if there is no such job.
+ */
+static Job *find_job(const char *command, const char *job_name, FILE *out)
+{
+    if (job_name == NULL)
+    {
+        fprintf(out, "Usage: %s <job name>\n", command);
+        return NULL;
+    }
+
+    Job *job_p = schedr_job_index_find(control_jobs, job_name);
+
+    if (job_p == NULL) { fprintf(out, "No job named \"%s\"\n", job_name); }
+
+    return job_p;
+}
+
+static Status tail(const char *job_name, FILE *out)
+{
+    Job *job_p = find_job("tail", job_name, out);
+
+    if (job_p == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    const OutputRing *ring = schedr_scheduler_get_output(job_p);
+
+    // Nothing has been written by the job yet
+    if (ring == NULL) { return SCHEDR_SUCCESS; }
+
+    return schedr_output_write(ring, out);
+}
+
+static const char *state_name(JobState state)
+{
+    if (state == Running) { return "running"; }
+    if (state == Paused) { return "paused"; }
+
+    return "stopped";
+}
+
+/*
+ * Prints the state of a job, how its last run went and how it is retried.
+ */
+static Status status(const char *job_name, FILE *out)
+{
+    Job *job_p = find_job("status", job_name, out);
+
+    if (job_p == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    const RetryState *retry = &(job_p->retry_state);
+
+    fprintf(out, "state: %s\n", state_name(job_p->state));
+    fprintf(out, "last exit status: %d\n", job_p->last_exit_status);
+    fprintf(out, "failures: %llu (%d in a row)\n", (unsigned long long)retry->failures, retry->failures_in_row);
+    fprintf(out, "backoff: %.3f s\n", (double)retry->backoff_ns / NANOSECS_PER_SEC);
+    fprintf(out, "breaker: %s, tripped %llu times\n", retry->breaker_open ? "open" : "closed", 
+            (unsigned long long)retry->breaker_trips);
+
+    if (job_p->monitor[0] != '\0') { fprintf(out, "monitor: %s\n", schedr_monitor_is_running(job_p) ? "running" : "stopped"); }
+
+    return SCHEDR_SUCCESS;
+}
+
+static void print_histogram(const char *name, const Histogram *histogram, FILE *out)
+{
+    static const double NANOSECS_PER_MILLISEC = 1000000.0;
+
+    fprintf(out, "%-8s p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms, %llu runs\n", name,
+            (double)schedr_histogram_percentile(histogram, 50.0) / NANOSECS_PER_MILLISEC,
+            (double)schedr_histogram_percentile(histogram, 90.0) / NANOSECS_PER_MILLISEC,
+            (double)schedr_histogram_percentile(histogram, 99.0) / NANOSECS_PER_MILLISEC,
+            (double)histogram->max_ns / NANOSECS_PER_MILLISEC, (unsigned long long)histogram->count);
+}
+
+/*
+ * Prints how late the runs of a job, or of every job without 'job_name',
+ * were started, how long starting their commands took and how long they ran.
+ */
+static Status latency(const char *job_name, FILE *out)
+{
+    Job *job_p = NULL;
+
+    if (job_name != NULL && (job_p = find_job("latency", job_name, out)) == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    const JobLatency *latency = schedr_scheduler_get_latency(job_p);
+
+    // Nothing has been run yet
+    if (latency == NULL) { return SCHEDR_SUCCESS; }
+
+    print_histogram("lag:", &(latency->lag), out);
+    print_histogram("spawn:", &(latency->spawn), out);
+    print_histogram("runtime:", &(latency->runtime), out);
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Prints the state and the name of every job, one job per line.
+ */
+static Status list(FILE *out)
+{
+    for (int i = 0; i < control_jobs->len; i++)
+    {
+        Job *job_p = schedr_job_index_at(control_jobs, i);
+
+        fprintf(out, "%-8s %s\n", state_name(job_p->state), job_p->name);
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Adds the job written in 'text' the same way as in the configuration file,
+ * and starts it.
+ */
+static Status add(const char *text, FILE *out)
+{
+    if (text == NULL)
+    {
+        fprintf(out, "Usage: add Job \"<job name>\" run `<command>` every <interval> ...\n");
+        return SCHEDR_ERROR_INVALID_ARGUMENT;
+    }
+
+    Job *job_p = (Job *)malloc(sizeof (Job));
+
+    if (job_p == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    Status status = schedr_config_parse_job(job_p, text);
+
+    if (status != SCHEDR_SUCCESS)
+    {
+        fprintf(out, "Could not parse the job, it needs a name, a command and an interval, a calendar or a trigger\n");
+        free(job_p);
+
+        return status;
+    }
+
+    if ((status = schedr_job_index_add(control_jobs, job_p, true)) != SCHEDR_SUCCESS)
+    {
+        if (status == SCHEDR_ERROR_INVALID_ARGUMENT) { fprintf(out, "There is a job named \"%s\" already\n", job_p->name); }
+
+        free(job_p);
+
+        return status;
+    }
+
+    if (prepare_added_job != NULL) { prepare_added_job(job_p); }
+
+    if ((status = schedr_scheduler_start_job(job_p)) != SCHEDR_SUCCESS) { schedr_job_index_remove(control_jobs, job_p); }
+
+    return status;
+}
+
+/*
+ * Stops a job and forgets about it. The commands it is running are sent SIGTERM.
+ */
+static Status remove_job(const char *job_name, FILE *out)
+{
+    Job *job_p = find_job("remove", job_name, out);
+
+    if (job_p == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    schedr_scheduler_remove_job(job_p);
+
+    return schedr_job_index_remove(control_jobs, job_p);
+}
+
+/*
+ * Pauses, resumes or runs a job right away, depending on 'command'.
+ */
+static Status control_job(const char *command, const char *job_name, FILE *out)
+{
+    Job *job_p = find_job(command, job_name, out);
+    Status status;
+
+    if (job_p == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    if (strcmp(command, "pause") == 0) { status = schedr_scheduler_pause_job(job_p); }
+    else if (strcmp(command, "resume") == 0) { status = schedr_scheduler_resume_job(job_p); }
+    else { status = schedr_scheduler_run_job_now(job_p); }
+
+    if (status == SCHEDR_ERROR_INVALID_ARGUMENT) { fprintf(out, "The job is stopped\n"); }
+    if (status == SCHEDR_FAILURE) { fprintf(out, "The job is running already, the run was skipped\n"); }
+
+    return status;
+}
+
+/*
+ * Runs the command of a request, writing what it prints to 'out'.
+ */
+static Status handle_request(char *request, FILE *out)
+{
+    char *arg = strchr(request, ' ');
+
+    if (arg != NULL)
+    {
+        *arg = '\0';
+        arg++;
+    }
+
+    if (strcmp(request, "tail") == 0) { return tail(arg, out); }
+    if (strcmp(request, "status") == 0) { return status(arg, out); }
+    if (strcmp(request, "latency") == 0) { return latency(arg, out); }
+    if (strcmp(request, "list") == 0) { return list(out); }
+    if (strcmp(request, "add") == 0) { return add(arg, out); }
+    if (strcmp(request, "remove") == 0) { return remove_job(arg, out); }
+
+    if (strcmp(request, "pause") == 0 || strcmp(request, "resume") == 0 || strcmp(request, "run") == 0)
+    {
+        return control_job(request, arg, out);
+    }
+
+    fprintf(out, "Unknown command \"%s\"\n", request);
+
+    return SCHEDR_ERROR_INVALID_ARGUMENT;
+}
+
+/*
+ * Prepares the response to the request of a connection, and waits for the
+ * connection to be ready for it.
+ */
+static void respond(Connection *conn, Status status, const char *output, size_t output_len)
+{
+    FILE *fp = open_memstream(&(conn->response), &(conn->response_len));
+
+    if (fp == NULL)
+    {
+        close_connection(conn);
+        return;
+    }
+
+    fprintf(fp, "%d\n", status);
+    fwrite(output, 1, output_len, fp);
+
+    if (fclose(fp) != 0 || schedr_scheduler_watch_fd(conn->fd, true, write_response, conn) != SCHEDR_SUCCESS)
+    {
+        close_connection(conn);
+    }
+}
+
+static void read_request(int fd, void *data)
+{
+    Connection *conn = (Connection *)data;
+    ssize_t len = recv(fd, conn->request + conn->request_len, SCHEDR_CONTROL_MAX_REQUEST_LEN - conn->request_len, 0);
+
+    if (len < 0 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+    if (len <= 0)
+    {
+        close_connection(conn);
+        return;
+    }
+
+    conn->request_len += (size_t)len;
+
+    char *end = (char *)memchr(conn->request, '\n', conn->request_len);
+
+    if (end == NULL && conn->request_len < SCHEDR_CONTROL_MAX_REQUEST_LEN) { return; }
+
+    char *output = NULL;
+    size_t output_len = 0;
+    FILE *out = open_memstream(&output, &output_len);
+    Status status;
+
+    if (out == NULL)
+    {
+        close_connection(conn);
+        return;
+    }
+
+    if (end == NULL)
+    {
+        fprintf(out, "Request too long\n");
+        status = SCHEDR_ERROR_BUFFER_OVERFLOW;
+    }
+    else
+    {
+        *end = '\0';
+        status = handle_request(conn->request, out);
+    }
+
+    fclose(out);
+    respond(conn, status, output, output_len);
+    free(output);
+}
+
+static void write_response(int fd, void *data)
+{
+    Connection *conn = (Connection *)data;
+    ssize_t len = send(fd, conn->response + conn->sent, conn->response_len - conn->sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (len < 0 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+    if (len > 0) { conn->sent += (size_t)len; }
+
+    if (len < 0 || conn->sent == conn->response_len) { close_connection(conn); }
+}
+
+static bool write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(fd, buf, len);
+
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written <= 0) { return false; }
+
+        buf += written;
+        len -= (size_t)written;
+    }
+
+    return true;
+}
+
+Status schedr_control_request(const char *socket_path, const char *request, FILE *out, FILE *err)
+{
+    if (socket_path == NULL || request == NULL || out == NULL || err == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (strlen(request) >= SCHEDR_CONTROL_MAX_REQUEST_LEN) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    struct sockaddr_un addr;
+    int fd = -1;
+
+    if (init_address(&addr, socket_path) == SCHEDR_SUCCESS) { fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0); }
+
+    if (fd == -1 || connect(fd, (struct sockaddr *)&addr, sizeof (addr)) != 0
+        || !write_all(fd, request, strlen(request)) || !write_all(fd, "\n", 1))
+    {
+        fprintf(err, "Could not reach the daemon at %s, is it running?\n", socket_path);
+
+        if (fd != -1) { close(fd); }
+
+        return SCHEDR_FAILURE;
+    }
+
+    char buf[READ_LEN];
+    char status_line[MAX_STATUS_LINE_LEN + 1];
+    size_t status_line_len = 0;
+    bool status_read = false;
+    Status status = SCHEDR_FAILURE;
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof (buf))) > 0 || (len < 0 && errno == EINTR))
+    {
+        char *body = buf;
+        size_t body_len = (len > 0) ? (size_t)len : 0;
+
+        // The first line is the status code, the rest is the output of the command
+        while (!status_read && body_len > 0 && status_line_len < MAX_STATUS_LINE_LEN)
+        {
+            status_line[status_line_len++] = *body;
+            status_read = (*body == '\n');
+            body++;
+            body_len--;
+        }
+
+        if (!status_read && status_line_len == MAX_STATUS_LINE_LEN) { break; }
+
+        if (status_read && status_line_len > 0)
+        {
+            status_line[status_line_len] = '\0';
+            status = (Status)strtol(status_line, NULL, 10);
+            status_line_len = 0;
+        }
+
+        fwrite(body, 1, body_len, (status == SCHEDR_SUCCESS) ? out : err);
+    }
+
+    close(fd);
+
+    if (!status_read)
+    {
+        fprintf(err, "The daemon at %s did not respond\n", socket_path);
+        return SCHEDR_FAILURE;
+    }
+
+    return status;
+}
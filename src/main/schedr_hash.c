@@ -0,0 +1,306 @@
+#include <stdlib.h>         // calloc(), free()
+#include <stddef.h>         // size_t, NULL
+#include <stdint.h>         // uint64_t
+#include <stdbool.h>        // bool, true, false
+#include <string.h>         // strlen(), strcmp()
+
+#include "schedr_hash.h"
+
+#define INITIAL_CAPACITY 16
+
+static void *(*allocator)(size_t count, size_t bytes) = calloc;
+static uint64_t (*string_hash)(const char *str) = schedr_hash_string;
+
+static uint64_t mix(uint64_t key);
+static size_t home_slot(const HashMap *const map, uint64_t key);
+static Status grow(HashMap *const map);
+
+#ifdef TEST
+void schedr_hash_set_allocator(void *(*calloc_func)(size_t count, size_t bytes)) { allocator = calloc_func; }
+void schedr_hash_reset_allocator() { allocator = calloc; }
+void schedr_hash_set_string_hash(uint64_t (*hash_func)(const char *str)) { string_hash = hash_func; }
+void schedr_hash_reset_string_hash() { string_hash = schedr_hash_string; }
+#endif
+
+Status schedr_hash_init(HashMap *const map)
+{
+    if (map == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    map->entries = NULL;
+    map->capacity = 0;
+    map->count = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_hash_destroy(HashMap *const map)
+{
+    if (map == NULL) { return; }
+
+    free(map->entries);
+    schedr_hash_init(map);
+}
+
+Status schedr_hash_put(HashMap *const map, uint64_t key, void *value)
+{
+    if (map == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    // Keep the map at most half full, so probe sequences stay short
+    if ((map->count + 1) * 2 > map->capacity)
+    {
+        Status status = grow(map);
+
+        if (status != SCHEDR_SUCCESS) { return status; }
+    }
+
+    size_t mask = map->capacity - 1;
+    size_t slot = home_slot(map, key);
+
+    while (map->entries[slot].used && map->entries[slot].key != key) { slot = (slot + 1) & mask; }
+
+    if (!map->entries[slot].used) { map->count++; }
+
+    map->entries[slot].key = key;
+    map->entries[slot].value = value;
+    map->entries[slot].used = true;
+
+    return SCHEDR_SUCCESS;
+}
+
+void *schedr_hash_get(const HashMap *const map, uint64_t key)
+{
+    if (map == NULL || map->count == 0) { return NULL; }
+
+    size_t mask = map->capacity - 1;
+    size_t slot = home_slot(map, key);
+
+    while (map->entries[slot].used)
+    {
+        if (map->entries[slot].key == key) { return map->entries[slot].value; }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return NULL;
+}
+
+Status schedr_hash_remove(HashMap *const map, uint64_t key)
+{
+    if (map == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (map->count == 0) { return SCHEDR_SUCCESS; }
+
+    size_t mask = map->capacity - 1;
+    size_t slot = home_slot(map, key);
+
+    while (map->entries[slot].used && map->entries[slot].key != key) { slot = (slot + 1) & mask; }
+
+    if (!map->entries[slot].used) { return SCHEDR_SUCCESS; }
+
+    // Move back every following entry that would no longer be found across the gap
+    size_t gap = slot;
+
+    for (size_t next = (gap + 1) & mask; map->entries[next].used; next = (next + 1) & mask)
+    {
+        size_t home = home_slot(map, map->entries[next].key);
+
+        if (((next - home) & mask) >= ((next - gap) & mask))
+        {
+            map->entries[gap] = map->entries[next];
+            gap = next;
+        }
+    }
+
+    map->entries[gap].used = false;
+    map->entries[gap].value = NULL;
+    map->count--;
+
+    return SCHEDR_SUCCESS;
+}
+
+uint64_t schedr_hash_bytes(uint64_t hash, const void *bytes, size_t len)
+{
+    const unsigned char *byte = (const unsigned char *)bytes;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= byte[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+uint64_t schedr_hash_string(const char *str)
+{
+    return mix(schedr_hash_bytes(SCHEDR_HASH_EMPTY, str, strlen(str)));
+}
+
+Status schedr_hash_strings_init(StringHashMap *const map)
+{
+    if (map == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    schedr_hash_init(&(map->by_hash));
+    map->count = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_hash_strings_destroy(StringHashMap *const map)
+{
+    if (map == NULL) { return; }
+
+    for (size_t i = 0; i < map->by_hash.capacity; i++)
+    {
+        if (!map->by_hash.entries[i].used) { continue; }
+
+        StringHashEntry *entry = (StringHashEntry *)map->by_hash.entries[i].value;
+
+        while (entry != NULL)
+        {
+            StringHashEntry *next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+
+    schedr_hash_destroy(&(map->by_hash));
+    map->count = 0;
+}
+
+/*
+ * Finds the entry of the key equal to 'key' in the chain of its hash.
+ */
+static StringHashEntry *find_string(const StringHashMap *const map, uint64_t hash, const char *key)
+{
+    StringHashEntry *entry = (StringHashEntry *)schedr_hash_get(&(map->by_hash), hash);
+
+    while (entry != NULL && strcmp(entry->key, key) != 0) { entry = entry->next; }
+
+    return entry;
+}
+
+Status schedr_hash_strings_put(StringHashMap *const map, const char *key, void *value)
+{
+    if (map == NULL || key == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    uint64_t hash = string_hash(key);
+    StringHashEntry *entry = find_string(map, hash, key);
+
+    if (entry != NULL)
+    {
+        entry->key = key;
+        entry->value = value;
+
+        return SCHEDR_SUCCESS;
+    }
+
+    if ((entry = (StringHashEntry *)allocator(1, sizeof (StringHashEntry))) == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    entry->key = key;
+    entry->value = value;
+    entry->next = (StringHashEntry *)schedr_hash_get(&(map->by_hash), hash);
+
+    if (schedr_hash_put(&(map->by_hash), hash, entry) != SCHEDR_SUCCESS)
+    {
+        free(entry);
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+
+    map->count++;
+
+    return SCHEDR_SUCCESS;
+}
+
+void *schedr_hash_strings_get(const StringHashMap *const map, const char *key)
+{
+    if (map == NULL || key == NULL) { return NULL; }
+
+    StringHashEntry *entry = find_string(map, string_hash(key), key);
+
+    return (entry != NULL) ? entry->value : NULL;
+}
+
+Status schedr_hash_strings_remove(StringHashMap *const map, const char *key)
+{
+    if (map == NULL || key == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    uint64_t hash = string_hash(key);
+    StringHashEntry *first = (StringHashEntry *)schedr_hash_get(&(map->by_hash), hash);
+    StringHashEntry *entry = find_string(map, hash, key);
+
+    if (entry == NULL) { return SCHEDR_SUCCESS; }
+
+    if (entry != first)
+    {
+        StringHashEntry *previous = first;
+
+        while (previous->next != entry) { previous = previous->next; }
+
+        previous->next = entry->next;
+        free(entry);
+    }
+    else if (entry->next != NULL)
+    {
+        // The second entry takes the place of the first, so the map is left as it is
+        StringHashEntry *second = entry->next;
+
+        *entry = *second;
+        free(second);
+    }
+    else
+    {
+        schedr_hash_remove(&(map->by_hash), hash);
+        free(entry);
+    }
+
+    map->count--;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * The finalizer of splitmix64, which spreads a change of any bit of 'key'
+ * over all of them.
+ */
+static uint64_t mix(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    return key;
+}
+
+/*
+ * Mixes the bits of the key, since pids and pointers only differ in a few of
+ * their bits.
+ */
+static size_t home_slot(const HashMap *const map, uint64_t key)
+{
+    return (size_t)mix(key) & (map->capacity - 1);
+}
+
+static Status grow(HashMap *const map)
+{
+    size_t new_capacity = (map->capacity == 0) ? INITIAL_CAPACITY : map->capacity * 2;
+    HashEntry *new_entries = (HashEntry *)allocator(new_capacity, sizeof (HashEntry));
+
+    if (new_entries == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    HashMap old = *map;
+
+    map->entries = new_entries;
+    map->capacity = new_capacity;
+    map->count = 0;
+
+    for (size_t i = 0; i < old.capacity; i++)
+    {
+        if (old.entries[i].used) { schedr_hash_put(map, old.entries[i].key, old.entries[i].value); }
+    }
+
+    free(old.entries);
+
+    return SCHEDR_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include <stddef.h>         // NULL
+#include <stdbool.h>        // bool
+#include <stdint.h>         // int64_t, uint64_t, uintptr_t, INT64_MAX
+#include <stdlib.h>         // malloc(), free()
+#include <string.h>         // memset()
+
+#include "schedr_histogram.h"
+#include "schedr_hash.h"
+
+static HashMap latencies_by_job;
+static JobLatency all_latency;
+
+/*
+ * Values below SCHEDR_HISTOGRAM_SUB_BUCKETS get a bucket each. Above that,
+ * the values from 2^e up to 2^(e + 1) are split into SCHEDR_HISTOGRAM_SUB_BUCKETS
+ * buckets, by the bits right below the highest one.
+ */
+static int bucket_of(uint64_t value)
+{
+    if (value < SCHEDR_HISTOGRAM_SUB_BUCKETS) { return (int)value; }
+
+    int exponent = 63 - __builtin_clzll(value);
+
+    if (exponent > SCHEDR_HISTOGRAM_MAX_EXPONENT) { return SCHEDR_HISTOGRAM_BUCKETS - 1; }
+
+    int shift = exponent - SCHEDR_HISTOGRAM_SUB_BUCKET_BITS;
+
+    return (shift + 1) * SCHEDR_HISTOGRAM_SUB_BUCKETS + (int)(value >> shift) - SCHEDR_HISTOGRAM_SUB_BUCKETS;
+}
+
+static int64_t highest_value_of(int bucket)
+{
+    if (bucket < SCHEDR_HISTOGRAM_SUB_BUCKETS) { return bucket; }
+
+    int shift = bucket / SCHEDR_HISTOGRAM_SUB_BUCKETS - 1;
+    int64_t sub_bucket = bucket % SCHEDR_HISTOGRAM_SUB_BUCKETS + SCHEDR_HISTOGRAM_SUB_BUCKETS;
+
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+Status schedr_histogram_init(Histogram *const histogram)
+{
+    if (histogram == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    memset(histogram, 0, sizeof (*histogram));
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_histogram_record(Histogram *const histogram, int64_t value_ns)
+{
+    if (histogram == NULL) { return; }
+    if (value_ns < 0) { value_ns = 0; }
+
+    if (histogram->count == 0 || value_ns < histogram->min_ns) { histogram->min_ns = value_ns; }
+    if (value_ns > histogram->max_ns) { histogram->max_ns = value_ns; }
+
+    histogram->count++;
+    histogram->sum_ns = (histogram->sum_ns <= INT64_MAX - value_ns) ? histogram->sum_ns + value_ns : INT64_MAX;
+    histogram->buckets[bucket_of((uint64_t)value_ns)]++;
+}
+
+int64_t schedr_histogram_percentile(const Histogram *const histogram, double percent)
+{
+    if (histogram == NULL || histogram->count == 0) { return 0; }
+
+    // The rank of the value, counted from 1, rounded up so 'percent' of the values are at or below it
+    double exact_rank = percent / 100.0 * (double)histogram->count;
+    uint64_t rank = (uint64_t)exact_rank;
+
+    if ((double)rank < exact_rank) { rank++; }
+    if (rank < 1) { rank = 1; }
+    if (rank >= histogram->count) { return histogram->max_ns; }
+
+    uint64_t seen = 0;
+
+    for (int i = 0; i < SCHEDR_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+
+        if (seen >= rank)
+        {
+            int64_t value = highest_value_of(i);
+
+            return (value < histogram->max_ns) ? value : histogram->max_ns;
+        }
+    }
+
+    return histogram->max_ns;   // GCOVR_EXCL_LINE (the buckets add up to the count)
+}
+
+void schedr_histogram_count_at_or_below(const Histogram *const histogram, const int64_t bounds_ns[], int bounds_len, 
+                                        uint64_t counts[])
+{
+    int bound = 0;
+    uint64_t seen = 0;
+
+    for (int i = 0; histogram != NULL && i < SCHEDR_HISTOGRAM_BUCKETS && bound < bounds_len; i++)
+    {
+        int64_t highest = highest_value_of(i);
+
+        // The bounds that end before this bucket have seen every value they count
+        for (; bound < bounds_len && bounds_ns[bound] < highest; bound++)
+        {
+            counts[bound] = (bounds_ns[bound] >= histogram->max_ns) ? histogram->count : seen;
+        }
+
+        seen += histogram->buckets[i];
+    }
+
+    for (; bound < bounds_len; bound++) { counts[bound] = seen; }
+}
+
+static void init_latency(JobLatency *const latency)
+{
+    schedr_histogram_init(&(latency->lag));
+    schedr_histogram_init(&(latency->spawn));
+    schedr_histogram_init(&(latency->runtime));
+}
+
+static JobLatency *latency_of(const Job *const job_p, bool create)
+{
+    JobLatency *latency = (JobLatency *)schedr_hash_get(&latencies_by_job, (uintptr_t)job_p);
+
+    if (latency != NULL || !create) { return latency; }
+
+    latency = (JobLatency *)malloc(sizeof (JobLatency));
+
+    if (latency == NULL) { return NULL; }
+
+    init_latency(latency);
+
+    if (schedr_hash_put(&latencies_by_job, (uintptr_t)job_p, latency) != SCHEDR_SUCCESS)
+    {
+        free(latency);
+        return NULL;
+    }
+
+    return latency;
+}
+
+void schedr_histogram_record_start(const Job *const job_p, int64_t lag_ns, int64_t spawn_ns)
+{
+    JobLatency *latency = latency_of(job_p, true);
+
+    schedr_histogram_record(&(all_latency.lag), lag_ns);
+    schedr_histogram_record(&(all_latency.spawn), spawn_ns);
+
+    if (latency == NULL) { return; }
+
+    schedr_histogram_record(&(latency->lag), lag_ns);
+    schedr_histogram_record(&(latency->spawn), spawn_ns);
+}
+
+void schedr_histogram_record_runtime(const Job *const job_p, int64_t runtime_ns)
+{
+    JobLatency *latency = latency_of(job_p, false);
+
+    schedr_histogram_record(&(all_latency.runtime), runtime_ns);
+
+    if (latency != NULL) { schedr_histogram_record(&(latency->runtime), runtime_ns); }
+}
+
+const JobLatency *schedr_histogram_get_latency(const Job *const job_p)
+{
+    if (job_p == NULL) { return (all_latency.spawn.count > 0) ? &all_latency : NULL; }
+
+    return latency_of(job_p, false);
+}
+
+void schedr_histogram_forget_latency(const Job *const job_p)
+{
+    if (job_p != NULL)
+    {
+        free(schedr_hash_get(&latencies_by_job, (uintptr_t)job_p));
+        schedr_hash_remove(&latencies_by_job, (uintptr_t)job_p);
+        return;
+    }
+
+    for (size_t i = 0; i < latencies_by_job.capacity; i++)
+    {
+        if (latencies_by_job.entries[i].used) { free(latencies_by_job.entries[i].value); }
+    }
+
+    schedr_hash_destroy(&latencies_by_job);
+    init_latency(&all_latency);
+}
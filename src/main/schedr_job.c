@@ -2,10 +2,18 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <unistd.h>         // access()
+#include <sys/stat.h>       // stat()
+#include <regex.h>          // regcomp(), regfree()
 
 #include "schedr_job.h"
+#include "schedr_hash.h"
+
+static const char SHELL_SPECIAL_CHARS[] = "|&;<>()$`\\\"'*?[]#~{}!\n\r";
+static const char BLANKS[] = " \t";
 
 static void copy_string(char *destination, const char *const source, size_t source_len, size_t max_len);
+static bool resolve_executable(const char *name, char *path, size_t path_size);
 static bool is_empty_str(const char *const str, size_t str_len);
 static bool contains_invalid_chars(const char *const name, size_t name_len);
 
@@ -15,8 +23,25 @@ Status schedr_job_init(Job *const job_p)
 
     job_p->name[0] = '\0';
     job_p->command[0] = '\0';
+    job_p->argc = 0;
+    job_p->exec_path[0] = '\0';
+    job_p->args[0] = '\0';
+    job_p->last_exit_status = -1;
+    job_p->last_duration_ns = 0;
+    job_p->last_cpu_ns = 0;
     schedr_job_set_interval(job_p, 0);
     schedr_job_set_state(job_p, Stopped);
+    schedr_job_set_timing(job_p, FixedDelay);
+    schedr_job_set_weight(job_p, 1);
+    schedr_job_set_overlap(job_p, OverlapWait, 1);
+    job_p->skipped_runs = 0;
+    job_p->queued_runs = 0;
+    schedr_job_set_splay(job_p, 0);
+    schedr_retry_init(&(job_p->retry), &(job_p->retry_state));
+    schedr_limits_init(&(job_p->limits));
+    job_p->monitor[0] = '\0';
+    job_p->pattern[0] = '\0';
+    schedr_calendar_init(&(job_p->calendar));
 
     return SCHEDR_SUCCESS;
 }
@@ -40,16 +65,17 @@ Status schedr_job_set_command(Job *const job_p, const char *command, size_t cmd_
     if (is_empty_str(command, cmd_len)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
 
     copy_string(&(job_p->command[0]), command, cmd_len, SCHEDR_JOB_MAX_CMD_LEN);
+    job_p->argc = 0;
 
     return SCHEDR_SUCCESS;
 }
 
-Status schedr_job_set_interval(Job *const job_p, int interval)
+Status schedr_job_set_interval(Job *const job_p, int64_t interval_ns)
 {
     if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
-    if (interval < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (interval_ns < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
 
-    job_p->interval_seconds = interval;
+    job_p->interval_ns = interval_ns;
 
     return SCHEDR_SUCCESS;
 }
@@ -64,6 +90,261 @@ Status schedr_job_set_state(Job *const job_p, JobState state)
     return SCHEDR_SUCCESS;
 }
 
+Status schedr_job_set_timing(Job *const job_p, JobTiming timing)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (timing < 0 || timing >= SCHEDR_JOB_TIMING_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->timing = timing;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_weight(Job *const job_p, int weight)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (weight < 1) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->weight = weight;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_overlap(Job *const job_p, OverlapPolicy overlap, int max_parallel)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (overlap < 0 || overlap >= SCHEDR_JOB_OVERLAP_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (max_parallel < 1 || (max_parallel != 1 && overlap != OverlapParallel)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->overlap = overlap;
+    job_p->max_parallel = max_parallel;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_splay(Job *const job_p, int64_t splay_ns)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (splay_ns < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->splay_ns = splay_ns;
+    job_p->splay_offset_ns = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_retry(Job *const job_p, const RetryPolicy *const policy)
+{
+    if (job_p == NULL || policy == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (schedr_retry_validate(policy) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->retry = *policy;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_limits(Job *const job_p, const Limits *const limits)
+{
+    if (job_p == NULL || limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (schedr_limits_validate(limits) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->limits = *limits;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_trigger(Job *const job_p, const char *monitor, size_t monitor_len, const char *pattern, size_t pattern_len)
+{
+    if (job_p == NULL || monitor == NULL || pattern == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (monitor_len > SCHEDR_JOB_MAX_CMD_LEN || pattern_len > SCHEDR_JOB_MAX_PATTERN_LEN) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+    if (is_empty_str(monitor, monitor_len) || is_empty_str(pattern, pattern_len)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    char copy[SCHEDR_JOB_MAX_PATTERN_LEN + 1];
+    regex_t regex;
+
+    copy_string(copy, pattern, pattern_len, SCHEDR_JOB_MAX_PATTERN_LEN);
+
+    // Only checked here, the monitor compiles the pattern once when the job is started
+    if (regcomp(&regex, copy, REG_EXTENDED | REG_NOSUB) != 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    regfree(&regex);
+    copy_string(job_p->monitor, monitor, monitor_len, SCHEDR_JOB_MAX_CMD_LEN);
+    strcpy(job_p->pattern, copy);
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_set_calendar(Job *const job_p, const Calendar *const calendar)
+{
+    if (job_p == NULL || calendar == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    Calendar compiled = *calendar;
+
+    if (schedr_calendar_compile(&compiled) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    job_p->calendar = compiled;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_compile_command(Job *const job_p)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    job_p->argc = 0;
+
+    if (strpbrk(job_p->command, SHELL_SPECIAL_CHARS) != NULL) { return SCHEDR_SUCCESS; }
+
+    int argc = 0;
+    size_t args_len = 0;
+    const char *word = job_p->command + strspn(job_p->command, BLANKS);
+
+    while (*word != '\0')
+    {
+        size_t word_len = strcspn(word, BLANKS);
+
+        if (argc == SCHEDR_JOB_MAX_ARGS) { return SCHEDR_SUCCESS; }
+
+        // A leading NAME=value is a variable assignment for the shell
+        if (argc == 0 && memchr(word, '=', word_len) != NULL) { return SCHEDR_SUCCESS; }
+
+        memcpy(job_p->args + args_len, word, word_len);
+        args_len += word_len;
+        job_p->args[args_len++] = '\0';
+        argc++;
+
+        word += word_len;
+        word += strspn(word, BLANKS);
+    }
+
+    if (argc == 0) { return SCHEDR_SUCCESS; }
+    if (!resolve_executable(job_p->args, job_p->exec_path, sizeof (job_p->exec_path))) { return SCHEDR_SUCCESS; }
+
+    job_p->argc = argc;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_job_get_argv(const Job *const job_p, char *argv[SCHEDR_JOB_MAX_ARGS + 1])
+{
+    if (job_p == NULL || argv == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (job_p->argc <= 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    const char *word = job_p->args;
+
+    for (int i = 0; i < job_p->argc; i++)
+    {
+        argv[i] = (char *)word;
+        word += strlen(word) + 1;
+    }
+
+    argv[job_p->argc] = NULL;
+
+    return SCHEDR_SUCCESS;
+}
+
+uint64_t schedr_job_fingerprint(const Job *const job_p)
+{
+    if (job_p == NULL) { return 0; }
+
+    const Limits *limits = &(job_p->limits);
+    int nice = limits->nice_set ? limits->nice : 0;
+    uint64_t hash = SCHEDR_HASH_EMPTY;
+
+    // Field by field, so the padding between them is not hashed
+    hash = schedr_hash_bytes(hash, job_p->name, strlen(job_p->name) + 1);
+    hash = schedr_hash_bytes(hash, job_p->command, strlen(job_p->command) + 1);
+    hash = schedr_hash_bytes(hash, &(job_p->interval_ns), sizeof (job_p->interval_ns));
+    hash = schedr_hash_bytes(hash, &(job_p->timing), sizeof (job_p->timing));
+    hash = schedr_hash_bytes(hash, &(job_p->weight), sizeof (job_p->weight));
+    hash = schedr_hash_bytes(hash, &(job_p->overlap), sizeof (job_p->overlap));
+    hash = schedr_hash_bytes(hash, &(job_p->max_parallel), sizeof (job_p->max_parallel));
+    hash = schedr_hash_bytes(hash, &(job_p->splay_ns), sizeof (job_p->splay_ns));
+    hash = schedr_hash_bytes(hash, &(job_p->retry.max_attempts), sizeof (job_p->retry.max_attempts));
+    hash = schedr_hash_bytes(hash, &(job_p->retry.backoff_ns), sizeof (job_p->retry.backoff_ns));
+    hash = schedr_hash_bytes(hash, &(job_p->retry.max_backoff_ns), sizeof (job_p->retry.max_backoff_ns));
+    hash = schedr_hash_bytes(hash, &(job_p->retry.jitter_percent), sizeof (job_p->retry.jitter_percent));
+    hash = schedr_hash_bytes(hash, &(job_p->retry.cooldown_ns), sizeof (job_p->retry.cooldown_ns));
+    hash = schedr_hash_bytes(hash, &(limits->cpu_percent), sizeof (limits->cpu_percent));
+    hash = schedr_hash_bytes(hash, &(limits->memory_bytes), sizeof (limits->memory_bytes));
+    hash = schedr_hash_bytes(hash, &(limits->io_weight), sizeof (limits->io_weight));
+    hash = schedr_hash_bytes(hash, &(limits->pids), sizeof (limits->pids));
+    hash = schedr_hash_bytes(hash, limits->cpus, sizeof (limits->cpus));
+    hash = schedr_hash_bytes(hash, &(limits->numa_nodes), sizeof (limits->numa_nodes));
+    hash = schedr_hash_bytes(hash, &(limits->nice_set), sizeof (limits->nice_set));
+    hash = schedr_hash_bytes(hash, &nice, sizeof (nice));
+    hash = schedr_hash_bytes(hash, &(limits->io_priority_class), sizeof (limits->io_priority_class));
+    hash = schedr_hash_bytes(hash, &(limits->io_priority_level), sizeof (limits->io_priority_level));
+    hash = schedr_hash_bytes(hash, job_p->monitor, strlen(job_p->monitor) + 1);
+    hash = schedr_hash_bytes(hash, job_p->pattern, strlen(job_p->pattern) + 1);
+    hash = schedr_hash_bytes(hash, &(job_p->calendar.minutes), sizeof (job_p->calendar.minutes));
+    hash = schedr_hash_bytes(hash, &(job_p->calendar.hours), sizeof (job_p->calendar.hours));
+    hash = schedr_hash_bytes(hash, &(job_p->calendar.days), sizeof (job_p->calendar.days));
+    hash = schedr_hash_bytes(hash, &(job_p->calendar.months), sizeof (job_p->calendar.months));
+    hash = schedr_hash_bytes(hash, &(job_p->calendar.weekdays), sizeof (job_p->calendar.weekdays));
+
+    return hash;
+}
+
+static bool is_executable_file(const char *path)
+{
+    struct stat file_stat;
+
+    return stat(path, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && access(path, X_OK) == 0;
+}
+
+/*
+ * Finds the executable the shell would run for 'name', the same way execvp() 
+ * does: names containing a slash are used as they are, other names are 
+ * searched for in every directory of $PATH.
+ */
+static bool resolve_executable(const char *name, char *path, size_t path_size)
+{
+    size_t name_len = strlen(name);
+
+    if (strchr(name, '/') != NULL)
+    {
+        if (name_len >= path_size || !is_executable_file(name)) { return false; }
+
+        strcpy(path, name);
+
+        return true;
+    }
+
+    const char *dir = getenv("PATH");
+
+    if (dir == NULL) { return false; }
+
+    while (true)
+    {
+        size_t dir_len = strcspn(dir, ":");
+
+        // An empty entry in $PATH means the current directory
+        if (dir_len == 0 && name_len < path_size)
+        {
+            strcpy(path, name);
+
+            if (is_executable_file(path)) { return true; }
+        }
+        else if (dir_len + 1 + name_len < path_size)
+        {
+            memcpy(path, dir, dir_len);
+            path[dir_len] = '/';
+            strcpy(path + dir_len + 1, name);
+
+            if (is_executable_file(path)) { return true; }
+        }
+
+        if (dir[dir_len] == '\0') { break; }
+
+        dir += dir_len + 1;
+    }
+
+    path[0] = '\0';
+
+    return false;
+}
+
 static void copy_string(char *destination, const char *const source, size_t source_len, size_t max_len)
 {
     size_t cpy_at_most = (max_len <= source_len) ?
@@ -0,0 +1,110 @@
+#include <stdlib.h>         // malloc(), realloc(), free()
+#include <stddef.h>         // NULL
+
+#include "schedr_job_index.h"
+
+#define INITIAL_CAPACITY 16
+
+Status schedr_job_index_init(JobIndex *const index)
+{
+    if (index == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    schedr_hash_strings_init(&(index->by_name));
+    index->jobs = NULL;
+    index->len = 0;
+    index->capacity = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_job_index_destroy(JobIndex *const index)
+{
+    if (index == NULL) { return; }
+
+    for (int i = 0; i < index->len; i++)
+    {
+        if (index->jobs[i]->owned) { free(index->jobs[i]->job); }
+
+        free(index->jobs[i]);
+    }
+
+    schedr_hash_strings_destroy(&(index->by_name));
+    free(index->jobs);
+    schedr_job_index_init(index);
+}
+
+Status schedr_job_index_add(JobIndex *const index, Job *const job_p, bool owned)
+{
+    if (index == NULL || job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    if (schedr_hash_strings_get(&(index->by_name), job_p->name) != NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    if (index->len == index->capacity)
+    {
+        int new_capacity = (index->capacity == 0) ? INITIAL_CAPACITY : index->capacity * 2;
+        IndexedJob **resized = (IndexedJob **)realloc(index->jobs, sizeof (IndexedJob *) * new_capacity);
+
+        if (resized == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+        index->jobs = resized;
+        index->capacity = new_capacity;
+    }
+
+    IndexedJob *indexed = (IndexedJob *)malloc(sizeof (IndexedJob));
+
+    if (indexed == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    indexed->job = job_p;
+    indexed->owned = owned;
+    indexed->position = index->len;
+
+    if (schedr_hash_strings_put(&(index->by_name), job_p->name, indexed) != SCHEDR_SUCCESS)
+    {
+        free(indexed);
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+
+    index->jobs[index->len] = indexed;
+    index->len++;
+
+    return SCHEDR_SUCCESS;
+}
+
+Job *schedr_job_index_find(const JobIndex *const index, const char *name)
+{
+    if (index == NULL || name == NULL) { return NULL; }
+
+    IndexedJob *indexed = (IndexedJob *)schedr_hash_strings_get(&(index->by_name), name);
+
+    return (indexed != NULL) ? indexed->job : NULL;
+}
+
+Status schedr_job_index_remove(JobIndex *const index, Job *const job_p)
+{
+    if (index == NULL || job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    IndexedJob *indexed = (IndexedJob *)schedr_hash_strings_get(&(index->by_name), job_p->name);
+
+    if (indexed == NULL || indexed->job != job_p) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    schedr_hash_strings_remove(&(index->by_name), job_p->name);
+
+    IndexedJob *last = index->jobs[index->len - 1];
+
+    index->jobs[indexed->position] = last;
+    last->position = indexed->position;
+    index->len--;
+
+    if (indexed->owned) { free(indexed->job); }
+
+    free(indexed);
+
+    return SCHEDR_SUCCESS;
+}
+
+Job *schedr_job_index_at(const JobIndex *const index, int position)
+{
+    if (index == NULL || position < 0 || position >= index->len) { return NULL; }
+
+    return index->jobs[position]->job;
+}
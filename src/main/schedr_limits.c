@@ -0,0 +1,608 @@
+#define _GNU_SOURCE             // syscall()
+
+#include <stdlib.h>             // realloc(), free()
+#include <stdio.h>              // snprintf()
+#include <string.h>             // memset(), memcmp(), strncmp(), strstr(), strlen(), strcspn()
+#include <ctype.h>              // isdigit()
+#include <stdint.h>             // int64_t, uint64_t
+#include <unistd.h>             // read(), write(), close(), syscall()
+#include <fcntl.h>              // open(), openat(), unlinkat()
+#include <errno.h>              // errno, EEXIST, EBADF
+#include <dirent.h>             // fdopendir(), readdir()
+#include <sys/stat.h>           // mkdirat()
+#include <limits.h>             // INT_MAX, PATH_MAX
+#include <signal.h>             // SIGCHLD
+#include <sys/syscall.h>        // SYS_clone3, SYS_sched_setaffinity, SYS_set_mempolicy, SYS_ioprio_set
+#include <sys/resource.h>       // setrlimit(), setpriority()
+#include <linux/sched.h>        // struct clone_args, CLONE_INTO_CGROUP
+#include <linux/mempolicy.h>    // MPOL_BIND
+
+#include "schedr_limits.h"
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+#define SELF_CGROUP_PATH "/proc/self/cgroup"
+#define DAEMON_LEAF "daemon"
+#define LEAF_PREFIX "job-"
+#define LEAF_AFFIX_LEN (4 + 1 + 20)    // The prefix, a dash and the number
+#define CPU_PERIOD_US 100000
+#define READ_LEN 4096
+#define NODE_DIR "/sys/devices/system/node"
+#define CPU_WORDS (SCHEDR_LIMITS_MAX_CPUS / 64)
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+
+enum Controller
+{
+    ControllerCpu = 1 << 0,
+    ControllerMemory = 1 << 1,
+    ControllerIo = 1 << 2,
+    ControllerPids = 1 << 3
+};
+
+static const char *CONTROLLER_NAMES[] = { "cpu", "memory", "io", "pids", NULL };
+
+static int root_fd = -1;
+static int controllers = 0;
+static uint64_t leaves_created = 0;
+
+// Leaves that still held processes when they were given back, removed once they are empty
+static char (*retired_leaves)[SCHEDR_LIMITS_MAX_LEAF_NAME_LEN + 1] = NULL;
+static int retired_leaves_len = 0;
+static int retired_leaves_capacity = 0;
+
+static const char *node_dir = NODE_DIR;
+
+#ifdef TEST
+void schedr_limits_set_node_dir(const char *dir) { node_dir = dir; }
+void schedr_limits_reset_node_dir() { node_dir = NODE_DIR; }
+#endif
+
+Status schedr_limits_init(Limits *const limits)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    limits->cpu_percent = 0;
+    limits->memory_bytes = 0;
+    limits->io_weight = 0;
+    limits->pids = 0;
+    memset(limits->cpus, 0, sizeof (limits->cpus));
+    limits->numa_nodes = 0;
+    limits->nice_set = false;
+    limits->nice = 0;
+    limits->io_priority_class = IoPriorityNone;
+    limits->io_priority_level = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_limits_validate(const Limits *const limits)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (limits->cpu_percent < 0 || limits->cpu_percent > SCHEDR_LIMITS_MAX_CPU_PERCENT) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (limits->io_weight < 0 || limits->io_weight > SCHEDR_LIMITS_MAX_IO_WEIGHT) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (limits->memory_bytes < 0 || limits->pids < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (limits->nice_set && (limits->nice < SCHEDR_LIMITS_MIN_NICE || limits->nice > SCHEDR_LIMITS_MAX_NICE)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (limits->io_priority_class < IoPriorityNone || limits->io_priority_class > IoPriorityIdle) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (limits->io_priority_level < 0 || limits->io_priority_level > SCHEDR_LIMITS_MAX_IO_PRIORITY_LEVEL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    return SCHEDR_SUCCESS;
+}
+
+bool schedr_limits_are_set(const Limits *const limits)
+{
+    if (limits == NULL) { return false; }
+
+    return limits->cpu_percent > 0 || limits->memory_bytes > 0 || limits->io_weight > 0 || limits->pids > 0;
+}
+
+bool schedr_limits_have_cpus(const Limits *const limits)
+{
+    if (limits == NULL) { return false; }
+
+    for (int i = 0; i < CPU_WORDS; i++)
+    {
+        if (limits->cpus[i] != 0) { return true; }
+    }
+
+    return false;
+}
+
+bool schedr_limits_equal(const Limits *const a, const Limits *const b)
+{
+    if (a == NULL || b == NULL) { return a == b; }
+
+    return a->cpu_percent == b->cpu_percent && a->memory_bytes == b->memory_bytes && a->io_weight == b->io_weight &&
+           a->pids == b->pids && memcmp(a->cpus, b->cpus, sizeof (a->cpus)) == 0 && a->numa_nodes == b->numa_nodes &&
+           a->nice_set == b->nice_set && (!a->nice_set || a->nice == b->nice) &&
+           a->io_priority_class == b->io_priority_class && a->io_priority_level == b->io_priority_level;
+}
+
+bool schedr_limits_have_placement(const Limits *const limits)
+{
+    if (limits == NULL) { return false; }
+
+    return schedr_limits_have_cpus(limits) || limits->numa_nodes != 0 || limits->nice_set || limits->io_priority_class != IoPriorityNone;
+}
+
+/*
+ * Parses a list of CPUs like "0-3,8" into 'cpus', which is left as it is if
+ * the list is malformed.
+ */
+static bool parse_cpu_list(const char *list, uint64_t cpus[CPU_WORDS])
+{
+    uint64_t parsed[CPU_WORDS] = { 0 };
+    char *end;
+
+    for (const char *c = list; ; c = end + 1)
+    {
+        if (!isdigit((unsigned char)*c)) { return false; }
+
+        long first = strtol(c, &end, 10);
+        long last = first;
+
+        if (*end == '-')
+        {
+            if (!isdigit((unsigned char)end[1])) { return false; }
+
+            last = strtol(end + 1, &end, 10);
+        }
+
+        if (first > last || last >= SCHEDR_LIMITS_MAX_CPUS) { return false; }
+
+        for (long cpu = first; cpu <= last; cpu++) { parsed[cpu / 64] |= 1ULL << (cpu % 64); }
+
+        if (*end == '\0') { break; }
+        if (*end != ',') { return false; }
+    }
+
+    memcpy(cpus, parsed, sizeof (parsed));
+
+    return true;
+}
+
+Status schedr_limits_set_cpus(Limits *const limits, const char *list)
+{
+    if (limits == NULL || list == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    return parse_cpu_list(list, limits->cpus) ? SCHEDR_SUCCESS : SCHEDR_ERROR_INVALID_ARGUMENT;
+}
+
+/*
+ * Reads the interface file 'name' of the cgroup 'dir_fd' into 'buf', which is
+ * NUL terminated. Returns false if it could not be read.
+ */
+static bool read_file(int dir_fd, const char *name, char *buf, size_t len)
+{
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) { return false; }
+
+    ssize_t read_len = read(fd, buf, len - 1);
+
+    close(fd);
+
+    if (read_len < 0) { return false; }
+
+    buf[read_len] = '\0';
+
+    return true;
+}
+
+/*
+ * Writes 'value' to the interface file 'name' of the cgroup 'dir_fd'. The file
+ * is created if it is missing, which it never is in a cgroup file system.
+ */
+static bool write_file(int dir_fd, const char *name, const char *value)
+{
+    int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd < 0) { return false; }
+
+    size_t len = strlen(value);
+    bool written = (write(fd, value, len) == (ssize_t)len);
+
+    close(fd);
+
+    return written;
+}
+
+Status schedr_limits_set_numa_node(Limits *const limits, int node)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (node < 0 || node >= SCHEDR_LIMITS_MAX_NUMA_NODES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    char path[PATH_MAX], cpulist[READ_LEN];
+    snprintf(path, sizeof (path), "%s/node%d", node_dir, node);
+
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    bool read = read_file(fd, "cpulist", cpulist, sizeof (cpulist));
+
+    close(fd);
+
+    if (!read) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    cpulist[strcspn(cpulist, "\n")] = '\0';
+
+    // A node with memory only has no CPUs to run the commands on
+    if (!schedr_limits_have_cpus(limits) && cpulist[0] != '\0' && !parse_cpu_list(cpulist, limits->cpus)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    limits->numa_nodes = 1ULL << node;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_limits_get_cpus(Limits *const limits)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    uint64_t cpus[CPU_WORDS] = { 0 };
+
+    if (syscall(SYS_sched_getaffinity, 0, sizeof (cpus), cpus) < 0) { return SCHEDR_FAILURE; }
+
+    memcpy(limits->cpus, cpus, sizeof (cpus));
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Finds the cgroup of the daemon in the unified hierarchy, which is listed
+ * with the hierarchy id 0.
+ */
+static bool find_own_cgroup(char *path, size_t len)
+{
+    char buf[READ_LEN];
+    int fd = open(SELF_CGROUP_PATH, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) { return false; }
+
+    ssize_t read_len = read(fd, buf, sizeof (buf) - 1);
+
+    close(fd);
+
+    if (read_len < 0) { return false; }
+
+    buf[read_len] = '\0';
+
+    for (char *line = strtok(buf, "\n"); line != NULL; line = strtok(NULL, "\n"))
+    {
+        if (strncmp(line, "0::", 3) == 0) { return snprintf(path, len, "%s%s", CGROUP_ROOT, line + 3) < (int)len; }
+    }
+
+    return false;
+}
+
+/*
+ * Kernels before 5.7 can not clone into a cgroup. A request to clone into a
+ * descriptor that is not open is refused with EBADF by those that can, before
+ * any process is created.
+ */
+static bool can_clone_into_cgroup()
+{
+    struct clone_args args;
+
+    memset(&args, 0, sizeof (args));
+    args.flags = CLONE_INTO_CGROUP;
+    args.exit_signal = SIGCHLD;
+    args.cgroup = INT_MAX;
+
+    return syscall(SYS_clone3, &args, sizeof (args)) < 0 && errno == EBADF;
+}
+
+/*
+ * Moves every process in the cgroup 'fd' to its daemon leaf, so controllers
+ * can be enabled for its children.
+ */
+static bool move_to_daemon_leaf(int fd)
+{
+    char procs[READ_LEN];
+
+    if (!read_file(fd, "cgroup.procs", procs, sizeof (procs))) { return false; }
+    if (procs[0] == '\0') { return true; }
+
+    if (mkdirat(fd, DAEMON_LEAF, 0755) != 0 && errno != EEXIST) { return false; }
+
+    int leaf_fd = openat(fd, DAEMON_LEAF, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool moved = (leaf_fd >= 0);
+
+    for (char *pid = strtok(procs, "\n"); moved && pid != NULL; pid = strtok(NULL, "\n"))
+    {
+        // A process that has exited since the list was read does not have to be moved
+        moved = write_file(leaf_fd, "cgroup.procs", pid) || errno == ESRCH;
+    }
+
+    if (leaf_fd >= 0) { close(leaf_fd); }
+
+    return moved;
+}
+
+/*
+ * Enables the controllers that are available for the children of the cgroup
+ * 'fd', and remembers which they are.
+ */
+static bool enable_controllers(int fd)
+{
+    char available[READ_LEN];
+    char enable[64] = "";
+
+    if (!read_file(fd, "cgroup.controllers", available, sizeof (available))) { return false; }
+
+    controllers = 0;
+
+    for (int i = 0; CONTROLLER_NAMES[i] != NULL; i++)
+    {
+        size_t name_len = strlen(CONTROLLER_NAMES[i]);
+
+        for (char *found = strstr(available, CONTROLLER_NAMES[i]); found != NULL; found = strstr(found + 1, CONTROLLER_NAMES[i]))
+        {
+            bool word_start = (found == available || found[-1] == ' ');
+            bool word_end = (found[name_len] == ' ' || found[name_len] == '\n' || found[name_len] == '\0');
+
+            if (!word_start || !word_end) { continue; }
+
+            controllers |= 1 << i;
+            strcat(enable, (enable[0] == '\0') ? "+" : " +");
+            strcat(enable, CONTROLLER_NAMES[i]);
+            break;
+        }
+    }
+
+    return enable[0] == '\0' || write_file(fd, "cgroup.subtree_control", enable);
+}
+
+/*
+ * Removes the leaves an earlier daemon left behind, those that are empty.
+ */
+static void remove_stale_leaves(int fd)
+{
+    int dir_fd = dup(fd);
+    DIR *dir = (dir_fd >= 0) ? fdopendir(dir_fd) : NULL;
+
+    if (dir == NULL)
+    {
+        if (dir_fd >= 0) { close(dir_fd); }
+        return;
+    }
+
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, LEAF_PREFIX, strlen(LEAF_PREFIX)) == 0) { unlinkat(fd, entry->d_name, AT_REMOVEDIR); }
+    }
+
+    closedir(dir);
+}
+
+Status schedr_limits_open_cgroup(const char *path)
+{
+    if (root_fd != -1) { return SCHEDR_SUCCESS; }
+
+    char own_path[PATH_MAX];
+
+    if (path == NULL && !find_own_cgroup(own_path, sizeof (own_path))) { return SCHEDR_FAILURE; }
+
+    int fd = open((path != NULL) ? path : own_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0) { return SCHEDR_FAILURE; }
+
+    if (!can_clone_into_cgroup() || !move_to_daemon_leaf(fd) || !enable_controllers(fd))
+    {
+        close(fd);
+        return SCHEDR_FAILURE;
+    }
+
+    remove_stale_leaves(fd);
+    root_fd = fd;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Removes the retired leaves that have become empty.
+ */
+static void remove_retired_leaves()
+{
+    int kept = 0;
+
+    for (int i = 0; i < retired_leaves_len; i++)
+    {
+        if (unlinkat(root_fd, retired_leaves[i], AT_REMOVEDIR) != 0 && errno != ENOENT)
+        {
+            memcpy(retired_leaves[kept++], retired_leaves[i], sizeof (retired_leaves[i]));
+        }
+    }
+
+    retired_leaves_len = kept;
+}
+
+void schedr_limits_close_cgroup()
+{
+    if (root_fd == -1) { return; }
+
+    remove_retired_leaves();
+    free(retired_leaves);
+    close(root_fd);
+
+    retired_leaves = NULL;
+    retired_leaves_len = retired_leaves_capacity = 0;
+    root_fd = -1;
+    controllers = 0;
+}
+
+bool schedr_limits_have_cgroup() { return root_fd != -1; }
+
+/*
+ * Writes the limits of the controllers that are enabled to the leaf 'fd'.
+ */
+static bool write_limits(int fd, const Limits *const limits)
+{
+    char value[64];
+    bool written = true;
+
+    if (limits->cpu_percent > 0 && (controllers & ControllerCpu))
+    {
+        snprintf(value, sizeof (value), "%lld %d", (long long)limits->cpu_percent * CPU_PERIOD_US / 100, CPU_PERIOD_US);
+        written = write_file(fd, "cpu.max", value);
+    }
+
+    if (written && limits->memory_bytes > 0 && (controllers & ControllerMemory))
+    {
+        snprintf(value, sizeof (value), "%lld", (long long)limits->memory_bytes);
+        written = write_file(fd, "memory.max", value);
+    }
+
+    if (written && limits->io_weight > 0 && (controllers & ControllerIo))
+    {
+        snprintf(value, sizeof (value), "default %d", limits->io_weight);
+        written = write_file(fd, "io.weight", value);
+    }
+
+    if (written && limits->pids > 0 && (controllers & ControllerPids))
+    {
+        snprintf(value, sizeof (value), "%d", limits->pids);
+        written = write_file(fd, "pids.max", value);
+    }
+
+    return written;
+}
+
+Status schedr_limits_create_leaf(CgroupLeaf *const leaf, const char *job_name, const Limits *const limits)
+{
+    if (leaf == NULL || job_name == NULL || limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (root_fd == -1) { return SCHEDR_FAILURE; }
+
+    char safe_name[SCHEDR_LIMITS_MAX_LEAF_NAME_LEN - LEAF_AFFIX_LEN + 1];
+    size_t safe_len = 0;
+
+    for (; job_name[safe_len] != '\0' && safe_len < sizeof (safe_name) - 1; safe_len++)
+    {
+        char c = job_name[safe_len];
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+
+        safe_name[safe_len] = allowed ? c : '_';
+    }
+
+    safe_name[safe_len] = '\0';
+    snprintf(leaf->name, sizeof (leaf->name), LEAF_PREFIX "%s-%llu", safe_name, (unsigned long long)++leaves_created);
+
+    remove_retired_leaves();
+
+    if (mkdirat(root_fd, leaf->name, 0755) != 0 && errno != EEXIST) { return SCHEDR_FAILURE; }
+
+    leaf->fd = openat(root_fd, leaf->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (leaf->fd < 0)
+    {
+        unlinkat(root_fd, leaf->name, AT_REMOVEDIR);
+        return SCHEDR_FAILURE;
+    }
+
+    if (!write_limits(leaf->fd, limits))
+    {
+        schedr_limits_remove_leaf(leaf);
+        return SCHEDR_FAILURE;
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_limits_remove_leaf(CgroupLeaf *const leaf)
+{
+    if (leaf == NULL || leaf->fd == -1) { return; }
+
+    close(leaf->fd);
+    leaf->fd = -1;
+
+    if (root_fd == -1 || unlinkat(root_fd, leaf->name, AT_REMOVEDIR) == 0 || errno == ENOENT) { return; }
+
+    if (retired_leaves_len == retired_leaves_capacity)
+    {
+        int capacity = (retired_leaves_capacity == 0) ? 16 : retired_leaves_capacity * 2;
+        void *resized = realloc(retired_leaves, sizeof (retired_leaves[0]) * capacity);
+
+        // The leaf is left behind, to be removed by the next daemon
+        if (resized == NULL) { return; }
+
+        retired_leaves = resized;
+        retired_leaves_capacity = capacity;
+    }
+
+    memcpy(retired_leaves[retired_leaves_len++], leaf->name, sizeof (leaf->name));
+}
+
+pid_t schedr_limits_clone(int cgroup_fd, bool vfork)
+{
+    struct clone_args args;
+
+    memset(&args, 0, sizeof (args));
+    args.exit_signal = SIGCHLD;
+
+    if (vfork) { args.flags |= CLONE_VFORK; }
+
+    if (cgroup_fd >= 0)
+    {
+        args.flags |= CLONE_INTO_CGROUP;
+        args.cgroup = (uint64_t)cgroup_fd;
+    }
+
+    return (pid_t)syscall(SYS_clone3, &args, sizeof (args));
+}
+
+/*
+ * Lowers the limit 'resource' to 'value', or as far as the hard limit allows.
+ */
+static bool lower_rlimit(int resource, rlim_t value)
+{
+    struct rlimit limit;
+
+    if (getrlimit(resource, &limit) != 0) { return false; }
+
+    if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < value) { value = limit.rlim_max; }
+
+    limit.rlim_cur = limit.rlim_max = value;
+
+    return setrlimit(resource, &limit) == 0;
+}
+
+Status schedr_limits_apply(const Limits *const limits)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    bool applied = true;
+
+    if (limits->memory_bytes > 0) { applied = lower_rlimit(RLIMIT_AS, (rlim_t)limits->memory_bytes); }
+    if (applied && limits->pids > 0) { applied = lower_rlimit(RLIMIT_NPROC, (rlim_t)limits->pids); }
+
+    return applied ? SCHEDR_SUCCESS : SCHEDR_FAILURE;
+}
+
+Status schedr_limits_place(pid_t pid, const Limits *const limits)
+{
+    if (limits == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    bool placed = true;
+
+    if (schedr_limits_have_cpus(limits) && syscall(SYS_sched_setaffinity, pid, sizeof (limits->cpus), limits->cpus) != 0) { placed = false; }
+
+    // The kernel reads one bit less than it is told to
+    if (limits->numa_nodes != 0 && pid == 0 &&
+        syscall(SYS_set_mempolicy, MPOL_BIND, &(limits->numa_nodes), SCHEDR_LIMITS_MAX_NUMA_NODES + 1) != 0)
+    {
+        placed = false;
+    }
+
+    if (limits->nice_set && setpriority(PRIO_PROCESS, (id_t)pid, limits->nice) != 0) { placed = false; }
+
+    if (limits->io_priority_class != IoPriorityNone)
+    {
+        int level = (limits->io_priority_class == IoPriorityIdle) ? 0 : limits->io_priority_level;
+        int priority = ((int)limits->io_priority_class << IOPRIO_CLASS_SHIFT) | level;
+
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, pid, priority) != 0) { placed = false; }
+    }
+
+    return placed ? SCHEDR_SUCCESS : SCHEDR_FAILURE;
+}
@@ -0,0 +1,547 @@
+#define _GNU_SOURCE             // IOV_MAX
+
+#include <stdlib.h>             // malloc(), free()
+#include <string.h>             // memcpy(), memchr(), memrchr(), strlen()
+#include <stdio.h>              // snprintf(), rename()
+#include <stdint.h>             // int64_t, uint64_t, uint32_t, uint16_t
+#include <stdbool.h>            // bool
+#include <limits.h>             // IOV_MAX, PATH_MAX
+#include <errno.h>              // errno, EACCES, EINTR, ETIMEDOUT
+#include <unistd.h>             // close(), write(), read(), unlink()
+#include <fcntl.h>              // open(), O_* constants
+#include <signal.h>             // sigset_t, sigfillset()
+#include <pthread.h>            // pthread_*
+#include <time.h>               // clock_gettime(), localtime_r(), strftime()
+#include <sys/stat.h>           // fstat()
+#include <sys/eventfd.h>        // eventfd()
+#include <sys/uio.h>            // writev(), struct iovec
+
+#include "schedr_log.h"
+#include "schedr_job.h"
+#include "schedr_time.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define NANOSECS_PER_MILLISEC 1000000LL
+
+// Time, job name and stream in front of every line: "YYYY-MM-DD HH:MM:SS.mmm <name> out "
+#define MAX_PREFIX_LEN (24 + SCHEDR_JOB_MAX_NAME_LEN + 6)
+
+// Every line takes two iovecs at least, its prefix and the line itself
+#define MAX_PREFIXES (IOV_MAX / 2)
+
+// Longest suffix added to the path of a rotated file: ".<int>"
+#define MAX_ROTATED_SUFFIX_LEN 12
+
+// Precedes the job name and the output of every record in the buffer
+struct RecordHeader
+{
+    int64_t time_ns;
+    uint32_t len;
+    uint16_t name_len;
+    uint16_t stream;
+};
+
+typedef struct RecordHeader RecordHeader;
+
+static const char *STREAM_NAMES[] = { "out", "err" };
+
+static ssize_t (*writer)(int fd, const struct iovec *iov, int iovcnt) = writev;
+
+// Shared between the event loop and the writer thread, guarded by 'lock'
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_writer;
+static pthread_cond_t batch_written;
+static char *buffers[2] = { NULL, NULL };
+static char *filling = NULL;
+static size_t filling_len = 0;
+static size_t buffer_len = 0;
+static bool full = false;
+static bool flush_requested = false;
+static bool closing = false;
+static uint64_t appended_bytes = 0;
+static uint64_t written_bytes = 0;
+static LogStats stats;
+
+// Only touched by the writer thread while the log is open
+static int log_fd = -1;
+static size_t file_len = 0;
+static int64_t file_started_ns = 0;
+static char prefixes[MAX_PREFIXES][MAX_PREFIX_LEN];
+
+// Set when the log is opened
+static bool log_open = false;
+static pthread_t writer_thread;
+static int event_fd = -1;
+static char log_path[PATH_MAX];
+static LogRotation rotation;
+
+static void *write_log(void *arg);
+
+#ifdef TEST
+void schedr_log_set_writer(ssize_t (*writev_func)(int fd, const struct iovec *iov, int iovcnt)) { writer = writev_func; }
+void schedr_log_reset_writer() { writer = writev; }
+#endif
+
+/*
+ * Opens the log file, continuing it if it already exists. Returns the
+ * descriptor, or -1 with errno set if it could not be opened.
+ */
+static int open_log_file()
+{
+    int fd = open(log_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    struct stat file_stat;
+
+    if (fd == -1) { return -1; }
+
+    file_len = (fstat(fd, &file_stat) == 0) ? (size_t)file_stat.st_size : 0;
+    file_started_ns = schedr_time_monotonic_ns();
+
+    return fd;
+}
+
+Status schedr_log_open(const char *path, const LogRotation *const log_rotation, size_t len)
+{
+    if (path == NULL || log_rotation == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (log_open || log_rotation->max_age_ns < 0 || log_rotation->keep < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (len < SCHEDR_LOG_MIN_BUFFER_LEN) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (strlen(path) + MAX_ROTATED_SUFFIX_LEN >= PATH_MAX) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    strcpy(log_path, path);
+    rotation = *log_rotation;
+
+    if ((log_fd = open_log_file()) == -1) { return (errno == EACCES) ? SCHEDR_ERROR_PERMISSION_DENIED : SCHEDR_FAILURE; }
+
+    buffers[0] = (char *)malloc(len);
+    buffers[1] = (char *)malloc(len);
+
+    if (buffers[0] == NULL || buffers[1] == NULL)
+    {
+        schedr_log_close();
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+
+    filling = buffers[0];
+    filling_len = 0;
+    buffer_len = len;
+    full = flush_requested = closing = false;
+    appended_bytes = written_bytes = 0;
+    memset(&stats, 0, sizeof (stats));
+
+    // The writer waits with timeouts on the monotonic clock, so changing the time of day does not stall it
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wake_writer, &cond_attr);
+    pthread_cond_init(&batch_written, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    if ((event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+    {
+        schedr_log_close();
+        return SCHEDR_FAILURE;
+    }
+
+    // Signals are left to the event loop, the writer blocks all of them
+    sigset_t all_signals, old_mask;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_mask);
+
+    int created = pthread_create(&writer_thread, NULL, write_log, NULL);
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+    if (created != 0)
+    {
+        schedr_log_close();
+        return SCHEDR_FAILURE;
+    }
+
+    log_open = true;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_log_close()
+{
+    if (log_open)
+    {
+        pthread_mutex_lock(&lock);
+        closing = true;
+        pthread_cond_signal(&wake_writer);
+        pthread_mutex_unlock(&lock);
+
+        pthread_join(writer_thread, NULL);
+        pthread_cond_destroy(&wake_writer);
+        pthread_cond_destroy(&batch_written);
+        log_open = false;
+    }
+
+    if (log_fd != -1) { close(log_fd); }
+    if (event_fd != -1) { close(event_fd); }
+
+    free(buffers[0]);
+    free(buffers[1]);
+
+    log_fd = event_fd = -1;
+    buffers[0] = buffers[1] = filling = NULL;
+    filling_len = buffer_len = 0;
+}
+
+bool schedr_log_is_open() { return log_open; }
+
+static size_t record_len(size_t name_len, size_t len) { return sizeof (RecordHeader) + name_len + len; }
+
+Status schedr_log_append(const char *job_name, OutputStream stream, int64_t time_ns, const char *data, size_t len)
+{
+    if (job_name == NULL || data == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (!log_open || (stream != OutputStdout && stream != OutputStderr)) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    size_t name_len = strnlen(job_name, SCHEDR_JOB_MAX_NAME_LEN);
+    RecordHeader header = { .time_ns = time_ns, .len = (uint32_t)len, .name_len = (uint16_t)name_len, .stream = (uint16_t)stream };
+
+    pthread_mutex_lock(&lock);
+
+    if (len > UINT32_MAX || filling_len + record_len(name_len, len) > buffer_len)
+    {
+        full = true;
+        stats.stalls++;
+        pthread_cond_signal(&wake_writer);
+        pthread_mutex_unlock(&lock);
+
+        return SCHEDR_ERROR_BUFFER_OVERFLOW;
+    }
+
+    memcpy(filling + filling_len, &header, sizeof (header));
+    memcpy(filling + filling_len + sizeof (header), job_name, name_len);
+    memcpy(filling + filling_len + sizeof (header) + name_len, data, len);
+
+    filling_len += record_len(name_len, len);
+    appended_bytes += record_len(name_len, len);
+
+    // The writer is only woken once a batch is worth writing, otherwise it wakes up on its own
+    if (filling_len >= buffer_len / 4) { pthread_cond_signal(&wake_writer); }
+
+    pthread_mutex_unlock(&lock);
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_log_append_lines(LogLine *const line, const char *job_name, OutputStream stream, int64_t time_ns, char *data, 
+                             size_t len)
+{
+    if (!log_open) { return; }
+
+    if (line->kept_len > 0)
+    {
+        data -= line->kept_len;
+        memcpy(data, line->kept, line->kept_len);
+        len += line->kept_len;
+    }
+
+    const char *last_new_line = (const char *)memrchr(data, '\n', len);
+    size_t whole_len = (last_new_line != NULL) ? (size_t)(last_new_line - data) + 1 : 0;
+
+    if (len - whole_len >= SCHEDR_LOG_MAX_LINE_LEN) { whole_len = len; }
+
+    if (whole_len > 0) { schedr_log_append(job_name, stream, time_ns, data, whole_len); }
+
+    if (line->kept == NULL && len > whole_len) { line->kept = (char *)malloc(SCHEDR_LOG_MAX_LINE_LEN); }
+
+    line->kept_len = (line->kept != NULL) ? len - whole_len : 0;
+
+    if (line->kept_len > 0) { memcpy(line->kept, data + whole_len, line->kept_len); }
+}
+
+void schedr_log_finish_lines(LogLine *const line, const char *job_name, OutputStream stream, int64_t time_ns)
+{
+    if (log_open && line->kept_len > 0) { schedr_log_append(job_name, stream, time_ns, line->kept, line->kept_len); }
+
+    line->kept_len = 0;
+}
+
+bool schedr_log_has_room(size_t name_len, size_t len)
+{
+    if (!log_open) { return true; }
+
+    if (name_len > SCHEDR_JOB_MAX_NAME_LEN) { name_len = SCHEDR_JOB_MAX_NAME_LEN; }
+
+    pthread_mutex_lock(&lock);
+
+    bool has_room = filling_len + record_len(name_len, len) <= buffer_len;
+
+    if (!has_room)
+    {
+        full = true;
+        stats.stalls++;
+        pthread_cond_signal(&wake_writer);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return has_room;
+}
+
+int schedr_log_event_fd() { return event_fd; }
+
+void schedr_log_clear_event()
+{
+    uint64_t events;
+
+    if (event_fd != -1) { read(event_fd, &events, sizeof (events)); }
+}
+
+void schedr_log_flush()
+{
+    if (!log_open) { return; }
+
+    pthread_mutex_lock(&lock);
+
+    uint64_t target = appended_bytes;
+
+    flush_requested = true;
+    pthread_cond_signal(&wake_writer);
+
+    while (written_bytes < target) { pthread_cond_wait(&batch_written, &lock); }
+
+    pthread_mutex_unlock(&lock);
+}
+
+Status schedr_log_get_stats(LogStats *const log_stats)
+{
+    if (log_stats == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    pthread_mutex_lock(&lock);
+    *log_stats = stats;
+    pthread_mutex_unlock(&lock);
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Renames the log file to <path>.1, after moving the rotated files one number
+ * up, and starts a new one. The oldest rotated file is overwritten.
+ */
+static void rotate(LogStats *const batch_stats)
+{
+    char from[PATH_MAX];
+    char to[PATH_MAX];
+
+    close(log_fd);
+
+    // The path was checked to have room for the suffixes when the log was opened
+    for (int i = rotation.keep; i >= 1; i--)
+    {
+        if (i == 1) { strcpy(from, log_path); }
+        else if (snprintf(from, sizeof (from), "%s.%d", log_path, i - 1) >= (int)sizeof (from)) { continue; }
+
+        if (snprintf(to, sizeof (to), "%s.%d", log_path, i) >= (int)sizeof (to)) { continue; }
+
+        rename(from, to);
+    }
+
+    if (rotation.keep == 0) { unlink(log_path); }
+
+    log_fd = open_log_file();
+    batch_stats->rotations++;
+}
+
+static bool is_due_for_rotation(size_t next_len)
+{
+    if (file_len == 0) { return false; }
+
+    bool too_large = rotation.max_file_len > 0 && file_len + next_len > rotation.max_file_len;
+    bool too_old = rotation.max_age_ns > 0 && schedr_time_monotonic_ns() - file_started_ns >= rotation.max_age_ns;
+
+    return too_large || too_old;
+}
+
+/*
+ * Writes 'iov_len' pieces of 'len' bytes in all to the log file, rotating it
+ * first if they would make it too large or it is too old.
+ */
+static void write_pieces(struct iovec *iov, int iov_len, size_t len, LogStats *const batch_stats)
+{
+    if (is_due_for_rotation(len)) { rotate(batch_stats); }
+
+    while (iov_len > 0)
+    {
+        ssize_t written = (log_fd != -1) ? writer(log_fd, iov, iov_len) : -1;
+
+        if (written < 0 && errno == EINTR) { continue; }
+
+        if (written < 0)
+        {
+            batch_stats->write_errors++;
+            return;
+        }
+
+        file_len += (size_t)written;
+        batch_stats->bytes_written += (uint64_t)written;
+
+        // A write may stop part way through, the rest is written from where it stopped
+        while (iov_len > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            iov_len--;
+        }
+
+        if (iov_len > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+}
+
+/*
+ * Formats the prefix of the lines of a record. The time is only formatted
+ * again once the second changes, most records of a batch share it.
+ */
+static size_t format_prefix(char *prefix, const RecordHeader *const header, const char *name)
+{
+    static time_t formatted_secs = -1;
+    static char formatted_time[32];
+
+    time_t secs = (time_t)(header->time_ns / NANOSECS_PER_SEC);
+    int millis = (int)((header->time_ns % NANOSECS_PER_SEC) / NANOSECS_PER_MILLISEC);
+
+    if (secs != formatted_secs)
+    {
+        struct tm local;
+
+        localtime_r(&secs, &local);
+        strftime(formatted_time, sizeof (formatted_time), "%Y-%m-%d %H:%M:%S", &local);
+        formatted_secs = secs;
+    }
+
+    int len = snprintf(prefix, MAX_PREFIX_LEN, "%s.%03d %.*s %s ", formatted_time, millis,
+                       (int)header->name_len, name, STREAM_NAMES[header->stream]);
+
+    return (len < MAX_PREFIX_LEN) ? (size_t)len : MAX_PREFIX_LEN - 1;
+}
+
+/*
+ * Writes the records of a batch to the log file, every line prefixed. The
+ * lines are gathered into as few writes as IOV_MAX allows.
+ */
+static void write_batch(const char *batch, size_t len, LogStats *const batch_stats)
+{
+    struct iovec iov[IOV_MAX];
+    int iov_len = 0;
+    int prefixes_len = 0;
+    size_t pieces_len = 0;
+    size_t offset = 0;
+
+    while (offset < len)
+    {
+        RecordHeader header;
+        memcpy(&header, batch + offset, sizeof (header));
+
+        const char *name = batch + offset + sizeof (header);
+        const char *line = name + header.name_len;
+        size_t left = header.len;
+        char *prefix = NULL;
+        size_t prefix_len = 0;
+
+        offset += record_len(header.name_len, header.len);
+
+        while (left > 0)
+        {
+            // Room for the prefix, the line and a line break
+            if (iov_len + 3 > IOV_MAX)
+            {
+                write_pieces(iov, iov_len, pieces_len, batch_stats);
+                iov_len = prefixes_len = 0;
+                pieces_len = 0;
+                prefix = NULL;
+            }
+
+            if (prefix == NULL)
+            {
+                prefix = prefixes[prefixes_len++];
+                prefix_len = format_prefix(prefix, &header, name);
+            }
+
+            const char *new_line = (const char *)memchr(line, '\n', left);
+            size_t line_len = (new_line != NULL) ? (size_t)(new_line - line) + 1 : left;
+
+            iov[iov_len++] = (struct iovec){ .iov_base = prefix, .iov_len = prefix_len };
+            iov[iov_len++] = (struct iovec){ .iov_base = (char *)line, .iov_len = line_len };
+            pieces_len += prefix_len + line_len;
+
+            if (new_line == NULL)
+            {
+                iov[iov_len++] = (struct iovec){ .iov_base = "\n", .iov_len = 1 };
+                pieces_len++;
+            }
+
+            line += line_len;
+            left -= line_len;
+        }
+    }
+
+    if (iov_len > 0) { write_pieces(iov, iov_len, pieces_len, batch_stats); }
+}
+
+/*
+ * The writer thread. Swaps the buffer the event loop fills for the one it has
+ * written, and writes the full one. It waits for a quarter of the buffer to
+ * fill up, but no longer than SCHEDR_LOG_FLUSH_INTERVAL_NS, so the batches
+ * are large when there is a lot of output and quiet jobs are still written
+ * soon after.
+ */
+static void *write_log(void *arg)
+{
+    pthread_mutex_lock(&lock);
+
+    while (!closing || filling_len > 0)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+        deadline.tv_nsec += SCHEDR_LOG_FLUSH_INTERVAL_NS;
+        deadline.tv_sec += deadline.tv_nsec / NANOSECS_PER_SEC;
+        deadline.tv_nsec %= NANOSECS_PER_SEC;
+
+        while (!closing && !flush_requested && !full && filling_len < buffer_len / 4)
+        {
+            if (pthread_cond_timedwait(&wake_writer, &lock, &deadline) == ETIMEDOUT) { break; }
+        }
+
+        char *batch = filling;
+        size_t batch_len = filling_len;
+        bool was_full = full;
+
+        filling = (filling == buffers[0]) ? buffers[1] : buffers[0];
+        filling_len = 0;
+        full = flush_requested = false;
+
+        pthread_mutex_unlock(&lock);
+
+        // The loop is told there is room again before the batch is written, since it goes into the other buffer
+        if (was_full)
+        {
+            uint64_t event = 1;
+            write(event_fd, &event, sizeof (event));
+        }
+
+        LogStats batch_stats = { 0 };
+
+        write_batch(batch, batch_len, &batch_stats);
+
+        pthread_mutex_lock(&lock);
+
+        stats.bytes_written += batch_stats.bytes_written;
+        stats.batches += (batch_len > 0) ? 1 : 0;
+        stats.rotations += batch_stats.rotations;
+        stats.write_errors += batch_stats.write_errors;
+        written_bytes += batch_len;
+
+        pthread_cond_broadcast(&batch_written);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
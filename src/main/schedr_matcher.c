@@ -0,0 +1,415 @@
+#include <stdlib.h>         // malloc(), realloc(), free()
+#include <stddef.h>         // NULL, size_t
+#include <string.h>         // strlen(), strchr(), memset(), memcpy()
+
+#include "schedr_matcher.h"
+
+#define INITIAL_CAPACITY 8
+#define ROOT 0
+
+static const char METACHARS[] = ".[]()*+?{}|^$\\";
+
+/*
+ * Gives the index of the character after the bracket expression starting at
+ * 'pattern[i]', or of the '\0' if the expression is not closed.
+ */
+static size_t skip_bracket(const char *pattern, size_t i)
+{
+    i++;
+
+    if (pattern[i] == '^') { i++; }
+    if (pattern[i] == ']') { i++; }
+
+    while (pattern[i] != '\0' && pattern[i] != ']')
+    {
+        // Character classes like [:alpha:] may hold a ']' of their own
+        if (pattern[i] == '[' && pattern[i + 1] != '\0' && strchr(":=.", pattern[i + 1]) != NULL)
+        {
+            char delim = pattern[i + 1];
+
+            i += 2;
+
+            while (pattern[i] != '\0' && !(pattern[i] == delim && pattern[i + 1] == ']')) { i++; }
+
+            if (pattern[i] != '\0') { i++; }
+        }
+
+        if (pattern[i] != '\0') { i++; }
+    }
+
+    return (pattern[i] == ']') ? i + 1 : i;
+}
+
+/*
+ * Gives the index of the character after the group starting at 'pattern[i]',
+ * or of the '\0' if the group is not closed.
+ */
+static size_t skip_group(const char *pattern, size_t i)
+{
+    int depth = 0;
+
+    while (pattern[i] != '\0')
+    {
+        if (pattern[i] == '[') { i = skip_bracket(pattern, i); continue; }
+
+        if (pattern[i] == '\\' && pattern[i + 1] != '\0') { i++; }
+        else if (pattern[i] == '(') { depth++; }
+        else if (pattern[i] == ')' && --depth == 0) { return i + 1; }
+
+        i++;
+    }
+
+    return i;
+}
+
+/*
+ * Keeps the literal run of 'run_len' characters in 'literal' if it is the
+ * longest so far.
+ */
+static void keep_longest(const char *run, size_t run_len, char *literal, size_t *literal_len)
+{
+    if (run_len <= *literal_len) { return; }
+
+    memcpy(literal, run, run_len);
+    literal[run_len] = '\0';
+    *literal_len = run_len;
+}
+
+/*
+ * Finds the longest run of literal characters every match of 'pattern' has to
+ * contain, outside groups and bracket expressions. Characters made optional by
+ * '*', '?' or an interval end a run without being part of it. A pattern with
+ * an alternative outside groups has no such run.
+ */
+#ifndef TEST
+static
+#endif
+size_t schedr_matcher_literal_of(const char *pattern, char literal[SCHEDR_MATCHER_MAX_PATTERN_LEN + 1])
+{
+    char run[SCHEDR_MATCHER_MAX_PATTERN_LEN + 1];
+    size_t run_len = 0;
+    size_t literal_len = 0;
+    size_t i = 0;
+
+    literal[0] = '\0';
+
+    while (pattern[i] != '\0')
+    {
+        char c = pattern[i];
+
+        if (c == '|')
+        {
+            literal[0] = '\0';
+            return 0;
+        }
+
+        if (c == '\\' && pattern[i + 1] != '\0' && strchr(METACHARS, pattern[i + 1]) != NULL)
+        {
+            run[run_len++] = pattern[i + 1];
+            i += 2;
+        }
+        else if (c == '*' || c == '?' || c == '{')
+        {
+            // The atom before is optional, and a group or bracket before has ended the run already
+            if (run_len > 0) { run_len--; }
+
+            keep_longest(run, run_len, literal, &literal_len);
+            run_len = 0;
+
+            if (c == '{')
+            {
+                while (pattern[i] != '\0' && pattern[i] != '}') { i++; }
+            }
+
+            if (pattern[i] != '\0') { i++; }
+        }
+        else if (c == '+')
+        {
+            keep_longest(run, run_len, literal, &literal_len);
+            run_len = 0;
+            i++;
+        }
+        else if (c == '[' || c == '(' || c == '.' || c == '^' || c == '$' || c == '\\')
+        {
+            keep_longest(run, run_len, literal, &literal_len);
+            run_len = 0;
+
+            if (c == '[') { i = skip_bracket(pattern, i); }
+            else if (c == '(') { i = skip_group(pattern, i); }
+            else { i += (c == '\\' && pattern[i + 1] != '\0') ? 2 : 1; }
+        }
+        else
+        {
+            run[run_len++] = c;
+            i++;
+        }
+    }
+
+    keep_longest(run, run_len, literal, &literal_len);
+
+    return literal_len;
+}
+
+Status schedr_matcher_init(Matcher *const matcher)
+{
+    if (matcher == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    memset(matcher, 0, sizeof (Matcher));
+    matcher->stale = true;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void free_automaton(Matcher *const matcher)
+{
+    free(matcher->transitions);
+    free(matcher->first_pattern);
+    free(matcher->output_link);
+    free(matcher->unanchored);
+
+    matcher->transitions = NULL;
+    matcher->first_pattern = NULL;
+    matcher->output_link = NULL;
+    matcher->unanchored = NULL;
+    matcher->states = 0;
+    matcher->unanchored_len = 0;
+}
+
+void schedr_matcher_destroy(Matcher *const matcher)
+{
+    if (matcher == NULL) { return; }
+
+    for (int i = 0; i < matcher->len; i++) { regfree(&(matcher->patterns[i].regex)); }
+
+    free_automaton(matcher);
+    free(matcher->patterns);
+    schedr_matcher_init(matcher);
+}
+
+Status schedr_matcher_add(Matcher *const matcher, const char *pattern, void *data)
+{
+    if (matcher == NULL || pattern == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (strlen(pattern) > SCHEDR_MATCHER_MAX_PATTERN_LEN) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    if (matcher->len == matcher->capacity)
+    {
+        int new_capacity = (matcher->capacity == 0) ? INITIAL_CAPACITY : matcher->capacity * 2;
+        MatcherPattern *resized = (MatcherPattern *)realloc(matcher->patterns, sizeof (MatcherPattern) * new_capacity);
+
+        if (resized == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+        matcher->patterns = resized;
+        matcher->capacity = new_capacity;
+    }
+
+    MatcherPattern *added = &(matcher->patterns[matcher->len]);
+
+    if (regcomp(&(added->regex), pattern, REG_EXTENDED | REG_NOSUB) != 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    added->data = data;
+    added->literal_len = schedr_matcher_literal_of(pattern, added->literal);
+    added->seen_line = 0;
+    matcher->len++;
+    matcher->stale = true;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_matcher_remove(Matcher *const matcher, const void *data)
+{
+    if (matcher == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    int removed = 0;
+
+    for (int i = matcher->len - 1; i >= 0; i--)
+    {
+        if (matcher->patterns[i].data != data) { continue; }
+
+        regfree(&(matcher->patterns[i].regex));
+        matcher->patterns[i] = matcher->patterns[matcher->len - 1];
+        matcher->len--;
+        removed++;
+    }
+
+    if (removed == 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    matcher->stale = true;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Builds the automaton of the literals of the patterns: a trie of the
+ * literals, whose missing transitions are then filled in breadth first from
+ * the failure link of every state, so scanning a line takes one table lookup
+ * per character.
+ */
+static Status build_automaton(Matcher *const matcher)
+{
+    size_t max_states = 1;
+    int classes = 1;
+
+    free_automaton(matcher);
+    memset(matcher->class_of, 0, sizeof (matcher->class_of));
+
+    for (int i = 0; i < matcher->len; i++)
+    {
+        const MatcherPattern *pattern = &(matcher->patterns[i]);
+
+        max_states += pattern->literal_len;
+
+        for (size_t j = 0; j < pattern->literal_len; j++)
+        {
+            unsigned char c = (unsigned char)pattern->literal[j];
+
+            if (matcher->class_of[c] == 0) { matcher->class_of[c] = (uint8_t)classes++; }
+        }
+    }
+
+    matcher->classes = classes;
+    matcher->transitions = (int *)malloc(sizeof (int) * max_states * (size_t)classes);
+    matcher->first_pattern = (int *)malloc(sizeof (int) * max_states);
+    matcher->output_link = (int *)malloc(sizeof (int) * max_states);
+    matcher->unanchored = (int *)malloc(sizeof (int) * (size_t)(matcher->len + 1));
+
+    int *fail = (int *)malloc(sizeof (int) * max_states);
+    int *queue = (int *)malloc(sizeof (int) * max_states);
+
+    if (matcher->transitions == NULL || matcher->first_pattern == NULL || matcher->output_link == NULL ||
+        matcher->unanchored == NULL || fail == NULL || queue == NULL)
+    {
+        free(fail);
+        free(queue);
+        free_automaton(matcher);
+
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+
+    int *transitions = matcher->transitions;
+    int states = 1;
+
+    for (size_t i = 0; i < max_states * (size_t)classes; i++) { transitions[i] = -1; }
+
+    for (size_t i = 0; i < max_states; i++) { matcher->first_pattern[i] = matcher->output_link[i] = -1; }
+
+    for (int i = 0; i < matcher->len; i++)
+    {
+        MatcherPattern *pattern = &(matcher->patterns[i]);
+        int state = ROOT;
+
+        if (pattern->literal_len == 0)
+        {
+            matcher->unanchored[matcher->unanchored_len++] = i;
+            continue;
+        }
+
+        for (size_t j = 0; j < pattern->literal_len; j++)
+        {
+            int *next = &(transitions[state * classes + matcher->class_of[(unsigned char)pattern->literal[j]]]);
+
+            if (*next == -1) { *next = states++; }
+
+            state = *next;
+        }
+
+        pattern->next_at_state = matcher->first_pattern[state];
+        matcher->first_pattern[state] = i;
+    }
+
+    int head = 0;
+    int tail = 0;
+
+    for (int c = 0; c < classes; c++)
+    {
+        int *next = &(transitions[ROOT * classes + c]);
+
+        if (*next == -1) { *next = ROOT; }
+        else
+        {
+            fail[*next] = ROOT;
+            queue[tail++] = *next;
+        }
+    }
+
+    while (head < tail)
+    {
+        int state = queue[head++];
+
+        for (int c = 0; c < classes; c++)
+        {
+            int *next = &(transitions[state * classes + c]);
+            int on_fail = transitions[fail[state] * classes + c];
+
+            if (*next == -1)
+            {
+                *next = on_fail;
+                continue;
+            }
+
+            fail[*next] = on_fail;
+            matcher->output_link[*next] = (matcher->first_pattern[on_fail] != -1) ? on_fail : matcher->output_link[on_fail];
+            queue[tail++] = *next;
+        }
+    }
+
+    free(fail);
+    free(queue);
+
+    matcher->states = states;
+    matcher->stale = false;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Confirms a pattern on the current line, unless it has been confirmed on it
+ * already, and calls the handler on a match.
+ */
+static void confirm(Matcher *const matcher, int index, const char *line, void (*handler)(void *data))
+{
+    MatcherPattern *pattern = &(matcher->patterns[index]);
+
+    if (pattern->seen_line == matcher->line) { return; }
+
+    pattern->seen_line = matcher->line;
+
+    if (regexec(&(pattern->regex), line, 0, NULL, 0) == 0) { handler(pattern->data); }
+}
+
+Status schedr_matcher_match(Matcher *const matcher, const char *line, size_t line_len, void (*handler)(void *data))
+{
+    if (matcher == NULL || line == NULL || handler == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (matcher->stale && build_automaton(matcher) != SCHEDR_SUCCESS) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    // Lines are told apart by number, so the patterns do not have to be cleared for every line
+    if (++matcher->line == 0)
+    {
+        for (int i = 0; i < matcher->len; i++) { matcher->patterns[i].seen_line = 0; }
+
+        matcher->line = 1;
+    }
+
+    const int *transitions = matcher->transitions;
+    const uint8_t *class_of = matcher->class_of;
+    int classes = matcher->classes;
+    int state = ROOT;
+
+    for (size_t i = 0; i < line_len; i++)
+    {
+        state = transitions[state * classes + class_of[(unsigned char)line[i]]];
+
+        int found = (matcher->first_pattern[state] != -1) ? state : matcher->output_link[state];
+
+        for (; found != -1; found = matcher->output_link[found])
+        {
+            for (int p = matcher->first_pattern[found]; p != -1; p = matcher->patterns[p].next_at_state)
+            {
+                confirm(matcher, p, line, handler);
+            }
+        }
+    }
+
+    for (int i = 0; i < matcher->unanchored_len; i++) { confirm(matcher, matcher->unanchored[i], line, handler); }
+
+    return SCHEDR_SUCCESS;
+}
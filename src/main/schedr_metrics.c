@@ -0,0 +1,457 @@
+#define _GNU_SOURCE             // accept4()
+
+#include <stdlib.h>             // malloc(), free()
+#include <stdio.h>              // FILE, open_memstream(), fprintf(), fopen(), fscanf()
+#include <string.h>             // strlen(), strcpy(), memset(), strncmp(), strstr()
+#include <stdbool.h>            // bool
+#include <stdint.h>             // int64_t, uint64_t
+#include <stddef.h>             // offsetof()
+#include <unistd.h>             // close(), unlink(), sysconf()
+#include <errno.h>              // errno, EAGAIN, EINTR, EACCES
+#include <dirent.h>             // opendir(), readdir(), closedir()
+#include <sys/socket.h>         // socket(), bind(), listen(), accept4(), setsockopt()
+#include <sys/stat.h>           // umask()
+#include <sys/un.h>             // struct sockaddr_un
+#include <netinet/in.h>         // struct sockaddr_in, INADDR_LOOPBACK, htons(), htonl()
+
+#include "schedr_metrics.h"
+#include "schedr_scheduler.h"
+#include "schedr_histogram.h"
+#include "schedr_run_queue.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define BUCKET_BOUNDS_LEN 14
+#define LISTENERS 2
+
+/*
+ * The upper bounds of the buckets of the histograms, in the seconds Prometheus
+ * expects, from a millisecond for spawns up to an hour for long commands.
+ */
+static const int64_t BUCKET_BOUNDS_NS[BUCKET_BOUNDS_LEN] =
+{
+    NANOSECS_PER_SEC / 1000, NANOSECS_PER_SEC / 200, NANOSECS_PER_SEC / 100, NANOSECS_PER_SEC / 20,
+    NANOSECS_PER_SEC / 10, NANOSECS_PER_SEC / 2, NANOSECS_PER_SEC, 5 * NANOSECS_PER_SEC, 10 * NANOSECS_PER_SEC,
+    30 * NANOSECS_PER_SEC, 60 * NANOSECS_PER_SEC, 300 * NANOSECS_PER_SEC, 1800 * NANOSECS_PER_SEC,
+    3600 * NANOSECS_PER_SEC
+};
+
+/*
+ * A scraper connected to one of the listeners. The request is read until the
+ * blank line ending its header, after which the response is written and the
+ * connection is closed.
+ */
+struct Connection
+{
+    int fd;
+    char request[SCHEDR_METRICS_MAX_REQUEST_LEN + 1];
+    size_t request_len;
+    char *response;
+    size_t response_len;
+    size_t sent;
+    struct Connection *next;
+    struct Connection *prev;
+};
+
+typedef struct Connection Connection;
+
+static int listen_fds[LISTENERS] = { -1, -1 };
+static char listen_path[sizeof (((struct sockaddr_un *)NULL)->sun_path)];
+
+static const JobIndex *metrics_jobs = NULL;
+
+static Connection connections = { .next = &connections, .prev = &connections };
+static int connections_len = 0;
+
+static void accept_connections(int fd, void *data);
+static void read_request(int fd, void *data);
+static void write_response(int fd, void *data);
+
+static Status listen_on(int fd, struct sockaddr *addr, socklen_t addr_len, bool private)
+{
+    mode_t old_mask = umask(private ? 0077 : 0022);
+    int bound = bind(fd, addr, addr_len);
+
+    umask(old_mask);
+
+    if (bound != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        Status status = (errno == EACCES) ? SCHEDR_ERROR_PERMISSION_DENIED : SCHEDR_FAILURE;
+
+        close(fd);
+
+        return status;
+    }
+
+    Status status = schedr_scheduler_watch_fd(fd, false, accept_connections, NULL);
+
+    if (status != SCHEDR_SUCCESS) { close(fd); }
+
+    return status;
+}
+
+static Status open_socket(const struct sockaddr_un *addr)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd == -1) { return SCHEDR_FAILURE; }
+
+    // A daemon that was killed leaves its socket behind, which would keep the address taken
+    unlink(addr->sun_path);
+
+    Status status = listen_on(fd, (struct sockaddr *)addr, sizeof (*addr), true);
+
+    if (status == SCHEDR_SUCCESS) { listen_fds[0] = fd; }
+
+    return status;
+}
+
+static Status open_port(int port)
+{
+    struct sockaddr_in addr;
+    int reuse = 1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd == -1) { return SCHEDR_FAILURE; }
+
+    // A port left in TIME_WAIT by the last daemon would otherwise keep it taken for a minute
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+
+    memset(&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+
+    Status status = listen_on(fd, (struct sockaddr *)&addr, sizeof (addr), false);
+
+    if (status == SCHEDR_SUCCESS) { listen_fds[1] = fd; }
+
+    return status;
+}
+
+Status schedr_metrics_open(const char *socket_path, int port, const JobIndex *const jobs)
+{
+    if (socket_path == NULL || jobs == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (port < 0 || port > SCHEDR_METRICS_MAX_PORT) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(socket_path) >= sizeof (addr.sun_path)) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    strcpy(addr.sun_path, socket_path);
+
+    schedr_metrics_close();
+
+    Status status = open_socket(&addr);
+
+    if (status != SCHEDR_SUCCESS) { return status; }
+
+    strcpy(listen_path, socket_path);
+
+    if (port != 0 && (status = open_port(port)) != SCHEDR_SUCCESS)
+    {
+        schedr_metrics_close();
+
+        return status;
+    }
+
+    metrics_jobs = jobs;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void close_connection(Connection *conn)
+{
+    schedr_scheduler_unwatch_fd(conn->fd);
+    close(conn->fd);
+
+    conn->prev->next = conn->next;
+    conn->next->prev = conn->prev;
+    connections_len--;
+
+    free(conn->response);
+    free(conn);
+}
+
+void schedr_metrics_close()
+{
+    while (connections.next != &connections) { close_connection(connections.next); }
+
+    for (int i = 0; i < LISTENERS; i++)
+    {
+        if (listen_fds[i] == -1) { continue; }
+
+        schedr_scheduler_unwatch_fd(listen_fds[i]);
+        close(listen_fds[i]);
+
+        listen_fds[i] = -1;
+    }
+
+    if (listen_path[0] != '\0') { unlink(listen_path); }
+
+    listen_path[0] = '\0';
+    metrics_jobs = NULL;
+}
+
+static void accept_connections(int fd, void *data)
+{
+    int conn_fd;
+
+    while ((conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        // Every connection holds a response in memory, so scrapers that never read can not pile them up
+        if (connections_len >= SCHEDR_METRICS_MAX_CONNECTIONS)
+        {
+            close(conn_fd);
+            continue;
+        }
+
+        Connection *conn = (Connection *)malloc(sizeof (Connection));
+
+        if (conn == NULL || schedr_scheduler_watch_fd(conn_fd, false, read_request, conn) != SCHEDR_SUCCESS)
+        {
+            close(conn_fd);
+            free(conn);
+            continue;
+        }
+
+        conn->fd = conn_fd;
+        conn->request_len = 0;
+        conn->response = NULL;
+        conn->response_len = 0;
+        conn->sent = 0;
+        conn->next = &connections;
+        conn->prev = connections.prev;
+        connections.prev->next = conn;
+        connections.prev = conn;
+        connections_len++;
+    }
+}
+
+/*
+ * Prints 'name' as the value of a label, escaped the way the exposition format
+ * requires.
+ */
+static void write_label_value(const char *name, FILE *out)
+{
+    for (; *name != '\0'; name++)
+    {
+        if (*name == '\\' || *name == '"') { fputc('\\', out); }
+
+        fputc(*name, out);
+    }
+}
+
+static void write_family(const char *name, const char *type, const char *help, FILE *out)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void write_job_counter(const char *name, const char *help, const JobIndex *jobs,
+                              uint64_t (*value_of)(const Job *job_p), FILE *out)
+{
+    write_family(name, "counter", help, out);
+
+    for (int i = 0; i < jobs->len; i++)
+    {
+        const Job *job_p = schedr_job_index_at(jobs, i);
+
+        fprintf(out, "%s{job=\"", name);
+        write_label_value(job_p->name, out);
+        fprintf(out, "\"} %llu\n", (unsigned long long)value_of(job_p));
+    }
+}
+
+static void write_job_histogram(const char *name, const char *help, const JobIndex *jobs, size_t offset, FILE *out)
+{
+    write_family(name, "histogram", help, out);
+
+    for (int i = 0; i < jobs->len; i++)
+    {
+        const Job *job_p = schedr_job_index_at(jobs, i);
+        const JobLatency *latency = schedr_scheduler_get_latency(job_p);
+        const Histogram *histogram = (latency != NULL) ? (const Histogram *)((const char *)latency + offset) : NULL;
+        uint64_t counts[BUCKET_BOUNDS_LEN];
+        uint64_t count = (histogram != NULL) ? histogram->count : 0;
+        int64_t sum_ns = (histogram != NULL) ? histogram->sum_ns : 0;
+
+        schedr_histogram_count_at_or_below(histogram, BUCKET_BOUNDS_NS, BUCKET_BOUNDS_LEN, counts);
+
+        for (int j = 0; j <= BUCKET_BOUNDS_LEN; j++)
+        {
+            fprintf(out, "%s_bucket{job=\"", name);
+            write_label_value(job_p->name, out);
+
+            if (j < BUCKET_BOUNDS_LEN)
+            {
+                fprintf(out, "\",le=\"%g\"} %llu\n", (double)BUCKET_BOUNDS_NS[j] / NANOSECS_PER_SEC, (unsigned long long)counts[j]);
+            }
+            else { fprintf(out, "\",le=\"+Inf\"} %llu\n", (unsigned long long)count); }
+        }
+
+        fprintf(out, "%s_sum{job=\"", name);
+        write_label_value(job_p->name, out);
+        fprintf(out, "\"} %.9f\n", (double)sum_ns / NANOSECS_PER_SEC);
+        fprintf(out, "%s_count{job=\"", name);
+        write_label_value(job_p->name, out);
+        fprintf(out, "\"} %llu\n", (unsigned long long)count);
+    }
+}
+
+static uint64_t runs_of(const Job *job_p)
+{
+    const JobLatency *latency = schedr_scheduler_get_latency(job_p);
+
+    return (latency != NULL) ? latency->spawn.count : 0;
+}
+
+static uint64_t failures_of(const Job *job_p) { return job_p->retry_state.failures; }
+static uint64_t skipped_runs_of(const Job *job_p) { return job_p->skipped_runs; }
+static uint64_t queued_runs_of(const Job *job_p) { return job_p->queued_runs; }
+
+/*
+ * Reads the resident set size of the daemon, in bytes, from procfs.
+ */
+static long long resident_bytes()
+{
+    long long size_pages = 0;
+    long long resident_pages = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp == NULL) { return 0; }
+
+    if (fscanf(fp, "%lld %lld", &size_pages, &resident_pages) != 2) { resident_pages = 0; }
+
+    fclose(fp);
+
+    return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+/*
+ * Counts the file descriptors open in the daemon, the one reading the
+ * directory excluded.
+ */
+static int open_fds()
+{
+    DIR *dir = opendir("/proc/self/fd");
+    int fds = 0;
+
+    if (dir == NULL) { return 0; }
+
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.') { fds++; }
+    }
+
+    closedir(dir);
+
+    return fds - 1;
+}
+
+Status schedr_metrics_write(const JobIndex *const jobs, FILE *out)
+{
+    if (jobs == NULL || out == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    RunQueueStats stats;
+
+    schedr_scheduler_get_run_queue_stats(&stats);
+
+    write_job_counter("schedr_job_runs_total", "Commands started for the job.", jobs, runs_of, out);
+    write_job_counter("schedr_job_failures_total", "Runs of the job that failed.", jobs, failures_of, out);
+    write_job_counter("schedr_job_skipped_runs_total", "Runs of the job dropped since they were due while it was running.",
+                      jobs, skipped_runs_of, out);
+    write_job_counter("schedr_job_queued_runs_total", "Runs of the job held until its running command had finished.",
+                      jobs, queued_runs_of, out);
+    write_job_histogram("schedr_job_lag_seconds", "How late the runs of the job were started.", jobs,
+                        offsetof(JobLatency, lag), out);
+    write_job_histogram("schedr_job_spawn_seconds", "How long starting the commands of the job took.", jobs,
+                        offsetof(JobLatency, spawn), out);
+    write_job_histogram("schedr_job_runtime_seconds", "How long the commands of the job ran.", jobs,
+                        offsetof(JobLatency, runtime), out);
+
+    write_family("schedr_commands_in_flight", "gauge", "Commands running.", out);
+    fprintf(out, "schedr_commands_in_flight %d\n", schedr_scheduler_get_cmds_in_flight());
+    write_family("schedr_run_queue_depth", "gauge", "Runs waiting for a free slot.", out);
+    fprintf(out, "schedr_run_queue_depth %d\n", stats.depth);
+    write_family("process_resident_memory_bytes", "gauge", "Resident memory size in bytes.", out);
+    fprintf(out, "process_resident_memory_bytes %lld\n", resident_bytes());
+    write_family("process_open_fds", "gauge", "Number of open file descriptors.", out);
+    fprintf(out, "process_open_fds %d\n", open_fds());
+
+    return ferror(out) ? SCHEDR_FAILURE : SCHEDR_SUCCESS;
+}
+
+/*
+ * Prepares the response to the request of a connection, and waits for the
+ * connection to be ready for it.
+ */
+static void respond(Connection *conn)
+{
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *fp = open_memstream(&body, &body_len);
+    bool is_get = (strncmp(conn->request, "GET ", 4) == 0);
+
+    if (fp == NULL)
+    {
+        close_connection(conn);
+        return;
+    }
+
+    if (is_get) { schedr_metrics_write(metrics_jobs, fp); }
+
+    fclose(fp);
+    fp = open_memstream(&(conn->response), &(conn->response_len));
+
+    if (fp != NULL)
+    {
+        fprintf(fp, "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n"
+                "Connection: close\r\n\r\n", is_get ? "200 OK" : "405 Method Not Allowed", is_get ? body_len : 0);
+
+        if (is_get) { fwrite(body, 1, body_len, fp); }
+    }
+
+    free(body);
+
+    if (fp == NULL || fclose(fp) != 0 || schedr_scheduler_watch_fd(conn->fd, true, write_response, conn) != SCHEDR_SUCCESS)
+    {
+        close_connection(conn);
+    }
+}
+
+static void read_request(int fd, void *data)
+{
+    Connection *conn = (Connection *)data;
+    ssize_t len = recv(fd, conn->request + conn->request_len, SCHEDR_METRICS_MAX_REQUEST_LEN - conn->request_len, 0);
+
+    if (len < 0 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+    if (len <= 0)
+    {
+        close_connection(conn);
+        return;
+    }
+
+    conn->request_len += (size_t)len;
+    conn->request[conn->request_len] = '\0';
+
+    // The header ends with a blank line, a scraper sends nothing after it
+    if (strstr(conn->request, "\r\n\r\n") != NULL || strstr(conn->request, "\n\n") != NULL) { respond(conn); }
+    else if (conn->request_len == SCHEDR_METRICS_MAX_REQUEST_LEN) { close_connection(conn); }
+}
+
+static void write_response(int fd, void *data)
+{
+    Connection *conn = (Connection *)data;
+    ssize_t len = send(fd, conn->response + conn->sent, conn->response_len - conn->sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (len < 0 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+    if (len > 0) { conn->sent += (size_t)len; }
+
+    if (len < 0 || conn->sent == conn->response_len) { close_connection(conn); }
+}
@@ -0,0 +1,361 @@
+#define _GNU_SOURCE             // pipe2()
+#include <stdlib.h>         // malloc(), free(), getenv()
+#include <stddef.h>         // NULL
+#include <stdint.h>         // int64_t, uint64_t, uintptr_t
+#include <errno.h>          // errno, EAGAIN, EINTR
+#include <string.h>         // memchr(), memcpy(), strcpy()
+#include <unistd.h>         // read(), close(), pipe2(), STDIN_FILENO, STDERR_FILENO
+#include <fcntl.h>          // O_CLOEXEC, O_NONBLOCK
+#include <signal.h>         // kill(), SIGTERM
+#include <sys/timerfd.h>    // timerfd_create(), timerfd_settime()
+
+#include "schedr_monitor.h"
+#include "schedr_scheduler.h"
+#include "schedr_spawn.h"
+#include "schedr_hash.h"
+#include "schedr_matcher.h"
+#include "schedr_time.h"
+#include "schedr_retry.h"
+
+#define READ_LEN 65536
+#define MAX_QUICK_RESTARTS 8
+
+/*
+ * A monitor command and the jobs triggered by its output. Jobs with the same
+ * monitor command share it, and the patterns of all of them are matched by a
+ * single matcher. 'pid' is 0 and 'fd' -1 while it is not running, and
+ * 'timer_fd' is set while it waits to be started again. The start of a line
+ * that has not been read to its end is kept in 'line'.
+ */
+struct Monitor
+{
+    char command[SCHEDR_JOB_MAX_CMD_LEN + 1];
+    Matcher matcher;
+    int subscribers;
+    pid_t pid;
+    int fd;
+    int timer_fd;
+    RetryState retry;
+    int64_t started_ns;
+    size_t line_len;
+    char line[SCHEDR_MONITOR_MAX_LINE_LEN + 1];
+};
+
+typedef struct Monitor Monitor;
+
+// The monitors by their command, and by the address of the jobs they trigger
+static StringHashMap monitors_by_command;
+static HashMap monitors_by_job;
+
+// A monitor that keeps exiting right away is started again after a backoff, and every few minutes once the breaker opens
+static RetryPolicy restart_policy =
+{
+    .max_attempts = MAX_QUICK_RESTARTS,
+    .backoff_ns = SCHEDR_RETRY_DEFAULT_BACKOFF_NS,
+    .max_backoff_ns = SCHEDR_RETRY_DEFAULT_MAX_BACKOFF_NS,
+    .jitter_percent = SCHEDR_RETRY_DEFAULT_JITTER_PERCENT,
+    .cooldown_ns = SCHEDR_RETRY_DEFAULT_MAX_BACKOFF_NS
+};
+
+static void read_monitor(int fd, void *data);
+static void restart_monitor(int fd, void *data);
+
+#ifdef TEST
+int schedr_monitor_count() { return (int)monitors_by_command.count; }
+void schedr_monitor_set_restart_backoff(int64_t backoff_ns) { restart_policy.backoff_ns = backoff_ns; }
+void schedr_monitor_reset_restart_backoff() { restart_policy.backoff_ns = SCHEDR_RETRY_DEFAULT_BACKOFF_NS; }
+#endif
+
+/*
+ * Starts the command of a monitor with its stdout on a pipe the loop reads
+ * without blocking.
+ */
+static Status spawn_monitor(Monitor *const monitor)
+{
+    int pipe_fds[2];
+    char *shell = getenv("SHELL");
+    char *argv[] = { shell, "-c", monitor->command, NULL };
+
+    if (shell == NULL || pipe2(pipe_fds, O_CLOEXEC) != 0) { return SCHEDR_FAILURE; }
+
+    int fds[3] = { STDIN_FILENO, pipe_fds[1], STDERR_FILENO };
+    Status status = schedr_spawn_redirected(shell, argv, fds, &(monitor->pid));
+
+    close(pipe_fds[1]);
+
+    if (status == SCHEDR_SUCCESS)
+    {
+        fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+        status = schedr_scheduler_watch_fd(pipe_fds[0], false, read_monitor, monitor);
+    }
+
+    if (status != SCHEDR_SUCCESS)
+    {
+        if (monitor->pid > 0) { kill(monitor->pid, SIGTERM); }
+
+        close(pipe_fds[0]);
+        monitor->pid = 0;
+
+        return SCHEDR_FAILURE;
+    }
+
+    monitor->fd = pipe_fds[0];
+    monitor->started_ns = schedr_time_monotonic_ns();
+    monitor->line_len = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Starts a monitor again once 'delay_ns' has passed, on a timer the loop
+ * watches.
+ */
+static Status schedule_restart(Monitor *const monitor, int64_t delay_ns)
+{
+    struct itimerspec delay = { .it_value = { .tv_sec = delay_ns / SCHEDR_TIME_NANOSECS_PER_SEC,
+                                              .tv_nsec = delay_ns % SCHEDR_TIME_NANOSECS_PER_SEC } };
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (timer_fd == -1) { return SCHEDR_FAILURE; }
+
+    if (timerfd_settime(timer_fd, 0, &delay, NULL) != 0 ||
+        schedr_scheduler_watch_fd(timer_fd, false, restart_monitor, monitor) != SCHEDR_SUCCESS)
+    {
+        close(timer_fd);
+        return SCHEDR_FAILURE;
+    }
+
+    monitor->timer_fd = timer_fd;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void cancel_restart(Monitor *const monitor)
+{
+    if (monitor->timer_fd == -1) { return; }
+
+    schedr_scheduler_unwatch_fd(monitor->timer_fd);
+    close(monitor->timer_fd);
+    monitor->timer_fd = -1;
+}
+
+/*
+ * Records how long a monitor that stopped ran for, and starts it again right
+ * away if it ran for long enough, or after a backoff if it did not.
+ */
+static void retry_monitor(Monitor *const monitor, bool failed)
+{
+    int64_t delay_ns = 0;
+
+    schedr_retry_record(&restart_policy, &(monitor->retry), failed, &delay_ns);
+
+    if (delay_ns == 0 && spawn_monitor(monitor) == SCHEDR_SUCCESS) { return; }
+
+    // A monitor that could not be started again is retried too
+    if (delay_ns == 0) { schedr_retry_record(&restart_policy, &(monitor->retry), true, &delay_ns); }
+
+    schedule_restart(monitor, delay_ns);
+}
+
+static void restart_monitor(int fd, void *data)
+{
+    Monitor *monitor = (Monitor *)data;
+    uint64_t expirations;
+
+    if (read(fd, &expirations, sizeof (expirations)) == -1 && errno == EAGAIN) { return; }
+
+    cancel_restart(monitor);
+
+    if (spawn_monitor(monitor) != SCHEDR_SUCCESS) { retry_monitor(monitor, true); }
+}
+
+/*
+ * Kills the command of a monitor, if it is still running, and stops reading it.
+ */
+static void kill_monitor(Monitor *const monitor)
+{
+    if (monitor->pid > 0) { kill(monitor->pid, SIGTERM); }
+
+    if (monitor->fd != -1)
+    {
+        schedr_scheduler_unwatch_fd(monitor->fd);
+        close(monitor->fd);
+    }
+
+    monitor->pid = 0;
+    monitor->fd = -1;
+}
+
+/*
+ * Gives the monitor running 'command', starting it if no job has started it
+ * yet, or NULL if it could not be started.
+ */
+static Monitor *monitor_of(const char *command)
+{
+    Monitor *monitor = (Monitor *)schedr_hash_strings_get(&monitors_by_command, command);
+    RetryPolicy defaults;
+
+    if (monitor != NULL) { return monitor; }
+
+    monitor = (Monitor *)malloc(sizeof (Monitor));
+
+    if (monitor == NULL) { return NULL; }
+
+    strcpy(monitor->command, command);
+    monitor->subscribers = 0;
+    monitor->pid = 0;
+    monitor->fd = -1;
+    monitor->timer_fd = -1;
+    schedr_matcher_init(&(monitor->matcher));
+    schedr_retry_init(&defaults, &(monitor->retry));
+
+    if (schedr_hash_strings_put(&monitors_by_command, monitor->command, monitor) != SCHEDR_SUCCESS)
+    {
+        free(monitor);
+        return NULL;
+    }
+
+    if (spawn_monitor(monitor) != SCHEDR_SUCCESS)
+    {
+        schedr_hash_strings_remove(&monitors_by_command, command);
+        free(monitor);
+
+        return NULL;
+    }
+
+    return monitor;
+}
+
+/*
+ * Kills a monitor that no job is triggered by any more and frees it.
+ */
+static void release_monitor(Monitor *const monitor)
+{
+    if (monitor->subscribers > 0) { return; }
+
+    kill_monitor(monitor);
+    cancel_restart(monitor);
+    schedr_hash_strings_remove(&monitors_by_command, monitor->command);
+    schedr_matcher_destroy(&(monitor->matcher));
+    free(monitor);
+}
+
+Status schedr_monitor_start(Job *const job_p)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (job_p->monitor[0] == '\0' || schedr_hash_get(&monitors_by_job, (uintptr_t)job_p) != NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    Monitor *monitor = monitor_of(job_p->monitor);
+
+    if (monitor == NULL) { return SCHEDR_FAILURE; }
+
+    Status status = schedr_matcher_add(&(monitor->matcher), job_p->pattern, job_p);
+
+    if (status == SCHEDR_SUCCESS && schedr_hash_put(&monitors_by_job, (uintptr_t)job_p, monitor) != SCHEDR_SUCCESS)
+    {
+        schedr_matcher_remove(&(monitor->matcher), job_p);
+        status = SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+
+    if (status != SCHEDR_SUCCESS)
+    {
+        release_monitor(monitor);
+        return (status == SCHEDR_ERROR_BUFFER_OVERFLOW) ? SCHEDR_ERROR_INVALID_ARGUMENT : status;
+    }
+
+    monitor->subscribers++;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_monitor_stop(const Job *const job_p)
+{
+    Monitor *monitor = (Monitor *)schedr_hash_get(&monitors_by_job, (uintptr_t)job_p);
+
+    if (monitor == NULL) { return; }
+
+    schedr_hash_remove(&monitors_by_job, (uintptr_t)job_p);
+    schedr_matcher_remove(&(monitor->matcher), job_p);
+    monitor->subscribers--;
+    release_monitor(monitor);
+}
+
+bool schedr_monitor_is_running(const Job *const job_p)
+{
+    Monitor *monitor = (Monitor *)schedr_hash_get(&monitors_by_job, (uintptr_t)job_p);
+
+    return monitor != NULL && monitor->fd != -1;
+}
+
+/*
+ * Runs a job whose pattern matched a line of its monitor, unless it is paused.
+ */
+static void run_matched_job(void *data)
+{
+    Job *job_p = (Job *)data;
+
+    if (job_p->state == Running) { schedr_scheduler_run_job_now(job_p); }
+}
+
+/*
+ * Matches the line kept in the monitor against the patterns of every job it
+ * triggers, in a single pass over the line.
+ */
+static void match_line(Monitor *const monitor)
+{
+    monitor->line[monitor->line_len] = '\0';
+    schedr_matcher_match(&(monitor->matcher), monitor->line, monitor->line_len, run_matched_job);
+    monitor->line_len = 0;
+}
+
+/*
+ * Appends 'len' characters to the line kept in the monitor, dropping those
+ * beyond SCHEDR_MONITOR_MAX_LINE_LEN.
+ */
+static void append_to_line(Monitor *const monitor, const char *chars, size_t len)
+{
+    size_t room = SCHEDR_MONITOR_MAX_LINE_LEN - monitor->line_len;
+
+    if (len > room) { len = room; }
+
+    memcpy(monitor->line + monitor->line_len, chars, len);
+    monitor->line_len += len;
+}
+
+/*
+ * Reads what the monitor has written, without blocking, and matches every
+ * line that has been read to its end.
+ */
+static void read_monitor(int fd, void *data)
+{
+    static char buf[READ_LEN];
+
+    Monitor *monitor = (Monitor *)data;
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof (buf))) > 0)
+    {
+        const char *start = buf;
+        const char *end = buf + len;
+        const char *newline;
+
+        while ((newline = (const char *)memchr(start, '\n', (size_t)(end - start))) != NULL)
+        {
+            append_to_line(monitor, start, (size_t)(newline - start));
+            match_line(monitor);
+            start = newline + 1;
+        }
+
+        append_to_line(monitor, start, (size_t)(end - start));
+    }
+
+    if (len == -1 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+    // The monitor has exited, or can not be read any more, and is started again
+    if (monitor->line_len > 0) { match_line(monitor); }
+
+    bool exited_right_away = schedr_time_monotonic_ns() - monitor->started_ns < SCHEDR_MONITOR_MIN_UPTIME_NS;
+
+    kill_monitor(monitor);
+    retry_monitor(monitor, exited_right_away);
+}
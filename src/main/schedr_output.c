@@ -0,0 +1,697 @@
+#define _GNU_SOURCE             // pipe2()
+
+#include <stdlib.h>         // malloc(), free()
+#include <string.h>         // memcpy(), memchr(), strlen()
+#include <stdint.h>         // int64_t, uint32_t, uintptr_t
+#include <stdbool.h>        // bool
+#include <stdio.h>          // FILE, fprintf(), fwrite(), fputc()
+#include <time.h>           // time_t, localtime_r(), strftime()
+#include <unistd.h>         // read(), close(), STDIN_FILENO
+#include <fcntl.h>          // fcntl(), O_CLOEXEC, O_NONBLOCK
+#include <errno.h>          // errno, EAGAIN, EINTR, ENOBUFS
+
+#include "schedr_output.h"
+#include "schedr_log.h"
+#include "schedr_hash.h"
+#include "schedr_scheduler.h"
+#include "schedr_time.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define NANOSECS_PER_MILLISEC 1000000LL
+
+// Precedes the bytes of every line in the ring
+struct RecordHeader
+{
+    int64_t time_ns;
+    uint32_t len;
+    uint32_t stream;
+};
+
+typedef struct RecordHeader RecordHeader;
+
+// As much as the start of a line kept back from the log, so both fit in a buffer of twice the length
+#define OUTPUT_READ_LEN SCHEDR_LOG_MAX_LINE_LEN
+#define OUTPUT_READS_PER_EVENT 16
+
+// No more than a read without the ring, so what is read always fits in the smallest buffer of the log
+#define URING_READ_LEN OUTPUT_READ_LEN
+#define URING_READ_BUFFERS 256
+#define URING_BUFFER_GROUP 1
+
+// Every read buffer of the ring is preceded by room for the start of a line kept back from the log
+#define URING_BUFFER_STRIDE (OUTPUT_READ_LEN + URING_READ_LEN)
+
+static const char *STREAM_NAMES[] = { "out", "err" };
+
+/*
+ * The read end of a pipe that stdout or stderr of a command of 'job' is 
+ * connected to. 'unlogged' holds the start of a line that has not been
+ * written to the log yet, and a pipe is 'paused' while the log has no room
+ * for more output.
+ *
+ * With the ring a pipe is 'reading' while a read is in flight, and
+ * 'held_buffer' is the buffer holding output the log had no room for, or -1.
+ */
+struct OutputPipe
+{
+    Job *job;
+    OutputStream stream;
+    int fd;
+    bool paused;
+    LogLine unlogged;
+    bool reading;
+    bool closing;
+    int held_buffer;
+    size_t held_len;
+};
+
+typedef struct OutputPipe OutputPipe;
+
+// The pipes being read, by their descriptor
+static HashMap pipes_by_fd;
+
+// The output kept of every job whose commands have written any, by the address of the Job
+static HashMap outputs_by_job;
+static size_t output_len = SCHEDR_OUTPUT_DEFAULT_RING_LEN;
+
+// The event of the log watched while pipes are paused because it is full, -1 while none are
+static int paused_event_fd = -1;
+
+// The ring the pipes are read through, into buffers of a pool shared by all of them, picked by the kernel
+static Uring *uring = NULL;
+static char *read_buffers = NULL;
+
+// Pipes closed while a read was in flight on the ring, they are freed once the read has completed
+static int pipes_closing = 0;
+
+Status schedr_output_init(OutputRing *const ring, size_t capacity)
+{
+    if (ring == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (capacity < SCHEDR_OUTPUT_MIN_RING_LEN) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    ring->data = (char *)malloc(capacity);
+
+    if (ring->data == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    ring->capacity = capacity;
+    ring->start = 0;
+    ring->used = 0;
+    ring->last = 0;
+    ring->line_open = false;
+    ring->dropped_bytes = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_output_destroy(OutputRing *const ring)
+{
+    if (ring == NULL) { return; }
+
+    free(ring->data);
+    ring->data = NULL;
+    ring->capacity = ring->start = ring->used = ring->last = 0;
+    ring->line_open = false;
+}
+
+/*
+ * Copies 'len' bytes into the ring at 'offset', wrapping around at the end.
+ */
+static void ring_put(OutputRing *const ring, size_t offset, const void *src, size_t len)
+{
+    size_t first = ring->capacity - offset;
+
+    if (first > len) { first = len; }
+
+    memcpy(ring->data + offset, src, first);
+    memcpy(ring->data, (const char *)src + first, len - first);
+}
+
+static void ring_get(const OutputRing *const ring, size_t offset, void *dst, size_t len)
+{
+    size_t first = ring->capacity - offset;
+
+    if (first > len) { first = len; }
+
+    memcpy(dst, ring->data + offset, first);
+    memcpy((char *)dst + first, ring->data, len - first);
+}
+
+static size_t ring_offset(const OutputRing *const ring, size_t offset, size_t len)
+{
+    return (offset + len) % ring->capacity;
+}
+
+/*
+ * Drops the oldest record.
+ */
+static void drop_oldest(OutputRing *const ring)
+{
+    RecordHeader header;
+    ring_get(ring, ring->start, &header, sizeof (header));
+
+    ring->start = ring_offset(ring, ring->start, sizeof (header) + header.len);
+    ring->used -= sizeof (header) + header.len;
+    ring->dropped_bytes += header.len;
+
+    if (ring->used == 0) { ring->line_open = false; }
+}
+
+/*
+ * Stores a piece of a line, continuing the newest record if it is an open line
+ * of the same stream that has room to grow, or as a new record otherwise.
+ */
+static void append_piece(OutputRing *const ring, OutputStream stream, int64_t time_ns, const char *data, size_t len, bool ends_line)
+{
+    size_t max_len = ring->capacity - sizeof (RecordHeader);
+    RecordHeader header;
+
+    if (ring->line_open) { ring_get(ring, ring->last, &header, sizeof (header)); }
+
+    if (ring->line_open && header.stream == (uint32_t)stream && len <= max_len - header.len)
+    {
+        // The record continued is the newest, so it is only dropped once every other record is
+        while (ring->capacity - ring->used < len) { drop_oldest(ring); }
+
+        ring_put(ring, ring_offset(ring, ring->last, sizeof (header) + header.len), data, len);
+        header.len += len;
+        ring_put(ring, ring->last, &header, sizeof (header));
+        ring->used += len;
+    }
+    else
+    {
+        if (len > max_len)
+        {
+            data += len - max_len;
+            len = max_len;
+        }
+
+        while (ring->capacity - ring->used < sizeof (header) + len) { drop_oldest(ring); }
+
+        header.time_ns = time_ns;
+        header.len = (uint32_t)len;
+        header.stream = (uint32_t)stream;
+
+        ring->last = ring_offset(ring, ring->start, ring->used);
+        ring_put(ring, ring->last, &header, sizeof (header));
+        ring_put(ring, ring_offset(ring, ring->last, sizeof (header)), data, len);
+        ring->used += sizeof (header) + len;
+    }
+
+    ring->line_open = !ends_line;
+}
+
+Status schedr_output_append(OutputRing *const ring, OutputStream stream, int64_t time_ns, const char *data, size_t len)
+{
+    if (ring == NULL || data == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (stream != OutputStdout && stream != OutputStderr) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    while (len > 0)
+    {
+        const char *new_line = (const char *)memchr(data, '\n', len);
+        size_t line_len = (new_line != NULL) ? (size_t)(new_line - data) + 1 : len;
+
+        append_piece(ring, stream, time_ns, data, line_len, new_line != NULL);
+
+        data += line_len;
+        len -= line_len;
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_output_write(const OutputRing *const ring, FILE *fp)
+{
+    if (ring == NULL || fp == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    size_t offset = ring->start;
+    size_t left = ring->used;
+    bool written = true;
+
+    while (left > 0 && written)
+    {
+        RecordHeader header;
+        ring_get(ring, offset, &header, sizeof (header));
+
+        time_t secs = (time_t)(header.time_ns / NANOSECS_PER_SEC);
+        int millis = (int)((header.time_ns % NANOSECS_PER_SEC) / NANOSECS_PER_MILLISEC);
+        struct tm local;
+        char time_str[32];
+
+        localtime_r(&secs, &local);
+        strftime(time_str, sizeof (time_str), "%Y-%m-%d %H:%M:%S", &local);
+
+        size_t data_offset = ring_offset(ring, offset, sizeof (header));
+        size_t first = ring->capacity - data_offset;
+
+        if (first > header.len) { first = header.len; }
+
+        written = fprintf(fp, "%s.%03d %s ", time_str, millis, STREAM_NAMES[header.stream]) > 0
+               && fwrite(ring->data + data_offset, 1, first, fp) == first
+               && fwrite(ring->data, 1, header.len - first, fp) == header.len - first;
+
+        // A line that was cut off, or is not finished yet, still gets a line of its own
+        char last_char = ring->data[ring_offset(ring, data_offset, header.len - 1)];
+
+        if (written && last_char != '\n') { written = fputc('\n', fp) != EOF; }
+
+        offset = ring_offset(ring, offset, sizeof (header) + header.len);
+        left -= sizeof (header) + header.len;
+    }
+
+    return written ? SCHEDR_SUCCESS : SCHEDR_FAILURE;
+}
+
+/*
+ * Gives the output kept of a job, which is created when its commands first
+ * write something.
+ */
+static OutputRing *output_of(const Job *const job_p, bool create)
+{
+    OutputRing *ring = (OutputRing *)schedr_hash_get(&outputs_by_job, (uintptr_t)job_p);
+
+    if (ring != NULL || !create) { return ring; }
+
+    ring = (OutputRing *)malloc(sizeof (OutputRing));
+
+    if (ring == NULL) { return NULL; }
+
+    if (schedr_output_init(ring, output_len) != SCHEDR_SUCCESS)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    if (schedr_hash_put(&outputs_by_job, (uintptr_t)job_p, ring) != SCHEDR_SUCCESS)
+    {
+        schedr_output_destroy(ring);
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+bool schedr_output_open_pipes(int fds[3], int read_fds[2])
+{
+    int pipe_fds[2][2];
+
+    if (pipe2(pipe_fds[0], O_CLOEXEC) != 0) { return false; }
+
+    if (pipe2(pipe_fds[1], O_CLOEXEC) != 0)
+    {
+        close(pipe_fds[0][0]);
+        close(pipe_fds[0][1]);
+        return false;
+    }
+
+    fds[0] = STDIN_FILENO;
+
+    for (int i = 0; i < 2; i++)
+    {
+        // Only the read end, the command may rely on blocking writes
+        if (uring == NULL) { fcntl(pipe_fds[i][0], F_SETFL, O_NONBLOCK); }
+
+        read_fds[i] = pipe_fds[i][0];
+        fds[i + 1] = pipe_fds[i][1];
+    }
+
+    return true;
+}
+
+static char *read_buffer_data(int buffer) { return read_buffers + (size_t)buffer * URING_BUFFER_STRIDE + OUTPUT_READ_LEN; }
+
+/*
+ * Hands 'buffer' of the pool back to the kernel, to be filled by the next
+ * read of any pipe. A buffer that can not be handed back is lost to the pool,
+ * reads wait for the others.
+ */
+static void provide_read_buffer(int buffer)
+{
+    schedr_uring_provide_buffer(uring, read_buffer_data(buffer), URING_READ_LEN, buffer, URING_BUFFER_GROUP);
+}
+
+static void queue_output_read(OutputPipe *output_pipe)
+{
+    output_pipe->reading = schedr_uring_queue_read(uring, output_pipe->fd, NULL, URING_READ_LEN, URING_BUFFER_GROUP, 
+                                                   (uintptr_t)output_pipe);
+}
+
+static void drain_output(int fd, void *data);
+
+bool schedr_output_watch_pipe(Job *const job_p, OutputStream stream, int fd)
+{
+    OutputPipe *output_pipe = (OutputPipe *)malloc(sizeof (OutputPipe));
+
+    if (output_pipe != NULL)
+    {
+        output_pipe->job = job_p;
+        output_pipe->stream = stream;
+        output_pipe->fd = fd;
+        output_pipe->paused = false;
+        output_pipe->unlogged.kept = NULL;
+        output_pipe->unlogged.kept_len = 0;
+        output_pipe->reading = false;
+        output_pipe->closing = false;
+        output_pipe->held_buffer = -1;
+        output_pipe->held_len = 0;
+    }
+
+    bool watched = output_pipe != NULL && schedr_hash_put(&pipes_by_fd, (uint64_t)fd, output_pipe) == SCHEDR_SUCCESS;
+
+    if (watched && uring == NULL && schedr_scheduler_watch_fd(fd, false, drain_output, output_pipe) != SCHEDR_SUCCESS)
+    {
+        schedr_hash_remove(&pipes_by_fd, (uint64_t)fd);
+        watched = false;
+    }
+
+    // The command gets SIGPIPE if it writes more, which is better than blocking on a pipe nobody reads
+    if (!watched)
+    {
+        close(fd);
+        free(output_pipe);
+        return false;
+    }
+
+    if (uring != NULL) { queue_output_read(output_pipe); }
+
+    return true;
+}
+
+static void free_output_pipe(OutputPipe *output_pipe)
+{
+    if (output_pipe->held_buffer != -1) { provide_read_buffer(output_pipe->held_buffer); }
+
+    free(output_pipe->unlogged.kept);
+    free(output_pipe);
+}
+
+/*
+ * Stops reading a pipe and closes it, through the ring if there is one, where
+ * it is submitted along with the other requests of the iteration. A read in
+ * flight on the ring is cancelled, and the pipe is freed once the read has
+ * completed.
+ */
+static void close_output_pipe(OutputPipe *output_pipe)
+{
+    schedr_hash_remove(&pipes_by_fd, (uint64_t)output_pipe->fd);
+
+    if (uring == NULL) { schedr_scheduler_unwatch_fd(output_pipe->fd); }
+    if (uring == NULL || !schedr_uring_queue_close(uring, output_pipe->fd)) { close(output_pipe->fd); }
+
+    if (!output_pipe->reading)
+    {
+        free_output_pipe(output_pipe);
+        return;
+    }
+
+    // Without the cancel the read completes once every process writing to the pipe has closed it
+    schedr_uring_queue_cancel(uring, (uintptr_t)output_pipe);
+    output_pipe->closing = true;
+    pipes_closing++;
+}
+
+static void resume_output_pipes(int fd, void *data);
+
+/*
+ * Stops reading a pipe until the log has room again. The command blocks once
+ * the pipe is full, which slows it down to the pace of the disk instead of
+ * losing its output.
+ */
+static void pause_output_pipe(OutputPipe *output_pipe)
+{
+    if (paused_event_fd == -1)
+    {
+        if (schedr_scheduler_watch_fd(schedr_log_event_fd(), false, resume_output_pipes, NULL) != SCHEDR_SUCCESS) { return; }
+
+        paused_event_fd = schedr_log_event_fd();
+    }
+
+    // The ring only reads a pipe when a read is queued, so there is nothing to stop
+    if (uring == NULL) { schedr_scheduler_unwatch_fd(output_pipe->fd); }
+
+    output_pipe->paused = true;
+}
+
+/*
+ * Moves 'len' bytes read from a pipe at 'data' into the output of its job and
+ * the log. The OUTPUT_READ_LEN bytes before 'data' are free for the start of
+ * the line kept back from the log.
+ */
+static void take_output(OutputPipe *output_pipe, char *data, size_t len, int64_t time_ns)
+{
+    OutputRing *ring = output_of(output_pipe->job, true);
+
+    if (ring != NULL) { schedr_output_append(ring, output_pipe->stream, time_ns, data, len); }
+
+    schedr_log_append_lines(&(output_pipe->unlogged), output_pipe->job->name, output_pipe->stream, time_ns, data, len);
+}
+
+/*
+ * Logs the rest of the output of a pipe every process writing to has closed,
+ * and closes it.
+ */
+static void finish_output_pipe(OutputPipe *output_pipe)
+{
+    schedr_log_finish_lines(&(output_pipe->unlogged), output_pipe->job->name, output_pipe->stream, schedr_time_realtime_ns());
+    close_output_pipe(output_pipe);
+}
+
+/*
+ * Moves what a command has written to one of its pipes into the output of its
+ * job and the log. Up to OUTPUT_READS_PER_EVENT reads of OUTPUT_READ_LEN bytes
+ * are made at a time, as much as a pipe holds by default, so a pipe is mostly
+ * emptied in one go while a chatty command can not keep the loop from the 
+ * other commands. Once the command has 'finished', one more read is made to
+ * see the end of the pipe.
+ */
+static void read_output(OutputPipe *output_pipe, bool finished)
+{
+    size_t name_len = strlen(output_pipe->job->name);
+
+    for (int i = 0; i < OUTPUT_READS_PER_EVENT + (finished ? 1 : 0); i++)
+    {
+        // Room for the start of a line kept back and what is read now
+        if (!schedr_log_has_room(name_len, 2 * OUTPUT_READ_LEN))
+        {
+            pause_output_pipe(output_pipe);
+            return;
+        }
+
+        char buf[2 * OUTPUT_READ_LEN];
+        ssize_t len = read(output_pipe->fd, buf + OUTPUT_READ_LEN, OUTPUT_READ_LEN);
+
+        if (len < 0 && (errno == EAGAIN || errno == EINTR)) { return; }
+
+        if (len <= 0)
+        {
+            finish_output_pipe(output_pipe);
+            return;
+        }
+
+        take_output(output_pipe, buf + OUTPUT_READ_LEN, (size_t)len, schedr_time_realtime_ns());
+
+        // A short read means the pipe is empty, unless the command has finished and it is about to be closed
+        if ((size_t)len < OUTPUT_READ_LEN && !finished) { return; }
+    }
+}
+
+static void drain_output(int fd, void *data) { read_output((OutputPipe *)data, false); }
+
+void schedr_output_drain_pipe(int fd)
+{
+    OutputPipe *output_pipe = (uring == NULL) ? (OutputPipe *)schedr_hash_get(&pipes_by_fd, (uint64_t)fd) : NULL;
+
+    if (output_pipe != NULL && !output_pipe->paused) { read_output(output_pipe, true); }
+}
+
+/*
+ * Moves the output held in a buffer of the pool into the output of the job
+ * and the log, if the log has room for it. Returns false if it has not.
+ */
+static bool take_held_output(OutputPipe *output_pipe)
+{
+    if (output_pipe->held_buffer == -1) { return true; }
+
+    if (!schedr_log_has_room(strlen(output_pipe->job->name), output_pipe->unlogged.kept_len + output_pipe->held_len)) { return false; }
+
+    take_output(output_pipe, read_buffer_data(output_pipe->held_buffer), output_pipe->held_len, schedr_time_realtime_ns());
+    provide_read_buffer(output_pipe->held_buffer);
+    output_pipe->held_buffer = -1;
+
+    return true;
+}
+
+void schedr_output_read_completed(uint64_t user_data, int res, unsigned flags)
+{
+    OutputPipe *output_pipe = (OutputPipe *)(uintptr_t)user_data;
+    int buffer = (flags & IORING_CQE_F_BUFFER) ? (int)(flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+    output_pipe->reading = false;
+    output_pipe->held_buffer = buffer;
+    output_pipe->held_len = (res > 0) ? (size_t)res : 0;
+
+    if (output_pipe->closing)
+    {
+        pipes_closing--;
+        free_output_pipe(output_pipe);
+        return;
+    }
+
+    if (res == -EAGAIN || res == -EINTR || res == -ENOBUFS)
+    {
+        // The buffers run out only for a moment, unless they are held by pipes waiting for the log
+        if (res == -ENOBUFS && paused_event_fd != -1) { pause_output_pipe(output_pipe); }
+        else { queue_output_read(output_pipe); }
+
+        return;
+    }
+
+    if (res <= 0)
+    {
+        finish_output_pipe(output_pipe);
+        return;
+    }
+
+    if (!take_held_output(output_pipe))
+    {
+        pause_output_pipe(output_pipe);
+        return;
+    }
+
+    queue_output_read(output_pipe);
+}
+
+/*
+ * Reads the paused pipes again, now that the writer of the log has made room.
+ */
+static void resume_output_pipes(int fd, void *data)
+{
+    bool still_full = false;
+
+    schedr_log_clear_event();
+    schedr_scheduler_unwatch_fd(fd);
+    paused_event_fd = -1;
+
+    for (size_t i = 0; i < pipes_by_fd.capacity; i++)
+    {
+        OutputPipe *output_pipe = (OutputPipe *)pipes_by_fd.entries[i].value;
+
+        if (!pipes_by_fd.entries[i].used || !output_pipe->paused) { continue; }
+
+        if (uring == NULL)
+        {
+            if (schedr_scheduler_watch_fd(output_pipe->fd, false, drain_output, output_pipe) == SCHEDR_SUCCESS) { output_pipe->paused = false; }
+        }
+        else if (!still_full && take_held_output(output_pipe))
+        {
+            output_pipe->paused = false;
+            queue_output_read(output_pipe);
+        }
+        else { still_full = true; }
+    }
+
+    if (still_full && schedr_scheduler_watch_fd(schedr_log_event_fd(), false, resume_output_pipes, NULL) == SCHEDR_SUCCESS)
+    {
+        paused_event_fd = schedr_log_event_fd();
+    }
+}
+
+bool schedr_output_has_pipes() { return pipes_by_fd.count > 0; }
+
+bool schedr_output_is_paused() { return paused_event_fd != -1; }
+
+Status schedr_output_start_ring(Uring *const ring)
+{
+    if (ring == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (uring != NULL || pipes_by_fd.count > 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    read_buffers = (char *)malloc((size_t)URING_READ_BUFFERS * URING_BUFFER_STRIDE);
+
+    if (read_buffers == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    uring = ring;
+
+    for (int i = 0; i < URING_READ_BUFFERS; i++) { provide_read_buffer(i); }
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_output_stop_ring()
+{
+    struct io_uring_cqe *cqe;
+
+    if (uring == NULL) { return; }
+
+    schedr_uring_submit(uring, false);
+
+    while (pipes_closing > 0 && schedr_uring_submit(uring, true) == SCHEDR_SUCCESS)
+    {
+        while ((cqe = schedr_uring_peek(uring)) != NULL)
+        {
+            struct io_uring_cqe completion = *cqe;
+
+            schedr_uring_seen(uring);
+
+            if (completion.user_data >= SCHEDR_URING_TAGS) { schedr_output_read_completed(completion.user_data, completion.res, completion.flags); }
+        }
+    }
+
+    free(read_buffers);
+    read_buffers = NULL;
+    uring = NULL;
+}
+
+Status schedr_output_set_len(size_t len)
+{
+    if (len < SCHEDR_OUTPUT_MIN_RING_LEN) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    output_len = len;
+
+    return SCHEDR_SUCCESS;
+}
+
+const OutputRing *schedr_output_of(const Job *const job_p) { return output_of(job_p, false); }
+
+void schedr_output_remove_job(const Job *const job_p)
+{
+    // Finishing a pipe moves the entries after it back, so the same slot is looked at again
+    for (size_t i = 0; i < pipes_by_fd.capacity; )
+    {
+        OutputPipe *output_pipe = (OutputPipe *)pipes_by_fd.entries[i].value;
+
+        if (pipes_by_fd.entries[i].used && (job_p == NULL || output_pipe->job == job_p))
+        {
+            finish_output_pipe(output_pipe);
+            continue;
+        }
+
+        i++;
+    }
+
+    if (job_p != NULL)
+    {
+        OutputRing *ring = output_of(job_p, false);
+
+        if (ring == NULL) { return; }
+
+        schedr_hash_remove(&outputs_by_job, (uintptr_t)job_p);
+        schedr_output_destroy(ring);
+        free(ring);
+        return;
+    }
+
+    if (paused_event_fd != -1) { schedr_scheduler_unwatch_fd(paused_event_fd); }
+
+    paused_event_fd = -1;
+
+    for (size_t i = 0; i < outputs_by_job.capacity; i++)
+    {
+        if (!outputs_by_job.entries[i].used) { continue; }
+
+        schedr_output_destroy((OutputRing *)outputs_by_job.entries[i].value);
+        free(outputs_by_job.entries[i].value);
+    }
+
+    schedr_hash_destroy(&outputs_by_job);
+    output_len = SCHEDR_OUTPUT_DEFAULT_RING_LEN;
+}
@@ -0,0 +1,181 @@
+#include <stdlib.h>         // malloc(), free()
+#include <stddef.h>         // NULL
+#include <stdbool.h>        // bool
+#include <string.h>         // strlen(), strcpy(), strcmp(), strrchr(), memset()
+#include <unistd.h>         // read(), close()
+#include <limits.h>         // PATH_MAX, NAME_MAX
+#include <sys/inotify.h>    // inotify_init1(), inotify_add_watch(), struct inotify_event
+
+#include "schedr_reload.h"
+#include "schedr_scheduler.h"
+
+#define EVENTS_LEN 4096
+
+static int inotify_fd = -1;
+static char watched_name[NAME_MAX + 1];
+static void (*reload_handler)() = NULL;
+
+/*
+ * Starts a copy of 'job_p' owned by the index.
+ */
+static Status start_copy(JobIndex *const index, const Job *const job_p)
+{
+    Job *copy = (Job *)malloc(sizeof (Job));
+
+    if (copy == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+
+    *copy = *job_p;
+
+    Status status = schedr_job_index_add(index, copy, true);
+
+    if (status != SCHEDR_SUCCESS)
+    {
+        free(copy);
+        return status;
+    }
+
+    if ((status = schedr_scheduler_start_job(copy)) != SCHEDR_SUCCESS) { schedr_job_index_remove(index, copy); }
+
+    return status;
+}
+
+Status schedr_reload_apply(JobIndex *const index, const Job jobs[], int jobs_len, ReloadStats *const stats)
+{
+    if (index == NULL || jobs == NULL || stats == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (jobs_len < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    JobIndex configured;
+
+    memset(stats, 0, sizeof (ReloadStats));
+    schedr_job_index_init(&configured);
+
+    // Two jobs with the same name are rejected before any job is touched, like the config loader rejects them
+    for (int i = 0; i < jobs_len; i++)
+    {
+        Status status = schedr_job_index_add(&configured, (Job *)&(jobs[i]), false);
+
+        if (status != SCHEDR_SUCCESS)
+        {
+            schedr_job_index_destroy(&configured);
+            return status;
+        }
+    }
+
+    // From the last job, since the last job takes the place of a removed one
+    for (int i = index->len - 1; i >= 0; i--)
+    {
+        Job *running = schedr_job_index_at(index, i);
+
+        if (schedr_job_index_find(&configured, running->name) != NULL) { continue; }
+
+        schedr_scheduler_remove_job(running);
+        schedr_job_index_remove(index, running);
+        stats->removed++;
+    }
+
+    for (int i = 0; i < configured.len; i++)
+    {
+        const Job *job_p = schedr_job_index_at(&configured, i);
+        Job *running = schedr_job_index_find(index, job_p->name);
+
+        if (running != NULL && schedr_job_fingerprint(running) == schedr_job_fingerprint(job_p))
+        {
+            stats->unchanged++;
+            continue;
+        }
+
+        if (running != NULL && schedr_scheduler_update_job(running, job_p) == SCHEDR_SUCCESS)
+        {
+            stats->updated++;
+            continue;
+        }
+
+        if (running != NULL)
+        {
+            schedr_scheduler_remove_job(running);
+            schedr_job_index_remove(index, running);
+        }
+
+        if (start_copy(index, job_p) != SCHEDR_SUCCESS) { stats->failed++; }
+        else if (running != NULL) { stats->restarted++; }
+        else { stats->started++; }
+    }
+
+    schedr_job_index_destroy(&configured);
+
+    return (stats->failed > 0) ? SCHEDR_FAILURE : SCHEDR_SUCCESS;
+}
+
+/*
+ * Reads the events of the watched directory, and reloads once if any of them
+ * was about the configuration file.
+ */
+static void read_events(int fd, void *data)
+{
+    char events[EVENTS_LEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool written = false;
+    ssize_t len;
+
+    while ((len = read(fd, events, sizeof (events))) > 0)
+    {
+        for (char *event_p = events; event_p < events + len; )
+        {
+            const struct inotify_event *event = (const struct inotify_event *)event_p;
+
+            if (event->len > 0 && strcmp(event->name, watched_name) == 0) { written = true; }
+
+            event_p += sizeof (struct inotify_event) + event->len;
+        }
+    }
+
+    if (written) { reload_handler(); }
+}
+
+Status schedr_reload_watch(const char *config_path, void (*reload)())
+{
+    if (config_path == NULL || reload == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (strlen(config_path) >= PATH_MAX) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    char dir[PATH_MAX];
+    strcpy(dir, config_path);
+
+    char *slash = strrchr(dir, '/');
+    const char *name = (slash != NULL) ? slash + 1 : config_path;
+
+    if (strlen(name) > NAME_MAX || name[0] == '\0') { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    if (slash == dir) { dir[1] = '\0'; }
+    else if (slash != NULL) { *slash = '\0'; }
+    else { strcpy(dir, "."); }
+
+    schedr_reload_unwatch();
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (fd == -1) { return SCHEDR_FAILURE; }
+
+    // Written in place, or written elsewhere and renamed over it
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) == -1 ||
+        schedr_scheduler_watch_fd(fd, false, read_events, NULL) != SCHEDR_SUCCESS)
+    {
+        close(fd);
+        return SCHEDR_FAILURE;
+    }
+
+    inotify_fd = fd;
+    strcpy(watched_name, name);
+    reload_handler = reload;
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_reload_unwatch()
+{
+    if (inotify_fd == -1) { return; }
+
+    schedr_scheduler_unwatch_fd(inotify_fd);
+    close(inotify_fd);
+
+    inotify_fd = -1;
+    reload_handler = NULL;
+}
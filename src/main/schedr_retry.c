@@ -0,0 +1,116 @@
+#include <stddef.h>         // NULL
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool
+#include <sys/random.h>     // getrandom()
+
+#include "schedr_retry.h"
+#include "schedr_time.h"
+
+static uint64_t random_u64();
+
+static uint64_t (*random_source)(void) = random_u64;
+
+#ifdef TEST
+void schedr_retry_set_random(uint64_t (*random_func)(void)) { random_source = random_func; }
+void schedr_retry_reset_random() { random_source = random_u64; }
+#endif
+
+Status schedr_retry_init(RetryPolicy *const policy, RetryState *const state)
+{
+    if (policy == NULL || state == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    policy->max_attempts = 0;
+    policy->backoff_ns = SCHEDR_RETRY_DEFAULT_BACKOFF_NS;
+    policy->max_backoff_ns = SCHEDR_RETRY_DEFAULT_MAX_BACKOFF_NS;
+    policy->jitter_percent = SCHEDR_RETRY_DEFAULT_JITTER_PERCENT;
+    policy->cooldown_ns = 0;
+
+    state->failures = 0;
+    state->failures_in_row = 0;
+    state->backoff_ns = 0;
+    state->breaker_open = false;
+    state->breaker_trips = 0;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_retry_validate(const RetryPolicy *const policy)
+{
+    if (policy == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (policy->max_attempts < 0 || policy->cooldown_ns < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (policy->backoff_ns < 1 || policy->max_backoff_ns < policy->backoff_ns) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (policy->jitter_percent < 0 || policy->jitter_percent > 100) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Doubles the first backoff for every failure in a row after the first, up to
+ * the cap, and takes the jitter off.
+ */
+static int64_t backoff_of(const RetryPolicy *const policy, int failures_in_row)
+{
+    int64_t backoff_ns = policy->backoff_ns;
+
+    // Doubled one step at a time, so it can not overflow however many failures there have been
+    for (int i = 1; i < failures_in_row && backoff_ns < policy->max_backoff_ns; i++) { backoff_ns *= 2; }
+
+    if (backoff_ns > policy->max_backoff_ns) { backoff_ns = policy->max_backoff_ns; }
+
+    uint64_t max_jitter_ns = (uint64_t)(backoff_ns / 100) * (uint64_t)policy->jitter_percent;
+
+    if (max_jitter_ns > 0) { backoff_ns -= (int64_t)(random_source() % (max_jitter_ns + 1)); }
+
+    return backoff_ns;
+}
+
+RetryAction schedr_retry_record(const RetryPolicy *const policy, RetryState *const state, bool failed, int64_t *delay_ns)
+{
+    if (policy == NULL || state == NULL || delay_ns == NULL) { return RetryGiveUp; }
+
+    *delay_ns = 0;
+
+    if (!failed)
+    {
+        state->failures_in_row = 0;
+        state->backoff_ns = 0;
+        state->breaker_open = false;
+
+        return RetryOnSchedule;
+    }
+
+    state->failures++;
+    state->failures_in_row++;
+
+    // The first run that fails is not a retry, the breaker opens once every retry has failed as well
+    if (!state->breaker_open && state->failures_in_row <= policy->max_attempts)
+    {
+        state->backoff_ns = *delay_ns = backoff_of(policy, state->failures_in_row);
+
+        return RetryAfterBackoff;
+    }
+
+    if (policy->cooldown_ns == 0)
+    {
+        state->backoff_ns = 0;
+
+        return RetryGiveUp;
+    }
+
+    if (!state->breaker_open) { state->breaker_trips++; }
+
+    state->breaker_open = true;
+    state->backoff_ns = *delay_ns = policy->cooldown_ns;
+
+    return RetryAfterCooldown;
+}
+
+static uint64_t random_u64()
+{
+    uint64_t value;
+
+    if (getrandom(&value, sizeof (value), GRND_NONBLOCK) == sizeof (value)) { return value; }
+
+    // Fall back on the clock, which is random enough to keep the retries apart
+    return (uint64_t)schedr_time_monotonic_ns() * 0x9e3779b97f4a7c15ULL;
+}
@@ -0,0 +1,166 @@
+#include <stddef.h>         // NULL
+#include <stdint.h>         // int64_t
+#include <stdbool.h>        // bool, true, false
+
+#include "schedr_run_queue.h"
+
+static void link_first(RunQueue *const queue, RunQueueNode *const node);
+static void link_last(RunQueue *const queue, RunQueueNode *const node);
+static void unlink_node(RunQueue *const queue, RunQueueNode *const node);
+
+Status schedr_run_queue_init(RunQueue *const queue, int max_slots)
+{
+    if (queue == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (max_slots < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    queue->head.next = &(queue->head);
+    queue->head.prev = &(queue->head);
+    queue->stats = (RunQueueStats){ .max_slots = max_slots };
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_run_queue_set_max_slots(RunQueue *const queue, int max_slots)
+{
+    if (queue == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (max_slots < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    queue->stats.max_slots = max_slots;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_run_queue_node_init(RunQueueNode *const node, void *data)
+{
+    if (node == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    node->next = NULL;
+    node->prev = NULL;
+    node->weight = 1;
+    node->queued_at_ns = 0;
+    node->queued = false;
+    node->data = data;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_run_queue_push(RunQueue *const queue, RunQueueNode *const node, int weight, int64_t now_ns)
+{
+    if (queue == NULL || node == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (node->queued || weight < 1) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    node->weight = weight;
+    node->queued_at_ns = now_ns;
+    link_last(queue, node);
+
+    return SCHEDR_SUCCESS;
+}
+
+RunQueueNode *schedr_run_queue_pop(RunQueue *const queue, int64_t now_ns)
+{
+    if (queue == NULL || !schedr_run_queue_can_pop(queue)) { return NULL; }
+
+    RunQueueNode *node = queue->head.next;
+    RunQueueStats *stats = &(queue->stats);
+    int64_t waited_ns = now_ns - node->queued_at_ns;
+
+    unlink_node(queue, node);
+
+    // The number of slots may have been lowered since the node was queued
+    if (stats->max_slots > 0 && node->weight > stats->max_slots) { node->weight = stats->max_slots; }
+
+    stats->slots_in_use += node->weight;
+    stats->runs_admitted++;
+
+    if (waited_ns > 0)
+    {
+        stats->total_wait_ns += waited_ns;
+
+        if (waited_ns > stats->max_wait_ns) { stats->max_wait_ns = waited_ns; }
+    }
+
+    return node;
+}
+
+Status schedr_run_queue_requeue(RunQueue *const queue, RunQueueNode *const node)
+{
+    if (queue == NULL || node == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (node->queued) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    queue->stats.slots_in_use -= node->weight;
+    queue->stats.runs_admitted--;
+    link_first(queue, node);
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_run_queue_release(RunQueue *const queue, int slots)
+{
+    if (queue == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (slots < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    queue->stats.slots_in_use -= slots;
+
+    if (queue->stats.slots_in_use < 0) { queue->stats.slots_in_use = 0; }
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_run_queue_remove(RunQueue *const queue, RunQueueNode *const node)
+{
+    if (queue == NULL || node == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    if (node->queued) { unlink_node(queue, node); }
+
+    return SCHEDR_SUCCESS;
+}
+
+bool schedr_run_queue_can_pop(const RunQueue *const queue)
+{
+    if (queue == NULL || queue->head.next == &(queue->head)) { return false; }
+
+    const RunQueueStats *stats = &(queue->stats);
+    int weight = queue->head.next->weight;
+
+    if (stats->max_slots == 0) { return true; }
+    if (weight > stats->max_slots) { weight = stats->max_slots; }
+
+    return stats->slots_in_use + weight <= stats->max_slots;
+}
+
+static void link_first(RunQueue *const queue, RunQueueNode *const node)
+{
+    node->prev = &(queue->head);
+    node->next = queue->head.next;
+    queue->head.next->prev = node;
+    queue->head.next = node;
+    node->queued = true;
+
+    queue->stats.depth++;
+
+    if (queue->stats.depth > queue->stats.max_depth) { queue->stats.max_depth = queue->stats.depth; }
+}
+
+static void link_last(RunQueue *const queue, RunQueueNode *const node)
+{
+    node->next = &(queue->head);
+    node->prev = queue->head.prev;
+    queue->head.prev->next = node;
+    queue->head.prev = node;
+    node->queued = true;
+
+    queue->stats.depth++;
+
+    if (queue->stats.depth > queue->stats.max_depth) { queue->stats.max_depth = queue->stats.depth; }
+}
+
+static void unlink_node(RunQueue *const queue, RunQueueNode *const node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+    node->queued = false;
+
+    queue->stats.depth--;
+}
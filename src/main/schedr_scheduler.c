@@ -1,84 +1,399 @@
 #include <sys/types.h>      // pid_t
 #include <stdlib.h>         // getenv()
-#include <unistd.h>         // fork(), execve(), sleep()
+#include <unistd.h>         // fork(), execve()
 #include <sys/wait.h>       // waitpid()
 #include <stdbool.h>        // false
 #include <string.h>
 #include <linux/limits.h>   // PATH_MAX
 #include <sys/stat.h>       // mkdir()
+#include <signal.h>         // sigprocmask()
+#include <sys/signalfd.h>   // signalfd()
+#include <sys/epoll.h>      // epoll_create1(), epoll_ctl(), epoll_wait()
+#include <sys/timerfd.h>    // timerfd_create(), timerfd_settime()
+#include <sys/resource.h>   // struct rusage
+#include <time.h>           // clock_nanosleep()
+#include <stdint.h>         // int64_t, uintptr_t
+#include <errno.h>          // EINTR
+#include <fcntl.h>          // fcntl(), O_CLOEXEC, O_NONBLOCK
 
 #include "schedr_scheduler.h"
+#include "schedr_timer.h"
+#include "schedr_spawn.h"
+#include "schedr_hash.h"
+#include "schedr_run_queue.h"
+#include "schedr_output.h"
+#include "schedr_uring.h"
+#include "schedr_limits.h"
+#include "schedr_monitor.h"
+#include "schedr_time.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define MAX_EVENTS 256
+#define URING_ENTRIES 1024
+#define URING_SIGNAL_INFOS 16
+#define TIMER_TICK_NS 100000LL
+#define STARTED_JOBS_INITIAL_CAPACITY 16
+
+// Runs of calendars further away are timed again after this long, so their deadline keeps up with the system clock
+#define CALENDAR_MAX_WAIT_SECS (24 * 60 * 60LL)
 
-#define MAX_RUNNING_JOBS 100
 static int started_jobs_count = 0;
+static int started_jobs_capacity = 0;
+static SchedulerMode mode = Supervised;
+
+static sigset_t loop_signals;
+static sigset_t original_signal_mask;
+static bool loop_signals_blocked = false;
+
+// Called between two iterations of the loop once SIGHUP has been received
+static void (*reload_handler)() = NULL;
+static bool reload_requested = false;
+
+static TimerWheel timers;
+static bool timers_initialized = false;
+static int cmds_in_flight = 0;
+
+// The event loop sleeps in epoll_wait() until a loop signal arrives, the timer reaches the next deadline
+// or the zygote reports a finished command on 'spawn_fd'
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static int timer_fd = -1;
+static int spawn_fd = -1;
+
+static LoopBackend loop_backend = LoopEpoll;
+
+/*
+ * With LoopUring the loop keeps a read of 'signal_fd', a poll of 'epoll_fd',
+ * which holds the descriptors watched by others, a poll of 'spawn_fd' and a
+ * timeout at the next deadline in flight on 'uring'. The output pipes are
+ * read through it by schedr_output, whose completions carry their pipe, the
+ * others one of UringTag.
+ */
+enum UringTag
+{
+    TagSignals = 2,
+    TagEpoll = 3,
+    TagSpawn = 4,
+    TagTimeout = 5
+};
+
+static Uring uring;
+static bool signals_read_queued = false;
+static bool epoll_poll_queued = false;
+static bool spawn_poll_queued = false;
+static int64_t queued_deadline = -1;
+static struct __kernel_timespec queued_deadline_ts;
+static struct signalfd_siginfo signal_infos[URING_SIGNAL_INFOS];
+
+// Finished commands are only reaped after SIGCHLD or a report of the zygote has been received
+static bool children_exited = true;
+
+// Commands of stopped jobs that have been sent SIGTERM but not reaped yet, by pid. The values are the run queue slots they occupy.
+static HashMap stopping_cmds;
+
+// Due runs waiting for a slot, in the order they became due
+static RunQueue run_queue = { .head = { .next = &(run_queue.head), .prev = &(run_queue.head) } };
+
+// Handlers of the file descriptors watched by the event loop besides its own, by descriptor
+static HashMap watches_by_fd;
+
 
-static int (*exec)(const char *fn, char *const argv[], char *const envp[]) = execve;
 static int (*forker)(void) = fork;
-static unsigned int (*sleeper)(unsigned int seconds) = sleep;
+static int (*sleeper)(clockid_t clock_id, int flags, const struct timespec *request, struct timespec *remain) = clock_nanosleep;
 
+struct JobProcMap;
+
+/*
+ * A run of a job in EventLoop mode. It is idle, in the run queue waiting for a
+ * slot since it was due at 'due_ns', or running the command 'pid' since
+ * 'started_ns'.
+ */
+struct JobRun
+{
+    struct JobProcMap *entry;
+    RunQueueNode queued_run;
+    pid_t pid;
+    int64_t due_ns;
+    int64_t started_ns;
+    int output_fds[2];          // The pipes the command writes to, -1 if they are not captured
+    CgroupLeaf cgroup;          // The leaf the commands of the run are started in, if the job has limits
+};
+
+typedef struct JobRun JobRun;
+
+/*
+ * In Supervised mode 'pid' is the process supervising the job, in EventLoop
+ * mode it is 0. 'run_at_ns' is the deadline of the current or next run, which
+ * the deadline of the run after it is calculated from. 'next_run_ns' is when
+ * 'next_run' is due, a retry included. 'index' is the position of the entry
+ * in 'started_jobs'. For a job with a calendar 'calendar_at_ns' is the time of
+ * the system clock the next run is due at, INT64_MAX if it is further away 
+ * than its deadline.
+ *
+ * In EventLoop mode a job has one run for every command it may run at the
+ * same time, 'active_runs' of which are queued or running. 'run_held' is set
+ * when a run was due at 'held_due_ns' while the job was running and is held
+ * until it finishes.
+ */
 struct JobProcMap 
 {
     Job *job;
     pid_t pid;
+    Timer next_run;
+    int64_t run_at_ns;
+    int64_t next_run_ns;
+    int64_t calendar_at_ns;
+    int index;
+    int active_runs;
+    bool run_held;
+    int64_t held_due_ns;
+    int runs_len;
+    JobRun runs[];
 };
 
 typedef struct JobProcMap JobProcMap;
 
-static JobProcMap started_jobs[MAX_RUNNING_JOBS];
+struct FdWatch
+{
+    void (*handler)(int fd, void *data);
+    void *data;
+};
+
+typedef struct FdWatch FdWatch;
+
+// Entries are allocated one by one, since the timer wheel links to them
+static JobProcMap **started_jobs = NULL;
+
+// Started jobs by the address of their Job, and the running commands of EventLoop jobs by their pid
+static HashMap jobs_by_address;
+static HashMap runs_by_pid;
+
+static Status add_started_job(Job *const job_p, pid_t pid, JobProcMap **entry_p);
+static Status set_run_pid(JobRun *const run, pid_t pid);
+static void remove_started_job(JobProcMap *const entry);
+static void stop_started_job(JobProcMap *const entry);
+static Status run_loop_iteration(bool *terminate);
+static void queue_run(JobRun *const run, int64_t now_ns);
+static void job_due(JobProcMap *const entry, int64_t now_ns);
+static bool run_due(JobProcMap *const entry, int64_t due_ns, int64_t now_ns);
+static Status launch_queued_runs(int64_t now_ns);
+static JobProcMap *find_started_job(const Job *const job_p);
+static JobRun *find_run_by_pid(pid_t pid);
+static void drain_finished_output(JobRun *const run);
+static Status watch_fd(int fd);
 
 #ifdef TEST
-void schedr_scheduler_set_exec(int (*exec_func)(const char *fn, char *const argv[], char *const envp[])) { exec = exec_func; }
-void schedr_scheduler_reset_exec() { exec = execve; }
-void schedr_scheduler_set_forker(int (*fork_func)(void)) { forker = fork_func; }
-void schedr_scheduler_reset_forker() { forker = fork; }
-void schedr_scheduler_set_sleeper(unsigned int (*sleep_func)(unsigned int seconds)) { sleeper = sleep_func; }
-void schedr_scheduler_reset_sleeper() { sleeper = sleep; }
+void schedr_scheduler_set_exec(int (*exec_func)(const char *fn, char *const argv[], char *const envp[])) { schedr_spawn_set_exec(exec_func); }
+void schedr_scheduler_reset_exec() { schedr_spawn_reset_exec(); }
+void schedr_scheduler_set_forker(int (*fork_func)(void)) { forker = fork_func; schedr_spawn_set_forker(fork_func); }
+void schedr_scheduler_reset_forker() { forker = fork; schedr_spawn_reset_forker(); }
+void schedr_scheduler_set_sleeper(int (*sleep_func)(clockid_t clock_id, int flags, 
+                                                   const struct timespec *request, 
+                                                   struct timespec *remain)) { sleeper = sleep_func; }
+void schedr_scheduler_reset_sleeper() { sleeper = clock_nanosleep; }
 
 void schedr_scheduler_kill_children() 
 {
     for (int i = started_jobs_count - 1; i >= 0; i--)
     {
-        pid_t pid = started_jobs[i].pid;
+        JobProcMap *entry = started_jobs[i];
         
-        kill(started_jobs[i].pid, SIGTERM);
-        waitpid(pid, NULL, 0);
+        for (int j = -1; j < entry->runs_len; j++)
+        {
+            pid_t pid = (j == -1) ? entry->pid : entry->runs[j].pid;
+            
+            if (pid != 0)
+            {
+                kill(pid, SIGTERM);
+                waitpid(pid, NULL, 0);
+            }
+        }
+        
+        remove_started_job(entry);
+    }
+    
+    for (size_t i = 0; i < stopping_cmds.capacity; i++)
+    {
+        if (!stopping_cmds.entries[i].used) { continue; }
         
-        started_jobs[i].job = NULL;
-        started_jobs[i].pid = 0;
+        pid_t pid = (pid_t)stopping_cmds.entries[i].key;
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
     }
     
-    started_jobs_count = 0;
+    schedr_hash_destroy(&stopping_cmds);
+    schedr_run_queue_init(&run_queue, run_queue.stats.max_slots);
+    cmds_in_flight = 0;
+    
+    schedr_output_remove_job(NULL);
+    schedr_scheduler_set_loop_backend(LoopEpoll);
+    schedr_histogram_forget_latency(NULL);
 }
 
-void schedr_scheduler_associate_pid_with_jod(Job *const job, pid_t pid) 
-{ 
-    started_jobs[started_jobs_count].job = job;
-    started_jobs[started_jobs_count].pid = pid;
-    started_jobs_count++;
-}
+bool schedr_scheduler_job_is_started(const Job *const job_p) { return find_started_job(job_p) != NULL; }
+
+void schedr_scheduler_associate_pid_with_jod(Job *const job, pid_t pid) { add_started_job(job, pid, NULL); }
+Status schedr_scheduler_run_once() { return run_loop_iteration(NULL); }
 
 void __gcov_flush();
 #endif
 
-static void cmd_proc(Job *job_p)
+/*
+ * Calculates when a job is due next, given the deadline of its last run and
+ * the current time. Deadlines of FixedRate jobs are kept on the grid of the 
+ * first run, so delays in one run do not add up over the following ones.
+ */
+static int64_t next_run_ns(const Job *const job_p, int64_t last_run_ns, int64_t now_ns)
+{
+    int64_t interval_ns = job_p->interval_ns;
+    
+    if (job_p->timing != FixedRate) { return now_ns + interval_ns; }
+    if (interval_ns == 0) { return now_ns; }
+    
+    int64_t next = last_run_ns + interval_ns;
+    
+    // Skip the runs that were missed while the last one was running
+    if (next <= now_ns) { next += ((now_ns - next) / interval_ns + 1) * interval_ns; }
+    
+    return next;
+}
+
+/*
+ * Calculates the deadline of the next run of a job with a calendar and sets
+ * 'calendar_at_ns' to the time of the system clock the run is due at. The 
+ * splay delays every run, so the calendar is searched from the time the
+ * current run was due at before it was delayed.
+ */
+static int64_t calendar_run_ns(const Job *const job_p, int64_t *calendar_at_ns)
+{
+    int64_t real_now_ns = schedr_time_realtime_ns();
+    time_t after = (time_t)((real_now_ns - job_p->splay_offset_ns) / NANOSECS_PER_SEC);
+    time_t next;
+    
+    if (schedr_calendar_next(&(job_p->calendar), after, &next) != SCHEDR_SUCCESS || next - after > CALENDAR_MAX_WAIT_SECS)
+    {
+        *calendar_at_ns = INT64_MAX;
+        return schedr_time_monotonic_ns() + CALENDAR_MAX_WAIT_SECS * NANOSECS_PER_SEC;
+    }
+    
+    *calendar_at_ns = (int64_t)next * NANOSECS_PER_SEC + job_p->splay_offset_ns;
+    
+    return schedr_time_monotonic_ns() + (*calendar_at_ns - real_now_ns);
+}
+
+/*
+ * Calculates when a started job is due next, by its calendar or from the 
+ * deadline of its last run.
+ */
+static int64_t time_next_run(JobProcMap *const entry, int64_t now_ns)
+{
+    if (schedr_calendar_is_set(&(entry->job->calendar))) { return calendar_run_ns(entry->job, &(entry->calendar_at_ns)); }
+    
+    return next_run_ns(entry->job, entry->run_at_ns, now_ns);
+}
+
+/*
+ * Tells if the next run of a job is timed as soon as the job is due, instead of
+ * when the run has finished. A job without an interval or calendar runs back 
+ * to back, so its runs can not overlap.
+ */
+static bool is_timed_when_due(const Job *const job_p)
+{
+    return job_p->overlap != OverlapWait && (job_p->interval_ns > 0 || schedr_calendar_is_set(&(job_p->calendar)));
+}
+
+/*
+ * Tells if a job runs on a timer. A job with a trigger and no interval or 
+ * calendar only runs when its monitor writes a matching line.
+ */
+static bool is_timed(const Job *const job_p)
 {
+    return job_p->interval_ns > 0 || schedr_calendar_is_set(&(job_p->calendar)) || job_p->monitor[0] == '\0';
+}
+
+static int max_runs(const Job *const job_p)
+{
+    return (job_p->overlap == OverlapParallel && job_p->max_parallel > 1) ? job_p->max_parallel : 1;
+}
+
+static void sleep_until(int64_t deadline_ns)
+{
+    struct timespec deadline = { .tv_sec = deadline_ns / NANOSECS_PER_SEC, .tv_nsec = deadline_ns % NANOSECS_PER_SEC };
+    
+    while (sleeper(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) { }
+}
+
+/*
+ * Sleeps until the next run of a job with a calendar is due on the system 
+ * clock, which may have been set or drifted from the monotonic clock while
+ * sleeping.
+ */
+static void sleep_until_calendar(const Job *const job_p)
+{
+    int64_t calendar_at_ns;
+    
+    do { sleep_until(calendar_run_ns(job_p, &calendar_at_ns)); } while (schedr_time_realtime_ns() < calendar_at_ns);
+}
+
+static void init_timers()
+{
+    if (timers_initialized) { return; }
+    
+    schedr_timer_wheel_init(&timers, TIMER_TICK_NS, schedr_time_monotonic_ns());
+    timers_initialized = true;
+}
+
+static void restore_signal_mask()
+{
+    if (loop_signals_blocked) { sigprocmask(SIG_SETMASK, &original_signal_mask, NULL); }
+}
+
+/*
+ * Starts a process running the command of the job, without waiting for it to
+ * finish. Compiled commands are executed directly, everything else in $SHELL.
+ * The process gets 'fds' as its stdin, stdout and stderr, or those of the 
+ * daemon if it is NULL. The process of a job with limits is started in the
+ * leaf 'cgroup', which is created on the first run, or with its limits set
+ * with setrlimit() if there are no cgroups.
+ *
+ * returns  SCHEDR_ERROR_FORK_FAILED if the process could not be created,
+ *          SCHEDR_FAILURE if the command could not be executed,
+ *          SCHEDR_SUCCESS otherwise
+ */
+static Status launch_job_cmd(Job *job_p, const int fds[3], CgroupLeaf *cgroup, pid_t *cmd_pid)
+{
+    const Limits *limits = &(job_p->limits);
+    
+    // A leaf that can not be created leaves the limits to setrlimit()
+    if (cgroup->fd == -1 && schedr_limits_are_set(limits) && schedr_limits_have_cgroup())
+    {
+        schedr_limits_create_leaf(cgroup, job_p->name, limits);
+    }
+    
+    if (job_p->argc > 0)
+    {
+        char *argv[SCHEDR_JOB_MAX_ARGS + 1];
+        schedr_job_get_argv(job_p, argv);
+        
+        return schedr_spawn_limited(job_p->exec_path, argv, fds, limits, cgroup->fd, cmd_pid);
+    }
+    
     char *shell = getenv("SHELL");
     char *argv[] = { shell, "-c", job_p->command, NULL };
-
-    #ifdef TEST
-    __gcov_flush();
-    #endif
     
-    exec(argv[0], argv, environ);   // GCOVR_EXCL_LINE
+    if (shell == NULL) { return SCHEDR_FAILURE; }
     
-    _exit(EXIT_FAILURE);    // GCOVR_EXCL_LINE
+    return schedr_spawn_limited(shell, argv, fds, limits, cgroup->fd, cmd_pid);
 }
 
-static int start_job_cmd(Job *job_p)
+static int start_job_cmd(Job *job_p, CgroupLeaf *cgroup)
 {
     pid_t cmd_pid;
+    Status status = launch_job_cmd(job_p, NULL, cgroup, &cmd_pid);
     
-    if ((cmd_pid = forker()) < 0) 
+    if (status == SCHEDR_FAILURE) { return EXIT_FAILURE; }
+    
+    if (status != SCHEDR_SUCCESS) 
     {
         /*
          * For some reason the following line is not reported as executed by GCOV
@@ -90,34 +405,46 @@ static int start_job_cmd(Job *job_p)
          
         return SCHEDR_ERROR_FORK_FAILED;    // GCOVR_EXCL_LINE
     }
-    else if (cmd_pid == 0)
-    {
-        cmd_proc(job_p);    // will not return
-        
-        return SCHEDR_FAILURE;  // GCOVR_EXCL_LINE  (return statement added to silence compiler)
-    }
-    else 
-    {
-        int cmd_status;
-        waitpid(cmd_pid, &cmd_status, 0);
-        return WEXITSTATUS(cmd_status);
-    }
+    
+    int cmd_status;
+    waitpid(cmd_pid, &cmd_status, 0);
+    return WEXITSTATUS(cmd_status);
 }
 
+/*
+ * Runs the command of a job on its interval, until the retry policy of the job
+ * gives up on it. A failed run is retried after its backoff, without moving 
+ * the deadline the next run on the schedule is timed from.
+ */
 static void child_proc(Job *job_p)
 {
-    int cmd_status = EXIT_SUCCESS;
+    int64_t run_at_ns = schedr_time_monotonic_ns() + job_p->splay_offset_ns;
+    int64_t delay_ns;
+    RetryAction action = RetryOnSchedule;
+    CgroupLeaf cgroup = { .fd = -1 };
+    
+    restore_signal_mask();
+    
+    if (schedr_calendar_is_set(&(job_p->calendar))) { sleep_until_calendar(job_p); }
+    else if (job_p->splay_offset_ns > 0) { sleep_until(run_at_ns); }
     
-    while (cmd_status == EXIT_SUCCESS)
+    while (action != RetryGiveUp)
     {
-        cmd_status = start_job_cmd(job_p);
+        int cmd_status = start_job_cmd(job_p, &cgroup);
         
-        if (cmd_status == EXIT_SUCCESS) 
+        action = schedr_retry_record(&(job_p->retry), &(job_p->retry_state), cmd_status != EXIT_SUCCESS, &delay_ns);
+        
+        if (action == RetryOnSchedule && schedr_calendar_is_set(&(job_p->calendar))) { sleep_until_calendar(job_p); }
+        else if (action == RetryOnSchedule) 
         {
-            sleeper(job_p->interval_seconds);
+            run_at_ns = next_run_ns(job_p, run_at_ns, schedr_time_monotonic_ns());
+            sleep_until(run_at_ns);
         }
+        else if (action != RetryGiveUp) { sleep_until(schedr_time_monotonic_ns() + delay_ns); }
     }
     
+    schedr_limits_remove_leaf(&cgroup);
+    
     #ifdef TEST
     __gcov_flush();
     #endif
@@ -132,17 +459,136 @@ static Status parent_proc(Job *job_p)
     return SCHEDR_SUCCESS;
 }
 
+Status schedr_scheduler_set_mode(SchedulerMode new_mode)
+{
+    if (new_mode < 0 || new_mode >= SCHEDR_SCHEDULER_MODE_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (started_jobs_count > 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    mode = new_mode;
+    
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Sets up the ring of LoopUring and hands it to schedr_output, which reads
+ * the output pipes through it.
+ */
+static Status start_uring()
+{
+    Status status = schedr_uring_init(&uring, URING_ENTRIES);
+    
+    if (status != SCHEDR_SUCCESS) { return status; }
+    
+    status = schedr_output_start_ring(&uring);
+    
+    if (status != SCHEDR_SUCCESS) { schedr_uring_destroy(&uring); }
+    
+    return status;
+}
+
+static void stop_uring()
+{
+    schedr_output_stop_ring();
+    schedr_uring_destroy(&uring);
+}
+
+Status schedr_scheduler_set_loop_backend(LoopBackend backend)
+{
+    if (backend < 0 || backend >= SCHEDR_SCHEDULER_LOOP_BACKEND_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (started_jobs_count > 0 || schedr_output_has_pipes()) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (backend == loop_backend) { return SCHEDR_SUCCESS; }
+    
+    if (backend == LoopUring)
+    {
+        Status status = start_uring();
+        
+        if (status != SCHEDR_SUCCESS) { return status; }
+        
+        signals_read_queued = epoll_poll_queued = spawn_poll_queued = false;
+        queued_deadline = -1;
+        children_exited = true;
+    }
+    else { stop_uring(); }
+    
+    loop_backend = backend;
+    
+    // The descriptors of the loop are set up already, they are moved to or from the ring
+    if (epoll_fd != -1)
+    {
+        int signal_flags = (backend == LoopUring) ? 0 : O_NONBLOCK;
+        
+        fcntl(signal_fd, F_SETFL, signal_flags);
+        
+        if (backend == LoopUring)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, signal_fd, NULL);
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, timer_fd, NULL);
+        }
+        else
+        {
+            watch_fd(signal_fd);
+            watch_fd(timer_fd);
+        }
+        
+        if (spawn_fd != -1 && backend == LoopUring) { epoll_ctl(epoll_fd, EPOLL_CTL_DEL, spawn_fd, NULL); }
+        
+        spawn_fd = -1;
+    }
+    
+    return SCHEDR_SUCCESS;
+}
+
 Status schedr_scheduler_start_job(Job *const job_p)
 {
     pid_t job_pid;
+    
+    if (find_started_job(job_p) != NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (job_p->monitor[0] != '\0' && mode != EventLoop) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    if (mode == EventLoop)
+    {
+        JobProcMap *entry;
+        Status status = add_started_job(job_p, 0, &entry);
+        
+        if (status != SCHEDR_SUCCESS) { return status; }
+        
+        // A deadline in the past makes the job due on the next iteration of the loop, unless it runs on a calendar
+        init_timers();
+        entry->run_at_ns = entry->next_run_ns = schedr_time_monotonic_ns() + job_p->splay_offset_ns;
+        
+        if (schedr_calendar_is_set(&(job_p->calendar))) { entry->run_at_ns = entry->next_run_ns = calendar_run_ns(job_p, &(entry->calendar_at_ns)); }
+        
+        if (is_timed(job_p))
+        {
+            bool delayed = job_p->splay_offset_ns > 0 || schedr_calendar_is_set(&(job_p->calendar));
+            
+            schedr_timer_add(&timers, &(entry->next_run), delayed ? entry->run_at_ns : 0);
+        }
+        
+        status = parent_proc(job_p);
+        
+        if (status == SCHEDR_SUCCESS && job_p->monitor[0] != '\0' && (status = schedr_monitor_start(job_p)) != SCHEDR_SUCCESS)
+        {
+            job_p->state = Stopped;
+            remove_started_job(entry);
+        }
+        
+        return status;
+    }
 
     if ((job_pid = forker()) < 0)  { return SCHEDR_ERROR_FORK_FAILED; }
     else if (job_pid == 0) { child_proc(job_p); }
     else 
     {
-        started_jobs[started_jobs_count].job = job_p;
-        started_jobs[started_jobs_count].pid = job_pid;
-        started_jobs_count++;
+        Status status = add_started_job(job_p, job_pid, NULL);
+        
+        if (status != SCHEDR_SUCCESS)
+        {
+            kill(job_pid, SIGTERM);
+            waitpid(job_pid, NULL, 0);
+            
+            return status;
+        }
         
         return parent_proc(job_p);
     }
@@ -150,49 +596,969 @@ Status schedr_scheduler_start_job(Job *const job_p)
     return SCHEDR_FAILURE; // GCOVR_EXCL_LINE (will never be executed)
 }
 
-static int find_job_index(const Job *const job_p)
+static Status add_started_job(Job *const job_p, pid_t pid, JobProcMap **entry_p)
 {
-    for (int i = started_jobs_count - 1; i >= 0; i--)
+    if (started_jobs_count == started_jobs_capacity)
     {
-        if (started_jobs[i].job == job_p)
-        {
-            return i;
-        }
+        int new_capacity = (started_jobs_capacity == 0) ? 
+                           STARTED_JOBS_INITIAL_CAPACITY : 
+                           started_jobs_capacity * 2;
+        JobProcMap **resized = (JobProcMap **)realloc(started_jobs, sizeof (JobProcMap *) * new_capacity);
+        
+        if (resized == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+        
+        started_jobs = resized;
+        started_jobs_capacity = new_capacity;
     }
     
-    return -1;
+    int runs_len = (mode == EventLoop) ? max_runs(job_p) : 0;
+    JobProcMap *entry = (JobProcMap *)malloc(sizeof (JobProcMap) + sizeof (JobRun) * runs_len);
+    
+    if (entry == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+    
+    entry->job = job_p;
+    entry->pid = pid;
+    entry->run_at_ns = 0;
+    entry->next_run_ns = 0;
+    entry->calendar_at_ns = 0;
+    entry->index = started_jobs_count;
+    entry->active_runs = 0;
+    entry->run_held = false;
+    entry->held_due_ns = 0;
+    entry->runs_len = runs_len;
+    schedr_timer_init(&(entry->next_run), entry);
+    
+    for (int i = 0; i < runs_len; i++)
+    {
+        entry->runs[i].entry = entry;
+        entry->runs[i].pid = 0;
+        entry->runs[i].due_ns = 0;
+        entry->runs[i].started_ns = 0;
+        entry->runs[i].output_fds[0] = entry->runs[i].output_fds[1] = -1;
+        entry->runs[i].cgroup.fd = -1;
+        schedr_run_queue_node_init(&(entry->runs[i].queued_run), &(entry->runs[i]));
+    }
+    
+    if (schedr_hash_put(&jobs_by_address, (uintptr_t)job_p, entry) != SCHEDR_SUCCESS)
+    {
+        free(entry);
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
+    }
+    
+    started_jobs[started_jobs_count] = entry;
+    started_jobs_count++;
+    
+    if (entry_p != NULL) { *entry_p = entry; }
+    
+    return SCHEDR_SUCCESS;
 }
 
-Status schedr_scheduler_stop_job(Job *const job_p)
+static Status set_run_pid(JobRun *const run, pid_t pid)
 {
-    job_p->state = Stopped;
+    if (run->pid != 0) { schedr_hash_remove(&runs_by_pid, (uint64_t)run->pid); }
     
-    int index = find_job_index(job_p);
+    run->pid = pid;
     
-    if (index != -1) 
-    { 
-        pid_t pid = started_jobs[index].pid;
-      
-        kill(started_jobs[index].pid, SIGTERM);
-        waitpid(pid, NULL, 0);
-        
-        started_jobs[index].job = NULL;
-        started_jobs[index].pid = 0;
+    if (pid == 0) { return SCHEDR_SUCCESS; }
+    
+    Status status = schedr_hash_put(&runs_by_pid, (uint64_t)pid, run);
+    
+    if (status != SCHEDR_SUCCESS) { run->pid = 0; }
+    
+    return status;
+}
+
+/*
+ * Frees the entry, moving the last entry of 'started_jobs' into its place so
+ * no other entry has to move.
+ */
+static void remove_started_job(JobProcMap *const entry)
+{
+    schedr_monitor_stop(entry->job);
+    
+    if (timers_initialized) { schedr_timer_cancel(&timers, &(entry->next_run)); }
+    
+    for (int i = 0; i < entry->runs_len; i++)
+    {
+        schedr_run_queue_remove(&run_queue, &(entry->runs[i].queued_run));
+        set_run_pid(&(entry->runs[i]), 0);
+        schedr_limits_remove_leaf(&(entry->runs[i].cgroup));
+    }
+    
+    schedr_hash_remove(&jobs_by_address, (uintptr_t)entry->job);
+    
+    JobProcMap *last = started_jobs[started_jobs_count - 1];
+    
+    started_jobs[entry->index] = last;
+    last->index = entry->index;
+    started_jobs_count--;
+    
+    free(entry);
+}
+
+static JobRun *find_run_by_pid(pid_t pid)
+{
+    return (JobRun *)schedr_hash_get(&runs_by_pid, (uint64_t)pid);
+}
+
+static void block_loop_signals()
+{
+    if (loop_signals_blocked) { return; }
+    
+    sigemptyset(&loop_signals);
+    sigaddset(&loop_signals, SIGCHLD);
+    sigaddset(&loop_signals, SIGTERM);
+    sigaddset(&loop_signals, SIGINT);
+    sigaddset(&loop_signals, SIGHUP);
+    sigprocmask(SIG_BLOCK, &loop_signals, &original_signal_mask);
+    
+    loop_signals_blocked = true;
+}
+
+static Status watch_fd(int fd)
+{
+    struct epoll_event event = { .events = EPOLLIN, .data.fd = fd };
+    
+    return (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0) ? SCHEDR_SUCCESS : SCHEDR_FAILURE;
+}
+
+/*
+ * Sets up the file descriptors the event loop waits on. The loop signals have
+ * to be blocked, so they are only delivered through 'signal_fd'.
+ */
+static Status init_event_fds()
+{
+    if (epoll_fd != -1) { return SCHEDR_SUCCESS; }
+    
+    int new_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    // The ring waits for a blocking read of the signals, epoll for one that does not block
+    int new_signal_fd = signalfd(-1, &loop_signals, ((loop_backend == LoopEpoll) ? SFD_NONBLOCK : 0) | SFD_CLOEXEC);
+    int new_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    
+    epoll_fd = new_epoll_fd;
+    signal_fd = new_signal_fd;
+    timer_fd = new_timer_fd;
+    
+    // With LoopUring the signals are read and the deadlines timed through the ring instead
+    if (epoll_fd == -1 || signal_fd == -1 || timer_fd == -1 
+        || (loop_backend == LoopEpoll && (watch_fd(signal_fd) != SCHEDR_SUCCESS || watch_fd(timer_fd) != SCHEDR_SUCCESS)))
+    {
+        if (epoll_fd != -1) { close(epoll_fd); }
+        if (signal_fd != -1) { close(signal_fd); }
+        if (timer_fd != -1) { close(timer_fd); }
         
-        if (index != started_jobs_count - 1)
-        {
-            for (int i = index; i < started_jobs_count - 1; i++)
-            {
-                started_jobs[i] = started_jobs[i + 1];
-            }
-        }
+        epoll_fd = signal_fd = timer_fd = -1;
         
-        started_jobs_count--;
+        return SCHEDR_FAILURE;
+    }
+    
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Stores the handler of 'fd', and adds it to the epoll set.
+ */
+static Status add_watch(int fd, uint32_t events, void (*handler)(int fd, void *data), void *data)
+{
+    block_loop_signals();
+    
+    if (init_event_fds() != SCHEDR_SUCCESS) { return SCHEDR_FAILURE; }
+    
+    FdWatch *old_watch = (FdWatch *)schedr_hash_get(&watches_by_fd, (uint64_t)fd);
+    FdWatch *watch = (FdWatch *)malloc(sizeof (FdWatch));
+    
+    if (watch == NULL) { return SCHEDR_ERROR_ALLOCATION_FAILED; }
+    
+    watch->handler = handler;
+    watch->data = data;
+    
+    struct epoll_event event = { .events = events, .data.fd = fd };
+    
+    if (epoll_ctl(epoll_fd, (old_watch != NULL) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        free(watch);
+        return SCHEDR_FAILURE;
+    }
+    
+    if (schedr_hash_put(&watches_by_fd, (uint64_t)fd, watch) != SCHEDR_SUCCESS)
+    {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        free(watch);
+        return SCHEDR_ERROR_ALLOCATION_FAILED;
     }
     
+    free(old_watch);
+    
     return SCHEDR_SUCCESS;
 }
 
+static void remove_watch(int fd)
+{
+    FdWatch *watch = (FdWatch *)schedr_hash_get(&watches_by_fd, (uint64_t)fd);
+    
+    if (watch == NULL) { return; }
+    
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    schedr_hash_remove(&watches_by_fd, (uint64_t)fd);
+    free(watch);
+}
+
+Status schedr_scheduler_watch_fd(int fd, bool for_writing, void (*handler)(int fd, void *data), void *data)
+{
+    if (handler == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (fd < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    return add_watch(fd, for_writing ? EPOLLOUT : EPOLLIN, handler, data);
+}
+
+void schedr_scheduler_unwatch_fd(int fd) { remove_watch(fd); }
+
+/*
+ * Makes the loop wake up when the zygote reports a finished command. The
+ * zygote may have been started or lost since the last iteration.
+ */
+static void watch_spawn_fd()
+{
+    int fd = schedr_spawn_event_fd();
+    
+    if (fd == spawn_fd) { return; }
+    
+    // The ring of LoopUring polls it instead
+    if (loop_backend == LoopUring)
+    {
+        spawn_fd = fd;
+        spawn_poll_queued = false;
+        return;
+    }
+    
+    // The socket of a lost zygote is already closed, which removes it from the epoll set
+    if (spawn_fd != -1) { epoll_ctl(epoll_fd, EPOLL_CTL_DEL, spawn_fd, NULL); }
+    
+    spawn_fd = (fd != -1 && watch_fd(fd) == SCHEDR_SUCCESS) ? fd : -1;
+}
+
+/*
+ * Handles a loop signal other than SIGCHLD. SIGHUP terminates the loop like
+ * SIGTERM unless there is a reload handler.
+ */
+static void handle_loop_signal(uint32_t signo, bool *terminate)
+{
+    if (signo == SIGHUP && reload_handler != NULL) { reload_requested = true; }
+    else if (terminate != NULL && (signo == SIGTERM || signo == SIGINT || signo == SIGHUP)) { *terminate = true; }
+}
+
+/*
+ * Reads every pending loop signal. SIGCHLD needs no handling of its own, since
+ * finished commands are always reaped before the loop waits.
+ */
+static void read_loop_signals(bool *terminate)
+{
+    struct signalfd_siginfo info;
+    
+    while (read(signal_fd, &info, sizeof (info)) == sizeof (info))
+    {
+        if (info.ssi_signo != SIGCHLD) { handle_loop_signal(info.ssi_signo, terminate); }
+    }
+}
+
+static int64_t timeval_to_ns(struct timeval time)
+{
+    return (int64_t)time.tv_sec * NANOSECS_PER_SEC + (int64_t)time.tv_usec * 1000;
+}
+
+/*
+ * Collects every command that has finished since the last call, without 
+ * blocking, and records how it went in its job. A job whose command exited
+ * successfully is due again according to its timing and overlap policy, a job
+ * whose command failed is retried or stopped according to its retry policy,
+ * just like its supervisor would.
+ */
+static void reap_finished_cmds()
+{
+    pid_t pid;
+    int cmd_status;
+    struct rusage usage;
+    
+    while (schedr_spawn_reap(&pid, &cmd_status, &usage) == SCHEDR_SUCCESS && pid > 0)
+    {
+        void *stopping_slots = schedr_hash_get(&stopping_cmds, (uint64_t)pid);
+        
+        if (stopping_slots != NULL)
+        {
+            schedr_run_queue_release(&run_queue, (int)(uintptr_t)stopping_slots);
+            schedr_hash_remove(&stopping_cmds, (uint64_t)pid);
+            cmds_in_flight--;
+            continue;
+        }
+        
+        JobRun *run = find_run_by_pid(pid);
+        
+        if (run == NULL) { continue; }
+        
+        JobProcMap *entry = run->entry;
+        
+        drain_finished_output(run);
+        set_run_pid(run, 0);
+        schedr_run_queue_release(&run_queue, run->queued_run.weight);
+        entry->active_runs--;
+        cmds_in_flight--;
+        
+        entry->job->last_exit_status = WIFEXITED(cmd_status) ? WEXITSTATUS(cmd_status) : 128 + WTERMSIG(cmd_status);
+        entry->job->last_duration_ns = schedr_time_monotonic_ns() - run->started_ns;
+        entry->job->last_cpu_ns = timeval_to_ns(usage.ru_utime) + timeval_to_ns(usage.ru_stime);
+        schedr_histogram_record_runtime(entry->job, entry->job->last_duration_ns);
+        
+        bool failed = !WIFEXITED(cmd_status) || WEXITSTATUS(cmd_status) != EXIT_SUCCESS;
+        int64_t delay_ns;
+        RetryAction action = schedr_retry_record(&(entry->job->retry), &(entry->job->retry_state), failed, &delay_ns);
+        
+        if (action == RetryGiveUp)
+        {
+            entry->job->state = Stopped;
+            stop_started_job(entry);
+        }
+        else if (entry->job->state == Paused)
+        {
+            // The job is timed again when it is resumed
+            entry->run_held = false;
+        }
+        else if (action != RetryOnSchedule)
+        {
+            // The retry takes the place of the next run on the schedule, which is timed from the same deadline as before
+            entry->next_run_ns = schedr_time_monotonic_ns() + delay_ns;
+            schedr_timer_cancel(&timers, &(entry->next_run));
+            schedr_timer_add(&timers, &(entry->next_run), entry->next_run_ns);
+        }
+        else if (!is_timed_when_due(entry->job) && is_timed(entry->job))
+        {
+            // A run started ahead of its schedule moves the schedule along with it
+            entry->run_at_ns = entry->next_run_ns = time_next_run(entry, schedr_time_monotonic_ns());
+            schedr_timer_cancel(&timers, &(entry->next_run));
+            schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns);
+        }
+        else if (entry->run_held)
+        {
+            // The run that was due while this one was running gets to go now
+            entry->run_held = false;
+            run->due_ns = entry->held_due_ns;
+            queue_run(run, schedr_time_monotonic_ns());
+        }
+    }
+}
+
+/*
+ * Reads what a command that has just been reaped left in its pipes, see
+ * schedr_output_drain_pipe().
+ */
+static void drain_finished_output(JobRun *const run)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        // The pipe may have been closed already, and its descriptor reused for the pipe of another command
+        if (run->output_fds[i] != -1) { schedr_output_drain_pipe(run->output_fds[i]); }
+        
+        run->output_fds[i] = -1;
+    }
+}
+
+/*
+ * Gives the timeout the loop may wait for, in ms. A run that is first in the
+ * queue and has a slot free can be started right away. If 'terminate' is
+ * NULL, the loop does not wait when there is nothing to wait for.
+ */
+static int loop_timeout(int64_t next_deadline, bool *terminate)
+{
+    if (!schedr_output_is_paused() && schedr_run_queue_can_pop(&run_queue)) { return 0; }
+    if (next_deadline == -1 && cmds_in_flight == 0 && terminate == NULL) { return 0; }
+    
+    return -1;
+}
+
+/*
+ * Calls the handlers of the descriptors epoll has reported ready.
+ */
+static void handle_epoll_events(const struct epoll_event *events, int ready, bool *terminate)
+{
+    for (int i = 0; i < ready; i++)
+    {
+        int fd = events[i].data.fd;
+        uint64_t expirations;
+        
+        if (fd == signal_fd) { read_loop_signals(terminate); }
+        else if (fd == timer_fd) { read(timer_fd, &expirations, sizeof (expirations)); }
+        else if (fd != spawn_fd)
+        {
+            // A handler may have stopped watching the descriptors of events later in the list
+            FdWatch *watch = (FdWatch *)schedr_hash_get(&watches_by_fd, (uint64_t)fd);
+            
+            if (watch != NULL) { watch->handler(fd, watch->data); }
+        }
+    }
+}
+
+/*
+ * Waits until either the next job is due, a command finishes, a watched file
+ * descriptor is ready or a termination signal arrives, and handles what has
+ * happened. 'terminate' is set to true when a termination signal is received.
+ * If it is NULL, does not wait when there is nothing to wait for.
+ */
+static void wait_for_events(bool *terminate)
+{
+    int64_t next_deadline = schedr_timer_next_deadline(&timers);
+    int timeout = loop_timeout(next_deadline, terminate);
+    
+    // An all zero deadline disarms the timer, so the earliest one armed is 1 ns
+    struct itimerspec deadline = { .it_interval = { 0, 0 }, .it_value = { 0, 0 } };
+    
+    if (next_deadline != -1)
+    {
+        if (next_deadline < 1) { next_deadline = 1; }
+        
+        deadline.it_value.tv_sec = next_deadline / NANOSECS_PER_SEC;
+        deadline.it_value.tv_nsec = next_deadline % NANOSECS_PER_SEC;
+    }
+    
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &deadline, NULL);
+    
+    struct epoll_event events[MAX_EVENTS];
+    int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+    
+    handle_epoll_events(events, ready, terminate);
+}
+
+/*
+ * Moves the timeout in flight on the ring to 'next_deadline', unless it is
+ * there already. A timeout that can not be queued is retried on the next
+ * iteration.
+ */
+static void queue_deadline(int64_t next_deadline)
+{
+    if (next_deadline == queued_deadline) { return; }
+    
+    if (queued_deadline != -1) { schedr_uring_remove_timeout(&uring, TagTimeout); }
+    
+    queued_deadline = -1;
+    
+    if (next_deadline == -1) { return; }
+    
+    queued_deadline_ts.tv_sec = next_deadline / NANOSECS_PER_SEC;
+    queued_deadline_ts.tv_nsec = next_deadline % NANOSECS_PER_SEC;
+    
+    if (schedr_uring_queue_timeout(&uring, &queued_deadline_ts, TagTimeout)) { queued_deadline = next_deadline; }
+}
+
+/*
+ * Handles the completion of a request the loop keeps in flight on the ring.
+ */
+static void loop_request_completed(uint64_t tag, int res, bool *terminate)
+{
+    struct epoll_event events[MAX_EVENTS];
+    
+    switch (tag)
+    {
+        case TagSignals:
+            signals_read_queued = false;
+            
+            for (int i = 0; res > 0 && i < res / (int)sizeof (struct signalfd_siginfo); i++)
+            {
+                uint32_t signo = signal_infos[i].ssi_signo;
+                
+                if (signo == SIGCHLD) { children_exited = true; }
+                else { handle_loop_signal(signo, terminate); }
+            }
+            
+            break;
+            
+        case TagEpoll:
+            epoll_poll_queued = false;
+            handle_epoll_events(events, epoll_wait(epoll_fd, events, MAX_EVENTS, 0), terminate);
+            break;
+            
+        case TagSpawn:
+            spawn_poll_queued = false;
+            children_exited = true;
+            break;
+            
+        case TagTimeout:
+            // A timeout that fired just as it was moved must not make the loop forget the one that replaced it
+            if (res == -ETIME && queued_deadline <= schedr_time_monotonic_ns()) { queued_deadline = -1; }
+            break;
+    }
+}
+
+/*
+ * Does what wait_for_events() does, through the ring of LoopUring. The
+ * requests that have to be in flight again are queued, submitted and waited
+ * for in one system call, and whatever has completed is handled without any.
+ * Finished commands are only reaped once SIGCHLD or a report of the zygote
+ * has been read.
+ */
+static void wait_for_completions(bool *terminate)
+{
+    int64_t next_deadline = schedr_timer_next_deadline(&timers);
+    
+    if (next_deadline != -1 && next_deadline < 1) { next_deadline = 1; }
+    
+    if (!signals_read_queued)
+    {
+        signals_read_queued = schedr_uring_queue_read(&uring, signal_fd, signal_infos, sizeof (signal_infos), 0, TagSignals);
+    }
+    
+    if (!epoll_poll_queued)
+    {
+        schedr_uring_queue_poll(&uring, epoll_fd, TagEpoll);
+        epoll_poll_queued = true;
+    }
+    
+    if (!spawn_poll_queued && spawn_fd != -1)
+    {
+        schedr_uring_queue_poll(&uring, spawn_fd, TagSpawn);
+        spawn_poll_queued = true;
+    }
+    
+    queue_deadline(next_deadline);
+    
+    if (schedr_uring_submit(&uring, loop_timeout(next_deadline, terminate) != 0) != SCHEDR_SUCCESS) { return; }
+    
+    struct io_uring_cqe *cqe;
+    
+    while ((cqe = schedr_uring_peek(&uring)) != NULL)
+    {
+        // The handlers queue requests, which may submit the queue and fill it with more completions
+        struct io_uring_cqe completion = *cqe;
+        
+        schedr_uring_seen(&uring);
+        
+        if (completion.user_data >= SCHEDR_URING_TAGS)
+        {
+            schedr_output_read_completed(completion.user_data, completion.res, completion.flags);
+        }
+        else { loop_request_completed(completion.user_data, completion.res, terminate); }
+    }
+}
+
+/*
+ * Waits for something to happen, then collects the commands that have finished
+ * and queues every job that is due, unless a termination signal was received.
+ * The queued runs are started for as long as there are free slots.
+ *
+ * 'terminate' is set to true when a termination signal is received. If it is
+ * NULL, the iteration does not wait when there is nothing to wait for.
+ */
+static Status run_loop_iteration(bool *terminate)
+{
+    block_loop_signals();
+    
+    if (init_event_fds() != SCHEDR_SUCCESS) { return SCHEDR_FAILURE; }
+    
+    watch_spawn_fd();
+    init_timers();
+    
+    if (loop_backend == LoopUring) { wait_for_completions(terminate); }
+    else { wait_for_events(terminate); }
+    
+    if (loop_backend == LoopEpoll || children_exited)
+    {
+        children_exited = false;
+        reap_finished_cmds();
+    }
+    
+    if (terminate != NULL && *terminate) { return SCHEDR_SUCCESS; }
+    
+    // Jobs are only changed between the handling of events, so no handler sees a job go away under it
+    if (reload_requested)
+    {
+        reload_requested = false;
+        reload_handler();
+    }
+    
+    int64_t now_ns = schedr_time_monotonic_ns();
+    Timer *due = NULL;
+    schedr_timer_advance(&timers, now_ns, &due);
+    
+    while (due != NULL)
+    {
+        // The timer of the job may be added again, so its link has to be followed first
+        Timer *next_due = due->next;
+        
+        job_due((JobProcMap *)due->data, now_ns);
+        due = next_due;
+    }
+    
+    return launch_queued_runs(now_ns);
+}
+
+/*
+ * Puts an idle run of a job last in the run queue.
+ */
+static void queue_run(JobRun *const run, int64_t now_ns)
+{
+    int weight = (run->entry->job->weight > 0) ? run->entry->job->weight : 1;
+    
+    schedr_run_queue_push(&run_queue, &(run->queued_run), weight, now_ns);
+    run->entry->active_runs++;
+}
+
+/*
+ * Queues a run of a job that has become due, unless the overlap policy of the
+ * job says it has to be held or skipped. Jobs that are timed when they are due
+ * get their next deadline right away, so they keep their cadence however long
+ * the runs take.
+ */
+static void job_due(JobProcMap *const entry, int64_t now_ns)
+{
+    Job *job_p = entry->job;
+    int64_t due_ns = entry->next_run_ns;
+    bool on_schedule = entry->next_run_ns == entry->run_at_ns;
+    
+    // The system clock may have been set back or drifted from the monotonic clock since a calendar run was timed
+    if (schedr_calendar_is_set(&(job_p->calendar)) && on_schedule && schedr_time_realtime_ns() < entry->calendar_at_ns)
+    {
+        entry->run_at_ns = entry->next_run_ns = time_next_run(entry, now_ns);
+        schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns);
+        
+        return;
+    }
+    
+    if (is_timed_when_due(job_p))
+    {
+        entry->run_at_ns = entry->next_run_ns = time_next_run(entry, now_ns);
+        schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns);
+    }
+    
+    run_due(entry, due_ns, now_ns);
+}
+
+/*
+ * Queues a run of a job that was due at 'due_ns' on an idle run, or holds or
+ * drops it according to the overlap policy of the job if every run is busy.
+ * Returns false if the run was dropped.
+ */
+static bool run_due(JobProcMap *const entry, int64_t due_ns, int64_t now_ns)
+{
+    Job *job_p = entry->job;
+    JobRun *idle_run = NULL;
+    
+    for (int i = 0; i < entry->runs_len && idle_run == NULL; i++)
+    {
+        if (entry->runs[i].pid == 0 && !entry->runs[i].queued_run.queued) { idle_run = &(entry->runs[i]); }
+    }
+    
+    if (idle_run != NULL)
+    {
+        idle_run->due_ns = due_ns;
+        queue_run(idle_run, now_ns);
+    }
+    else if (job_p->overlap == OverlapQueue && !entry->run_held)
+    {
+        entry->run_held = true;
+        entry->held_due_ns = due_ns;
+        job_p->queued_runs++;
+    }
+    else
+    {
+        job_p->skipped_runs++;
+        return false;
+    }
+    
+    return true;
+}
+
+/*
+ * Starts the commands of the runs first in the queue, until the queue is empty
+ * or the first run has to wait for a slot. Nothing is started while the log
+ * is full.
+ */
+static Status launch_queued_runs(int64_t now_ns)
+{
+    RunQueueNode *node;
+    
+    if (schedr_output_is_paused()) { return SCHEDR_SUCCESS; }
+    
+    while ((node = schedr_run_queue_pop(&run_queue, now_ns)) != NULL)
+    {
+        JobRun *run = (JobRun *)node->data;
+        JobProcMap *entry = run->entry;
+        pid_t cmd_pid;
+        int fds[3], read_fds[2];
+        bool captured = schedr_output_open_pipes(fds, read_fds);
+        int64_t launch_ns = schedr_time_monotonic_ns();
+        Status status = launch_job_cmd(entry->job, captured ? fds : NULL, &(run->cgroup), &cmd_pid);
+        int64_t launched_ns = schedr_time_monotonic_ns();
+        
+        for (int i = 0; i < 2; i++)
+        {
+            run->output_fds[i] = -1;
+            
+            if (!captured) { continue; }
+            
+            close(fds[i + 1]);
+            
+            if (status != SCHEDR_SUCCESS) { close(read_fds[i]); }
+            else if (schedr_output_watch_pipe(entry->job, (OutputStream)i, read_fds[i])) { run->output_fds[i] = read_fds[i]; }
+        }
+        
+        if (status == SCHEDR_FAILURE)
+        {
+            // The command can not be executed, stop the job as if it had failed
+            schedr_run_queue_release(&run_queue, node->weight);
+            entry->job->state = Stopped;
+            stop_started_job(entry);
+            continue;
+        }
+        
+        if (status == SCHEDR_SUCCESS && set_run_pid(run, cmd_pid) != SCHEDR_SUCCESS)
+        {
+            // A command that can not be looked up when it exits must not keep running
+            kill(cmd_pid, SIGKILL);
+            waitpid(cmd_pid, NULL, 0);
+            status = SCHEDR_ERROR_ALLOCATION_FAILED;
+        }
+        
+        if (status != SCHEDR_SUCCESS)
+        {
+            // Keep the run first in the queue, so it is retried
+            schedr_run_queue_requeue(&run_queue, node);
+            
+            return status;
+        }
+        
+        run->started_ns = launched_ns;
+        schedr_histogram_record_start(entry->job, launch_ns - run->due_ns, launched_ns - launch_ns);
+        cmds_in_flight++;
+    }
+    
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_scheduler_run()
+{
+    if (mode != EventLoop) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    bool terminate = false;
+    Status status = SCHEDR_SUCCESS;
+    
+    while (!terminate && status == SCHEDR_SUCCESS)
+    {
+        status = run_loop_iteration(&terminate);
+    }
+    
+    return status;
+}
+
+static JobProcMap *find_started_job(const Job *const job_p)
+{
+    return (JobProcMap *)schedr_hash_get(&jobs_by_address, (uintptr_t)job_p);
+}
+
+Status schedr_scheduler_stop_job(Job *const job_p)
+{
+    job_p->state = Stopped;
+    
+    JobProcMap *entry = find_started_job(job_p);
+    
+    if (entry != NULL) { stop_started_job(entry); }
+    
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Gives the entry of a job started in EventLoop mode, or NULL if it is not.
+ */
+static JobProcMap *find_loop_job(const Job *const job_p)
+{
+    JobProcMap *entry = (job_p != NULL) ? find_started_job(job_p) : NULL;
+    
+    return (entry != NULL && entry->pid == 0 && mode == EventLoop) ? entry : NULL;
+}
+
+Status schedr_scheduler_pause_job(Job *const job_p)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    
+    JobProcMap *entry = find_loop_job(job_p);
+    
+    if (entry == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    schedr_timer_cancel(&timers, &(entry->next_run));
+    entry->run_held = false;
+    job_p->state = Paused;
+    
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_scheduler_resume_job(Job *const job_p)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    
+    JobProcMap *entry = find_loop_job(job_p);
+    
+    if (entry == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (job_p->state != Paused) { return SCHEDR_SUCCESS; }
+    
+    job_p->state = Running;
+    
+    // A job that waits for its command is timed once the command has finished
+    if (is_timed(job_p) && (is_timed_when_due(job_p) || entry->active_runs == 0))
+    {
+        entry->run_at_ns = entry->next_run_ns = time_next_run(entry, schedr_time_monotonic_ns());
+        schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns);
+    }
+    
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_scheduler_run_job_now(Job *const job_p)
+{
+    if (job_p == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    
+    JobProcMap *entry = find_loop_job(job_p);
+    
+    if (entry == NULL) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    
+    int64_t now_ns = schedr_time_monotonic_ns();
+    
+    return run_due(entry, now_ns, now_ns) ? SCHEDR_SUCCESS : SCHEDR_FAILURE;
+}
+
+Status schedr_scheduler_update_job(Job *const job_p, const Job *const updated)
+{
+    if (job_p == NULL || updated == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    
+    JobProcMap *entry = find_loop_job(job_p);
+    
+    // The runs of a job and the cgroup leaves they start their commands in are set up for the job as it was started,
+    // and so is its monitor
+    if (entry == NULL || max_runs(updated) != entry->runs_len || !schedr_limits_equal(&(job_p->limits), &(updated->limits))
+        || strcmp(job_p->monitor, updated->monitor) != 0 || strcmp(job_p->pattern, updated->pattern) != 0)
+    {
+        return SCHEDR_ERROR_INVALID_ARGUMENT;
+    }
+    
+    // The offset of 'updated' is assigned by schedr_splay_reassign_offsets() on reload, one that is left
+    // from a longer splay is brought within the new one
+    int64_t splay_offset_ns = (updated->splay_ns > 0) ? updated->splay_offset_ns % updated->splay_ns : 0;
+    int64_t splay_moved_ns = splay_offset_ns - job_p->splay_offset_ns;
+    
+    // A job that leaves its calendar for an interval counts it from now, a first run that has not started yet is moved
+    // with the offset it was delayed by
+    int64_t last_run_ns = schedr_calendar_is_set(&(job_p->calendar)) ? schedr_time_monotonic_ns() : entry->run_at_ns - job_p->interval_ns;
+    bool retimed = job_p->interval_ns != updated->interval_ns || job_p->timing != updated->timing || splay_moved_ns != 0 ||
+                   !schedr_calendar_equal(&(job_p->calendar), &(updated->calendar));
+    
+    if (job_p->last_exit_status == -1 && entry->active_runs == 0 && !schedr_calendar_is_set(&(job_p->calendar)))
+    {
+        last_run_ns += splay_moved_ns;
+    }
+    
+    memcpy(job_p->command, updated->command, sizeof (job_p->command));
+    memcpy(job_p->exec_path, updated->exec_path, sizeof (job_p->exec_path));
+    memcpy(job_p->args, updated->args, sizeof (job_p->args));
+    job_p->argc = updated->argc;
+    job_p->interval_ns = updated->interval_ns;
+    job_p->timing = updated->timing;
+    job_p->weight = updated->weight;
+    job_p->overlap = updated->overlap;
+    job_p->max_parallel = updated->max_parallel;
+    job_p->splay_ns = updated->splay_ns;
+    job_p->splay_offset_ns = splay_offset_ns;
+    job_p->retry = updated->retry;
+    job_p->calendar = updated->calendar;
+    
+    // A run that is waited for is moved to the new interval, counted from the run before it, a retry keeps its backoff
+    if (retimed && entry->next_run.pending && entry->next_run_ns == entry->run_at_ns)
+    {
+        schedr_timer_cancel(&timers, &(entry->next_run));
+        entry->run_at_ns = entry->next_run_ns = last_run_ns + updated->interval_ns;
+        
+        if (schedr_calendar_is_set(&(job_p->calendar))) { entry->run_at_ns = entry->next_run_ns = calendar_run_ns(job_p, &(entry->calendar_at_ns)); }
+        
+        if (is_timed(job_p)) { schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns); }
+    }
+    else if (retimed && !entry->next_run.pending && entry->active_runs == 0 && job_p->state == Running && is_timed(job_p))
+    {
+        // A job that only ran on its trigger is timed from now on
+        entry->run_at_ns = entry->next_run_ns = schedr_time_monotonic_ns() + updated->interval_ns;
+        
+        if (schedr_calendar_is_set(&(job_p->calendar))) { entry->run_at_ns = entry->next_run_ns = calendar_run_ns(job_p, &(entry->calendar_at_ns)); }
+        schedr_timer_add(&timers, &(entry->next_run), entry->run_at_ns);
+    }
+    
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_scheduler_remove_job(Job *const job_p)
+{
+    if (job_p == NULL) { return; }
+    
+    schedr_scheduler_stop_job(job_p);
+    schedr_output_remove_job(job_p);
+    schedr_histogram_forget_latency(job_p);
+}
+
+/*
+ * Sends SIGTERM to the supervisor or the running commands of a job and forgets
+ * about the job. The event loop reaps the commands once they have exited, the
+ * job does not have to wait for them.
+ */
+static void stop_started_job(JobProcMap *const entry)
+{
+    if (entry->pid != 0)
+    {
+        kill(entry->pid, SIGTERM);
+        waitpid(entry->pid, NULL, 0);
+    }
+    
+    for (int i = 0; i < entry->runs_len; i++)
+    {
+        JobRun *run = &(entry->runs[i]);
+        
+        if (run->pid == 0) { continue; }
+        
+        kill(run->pid, SIGTERM);
+        
+        if (schedr_hash_put(&stopping_cmds, (uint64_t)run->pid, (void *)(uintptr_t)run->queued_run.weight) != SCHEDR_SUCCESS)
+        {
+            waitpid(run->pid, NULL, 0);
+            schedr_run_queue_release(&run_queue, run->queued_run.weight);
+            cmds_in_flight--;
+        }
+    }
+    
+    remove_started_job(entry);
+}
+
+void schedr_scheduler_set_reload_handler(void (*handler)())
+{
+    reload_handler = handler;
+    reload_requested = false;
+}
+
+Status schedr_scheduler_set_max_concurrent(int max_concurrent)
+{
+    return schedr_run_queue_set_max_slots(&run_queue, max_concurrent);
+}
+
+Status schedr_scheduler_set_output_len(size_t len) { return schedr_output_set_len(len); }
+
+const OutputRing *schedr_scheduler_get_output(const Job *const job_p) { return schedr_output_of(job_p); }
+
+const JobLatency *schedr_scheduler_get_latency(const Job *const job_p)
+{
+    return schedr_histogram_get_latency(job_p);
+}
+
+Status schedr_scheduler_get_run_queue_stats(RunQueueStats *const stats)
+{
+    if (stats == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    
+    *stats = run_queue.stats;
+    
+    return SCHEDR_SUCCESS;
+}
+
+int schedr_scheduler_get_cmds_in_flight() { return cmds_in_flight; }
+
 static void create_config_dir()
 {
     const char *dirs[] = {"/.config", "/schedr", "/bin", NULL};
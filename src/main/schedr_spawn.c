@@ -0,0 +1,186 @@
+#define _GNU_SOURCE             // POSIX_SPAWN_USEVFORK
+
+#include <sys/types.h>          // pid_t
+#include <stdlib.h>             // EXIT_FAILURE
+#include <unistd.h>             // fork(), execve(), _exit()
+#include <signal.h>             // sigset_t, sigprocmask()
+#include <spawn.h>              // posix_spawn()
+#include <errno.h>              // EAGAIN, ENOMEM
+#include <stdbool.h>            // bool
+#include <sys/wait.h>           // wait4()
+
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+
+extern char **environ;
+
+static int (*exec)(const char *fn, char *const argv[], char *const envp[]) = execve;
+static int (*forker)(void) = fork;
+static int (*spawner)(pid_t *pid, const char *path, const posix_spawn_file_actions_t *file_actions,
+                      const posix_spawnattr_t *attr, char *const argv[], char *const envp[]) = posix_spawn;
+
+static SpawnBackend backend = ForkExec;
+
+// The commands that are not redirected get the same stdin, stdout and stderr as the daemon
+static const int STDIO_FDS[] = { 0, 1, 2 };
+
+// Signals the daemon blocks or handles itself, which the commands should not inherit
+static const int DAEMON_SIGNALS[] = { SIGCHLD, SIGTERM, SIGINT, SIGHUP, SIGPIPE, 0 };
+
+#ifdef TEST
+void schedr_spawn_set_exec(int (*exec_func)(const char *fn, char *const argv[], char *const envp[])) { exec = exec_func; }
+void schedr_spawn_reset_exec() { exec = execve; }
+void schedr_spawn_set_forker(int (*fork_func)(void)) { forker = fork_func; }
+void schedr_spawn_reset_forker() { forker = fork; }
+void schedr_spawn_set_spawner(int (*spawn_func)(pid_t *pid, const char *path,
+                                                const posix_spawn_file_actions_t *file_actions,
+                                                const posix_spawnattr_t *attr,
+                                                char *const argv[], char *const envp[])) { spawner = spawn_func; }
+void schedr_spawn_reset_spawner() { spawner = posix_spawn; }
+
+void __gcov_flush();
+#endif
+
+Status schedr_spawn_set_backend(SpawnBackend new_backend)
+{
+    if (new_backend < 0 || new_backend >= SCHEDR_SPAWN_BACKEND_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    backend = new_backend;
+
+    return SCHEDR_SUCCESS;
+}
+
+static void reset_signals()
+{
+    sigset_t empty;
+    sigemptyset(&empty);
+
+    for (int i = 0; DAEMON_SIGNALS[i] != 0; i++) { signal(DAEMON_SIGNALS[i], SIG_DFL); }
+
+    sigprocmask(SIG_SETMASK, &empty, NULL);
+}
+
+/*
+ * Makes 'fds' the stdin, stdout and stderr of the process. The originals are
+ * closed on exec, since the daemon opens every descriptor with close-on-exec.
+ */
+static void redirect_stdio(const int fds[3])
+{
+    for (int i = 0; fds != NULL && i < 3; i++)
+    {
+        if (fds[i] != i) { dup2(fds[i], i); }
+    }
+}
+
+static Status fork_exec(const char *path, char *const argv[], const int fds[3], const Limits *limits, int cgroup_fd, pid_t *pid)
+{
+    pid_t child_pid = (cgroup_fd >= 0) ? schedr_limits_clone(cgroup_fd, false) : forker();
+
+    if (child_pid < 0) { return SCHEDR_ERROR_FORK_FAILED; }
+
+    if (child_pid == 0)
+    {
+        reset_signals();
+        redirect_stdio(fds);
+
+        if (limits != NULL) { schedr_limits_place(0, limits); }
+        if (cgroup_fd < 0 && limits != NULL) { schedr_limits_apply(limits); }
+
+        #ifdef TEST
+        __gcov_flush();
+        #endif
+
+        exec(path, argv, environ);  // GCOVR_EXCL_LINE
+
+        _exit(EXIT_FAILURE);        // GCOVR_EXCL_LINE
+    }
+
+    *pid = child_pid;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * glibc implements posix_spawn() with clone(CLONE_VM | CLONE_VFORK), so the
+ * child shares the memory of the daemon until it has called execve() and no
+ * page tables are copied.
+ */
+static Status posix_spawn_exec(const char *path, char *const argv[], const int fds[3], pid_t *pid)
+{
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attr;
+    sigset_t empty, defaults;
+
+    sigemptyset(&empty);
+    sigemptyset(&defaults);
+
+    for (int i = 0; DAEMON_SIGNALS[i] != 0; i++) { sigaddset(&defaults, DAEMON_SIGNALS[i]); }
+
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_USEVFORK);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawn_file_actions_init(&file_actions);
+
+    for (int i = 0; fds != NULL && i < 3; i++)
+    {
+        if (fds[i] != i) { posix_spawn_file_actions_adddup2(&file_actions, fds[i], i); }
+    }
+
+    int error = spawner(pid, path, &file_actions, &attr, argv, environ);
+
+    posix_spawn_file_actions_destroy(&file_actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (error == EAGAIN || error == ENOMEM) { return SCHEDR_ERROR_FORK_FAILED; }
+    if (error != 0) { return SCHEDR_FAILURE; }
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_spawn(const char *path, char *const argv[], pid_t *pid)
+{
+    return schedr_spawn_redirected(path, argv, NULL, pid);
+}
+
+Status schedr_spawn_redirected(const char *path, char *const argv[], const int fds[3], pid_t *pid)
+{
+    return schedr_spawn_limited(path, argv, fds, NULL, -1, pid);
+}
+
+Status schedr_spawn_limited(const char *path, char *const argv[], const int fds[3], const Limits *limits, int cgroup_fd, pid_t *pid)
+{
+    if (path == NULL || argv == NULL || pid == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    if (backend == Zygote && schedr_zygote_is_running())
+    {
+        Status status = schedr_zygote_spawn_limited(path, argv, environ, (fds != NULL) ? fds : STDIO_FDS, limits, cgroup_fd, pid);
+
+        // If the zygote is gone, the command is started by the daemon itself instead
+        if (status != SCHEDR_FAILURE || schedr_zygote_is_running()) { return status; }
+    }
+
+    bool limited = (cgroup_fd >= 0 || schedr_limits_are_set(limits) || schedr_limits_have_placement(limits));
+
+    if (!limited && (backend == PosixSpawn || backend == Zygote)) { return posix_spawn_exec(path, argv, fds, pid); }
+
+    return fork_exec(path, argv, fds, limits, cgroup_fd, pid);
+}
+
+int schedr_spawn_event_fd() { return schedr_zygote_fd(); }
+
+Status schedr_spawn_reap(pid_t *pid, int *status, struct rusage *usage)
+{
+    if (pid == NULL || status == NULL || usage == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    schedr_zygote_reap(pid, status, usage);
+
+    if (*pid > 0) { return SCHEDR_SUCCESS; }
+
+    // The commands started by the daemon itself, and those handed over by a zygote that has exited
+    *pid = wait4(-1, status, WNOHANG, usage);
+
+    if (*pid < 0) { *pid = 0; }
+
+    return SCHEDR_SUCCESS;
+}
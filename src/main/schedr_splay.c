@@ -0,0 +1,200 @@
+#include <stdio.h>          // FILE, fopen(), fclose(), fgets(), fprintf(), rename()
+#include <stdlib.h>         // malloc(), free(), strtoll()
+#include <string.h>         // strchr()
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool
+#include <errno.h>          // errno, EACCES
+#include <sys/random.h>     // getrandom()
+#include <linux/limits.h>   // PATH_MAX
+
+#include "schedr_splay.h"
+#include "schedr_hash.h"
+#include "schedr_time.h"
+
+#define STATE_LINE_LEN (SCHEDR_JOB_MAX_NAME_LEN + 32)
+
+static uint64_t random_u64();
+
+static uint64_t (*random_source)(void) = random_u64;
+
+static int64_t *load_state(const char *state_path, HashMap *offsets_by_name);
+static Status save_state(const char *state_path, const Job jobs[], int jobs_len);
+
+#ifdef TEST
+void schedr_splay_set_random(uint64_t (*random_func)(void)) { random_source = random_func; }
+void schedr_splay_reset_random() { random_source = random_u64; }
+#endif
+
+/*
+ * Assigns the offsets of 'jobs', keeping those of the jobs in 'running', if it
+ * is not NULL, whose splay did not change.
+ */
+static Status assign_offsets(Job jobs[], int jobs_len, SplayMode mode, const JobIndex *const running, const char *state_path)
+{
+    if (jobs_len < 0 || mode < 0 || mode >= SCHEDR_SPLAY_MODE_VALUES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    HashMap offsets_by_name;
+    int64_t *saved = NULL;
+    int kept = 0;
+    bool drawn = false;
+
+    schedr_hash_init(&offsets_by_name);
+
+    if (mode == SplayRandom && state_path != NULL) { saved = load_state(state_path, &offsets_by_name); }
+
+    for (int i = 0; i < jobs_len; i++)
+    {
+        Job *job_p = &(jobs[i]);
+        uint64_t name_hash = schedr_hash_string(job_p->name);
+
+        job_p->splay_offset_ns = 0;
+
+        if (job_p->splay_ns <= 0) { continue; }
+
+        const Job *running_p = (running != NULL) ? schedr_job_index_find(running, job_p->name) : NULL;
+
+        if (running_p != NULL && running_p->splay_ns == job_p->splay_ns)
+        {
+            job_p->splay_offset_ns = running_p->splay_offset_ns;
+            kept++;
+            continue;
+        }
+
+        drawn = true;
+
+        if (mode == SplayHashed)
+        {
+            job_p->splay_offset_ns = (int64_t)(name_hash % (uint64_t)job_p->splay_ns);
+            continue;
+        }
+
+        int64_t *offset_ns = (int64_t *)schedr_hash_get(&offsets_by_name, name_hash);
+
+        // An offset saved for a longer splay would delay the first run too much, so it is drawn again
+        if (offset_ns != NULL && *offset_ns < job_p->splay_ns) { job_p->splay_offset_ns = *offset_ns; }
+        else { job_p->splay_offset_ns = (int64_t)(random_source() % (uint64_t)job_p->splay_ns); }
+    }
+
+    schedr_hash_destroy(&offsets_by_name);
+    free(saved);
+
+    // Every running job with a splay that did not keep its offset has been removed or has a new one
+    for (int i = 0; running != NULL && i < running->len && !drawn; i++)
+    {
+        if (schedr_job_index_at(running, i)->splay_ns > 0) { kept--; }
+    }
+
+    if (mode == SplayRandom && state_path != NULL && (running == NULL || drawn || kept != 0)) { return save_state(state_path, jobs, jobs_len); }
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_splay_assign_offsets(Job jobs[], int jobs_len, SplayMode mode, const char *state_path)
+{
+    if (jobs == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    return assign_offsets(jobs, jobs_len, mode, NULL, state_path);
+}
+
+Status schedr_splay_reassign_offsets(Job jobs[], int jobs_len, SplayMode mode, const JobIndex *const running,
+                                     const char *state_path)
+{
+    if (jobs == NULL || running == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    return assign_offsets(jobs, jobs_len, mode, running, state_path);
+}
+
+static uint64_t random_u64()
+{
+    uint64_t value;
+
+    if (getrandom(&value, sizeof (value), 0) == sizeof (value)) { return value; }
+
+    // Fall back on the clock, which is random enough to spread the jobs out
+    return (uint64_t)schedr_time_monotonic_ns() * 0x9e3779b97f4a7c15ULL;
+}
+
+/*
+ * Reads the state file, which has a line '<offset in ns> <job name>' for every
+ * job. The offsets are put in 'offsets_by_name' by the hash of the name of 
+ * their job. Returns the array the offsets are stored in, or NULL if the file
+ * could not be read.
+ */
+static int64_t *load_state(const char *state_path, HashMap *offsets_by_name)
+{
+    FILE *fp = fopen(state_path, "r");
+
+    if (fp == NULL) { return NULL; }
+
+    char line[STATE_LINE_LEN];
+    int lines = 0;
+
+    while (fgets(line, sizeof (line), fp) != NULL) { lines++; }
+
+    int64_t *saved = (int64_t *)malloc(sizeof (int64_t) * (lines + 1));
+
+    if (saved == NULL)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    rewind(fp);
+
+    for (int i = 0; i < lines && fgets(line, sizeof (line), fp) != NULL; i++)
+    {
+        char *name = strchr(line, ' ');
+        char *end = strchr(line, '\n');
+
+        if (name == NULL) { continue; }
+        if (end != NULL) { *end = '\0'; }
+
+        *name = '\0';
+        name++;
+
+        errno = 0;
+        saved[i] = strtoll(line, NULL, 10);
+
+        if (errno == ERANGE || saved[i] < 0) { continue; }
+
+        schedr_hash_put(offsets_by_name, schedr_hash_string(name), &(saved[i]));
+    }
+
+    fclose(fp);
+
+    return saved;
+}
+
+/*
+ * Writes the offsets of the jobs with a splay to a temporary file, which then
+ * replaces the state file, so a crash never leaves half a state file behind.
+ */
+static Status save_state(const char *state_path, const Job jobs[], int jobs_len)
+{
+    char tmp_path[PATH_MAX];
+
+    if (snprintf(tmp_path, sizeof (tmp_path), "%s.tmp", state_path) >= (int)sizeof (tmp_path)) { return SCHEDR_FAILURE; }
+
+    FILE *fp = fopen(tmp_path, "w");
+
+    if (fp == NULL) { return (errno == EACCES) ? SCHEDR_ERROR_PERMISSION_DENIED : SCHEDR_FAILURE; }
+
+    bool written = true;
+
+    for (int i = 0; i < jobs_len; i++)
+    {
+        if (jobs[i].splay_ns <= 0) { continue; }
+
+        if (fprintf(fp, "%lld %s\n", (long long)jobs[i].splay_offset_ns, jobs[i].name) < 0) { written = false; }
+    }
+
+    if (fclose(fp) != 0) { written = false; }
+
+    if (!written || rename(tmp_path, state_path) != 0)
+    {
+        remove(tmp_path);
+        return (errno == EACCES) ? SCHEDR_ERROR_PERMISSION_DENIED : SCHEDR_FAILURE;
+    }
+
+    return SCHEDR_SUCCESS;
+}
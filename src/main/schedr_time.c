@@ -0,0 +1,22 @@
+#include <time.h>           // clock_gettime(), clockid_t, struct timespec
+
+#include "schedr_time.h"
+
+static int (*clock_reader)(clockid_t clock_id, struct timespec *now) = clock_gettime;
+
+#ifdef TEST
+void schedr_time_set_clock(int (*clock_func)(clockid_t clock_id, struct timespec *now)) { clock_reader = clock_func; }
+void schedr_time_reset_clock() { clock_reader = clock_gettime; }
+#endif
+
+static int64_t now_ns(clockid_t clock_id)
+{
+    struct timespec now;
+    clock_reader(clock_id, &now);
+
+    return (int64_t)now.tv_sec * SCHEDR_TIME_NANOSECS_PER_SEC + now.tv_nsec;
+}
+
+int64_t schedr_time_monotonic_ns() { return now_ns(CLOCK_MONOTONIC); }
+
+int64_t schedr_time_realtime_ns() { return now_ns(CLOCK_REALTIME); }
@@ -0,0 +1,304 @@
+#include <stddef.h>         // NULL
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool, true, false
+
+#include "schedr_timer.h"
+
+#define LEVEL_SHIFT(level) ((level) * SCHEDR_TIMER_SLOT_BITS)
+#define SLOT_MASK (SCHEDR_TIMER_SLOTS - 1)
+#define TOP_LEVEL (SCHEDR_TIMER_LEVELS - 1)
+#define OVERDUE_LEVEL SCHEDR_TIMER_LEVELS
+
+/*
+ * The farthest a timer is placed ahead of the current tick. Timers that are
+ * due later are parked in the top level and moved again when it is reached.
+ * Keeping one top level slot free means a slot never holds timers from two
+ * different rotations of the top level.
+ */
+#define MAX_TICKS_AHEAD ((uint64_t)SLOT_MASK << LEVEL_SHIFT(TOP_LEVEL))
+
+static void place_timer(TimerWheel *const wheel, Timer *const timer);
+static void link_timer(Timer *const head, Timer *const timer);
+static void unlink_timer(TimerWheel *const wheel, Timer *const timer);
+static bool find_next_event_tick(const TimerWheel *const wheel, uint64_t *tick);
+static void process_tick(TimerWheel *const wheel, uint64_t tick, Timer **expired_tail);
+
+Status schedr_timer_wheel_init(TimerWheel *const wheel, int64_t tick_ns, int64_t now_ns)
+{
+    if (wheel == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (tick_ns <= 0 || now_ns < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    wheel->tick_ns = tick_ns;
+    wheel->now_tick = (uint64_t)(now_ns / tick_ns);
+    wheel->pending = 0;
+    wheel->overdue.next = &(wheel->overdue);
+    wheel->overdue.prev = &(wheel->overdue);
+
+    for (int level = 0; level < SCHEDR_TIMER_LEVELS; level++)
+    {
+        wheel->occupied[level] = 0;
+
+        for (int slot = 0; slot < SCHEDR_TIMER_SLOTS; slot++)
+        {
+            Timer *head = &(wheel->slots[level][slot]);
+            head->next = head;
+            head->prev = head;
+        }
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_timer_init(Timer *const timer, void *data)
+{
+    if (timer == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires_tick = 0;
+    timer->level = 0;
+    timer->slot = 0;
+    timer->pending = false;
+    timer->data = data;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_timer_add(TimerWheel *const wheel, Timer *const timer, int64_t expires_ns)
+{
+    if (wheel == NULL || timer == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (timer->pending) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    // Round up so the timer never expires before its deadline
+    uint64_t expires_tick = (expires_ns <= 0) ?
+                            0 :
+                            (uint64_t)((expires_ns + wheel->tick_ns - 1) / wheel->tick_ns);
+
+    timer->pending = true;
+    wheel->pending++;
+
+    // The ticks before 'now_tick' have already been processed
+    if (expires_tick < wheel->now_tick)
+    {
+        timer->expires_tick = wheel->now_tick;
+        timer->level = OVERDUE_LEVEL;
+        link_timer(&(wheel->overdue), timer);
+
+        return SCHEDR_SUCCESS;
+    }
+
+    timer->expires_tick = expires_tick;
+    place_timer(wheel, timer);
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_timer_cancel(TimerWheel *const wheel, Timer *const timer)
+{
+    if (wheel == NULL || timer == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (!timer->pending) { return SCHEDR_SUCCESS; }
+
+    unlink_timer(wheel, timer);
+    timer->pending = false;
+    wheel->pending--;
+
+    return SCHEDR_SUCCESS;
+}
+
+Status schedr_timer_advance(TimerWheel *const wheel, int64_t now_ns, Timer **expired)
+{
+    if (wheel == NULL || expired == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    Timer expired_head = { .next = NULL };
+    Timer *expired_tail = &expired_head;
+    uint64_t target_tick = (now_ns <= 0) ? 0 : (uint64_t)(now_ns / wheel->tick_ns);
+    uint64_t tick;
+
+    if (wheel->overdue.next != &(wheel->overdue))
+    {
+        for (Timer *timer = wheel->overdue.next; timer != &(wheel->overdue); timer = timer->next)
+        {
+            timer->pending = false;
+            wheel->pending--;
+            expired_tail->next = timer;
+            expired_tail = timer;
+        }
+
+        wheel->overdue.next = &(wheel->overdue);
+        wheel->overdue.prev = &(wheel->overdue);
+    }
+
+    // Jump straight between the ticks where something happens instead of
+    // visiting every tick in between
+    while (find_next_event_tick(wheel, &tick) && tick <= target_tick)
+    {
+        process_tick(wheel, tick, &expired_tail);
+        wheel->now_tick = tick + 1;
+    }
+
+    if (target_tick >= wheel->now_tick) { wheel->now_tick = target_tick + 1; }
+
+    expired_tail->next = NULL;
+    *expired = expired_head.next;
+
+    return SCHEDR_SUCCESS;
+}
+
+int64_t schedr_timer_next_deadline(const TimerWheel *const wheel)
+{
+    uint64_t tick;
+
+    if (wheel == NULL) { return -1; }
+    if (wheel->overdue.next != &(wheel->overdue)) { return (int64_t)(wheel->now_tick - 1) * wheel->tick_ns; }
+    if (!find_next_event_tick(wheel, &tick)) { return -1; }
+
+    return (int64_t)tick * wheel->tick_ns;
+}
+
+/*
+ * Puts a timer in the lowest level whose slots still separate its deadline
+ * from the current tick. Everything in a level below the top one expires
+ * within the current rotation of the level above it.
+ */
+static void place_timer(TimerWheel *const wheel, Timer *const timer)
+{
+    uint64_t now = wheel->now_tick;
+    uint64_t expires = timer->expires_tick;
+
+    if (expires < now) { expires = now; }
+    if (expires - now > MAX_TICKS_AHEAD) { expires = now + MAX_TICKS_AHEAD; }
+
+    int level = 0;
+
+    while (level < TOP_LEVEL && (expires >> LEVEL_SHIFT(level + 1)) != (now >> LEVEL_SHIFT(level + 1)))
+    {
+        level++;
+    }
+
+    int slot = (int)((expires >> LEVEL_SHIFT(level)) & SLOT_MASK);
+
+    timer->level = (unsigned char)level;
+    timer->slot = (unsigned char)slot;
+    link_timer(&(wheel->slots[level][slot]), timer);
+
+    wheel->occupied[level] |= (1ULL << slot);
+}
+
+static void link_timer(Timer *const head, Timer *const timer)
+{
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static void unlink_timer(TimerWheel *const wheel, Timer *const timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+
+    if (timer->level == OVERDUE_LEVEL) { return; }
+
+    Timer *head = &(wheel->slots[timer->level][timer->slot]);
+
+    if (head->next == head) { wheel->occupied[timer->level] &= ~(1ULL << timer->slot); }
+}
+
+/*
+ * Finds the first tick, from the current one, where a slot of any level has
+ * to be expired or moved to a lower level.
+ */
+static bool find_next_event_tick(const TimerWheel *const wheel, uint64_t *tick)
+{
+    uint64_t now = wheel->now_tick;
+    bool found = false;
+
+    *tick = UINT64_MAX;
+
+    for (int level = 0; level < SCHEDR_TIMER_LEVELS; level++)
+    {
+        uint64_t occupied = wheel->occupied[level];
+
+        if (occupied == 0) { continue; }
+
+        int shift = LEVEL_SHIFT(level);
+        int index = (int)((now >> shift) & SLOT_MASK);
+        uint64_t rotation_start = (now >> (shift + SCHEDR_TIMER_SLOT_BITS)) << (shift + SCHEDR_TIMER_SLOT_BITS);
+        uint64_t ahead = occupied & (~0ULL << index);
+        uint64_t candidate;
+
+        if (ahead != 0)
+        {
+            candidate = rotation_start + ((uint64_t)__builtin_ctzll(ahead) << shift);
+        }
+        else if (level == TOP_LEVEL)
+        {
+            // The top level wraps around, the slots behind the current one
+            // belong to its next rotation
+            uint64_t rotation_len = 1ULL << (shift + SCHEDR_TIMER_SLOT_BITS);
+            candidate = rotation_start + rotation_len + ((uint64_t)__builtin_ctzll(occupied) << shift);
+        }
+        else
+        {
+            continue;
+        }
+
+        if (candidate < now) { candidate = now; }
+        if (candidate < *tick) { *tick = candidate; }
+
+        found = true;
+    }
+
+    return found;
+}
+
+static void process_tick(TimerWheel *const wheel, uint64_t tick, Timer **expired_tail)
+{
+    wheel->now_tick = tick;
+
+    // Move the timers in the slots the tick has reached closer, from the top down
+    for (int level = TOP_LEVEL; level > 0; level--)
+    {
+        int slot = (int)((tick >> LEVEL_SHIFT(level)) & SLOT_MASK);
+
+        if ((wheel->occupied[level] & (1ULL << slot)) == 0) { continue; }
+
+        Timer *head = &(wheel->slots[level][slot]);
+        Timer *timer = head->next;
+
+        head->next = head;
+        head->prev = head;
+        wheel->occupied[level] &= ~(1ULL << slot);
+
+        while (timer != head)
+        {
+            Timer *next = timer->next;
+            place_timer(wheel, timer);
+            timer = next;
+        }
+    }
+
+    int slot = (int)(tick & SLOT_MASK);
+    Timer *head = &(wheel->slots[0][slot]);
+
+    if (head->next != head)
+    {
+        Timer *timer = head->next;
+
+        while (timer != head)
+        {
+            Timer *next = timer->next;
+
+            timer->pending = false;
+            wheel->pending--;
+            (*expired_tail)->next = timer;
+            *expired_tail = timer;
+
+            timer = next;
+        }
+
+        head->next = head;
+        head->prev = head;
+        wheel->occupied[0] &= ~(1ULL << slot);
+    }
+}
@@ -0,0 +1,255 @@
+#include <stddef.h>             // NULL
+#include <stdint.h>             // uint64_t, uintptr_t
+#include <poll.h>               // POLLIN
+#include <string.h>             // memset()
+#include <errno.h>              // errno, ENOSYS, EPERM, EINVAL, EINTR, EBUSY, EAGAIN
+#include <unistd.h>             // syscall(), close()
+#include <sys/mman.h>           // mmap(), munmap()
+#include <sys/syscall.h>        // __NR_io_uring_setup, __NR_io_uring_enter
+
+#include "schedr_uring.h"
+
+// Polling files that are not ready, buffers selected by the kernel and keeping completions that do not fit came with these
+#define REQUIRED_FEATURES (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_SUBMIT_STABLE | IORING_FEAT_FAST_POLL)
+
+static int setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int (*setup_ring)(unsigned entries, struct io_uring_params *params) = setup;
+
+#ifdef TEST
+void schedr_uring_set_setup(int (*setup_func)(unsigned entries, struct io_uring_params *params)) { setup_ring = setup_func; }
+void schedr_uring_reset_setup() { setup_ring = setup; }
+#endif
+
+Status schedr_uring_init(Uring *const ring, unsigned entries)
+{
+    if (ring == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (entries == 0 || entries > SCHEDR_URING_MAX_ENTRIES) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+
+    struct io_uring_params params;
+
+    memset(ring, 0, sizeof (Uring));
+    memset(&params, 0, sizeof (params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = entries * SCHEDR_URING_CQ_FACTOR;
+
+    ring->fd = setup_ring(entries, &params);
+
+    if (ring->fd < 0)
+    {
+        // Older kernels do not know the flags either
+        return (errno == ENOSYS || errno == EPERM || errno == EINVAL) ? SCHEDR_ERROR_NOT_IMPLEMENTED : SCHEDR_FAILURE;
+    }
+
+    if ((params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES)
+    {
+        close(ring->fd);
+        return SCHEDR_ERROR_NOT_IMPLEMENTED;
+    }
+
+    size_t sq_len = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    size_t cq_len = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+
+    ring->rings_len = (sq_len > cq_len) ? sq_len : cq_len;
+    ring->sqes_len = params.sq_entries * sizeof (struct io_uring_sqe);
+    ring->rings = mmap(NULL, ring->rings_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                             ring->fd, IORING_OFF_SQES);
+
+    if (ring->rings == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        if (ring->rings != MAP_FAILED) { munmap(ring->rings, ring->rings_len); }
+        if (ring->sqes != MAP_FAILED) { munmap(ring->sqes, ring->sqes_len); }
+
+        close(ring->fd);
+        memset(ring, 0, sizeof (Uring));
+        return SCHEDR_FAILURE;
+    }
+
+    char *rings = (char *)ring->rings;
+
+    ring->sq_entries = params.sq_entries;
+    ring->sq_head = (unsigned *)(rings + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(rings + params.sq_off.tail);
+    ring->sq_flags = (unsigned *)(rings + params.sq_off.flags);
+    ring->sq_mask = (unsigned *)(rings + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(rings + params.sq_off.array);
+    ring->cq_head = (unsigned *)(rings + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(rings + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(rings + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(rings + params.cq_off.cqes);
+
+    return SCHEDR_SUCCESS;
+}
+
+void schedr_uring_destroy(Uring *const ring)
+{
+    if (ring == NULL || ring->rings == NULL) { return; }
+
+    munmap(ring->sqes, ring->sqes_len);
+    munmap(ring->rings, ring->rings_len);
+    close(ring->fd);
+    memset(ring, 0, sizeof (Uring));
+    ring->fd = -1;
+}
+
+static unsigned queued(const Uring *const ring)
+{
+    return ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+struct io_uring_sqe *schedr_uring_get_sqe(Uring *const ring)
+{
+    if (queued(ring) == ring->sq_entries) { schedr_uring_submit(ring, false); }
+    if (queued(ring) == ring->sq_entries) { return NULL; }
+
+    unsigned index = ring->sqe_tail & *(ring->sq_mask);
+    struct io_uring_sqe *sqe = &(ring->sqes[index]);
+
+    memset(sqe, 0, sizeof (struct io_uring_sqe));
+    ring->sq_array[index] = index;
+    ring->sqe_tail++;
+
+    return sqe;
+}
+
+Status schedr_uring_submit(Uring *const ring, bool wait)
+{
+    if (ring == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    // Completions held back by the kernel are only moved to the queue when it is entered
+    bool overflowed = (__atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) != 0;
+    unsigned to_submit = queued(ring);
+
+    if (to_submit == 0 && !wait && !overflowed) { return SCHEDR_SUCCESS; }
+
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+
+    int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, wait ? 1 : 0,
+                                 (wait || overflowed) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+    // The requests the kernel did not take stay in the queue and are submitted on the next call
+    if (submitted < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) { return SCHEDR_FAILURE; }
+
+    return SCHEDR_SUCCESS;
+}
+
+struct io_uring_cqe *schedr_uring_peek(Uring *const ring)
+{
+    unsigned head = *(ring->cq_head);
+
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) { return NULL; }
+
+    return &(ring->cqes[head & *(ring->cq_mask)]);
+}
+
+void schedr_uring_seen(Uring *const ring)
+{
+    __atomic_store_n(ring->cq_head, *(ring->cq_head) + 1, __ATOMIC_RELEASE);
+}
+
+bool schedr_uring_queue_read(Uring *const ring, int fd, void *buf, unsigned len, int buffer_group, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (uint64_t)-1;
+    sqe->flags = (buffer_group != 0) ? IOSQE_BUFFER_SELECT : 0;
+    sqe->buf_group = (uint16_t)buffer_group;
+    sqe->user_data = user_data;
+
+    return true;
+}
+
+bool schedr_uring_queue_poll(Uring *const ring, int fd, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = user_data;
+
+    return true;
+}
+
+bool schedr_uring_queue_close(Uring *const ring, int fd)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = SCHEDR_URING_IGNORED;
+
+    return true;
+}
+
+bool schedr_uring_queue_cancel(Uring *const ring, uint64_t target)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = target;
+    sqe->user_data = SCHEDR_URING_IGNORED;
+
+    return true;
+}
+
+bool schedr_uring_provide_buffer(Uring *const ring, void *buf, unsigned len, int id, int buffer_group)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (uint64_t)id;
+    sqe->buf_group = (uint16_t)buffer_group;
+    sqe->user_data = SCHEDR_URING_IGNORED;
+
+    return true;
+}
+
+bool schedr_uring_queue_timeout(Uring *const ring, const struct __kernel_timespec *deadline, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uintptr_t)deadline;
+    sqe->len = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    sqe->user_data = user_data;
+
+    return true;
+}
+
+bool schedr_uring_remove_timeout(Uring *const ring, uint64_t target)
+{
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(ring);
+
+    if (sqe == NULL) { return false; }
+
+    sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+    sqe->addr = target;
+    sqe->user_data = SCHEDR_URING_IGNORED;
+
+    return true;
+}
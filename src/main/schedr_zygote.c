@@ -0,0 +1,583 @@
+#define _GNU_SOURCE             // POSIX_SPAWN_USEVFORK, MSG_CMSG_CLOEXEC
+
+#include <stdlib.h>             // malloc(), realloc(), free(), EXIT_SUCCESS, EXIT_FAILURE
+#include <string.h>             // memcpy(), memset(), strlen()
+#include <stdint.h>             // uint32_t
+#include <unistd.h>             // fork(), close(), getpid(), getppid(), _exit()
+#include <signal.h>             // sigset_t, sigprocmask()
+#include <spawn.h>              // posix_spawn()
+#include <errno.h>              // errno, EINTR, EAGAIN, ENOMEM
+#include <poll.h>               // poll()
+#include <sys/socket.h>         // socketpair(), sendmsg(), recvmsg()
+#include <sys/signalfd.h>       // signalfd()
+#include <sys/prctl.h>          // prctl()
+#include <sys/wait.h>           // waitpid(), wait4()
+#include <sys/mman.h>           // mmap()
+
+#include "schedr_zygote.h"
+
+#define REQUEST_FDS 3
+#define MAX_REQUEST_FDS (REQUEST_FDS + 1)
+
+enum ReplyType
+{
+    Spawned = 0,
+    Exited = 1
+};
+
+typedef enum ReplyType ReplyType;
+
+// Followed by the path, the arguments and the environment as NUL terminated strings
+struct Request
+{
+    uint32_t argc;
+    uint32_t envc;
+    Limits limits;
+    uint32_t in_cgroup;     // Set if the cgroup of the command is sent after its stdin, stdout and stderr
+};
+
+struct Reply
+{
+    ReplyType type;
+    pid_t pid;
+    int error;
+    int status;
+    struct rusage usage;
+};
+
+typedef struct Request Request;
+typedef struct Reply Reply;
+
+static int zygote_fd = -1;
+static pid_t zygote_pid = 0;
+static pid_t owner_pid = 0;
+
+// Exits reported while waiting for the pid of a command, handed out by schedr_zygote_reap()
+static Reply *pending_exits = NULL;
+static size_t pending_exits_len = 0;
+static size_t pending_exits_head = 0;
+static size_t pending_exits_capacity = 0;
+
+static char request_buf[SCHEDR_ZYGOTE_MAX_REQUEST_LEN];
+
+// Where a limited command the zygote has cloned stores why it could not be executed, shared with the zygote
+static int *exec_error = NULL;
+
+static void serve(int sock);
+
+#ifdef TEST
+void __gcov_flush();
+#endif
+
+Status schedr_zygote_start()
+{
+    if (schedr_zygote_is_running()) { return SCHEDR_SUCCESS; }
+
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0) { return SCHEDR_FAILURE; }
+
+    pid_t parent_pid = getpid();
+    pid_t pid = fork();
+
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+
+        return SCHEDR_ERROR_FORK_FAILED;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+
+        // Processes forked by the daemon keep its end of the socket open, so it never reads EOF when the daemon dies
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+        if (getppid() == parent_pid) { serve(fds[1]); }
+
+        #ifdef TEST
+        __gcov_flush();
+        #endif
+
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(fds[1]);
+
+    // Commands still running when the zygote exits are handed over to the daemon instead of init
+    prctl(PR_SET_CHILD_SUBREAPER, 1);
+
+    zygote_fd = fds[0];
+    zygote_pid = pid;
+    owner_pid = parent_pid;
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * Forgets about the zygote, once it has exited or can no longer be reached.
+ */
+static void lose_zygote()
+{
+    // Processes forked by the daemon may keep the socket open, so the zygote is not left to notice it closing
+    close(zygote_fd);
+    kill(zygote_pid, SIGTERM);
+    waitpid(zygote_pid, NULL, 0);
+
+    zygote_fd = -1;
+    zygote_pid = 0;
+    owner_pid = 0;
+}
+
+void schedr_zygote_stop()
+{
+    if (!schedr_zygote_is_running()) { return; }
+
+    lose_zygote();
+
+    free(pending_exits);
+    pending_exits = NULL;
+    pending_exits_len = pending_exits_head = pending_exits_capacity = 0;
+}
+
+bool schedr_zygote_is_running() { return zygote_fd != -1 && owner_pid == getpid(); }
+
+int schedr_zygote_fd() { return schedr_zygote_is_running() ? zygote_fd : -1; }
+
+pid_t schedr_zygote_pid() { return schedr_zygote_is_running() ? zygote_pid : 0; }
+
+static bool append_string(size_t *len, const char *str)
+{
+    size_t str_len = strlen(str) + 1;
+
+    if (str_len > sizeof (request_buf) - *len) { return false; }
+
+    memcpy(request_buf + *len, str, str_len);
+    *len += str_len;
+
+    return true;
+}
+
+/*
+ * Sends a request to start a command, with the file descriptors of the
+ * command, and its cgroup unless 'cgroup_fd' is -1, attached to it.
+ */
+static Status send_request(const char *path, char *const argv[], char *const envp[], const int fds[REQUEST_FDS],
+                           const Limits *limits, int cgroup_fd)
+{
+    Request request = { .argc = 0, .envc = 0, .in_cgroup = (cgroup_fd >= 0) };
+    size_t len = sizeof (request);
+    int fds_len = REQUEST_FDS + (int)request.in_cgroup;
+
+    if (limits != NULL) { request.limits = *limits; }
+    else { schedr_limits_init(&(request.limits)); }
+
+    bool fits = append_string(&len, path);
+
+    for (; fits && argv[request.argc] != NULL; request.argc++) { fits = append_string(&len, argv[request.argc]); }
+    for (; fits && envp[request.envc] != NULL; request.envc++) { fits = append_string(&len, envp[request.envc]); }
+
+    if (!fits) { return SCHEDR_ERROR_BUFFER_OVERFLOW; }
+
+    memcpy(request_buf, &request, sizeof (request));
+
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (int) * MAX_REQUEST_FDS)];
+        struct cmsghdr align;
+    } control;
+
+    struct iovec iov = { .iov_base = request_buf, .iov_len = len };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf, .msg_controllen = CMSG_SPACE(sizeof (int) * fds_len) };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (int) * fds_len);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof (int) * REQUEST_FDS);
+
+    if (request.in_cgroup) { memcpy(CMSG_DATA(cmsg) + sizeof (int) * REQUEST_FDS, &cgroup_fd, sizeof (int)); }
+
+    ssize_t sent;
+
+    while ((sent = sendmsg(zygote_fd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR);
+
+    if (sent < 0)
+    {
+        lose_zygote();
+        return SCHEDR_FAILURE;
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+static bool keep_exit(const Reply *reply)
+{
+    if (pending_exits_len == pending_exits_capacity)
+    {
+        size_t capacity = (pending_exits_capacity == 0) ? 16 : pending_exits_capacity * 2;
+        Reply *exits = (Reply *)realloc(pending_exits, sizeof (Reply) * capacity);
+
+        if (exits == NULL) { return false; }
+
+        pending_exits = exits;
+        pending_exits_capacity = capacity;
+    }
+
+    pending_exits[pending_exits_len++] = *reply;
+
+    return true;
+}
+
+Status schedr_zygote_spawn(const char *path, char *const argv[], char *const envp[], const int fds[3], pid_t *pid)
+{
+    return schedr_zygote_spawn_limited(path, argv, envp, fds, NULL, -1, pid);
+}
+
+Status schedr_zygote_spawn_limited(const char *path, char *const argv[], char *const envp[], const int fds[3],
+                                   const Limits *limits, int cgroup_fd, pid_t *pid)
+{
+    if (path == NULL || argv == NULL || envp == NULL || fds == NULL || pid == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+    if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0) { return SCHEDR_ERROR_INVALID_ARGUMENT; }
+    if (!schedr_zygote_is_running()) { return SCHEDR_FAILURE; }
+
+    Status status = send_request(path, argv, envp, fds, limits, cgroup_fd);
+
+    if (status != SCHEDR_SUCCESS) { return status; }
+
+    // Commands started earlier may exit before the zygote gets to the request, their exits are kept for later
+    for (;;)
+    {
+        Reply reply;
+        ssize_t len = recv(zygote_fd, &reply, sizeof (reply), 0);
+
+        if (len < 0 && errno == EINTR) { continue; }
+
+        if (len != sizeof (reply))
+        {
+            lose_zygote();
+            return SCHEDR_FAILURE;
+        }
+
+        if (reply.type == Exited)
+        {
+            // There is nothing better to do with an exit that can not be kept than to drop it
+            keep_exit(&reply);
+            continue;
+        }
+
+        if (reply.error == EAGAIN || reply.error == ENOMEM) { return SCHEDR_ERROR_FORK_FAILED; }
+        if (reply.error != 0) { return SCHEDR_FAILURE; }
+
+        *pid = reply.pid;
+
+        return SCHEDR_SUCCESS;
+    }
+}
+
+Status schedr_zygote_reap(pid_t *pid, int *status, struct rusage *usage)
+{
+    if (pid == NULL || status == NULL || usage == NULL) { return SCHEDR_ERROR_NULL_ARGUMENT; }
+
+    Reply reply;
+    bool exited = false;
+
+    if (pending_exits_head < pending_exits_len)
+    {
+        reply = pending_exits[pending_exits_head++];
+        exited = true;
+
+        if (pending_exits_head == pending_exits_len) { pending_exits_head = pending_exits_len = 0; }
+    }
+
+    while (!exited && schedr_zygote_is_running())
+    {
+        ssize_t len = recv(zygote_fd, &reply, sizeof (reply), MSG_DONTWAIT);
+
+        if (len < 0 && errno == EINTR) { continue; }
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { break; }
+
+        if (len != sizeof (reply))
+        {
+            lose_zygote();
+            break;
+        }
+
+        exited = (reply.type == Exited);
+    }
+
+    *pid = exited ? reply.pid : 0;
+
+    if (exited)
+    {
+        *status = reply.status;
+        *usage = reply.usage;
+    }
+
+    return SCHEDR_SUCCESS;
+}
+
+/*
+ * The rest of this file runs in the zygote.
+ */
+
+/*
+ * Starts a command that is limited by clone(), which unlike posix_spawn() can
+ * start it in a cgroup and set its limits and placement before it is executed. The zygote
+ * is suspended until the command has been executed, so it knows whether it
+ * could be. Returns 0 or the error number.
+ */
+static int start_limited_cmd(const char *path, char *const argv[], char *const envp[], const int fds[REQUEST_FDS],
+                             const Limits *limits, int cgroup_fd, pid_t *pid)
+{
+    static const int RESET_SIGNALS[] = { SIGCHLD, SIGTERM, SIGINT, SIGHUP, SIGPIPE, 0 };
+
+    if (exec_error == NULL)
+    {
+        void *shared = mmap(NULL, sizeof (int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+        if (shared == MAP_FAILED) { return ENOMEM; }
+
+        exec_error = (int *)shared;
+    }
+
+    *exec_error = 0;
+
+    pid_t child_pid = schedr_limits_clone(cgroup_fd, true);
+
+    if (child_pid < 0) { return errno; }
+
+    if (child_pid == 0)
+    {
+        sigset_t empty;
+        sigemptyset(&empty);
+
+        for (int i = 0; RESET_SIGNALS[i] != 0; i++) { signal(RESET_SIGNALS[i], SIG_DFL); }
+
+        sigprocmask(SIG_SETMASK, &empty, NULL);
+
+        for (int i = 0; i < REQUEST_FDS; i++) { dup2(fds[i], i); }
+
+        schedr_limits_place(0, limits);
+
+        if (cgroup_fd < 0) { schedr_limits_apply(limits); }
+
+        execve(path, argv, envp);
+
+        *exec_error = errno;    // GCOVR_EXCL_LINE
+        _exit(EXIT_FAILURE);    // GCOVR_EXCL_LINE
+    }
+
+    // The child has been executed or has exited by now, the latter is reaped here like posix_spawn() does
+    if (*exec_error != 0)
+    {
+        waitpid(child_pid, NULL, 0);
+        return *exec_error;
+    }
+
+    *pid = child_pid;
+
+    return 0;
+}
+
+/*
+ * Starts a command with posix_spawn(), which every signal is reset to its
+ * default action in and none is blocked, or with start_limited_cmd() if it is
+ * limited. Returns 0 or the error number.
+ */
+static int start_cmd(const char *path, char *const argv[], char *const envp[], const int fds[REQUEST_FDS],
+                     const Limits *limits, int cgroup_fd, pid_t *pid)
+{
+    if (cgroup_fd >= 0 || schedr_limits_are_set(limits) || schedr_limits_have_placement(limits)) { return start_limited_cmd(path, argv, envp, fds, limits, cgroup_fd, pid); }
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attr;
+    sigset_t empty, all;
+
+    sigemptyset(&empty);
+    sigfillset(&all);
+
+    posix_spawn_file_actions_init(&file_actions);
+
+    for (int i = 0; i < REQUEST_FDS; i++) { posix_spawn_file_actions_adddup2(&file_actions, fds[i], i); }
+
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_USEVFORK);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setsigdefault(&attr, &all);
+
+    int error = posix_spawn(pid, path, &file_actions, &attr, argv, envp);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&file_actions);
+
+    return error;
+}
+
+/*
+ * Splits the strings of a request into the path, the arguments and the
+ * environment of the command. Returns the array the arguments and the
+ * environment are stored in, NULL terminated each, or NULL if the request
+ * is malformed.
+ */
+static char **parse_request(char *buf, size_t len, Request *request, char **path, char ***envp)
+{
+    if (len < sizeof (*request) || buf[len - 1] != '\0') { return NULL; }
+
+    memcpy(request, buf, sizeof (*request));
+
+    if ((size_t)request->argc + request->envc + 1 > len) { return NULL; }
+
+    char **strings = (char **)malloc(sizeof (char *) * (request->argc + request->envc + 2));
+
+    if (strings == NULL) { return NULL; }
+
+    char *str = buf + sizeof (*request);
+    char *end = buf + len;
+
+    *path = str;
+    str += strlen(str) + 1;
+
+    for (uint32_t i = 0; i < request->argc + request->envc; i++)
+    {
+        if (str >= end)
+        {
+            free(strings);
+            return NULL;
+        }
+
+        // The arguments and the environment are separated by a NULL
+        strings[(i < request->argc) ? i : i + 1] = str;
+        str += strlen(str) + 1;
+    }
+
+    strings[request->argc] = NULL;
+    strings[request->argc + request->envc + 1] = NULL;
+    *envp = &(strings[request->argc + 1]);
+
+    return strings;
+}
+
+/*
+ * Receives a request to start a command, starts it and replies with its pid.
+ * Returns false when the daemon has closed its end of the socket.
+ */
+static bool serve_request(int sock)
+{
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (int) * MAX_REQUEST_FDS)];
+        struct cmsghdr align;
+    } control;
+
+    struct iovec iov = { .iov_base = request_buf, .iov_len = sizeof (request_buf) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf, .msg_controllen = sizeof (control.buf) };
+
+    // The descriptors must not leak into commands started for later requests
+    ssize_t len = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+
+    if (len == 0) { return false; }
+    if (len < 0) { return errno == EINTR || errno == EAGAIN; }
+
+    int fds[MAX_REQUEST_FDS];
+    int fds_len = 0;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+
+        int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof (int);
+
+        for (int i = 0; i < count; i++)
+        {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + sizeof (int) * i, sizeof (int));
+
+            if (fds_len < MAX_REQUEST_FDS) { fds[fds_len++] = fd; }
+            else { close(fd); }
+        }
+    }
+
+    Reply reply;
+    Request request;
+    char *path, **envp;
+    char **argv = (fds_len >= REQUEST_FDS && !(msg.msg_flags & MSG_TRUNC))
+                ? parse_request(request_buf, (size_t)len, &request, &path, &envp) : NULL;
+
+    // The cgroup is sent along only if the request says so
+    if (argv != NULL && fds_len != REQUEST_FDS + (request.in_cgroup ? 1 : 0))
+    {
+        free(argv);
+        argv = NULL;
+    }
+
+    int cgroup_fd = (argv != NULL && request.in_cgroup) ? fds[REQUEST_FDS] : -1;
+
+    memset(&reply, 0, sizeof (reply));
+    reply.type = Spawned;
+    reply.error = (argv != NULL) ? start_cmd(path, argv, envp, fds, &(request.limits), cgroup_fd, &(reply.pid)) : EINVAL;
+
+    free(argv);
+
+    for (int i = 0; i < fds_len; i++) { close(fds[i]); }
+
+    return send(sock, &reply, sizeof (reply), MSG_NOSIGNAL) == sizeof (reply);
+}
+
+/*
+ * Waits for every command that has exited and reports it to the daemon.
+ * Returns false when the daemon can no longer be reached.
+ */
+static bool report_exits(int sock, int signal_fd)
+{
+    struct signalfd_siginfo info;
+    Reply reply;
+
+    while (read(signal_fd, &info, sizeof (info)) == sizeof (info));
+
+    memset(&reply, 0, sizeof (reply));
+    reply.type = Exited;
+
+    while ((reply.pid = wait4(-1, &(reply.status), WNOHANG, &(reply.usage))) > 0)
+    {
+        if (send(sock, &reply, sizeof (reply), MSG_NOSIGNAL) != sizeof (reply)) { return false; }
+    }
+
+    return true;
+}
+
+/*
+ * Serves requests from the daemon until it closes its end of the socket.
+ */
+static void serve(int sock)
+{
+    sigset_t child_signals;
+
+    sigemptyset(&child_signals);
+    sigaddset(&child_signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &child_signals, NULL);
+
+    int signal_fd = signalfd(-1, &child_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    if (signal_fd == -1) { return; }
+
+    struct pollfd fds[2] = { { .fd = sock, .events = POLLIN }, { .fd = signal_fd, .events = POLLIN } };
+    bool serving = true;
+
+    while (serving)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            serving = (errno == EINTR);
+            continue;
+        }
+
+        if (fds[1].revents != 0) { serving = report_exits(sock, signal_fd); }
+        if (serving && fds[0].revents != 0) { serving = serve_request(sock); }
+    }
+
+    close(signal_fd);
+    close(sock);
+}
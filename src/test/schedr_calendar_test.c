@@ -0,0 +1,255 @@
+#include <stdlib.h>         // setenv(), rand(), srand(), EXIT_SUCCESS
+#include <stdint.h>         // uint64_t
+#include <stdbool.h>        // bool
+#include <time.h>           // time_t, struct tm, timegm(), localtime_r(), tzset()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_calendar.h"
+
+#define AGREEMENT_CALENDARS 300
+#define MAX_BRUTE_FORCE_MINUTES (60 * 24 * 62)
+
+static Calendar calendar;
+
+static void set_timezone(const char *zone)
+{
+    setenv("TZ", zone, 1);
+    tzset();
+}
+
+static void setup()
+{
+    set_timezone("UTC");
+    schedr_calendar_init(&calendar);
+    calendar.minutes = 1ULL << 0;
+    calendar.hours = 1U << 0;
+    calendar.days = SCHEDR_CALENDAR_ALL_DAYS;
+    calendar.months = SCHEDR_CALENDAR_ALL_MONTHS;
+    calendar.weekdays = SCHEDR_CALENDAR_ALL_WEEKDAYS;
+}
+
+static void teardown()
+{
+    set_timezone("UTC");
+}
+
+/*
+ * Returns the instant of a date and time in UTC.
+ */
+static time_t utc(int year, int month, int day, int hour, int minute)
+{
+    struct tm tm = { .tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = day, .tm_hour = hour, .tm_min = minute };
+
+    return timegm(&tm);
+}
+
+static time_t next_after(time_t after)
+{
+    time_t next = 0;
+
+    ssct_assert_equals(schedr_calendar_next(&calendar, after, &next), SCHEDR_SUCCESS);
+
+    return next;
+}
+
+/*
+ * Tells if the calendar fires at the start of the minute 'instant' is in,
+ * local time.
+ */
+static bool fires_at(time_t instant)
+{
+    struct tm local;
+
+    localtime_r(&instant, &local);
+
+    return ((calendar.minutes >> local.tm_min) & 1) && ((calendar.hours >> local.tm_hour) & 1) &&
+           ((calendar.days >> local.tm_mday) & 1) && ((calendar.months >> (local.tm_mon + 1)) & 1) &&
+           ((calendar.weekdays >> local.tm_wday) & 1);
+}
+
+static void compile_should_reject_calendars_that_never_fire()
+{
+    Calendar invalid;
+
+    ssct_assert_equals(schedr_calendar_compile(&calendar), SCHEDR_SUCCESS);
+
+    invalid = calendar;
+    invalid.minutes = 1ULL << 60;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    invalid = calendar;
+    invalid.hours = 0;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    invalid = calendar;
+    invalid.days = 1U << 0;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    invalid = calendar;
+    invalid.months = 1U << 13;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    invalid = calendar;
+    invalid.weekdays = 1U << 7;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    // February 30th never comes, the 29th does
+    invalid = calendar;
+    invalid.days = 1U << 30;
+    invalid.months = 1U << 2;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    invalid.days = 1U << 29;
+    ssct_assert_equals(schedr_calendar_compile(&invalid), SCHEDR_SUCCESS);
+}
+
+static void next_should_find_next_time_calendar_fires_at()
+{
+    // Every friday at 12 am, from a sunday
+    calendar.weekdays = 1U << 5;
+    schedr_calendar_compile(&calendar);
+
+    ssct_assert_true(next_after(utc(2026, 10, 18, 0, 45)) == utc(2026, 10, 23, 0, 0));
+    ssct_assert_true(next_after(utc(2026, 10, 23, 0, 0)) == utc(2026, 10, 30, 0, 0));
+    ssct_assert_true(next_after(utc(2026, 10, 22, 23, 59) + 59) == utc(2026, 10, 23, 0, 0));
+
+    // On the 1st and 15th at 9:15 and 9:45 in december, carried over into the next year
+    calendar.weekdays = SCHEDR_CALENDAR_ALL_WEEKDAYS;
+    calendar.days = (1U << 1) | (1U << 15);
+    calendar.months = 1U << 12;
+    calendar.hours = 1U << 9;
+    calendar.minutes = (1ULL << 15) | (1ULL << 45);
+    schedr_calendar_compile(&calendar);
+
+    ssct_assert_true(next_after(utc(2026, 12, 1, 9, 15)) == utc(2026, 12, 1, 9, 45));
+    ssct_assert_true(next_after(utc(2026, 12, 1, 9, 45)) == utc(2026, 12, 15, 9, 15));
+    ssct_assert_true(next_after(utc(2026, 12, 15, 9, 45)) == utc(2027, 12, 1, 9, 15));
+}
+
+static void next_should_find_leap_day_on_weekday_decades_ahead()
+{
+    calendar.days = 1U << 29;
+    calendar.months = 1U << 2;
+    calendar.weekdays = 1U << 1;
+    schedr_calendar_compile(&calendar);
+
+    ssct_assert_true(next_after(utc(2026, 10, 18, 0, 0)) == utc(2044, 2, 29, 0, 0));
+}
+
+static void next_should_fire_when_clocks_are_put_forward_past_time()
+{
+    set_timezone("Europe/Stockholm");
+
+    // 2:30 does not exist on 2026-03-29, the clocks go from 2:00 to 3:00, at 01:00 UTC
+    calendar.hours = 1U << 2;
+    calendar.minutes = 1ULL << 30;
+    schedr_calendar_compile(&calendar);
+
+    ssct_assert_true(next_after(utc(2026, 3, 28, 12, 0)) == utc(2026, 3, 29, 1, 0));
+    ssct_assert_true(next_after(utc(2026, 3, 29, 1, 0)) == utc(2026, 3, 30, 0, 30));
+}
+
+static void next_should_fire_once_when_time_happens_twice()
+{
+    set_timezone("Europe/Stockholm");
+
+    // 2:30 happens twice on 2026-10-25, the clocks go back from 3:00 to 2:00 at 01:00 UTC
+    calendar.hours = 1U << 2;
+    calendar.minutes = 1ULL << 30;
+    schedr_calendar_compile(&calendar);
+
+    ssct_assert_true(next_after(utc(2026, 10, 24, 12, 0)) == utc(2026, 10, 25, 0, 30));
+    ssct_assert_true(next_after(utc(2026, 10, 25, 0, 30)) == utc(2026, 10, 26, 1, 30));
+}
+
+static void hourly_calendar_should_skip_missing_hour_and_fire_in_both_repeated_ones()
+{
+    set_timezone("Europe/Stockholm");
+
+    calendar.hours = SCHEDR_CALENDAR_ALL_HOURS;
+    calendar.minutes = 1ULL << 30;
+    schedr_calendar_compile(&calendar);
+
+    // 1:30 CET, then 3:30 CEST
+    ssct_assert_true(next_after(utc(2026, 3, 29, 0, 0)) == utc(2026, 3, 29, 0, 30));
+    ssct_assert_true(next_after(utc(2026, 3, 29, 0, 30)) == utc(2026, 3, 29, 1, 30));
+
+    // 2:30 CEST, 2:30 CET, 3:30 CET
+    ssct_assert_true(next_after(utc(2026, 10, 24, 23, 45)) == utc(2026, 10, 25, 0, 30));
+    ssct_assert_true(next_after(utc(2026, 10, 25, 0, 30)) == utc(2026, 10, 25, 1, 30));
+    ssct_assert_true(next_after(utc(2026, 10, 25, 1, 30)) == utc(2026, 10, 25, 2, 30));
+}
+
+static void next_should_agree_with_search_minute_by_minute()
+{
+    static const char *ZONES[] = { "UTC", "Asia/Kolkata", "America/Los_Angeles" };
+
+    bool agrees = true;
+
+    srand(11);
+
+    for (int i = 0; i < AGREEMENT_CALENDARS && agrees; i++)
+    {
+        setup();
+        set_timezone(ZONES[i % 3]);
+        calendar.minutes = (1ULL << (rand() % 60)) | (1ULL << (rand() % 60));
+        calendar.hours = (1U << (rand() % 24)) | (1U << (rand() % 24));
+        calendar.weekdays = (rand() % 2 == 0) ? SCHEDR_CALENDAR_ALL_WEEKDAYS : (uint8_t)(1U << (rand() % 7));
+        calendar.days = (rand() % 2 == 0) ? SCHEDR_CALENDAR_ALL_DAYS : (uint32_t)((1U << (1 + rand() % 28)) | (1U << (1 + rand() % 31)));
+
+        // Hours the clocks skip or repeat are left out, they are covered above
+        calendar.hours &= ~((1U << 1) | (1U << 2));
+        calendar.hours |= (calendar.hours == 0) ? (1U << 12) : 0;
+
+        if (schedr_calendar_compile(&calendar) != SCHEDR_SUCCESS) { continue; }
+
+        time_t after = utc(2026, 1, 1, 0, 0) + (time_t)(rand() % (365 * 24 * 60)) * 60 + rand() % 60;
+        time_t expected = after - after % 60 + 60;
+        time_t next = 0;
+
+        for (int j = 0; j < MAX_BRUTE_FORCE_MINUTES && !fires_at(expected); j++) { expected += 60; }
+
+        agrees = schedr_calendar_next(&calendar, after, &next) == SCHEDR_SUCCESS && (next == expected || !fires_at(expected));
+    }
+
+    ssct_assert_true(agrees);
+}
+
+static void functions_should_return_error_when_arguments_are_invalid()
+{
+    Calendar unset;
+    time_t next;
+
+    schedr_calendar_init(&unset);
+
+    ssct_assert_equals(schedr_calendar_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_calendar_compile(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_calendar_compile(&unset), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_calendar_next(NULL, 0, &next), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_calendar_next(&calendar, 0, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_calendar_next(&unset, 0, &next), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_false(schedr_calendar_is_set(&unset));
+    ssct_assert_false(schedr_calendar_is_set(NULL));
+    ssct_assert_true(schedr_calendar_equal(NULL, NULL));
+    ssct_assert_false(schedr_calendar_equal(&calendar, NULL));
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(compile_should_reject_calendars_that_never_fire);
+    ssct_run(next_should_find_next_time_calendar_fires_at);
+    ssct_run(next_should_find_leap_day_on_weekday_decades_ahead);
+    ssct_run(next_should_fire_when_clocks_are_put_forward_past_time);
+    ssct_run(next_should_fire_once_when_time_happens_twice);
+    ssct_run(hourly_calendar_should_skip_missing_hour_and_fire_in_both_repeated_ones);
+    ssct_run(next_should_agree_with_search_minute_by_minute);
+    ssct_run(functions_should_return_error_when_arguments_are_invalid);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,8 @@
 #include "schedr_job.h"
 #include "schedr_status_codes.h"
 
+#define NANOSECS_PER_SEC 1000000000LL
+
 static Job *jobs_actual;
 static int jobs_actual_len;
 static char *conf_file = NULL;
@@ -14,6 +16,7 @@ static void setup()
 {
     jobs_actual = NULL;
     jobs_actual_len = 0;
+    conf_file = NULL;
 }
 
 static void teardown()
@@ -53,7 +56,7 @@ static bool job_arrays_equal(const Job *const arr1, size_t arr1_len, const Job *
     {
         if (strcmp(arr1[i].name, arr2[i].name) != 0) { return false; }
         if (strcmp(arr1[i].command, arr2[i].command) != 0) { return false; }
-        if (arr1[i].interval_seconds != arr2[i].interval_seconds) { return false; }
+        if (arr1[i].interval_ns != arr2[i].interval_ns) { return false; }
         if (arr1[i].state != arr2[i].state) { return false; }
     }
 
@@ -66,17 +69,17 @@ static void load_jobs_should_load_correct_values()
     static const size_t TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
 
     static const Job expected[] = {
-        {.name = "echo_every_10_s", .command = "echo 'testing interval every 10 s'", .interval_seconds = 10, .state = Stopped },
-        {.name = "echo_every_10_sec", .command = "echo 'testing interval every 10 sec'", .interval_seconds = 10, .state = Stopped },
-        {.name = "echo_every_10_seconds", .command = "echo 'testing interval every 10 seconds'", .interval_seconds = 10, .state = Stopped },
-        {.name = "echo_every_second", .command = "echo 'testing interval every second'", .interval_seconds = 1, .state = Stopped },
-        {.name = "echo_every_5_m", .command = "echo 'testing interval every 5 m'", .interval_seconds = 300, .state = Stopped },
-        {.name = "echo_every_5_min", .command = "echo 'testing interval every 5 min'", .interval_seconds = 300, .state = Stopped },
-        {.name = "echo_every_5_minutes", .command = "echo 'testing interval every 5 minutes'", .interval_seconds = 300, .state = Stopped },
-        {.name = "echo_every_minute", .command = "echo 'testing interval every minute'", .interval_seconds = 60, .state = Stopped },
-        {.name = "echo_every_2_h", .command = "echo 'testing interval every 2 h'", .interval_seconds = 7200, .state = Stopped },
-        {.name = "echo_every_2_hours", .command = "echo 'testing interval every 2 hours'", .interval_seconds = 7200, .state = Stopped },
-        {.name = "echo_every_hour", .command = "echo 'testing interval every hour'", .interval_seconds = 3600, .state = Stopped}
+        {.name = "echo_every_10_s", .command = "echo 'testing interval every 10 s'", .interval_ns = 10 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_10_sec", .command = "echo 'testing interval every 10 sec'", .interval_ns = 10 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_10_seconds", .command = "echo 'testing interval every 10 seconds'", .interval_ns = 10 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_second", .command = "echo 'testing interval every second'", .interval_ns = 1 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_5_m", .command = "echo 'testing interval every 5 m'", .interval_ns = 300 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_5_min", .command = "echo 'testing interval every 5 min'", .interval_ns = 300 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_5_minutes", .command = "echo 'testing interval every 5 minutes'", .interval_ns = 300 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_minute", .command = "echo 'testing interval every minute'", .interval_ns = 60 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_2_h", .command = "echo 'testing interval every 2 h'", .interval_ns = 7200 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_2_hours", .command = "echo 'testing interval every 2 hours'", .interval_ns = 7200 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "echo_every_hour", .command = "echo 'testing interval every hour'", .interval_ns = 3600 * NANOSECS_PER_SEC, .state = Stopped}
     };
     static const int expected_len = sizeof (expected) / sizeof (Job);
 
@@ -209,9 +212,9 @@ static void load_jobs_should_load_config_file_case_insensitive()
     static const int expected_len = 3;
     
     static const Job expected_jobs[] = {
-        {.name = "all lowercase", .command = "echo 'lowercase'", .interval_seconds = 10, .state = Stopped },
-        {.name = "ALL UPPERCASE", .command = "echo 'AAAAAHHHHHH'", .interval_seconds = 600, .state = Stopped },
-        {.name = "MiXeD CaSe", .command = "echo 'MiXeD CaSe'", .interval_seconds = 3600, .state = Stopped }
+        {.name = "all lowercase", .command = "echo 'lowercase'", .interval_ns = 10 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "ALL UPPERCASE", .command = "echo 'AAAAAHHHHHH'", .interval_ns = 600 * NANOSECS_PER_SEC, .state = Stopped },
+        {.name = "MiXeD CaSe", .command = "echo 'MiXeD CaSe'", .interval_ns = 3600 * NANOSECS_PER_SEC, .state = Stopped }
     };
     
     conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
@@ -223,6 +226,438 @@ static void load_jobs_should_load_config_file_case_insensitive()
     ssct_assert_equals(status, SCHEDR_SUCCESS);
 }
 
+static void load_jobs_should_compile_simple_commands()
+{
+    static const char TEST_CONF[] = "test_simple_commands.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 3);
+    ssct_assert_equals(jobs_actual[0].argc, 2);
+    ssct_assert_zero(jobs_actual[1].argc);
+    ssct_assert_zero(jobs_actual[2].argc);
+}
+
+static void load_jobs_should_load_job_timing()
+{
+    static const char TEST_CONF[] = "test_timing.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 3);
+    ssct_assert_equals(jobs_actual[0].timing, FixedDelay);
+    ssct_assert_equals(jobs_actual[1].timing, FixedRate);
+    ssct_assert_equals(jobs_actual[2].timing, FixedDelay);
+    ssct_assert_equals(jobs_actual[1].interval_ns, 10 * NANOSECS_PER_SEC);
+}
+
+static void load_jobs_should_load_sub_second_intervals()
+{
+    static const char TEST_CONF[] = "test_sub_second.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 5);
+    ssct_assert_equals(jobs_actual[0].interval_ns, 250000000LL);
+    ssct_assert_equals(jobs_actual[1].interval_ns, 100000000LL);
+    ssct_assert_equals(jobs_actual[2].interval_ns, 500000LL);
+    ssct_assert_equals(jobs_actual[3].interval_ns, 1000000LL);
+    ssct_assert_equals(jobs_actual[4].interval_ns, 120 * NANOSECS_PER_SEC);
+}
+
+static void load_should_load_max_concurrent_and_job_weights()
+{
+    static const char TEST_CONF[] = "test_concurrency.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.max_concurrent, 4);
+    ssct_assert_equals(settings.output_len, SCHEDR_OUTPUT_DEFAULT_RING_LEN);
+    ssct_assert_equals(jobs_actual_len, 2);
+    ssct_assert_equals(jobs_actual[0].weight, 1);
+    ssct_assert_equals(jobs_actual[1].weight, 3);
+}
+
+static void load_should_return_config_format_error_when_setting_follows_a_job()
+{
+    static const char TEST_CONF[] = "test_late_setting.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    ssct_assert_equals(schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file), SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(schedr_config_load(NULL, &jobs_actual, &jobs_actual_len, conf_file), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void load_should_return_config_format_error_when_two_jobs_have_same_name()
+{
+    static const char TEST_CONF[] = "test_duplicate_names.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    ssct_assert_equals(schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file), SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_true(jobs_actual == NULL);
+}
+
+static void load_should_load_output_buffer_len()
+{
+    static const char TEST_CONF[] = "test_output_buffer.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.output_len, 64 * 1024);
+    ssct_assert_equals(jobs_actual_len, 1);
+}
+
+static void load_should_load_log_rotation()
+{
+    static const char TEST_CONF[] = "test_log_rotation.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.log_rotation.max_file_len, 50 * 1024 * 1024);
+    ssct_assert_equals(settings.log_rotation.max_age_ns, 12 * 3600 * 1000000000LL);
+    ssct_assert_equals(settings.log_rotation.keep, 3);
+    ssct_assert_equals(settings.loop_backend, LoopEpoll);
+    ssct_assert_zero(settings.metrics_port);
+    ssct_assert_equals(jobs_actual_len, 1);
+}
+
+static void load_jobs_should_load_retry_policies()
+{
+    static const char TEST_CONF[] = "test_retry.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    static const int64_t SEC = 1000000000LL;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 3);
+    ssct_assert_equals(jobs_actual[0].retry.max_attempts, 5);
+    ssct_assert_equals(jobs_actual[0].retry.backoff_ns, 2 * SEC);
+    ssct_assert_equals(jobs_actual[0].retry.max_backoff_ns, 60 * SEC);
+    ssct_assert_equals(jobs_actual[0].retry.jitter_percent, 10);
+    ssct_assert_equals(jobs_actual[0].retry.cooldown_ns, 300 * SEC);
+    ssct_assert_equals(jobs_actual[0].interval_ns, 10 * SEC);
+    ssct_assert_equals(jobs_actual[1].retry.max_attempts, 3);
+    ssct_assert_equals(jobs_actual[1].retry.max_backoff_ns, 600 * SEC);
+    ssct_assert_equals(jobs_actual[1].retry.jitter_percent, SCHEDR_RETRY_DEFAULT_JITTER_PERCENT);
+    ssct_assert_zero(jobs_actual[1].retry.cooldown_ns);
+    ssct_assert_zero(jobs_actual[2].retry.max_attempts);
+}
+
+static void load_jobs_should_load_limits()
+{
+    static const char TEST_CONF[] = "test_limits.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 3);
+    ssct_assert_equals(jobs_actual[0].limits.cpu_percent, 250);
+    ssct_assert_equals(jobs_actual[0].limits.memory_bytes, 512LL * 1024 * 1024);
+    ssct_assert_equals(jobs_actual[0].limits.io_weight, 100);
+    ssct_assert_equals(jobs_actual[0].limits.pids, 64);
+    ssct_assert_equals(jobs_actual[0].interval_ns, 3600LL * 1000000000LL);
+    ssct_assert_equals(jobs_actual[1].limits.memory_bytes, 2LL * 1024 * 1024 * 1024);
+    ssct_assert_zero(jobs_actual[1].limits.cpu_percent);
+    ssct_assert_false(schedr_limits_are_set(&(jobs_actual[2].limits)));
+}
+
+static void load_should_load_placement_of_daemon_and_jobs()
+{
+    static const char TEST_CONF[] = "test_placement.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    static const char NODE_DIR[] = "nodes";
+    
+    Settings settings;
+    char *node_dir = get_test_resource(NODE_DIR, sizeof (NODE_DIR) - 1);
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+    
+    schedr_limits_set_node_dir(node_dir);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    schedr_limits_reset_node_dir();
+    free(node_dir);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 3);
+    ssct_assert_equals(settings.daemon_limits.cpus[0], 0x3ULL);
+    ssct_assert_equals(jobs_actual[0].limits.cpus[0], 0x2F0ULL);
+    ssct_assert_true(jobs_actual[0].limits.nice_set);
+    ssct_assert_equals(jobs_actual[0].limits.nice, 10);
+    ssct_assert_equals(jobs_actual[0].limits.io_priority_class, IoPriorityIdle);
+    
+    // The CPUs of the node are used when the job has none of its own
+    ssct_assert_equals(jobs_actual[1].limits.numa_nodes, 0x2ULL);
+    ssct_assert_equals(jobs_actual[1].limits.cpus[0], 0xCULL);
+    ssct_assert_equals(jobs_actual[1].limits.nice, -5);
+    ssct_assert_equals(jobs_actual[1].limits.io_priority_class, IoPriorityBestEffort);
+    ssct_assert_equals(jobs_actual[1].limits.io_priority_level, 7);
+    ssct_assert_false(schedr_limits_are_set(&(jobs_actual[1].limits)));
+    ssct_assert_false(schedr_limits_have_placement(&(jobs_actual[2].limits)));
+}
+
+static void load_should_load_loop_backend()
+{
+    static const char TEST_CONF[] = "test_loop_backend.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.loop_backend, LoopUring);
+    ssct_assert_equals(jobs_actual_len, 1);
+}
+
+static void load_should_load_metrics_port()
+{
+    static const char TEST_CONF[] = "test_metrics.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.metrics_port, 9464);
+    ssct_assert_equals(jobs_actual_len, 1);
+}
+
+static void parse_job_should_parse_one_job_written_on_one_line()
+{
+    Job job;
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"Added\" run `/bin/echo added` every 5 min"), SCHEDR_SUCCESS);
+    ssct_assert_true(strcmp(job.name, "Added") == 0);
+    ssct_assert_true(strcmp(job.command, "/bin/echo added") == 0);
+    ssct_assert_true(job.interval_ns == 5 * 60 * NANOSECS_PER_SEC);
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"Added\" run `/bin/true`"), SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"A\" run `/bin/true` every 1 h Job \"B\" run `/bin/true` every 1 h"),
+                       SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(schedr_config_parse_job(NULL, "Job \"Added\" run `/bin/true` every 1 h"), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_config_parse_job(&job, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void load_jobs_should_load_overlap_policies()
+{
+    static const char TEST_CONF[] = "test_overlap.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 4);
+    ssct_assert_equals(jobs_actual[0].overlap, OverlapWait);
+    ssct_assert_equals(jobs_actual[1].overlap, OverlapSkip);
+    ssct_assert_equals(jobs_actual[2].overlap, OverlapQueue);
+    ssct_assert_equals(jobs_actual[2].timing, FixedRate);
+    ssct_assert_equals(jobs_actual[3].overlap, OverlapParallel);
+    ssct_assert_equals(jobs_actual[3].max_parallel, 3);
+}
+
+static void load_jobs_should_load_triggers()
+{
+    static const char TEST_CONF[] = "test_when.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 2);
+    ssct_assert_true(strcmp(jobs_actual[0].monitor, "nmcli device monitor") == 0);
+    ssct_assert_true(strcmp(jobs_actual[0].pattern, "wlan0: (connected|disconnected)$") == 0);
+    ssct_assert_true(jobs_actual[0].interval_ns == 0);
+    ssct_assert_true(strcmp(jobs_actual[1].monitor, "journalctl -f") == 0);
+    ssct_assert_true(jobs_actual[1].interval_ns == 3600 * NANOSECS_PER_SEC);
+}
+
+static void parse_job_should_reject_words_that_only_start_with_a_keyword()
+{
+    static const char *MISSPELLED[] = {
+        "Job \"T\" run `true` every 1 h once overlap skip",
+        "Job \"T\" run `true` every 1 h ion weight 100",
+        "maximum concurrent 2 Job \"T\" run `true` every 1 h",
+        "logging size 1 MB Job \"T\" run `true` every 1 h",
+        "Jobs \"T\" run `true` every 1 h",
+    };
+
+    Job job;
+
+    for (int i = 0; i < 5; i++) { ssct_assert_equals(schedr_config_parse_job(&job, MISSPELLED[i]), SCHEDR_ERROR_CONFIG_FORMAT); }
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` every 1 h ON OVERLAP skip"), SCHEDR_SUCCESS);
+}
+
+static void parse_job_should_parse_job_with_trigger_and_reject_invalid_ones()
+{
+    Job job;
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` when `tail -f log` outputs \"fail\""), SCHEDR_SUCCESS);
+    ssct_assert_true(strcmp(job.monitor, "tail -f log") == 0);
+    ssct_assert_true(strcmp(job.pattern, "fail") == 0);
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` when `tail -f log` prints \"fail\""), 
+                       SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` when `tail -f log` outputs \"(fail\""), 
+                       SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` when `tail -f log` outputs"), SCHEDR_ERROR_CONFIG_FORMAT);
+}
+
+static void load_jobs_should_load_calendars()
+{
+    static const char TEST_CONF[] = "test_calendar.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load_jobs(&jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(jobs_actual_len, 5);
+
+    // 12 am is midnight
+    ssct_assert_true(jobs_actual[0].interval_ns == 0);
+    ssct_assert_true(jobs_actual[0].calendar.weekdays == 1U << 5);
+    ssct_assert_true(jobs_actual[0].calendar.hours == 1U << 0 && jobs_actual[0].calendar.minutes == 1ULL << 0);
+    ssct_assert_true(jobs_actual[0].calendar.days == SCHEDR_CALENDAR_ALL_DAYS);
+
+    ssct_assert_true(jobs_actual[1].calendar.hours == SCHEDR_CALENDAR_ALL_HOURS);
+    ssct_assert_true(jobs_actual[1].calendar.minutes == ((1ULL << 15) | (1ULL << 45)));
+
+    ssct_assert_true(jobs_actual[2].calendar.weekdays == 0x3e);
+    ssct_assert_true(jobs_actual[2].calendar.hours == ((1U << 9) | (1U << 17)));
+
+    ssct_assert_true(jobs_actual[3].calendar.days == 1U << 1);
+    ssct_assert_true(jobs_actual[3].calendar.months == ((1U << 1) | (1U << 4) | (1U << 7) | (1U << 10)));
+    ssct_assert_true(jobs_actual[3].calendar.hours == 1U << 12);
+    ssct_assert_true(jobs_actual[3].splay_ns == 600 * NANOSECS_PER_SEC);
+
+    // A bare hour is still an interval
+    ssct_assert_false(schedr_calendar_is_set(&(jobs_actual[4].calendar)));
+    ssct_assert_true(jobs_actual[4].interval_ns == 3600 * NANOSECS_PER_SEC);
+}
+
+static void parse_job_should_parse_calendars_and_reject_invalid_ones()
+{
+    static const char *INVALID[] = {
+        "Job \"T\" run `true` every fridays",
+        "Job \"T\" run `true` every friday at",
+        "Job \"T\" run `true` every friday at 13 pm",
+        "Job \"T\" run `true` every friday at 9:00, 17:30",
+        "Job \"T\" run `true` every friday at noon am",
+        "Job \"T\" run `true` every day at 9:5",
+        "Job \"T\" run `true` every 30th in february",
+        "Job \"T\" run `true` every 1th",
+        "Job \"T\" run `true` every 5th-1st",
+        "Job \"T\" run `true` every hour at 9:15",
+        "Job \"T\" run `true` every monday, in june",
+        NULL
+    };
+
+    Job job;
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` every friday 13th at 9:30pm"), SCHEDR_SUCCESS);
+    ssct_assert_true(job.calendar.weekdays == 1U << 5 && job.calendar.days == 1U << 13);
+    ssct_assert_true(job.calendar.hours == 1U << 21 && job.calendar.minutes == 1ULL << 30);
+
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` every sat-mon in dec-feb at midnight, 6"), SCHEDR_SUCCESS);
+    ssct_assert_true(job.calendar.weekdays == ((1U << 6) | (1U << 0) | (1U << 1)));
+    ssct_assert_true(job.calendar.months == ((1U << 12) | (1U << 1) | (1U << 2)));
+    ssct_assert_true(job.calendar.hours == ((1U << 0) | (1U << 6)));
+
+    // The last schedule of a job is the one it runs on
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` every weekday every 5 min"), SCHEDR_SUCCESS);
+    ssct_assert_false(schedr_calendar_is_set(&(job.calendar)));
+    ssct_assert_equals(schedr_config_parse_job(&job, "Job \"T\" run `true` every 5 min every weekend"), SCHEDR_SUCCESS);
+    ssct_assert_true(job.interval_ns == 0 && job.calendar.weekdays == ((1U << 0) | (1U << 6)));
+
+    for (int i = 0; INVALID[i] != NULL; i++)
+    {
+        ssct_assert_equals(schedr_config_parse_job(&job, INVALID[i]), SCHEDR_ERROR_CONFIG_FORMAT);
+    }
+}
+
+static void load_should_load_splay_of_jobs_and_default_splay()
+{
+    static const char TEST_CONF[] = "test_splay.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.splay_ns, 30 * NANOSECS_PER_SEC);
+    ssct_assert_equals(settings.splay_mode, SplayRandom);
+    ssct_assert_equals(jobs_actual_len, 2);
+    ssct_assert_equals(jobs_actual[0].splay_ns, 30 * NANOSECS_PER_SEC);
+    ssct_assert_equals(jobs_actual[1].splay_ns, 500000000LL);
+}
+
+static void load_should_default_to_hashed_splay()
+{
+    static const char TEST_CONF[] = "test_splay_hashed.conf";
+    static const int TEST_CONF_LEN = sizeof (TEST_CONF) - 1;
+    
+    Settings settings;
+    conf_file = get_test_resource(TEST_CONF, TEST_CONF_LEN);
+
+    Status status = schedr_config_load(&settings, &jobs_actual, &jobs_actual_len, conf_file);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(settings.splay_mode, SplayHashed);
+    ssct_assert_equals(jobs_actual_len, 1);
+    ssct_assert_equals(jobs_actual[0].splay_ns, 60 * NANOSECS_PER_SEC);
+    ssct_assert_true(strcmp(jobs_actual[0].name, "default") == 0);
+}
+
 int main(void) 
 {
     ssct_setup = setup;
@@ -238,6 +673,28 @@ int main(void)
     ssct_run(load_jobs_should_return_invalid_argument_error_when_file_is_directory);
     ssct_run(load_jobs_should_return_failure_when_unlikely_open_file_error_occurs);
     ssct_run(load_jobs_should_load_config_file_case_insensitive);
+    ssct_run(load_jobs_should_compile_simple_commands);
+    ssct_run(load_jobs_should_load_job_timing);
+    ssct_run(load_jobs_should_load_sub_second_intervals);
+    ssct_run(load_should_load_max_concurrent_and_job_weights);
+    ssct_run(load_should_load_output_buffer_len);
+    ssct_run(load_should_load_log_rotation);
+    ssct_run(load_should_load_loop_backend);
+    ssct_run(load_should_load_metrics_port);
+    ssct_run(parse_job_should_parse_one_job_written_on_one_line);
+    ssct_run(load_jobs_should_load_retry_policies);
+    ssct_run(load_jobs_should_load_limits);
+    ssct_run(load_should_load_placement_of_daemon_and_jobs);
+    ssct_run(load_jobs_should_load_overlap_policies);
+    ssct_run(load_jobs_should_load_triggers);
+    ssct_run(parse_job_should_reject_words_that_only_start_with_a_keyword);
+    ssct_run(parse_job_should_parse_job_with_trigger_and_reject_invalid_ones);
+    ssct_run(load_jobs_should_load_calendars);
+    ssct_run(parse_job_should_parse_calendars_and_reject_invalid_ones);
+    ssct_run(load_should_load_splay_of_jobs_and_default_splay);
+    ssct_run(load_should_default_to_hashed_splay);
+    ssct_run(load_should_return_config_format_error_when_setting_follows_a_job);
+    ssct_run(load_should_return_config_format_error_when_two_jobs_have_same_name);
 
     ssct_print_summary();
 
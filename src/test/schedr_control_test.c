@@ -0,0 +1,247 @@
+#include <stdlib.h>         // EXIT_SUCCESS, free()
+#include <stdio.h>          // FILE, open_memstream(), fclose(), snprintf()
+#include <string.h>         // strlen(), strstr(), memset()
+#include <stdbool.h>        // bool
+#include <unistd.h>         // fork(), getpid(), usleep(), _exit()
+#include <signal.h>         // kill(), SIGTERM
+#include <sys/wait.h>       // waitpid()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_control.h"
+#include "schedr_scheduler.h"
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define REQUEST_ATTEMPTS 500
+#define REQUEST_RETRY_US 10000
+
+static char socket_path[64];
+static char *out_buf;
+static size_t out_len;
+static char *err_buf;
+static size_t err_len;
+static FILE *out;
+static FILE *err;
+static pid_t daemon_pid;
+
+static void setup()
+{
+    snprintf(socket_path, sizeof (socket_path), "/tmp/schedr_control_test_%d.sock", (int)getpid());
+    out = open_memstream(&out_buf, &out_len);
+    err = open_memstream(&err_buf, &err_len);
+    daemon_pid = 0;
+}
+
+static void teardown()
+{
+    if (daemon_pid > 0)
+    {
+        kill(daemon_pid, SIGTERM);
+        waitpid(daemon_pid, NULL, 0);
+    }
+
+    fclose(out);
+    fclose(err);
+    free(out_buf);
+    free(err_buf);
+    unlink(socket_path);
+}
+
+/*
+ * Starts a daemon serving the control socket with a job writing "hello" every
+ * 50 milliseconds.
+ */
+static void start_daemon()
+{
+    daemon_pid = fork();
+
+    if (daemon_pid != 0) { return; }
+
+    static Job job;
+    static JobIndex jobs;
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Greeter", strlen("Greeter"));
+    schedr_job_set_command(&job, "/bin/echo hello", strlen("/bin/echo hello"));
+    schedr_job_compile_command(&job);
+    schedr_job_set_interval(&job, NANOSECS_PER_SEC / 20);
+
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_job_index_init(&jobs);
+    schedr_job_index_add(&jobs, &job, false);
+
+    if (schedr_control_open(socket_path, &jobs, NULL) != SCHEDR_SUCCESS) { _exit(EXIT_FAILURE); }
+
+    schedr_scheduler_run();
+
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Sends 'request' until the daemon has started and the output contains
+ * 'expected', which may be empty if the command prints nothing.
+ */
+static Status request_until(const char *request, const char *expected)
+{
+    Status status = SCHEDR_FAILURE;
+
+    for (int i = 0; i < REQUEST_ATTEMPTS; i++)
+    {
+        rewind(out);
+        rewind(err);
+        status = schedr_control_request(socket_path, request, out, err);
+        fflush(out);
+        fflush(err);
+
+        bool found = (expected[0] == '\0') ||
+                     ((status == SCHEDR_SUCCESS) ? (out_len > 0 && strstr(out_buf, expected) != NULL)
+                                                 : (err_len > 0 && strstr(err_buf, expected) != NULL));
+
+        if (status != SCHEDR_FAILURE && found) { break; }
+
+        usleep(REQUEST_RETRY_US);
+    }
+
+    return status;
+}
+
+static void open_should_return_error_when_arguments_are_invalid()
+{
+    JobIndex jobs;
+    char long_path[256];
+
+    schedr_job_index_init(&jobs);
+
+    memset(long_path, 'a', sizeof (long_path) - 1);
+    long_path[sizeof (long_path) - 1] = '\0';
+
+    ssct_assert_equals(schedr_control_open(NULL, &jobs, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_control_open(socket_path, NULL, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_control_open(long_path, &jobs, NULL), SCHEDR_ERROR_BUFFER_OVERFLOW);
+}
+
+static void request_should_return_error_when_arguments_are_invalid()
+{
+    char long_request[SCHEDR_CONTROL_MAX_REQUEST_LEN + 1];
+
+    memset(long_request, 'a', sizeof (long_request) - 1);
+    long_request[sizeof (long_request) - 1] = '\0';
+
+    ssct_assert_equals(schedr_control_request(NULL, "tail x", out, err), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_control_request(socket_path, NULL, out, err), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_control_request(socket_path, "tail x", NULL, err), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_control_request(socket_path, long_request, out, err), SCHEDR_ERROR_BUFFER_OVERFLOW);
+}
+
+static void request_should_return_failure_when_daemon_is_not_running()
+{
+    ssct_assert_equals(schedr_control_request(socket_path, "tail x", out, err), SCHEDR_FAILURE);
+
+    fflush(err);
+
+    ssct_assert_true(err_len > 0 && strstr(err_buf, "is it running?") != NULL);
+}
+
+static void tail_should_return_output_of_job()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("tail Greeter", " out hello\n"), SCHEDR_SUCCESS);
+    ssct_assert_true(out_len > 0 && strstr(out_buf, " out hello\n") != NULL);
+}
+
+static void tail_should_return_invalid_argument_error_when_job_does_not_exist()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("tail Nobody", "No job named \"Nobody\""), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void status_should_return_state_and_failures_of_job()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("status Greeter", "failures: 0 (0 in a row)\n"), SCHEDR_SUCCESS);
+    ssct_assert_true(strstr(out_buf, "state: running\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "breaker: closed, tripped 0 times\n") != NULL);
+}
+
+static void latency_should_return_percentiles_of_job_and_every_job()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("latency Greeter", "runtime:"), SCHEDR_SUCCESS);
+    ssct_assert_true(strstr(out_buf, "lag:     p50 ") != NULL);
+    ssct_assert_true(strstr(out_buf, "spawn:   p50 ") != NULL);
+    ssct_assert_equals(request_until("latency", "runtime:"), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("latency Nobody", "No job named \"Nobody\""), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void list_should_return_state_and_name_of_every_job()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("list", "Greeter\n"), SCHEDR_SUCCESS);
+    ssct_assert_true(strstr(out_buf, "running  Greeter\n") != NULL);
+}
+
+static void pause_and_resume_should_change_state_of_job()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("pause Greeter", ""), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("status Greeter", "state: paused\n"), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("resume Greeter", ""), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("status Greeter", "state: running\n"), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("pause Nobody", "No job named \"Nobody\""), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void add_should_start_job_and_remove_should_forget_it()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("add Job \"Adder\" run `/bin/echo added` every 1 h", ""), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("list", "Adder\n"), SCHEDR_SUCCESS);
+    ssct_assert_true(strstr(out_buf, "running  Adder\n") != NULL);
+    ssct_assert_equals(request_until("run Adder", ""), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("tail Adder", " out added\n"), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("add Job \"Adder\" run `/bin/true` every 1 h", "There is a job named \"Adder\" already"),
+                       SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(request_until("add Job \"Broken\" every 1 h", "Could not parse the job"), SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(request_until("add Job \"First\" run `/bin/true` every 1 h Job \"Second\" run `/bin/true` every 1 h",
+                                     "Could not parse the job"), SCHEDR_ERROR_CONFIG_FORMAT);
+    ssct_assert_equals(request_until("tail First", "No job named \"First\""), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(request_until("remove Adder", ""), SCHEDR_SUCCESS);
+    ssct_assert_equals(request_until("tail Adder", "No job named \"Adder\""), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void request_should_return_invalid_argument_error_when_command_is_unknown()
+{
+    start_daemon();
+
+    ssct_assert_equals(request_until("frobnicate", "Unknown command"), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(open_should_return_error_when_arguments_are_invalid);
+    ssct_run(request_should_return_error_when_arguments_are_invalid);
+    ssct_run(request_should_return_failure_when_daemon_is_not_running);
+    ssct_run(tail_should_return_output_of_job);
+    ssct_run(tail_should_return_invalid_argument_error_when_job_does_not_exist);
+    ssct_run(status_should_return_state_and_failures_of_job);
+    ssct_run(latency_should_return_percentiles_of_job_and_every_job);
+    ssct_run(list_should_return_state_and_name_of_every_job);
+    ssct_run(pause_and_resume_should_change_state_of_job);
+    ssct_run(add_should_start_job_and_remove_should_forget_it);
+    ssct_run(request_should_return_invalid_argument_error_when_command_is_unknown);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+#include <stdlib.h>         // malloc(), free(), rand(), srand(), EXIT_SUCCESS
+#include <stdint.h>         // uint64_t
+#include <stdbool.h>        // bool, true, false
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_hash.h"
+
+#define STRESS_KEYS 100000
+#define STRESS_OPERATIONS 1000000
+
+static HashMap map;
+
+static void *mock_calloc_will_fail(size_t count, size_t bytes) { return NULL; }
+static uint64_t same_hash(const char *str) { return 42; }
+
+static void setup()
+{
+    schedr_hash_init(&map);
+}
+
+static void teardown()
+{
+    schedr_hash_destroy(&map);
+    schedr_hash_reset_allocator();
+    schedr_hash_reset_string_hash();
+}
+
+static void hash_bytes_should_hash_with_fnv_1a_in_parts()
+{
+    ssct_assert_true(schedr_hash_bytes(SCHEDR_HASH_EMPTY, "", 0) == SCHEDR_HASH_EMPTY);
+    ssct_assert_true(schedr_hash_bytes(SCHEDR_HASH_EMPTY, "a", 1) == 0xaf63dc4c8601ec8cULL);
+    ssct_assert_true(schedr_hash_bytes(schedr_hash_bytes(SCHEDR_HASH_EMPTY, "Back", 4), "up", 2) ==
+                     schedr_hash_bytes(SCHEDR_HASH_EMPTY, "Backup", 6));
+}
+
+static void hash_string_should_tell_apart_strings_that_differ_in_last_character()
+{
+    ssct_assert_true(schedr_hash_string("Job 1") != schedr_hash_string("Job 2"));
+    ssct_assert_true(schedr_hash_string("Job 1") == schedr_hash_string("Job 1"));
+
+    // Mixed, so the low bits used by a small map differ too
+    ssct_assert_true((schedr_hash_string("Job 1") & 0xff) != (schedr_hash_string("Job 2") & 0xff));
+}
+
+static void init_should_return_null_argument_error_when_map_is_null()
+{
+    ssct_assert_equals(schedr_hash_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void get_should_return_null_when_key_is_missing()
+{
+    int value = 0;
+
+    ssct_assert_true(schedr_hash_get(&map, 1) == NULL);
+
+    schedr_hash_put(&map, 2, &value);
+
+    ssct_assert_true(schedr_hash_get(&map, 1) == NULL);
+}
+
+static void get_should_return_value_of_key()
+{
+    int first = 0, second = 0;
+
+    schedr_hash_put(&map, 1, &first);
+    schedr_hash_put(&map, 2, &second);
+
+    ssct_assert_true(schedr_hash_get(&map, 1) == &first);
+    ssct_assert_true(schedr_hash_get(&map, 2) == &second);
+    ssct_assert_equals(map.count, 2);
+}
+
+static void put_should_replace_value_of_existing_key()
+{
+    int first = 0, second = 0;
+
+    schedr_hash_put(&map, 1, &first);
+    schedr_hash_put(&map, 1, &second);
+
+    ssct_assert_true(schedr_hash_get(&map, 1) == &second);
+    ssct_assert_equals(map.count, 1);
+}
+
+static void put_should_return_allocation_failed_error_when_map_can_not_grow()
+{
+    int value = 0;
+
+    schedr_hash_set_allocator(mock_calloc_will_fail);
+
+    ssct_assert_equals(schedr_hash_put(&map, 1, &value), SCHEDR_ERROR_ALLOCATION_FAILED);
+    ssct_assert_zero(map.count);
+}
+
+static void remove_should_only_remove_key()
+{
+    int first = 0, second = 0;
+
+    schedr_hash_put(&map, 1, &first);
+    schedr_hash_put(&map, 2, &second);
+
+    ssct_assert_equals(schedr_hash_remove(&map, 1), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_hash_get(&map, 1) == NULL);
+    ssct_assert_true(schedr_hash_get(&map, 2) == &second);
+    ssct_assert_equals(map.count, 1);
+}
+
+static void remove_should_return_success_when_key_is_missing()
+{
+    ssct_assert_equals(schedr_hash_remove(&map, 1), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_hash_remove(NULL, 1), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void strings_should_tell_apart_keys_of_same_hash()
+{
+    StringHashMap strings;
+    int first = 0, second = 0, third = 0;
+
+    schedr_hash_set_string_hash(same_hash);
+    schedr_hash_strings_init(&strings);
+
+    schedr_hash_strings_put(&strings, "first", &first);
+    schedr_hash_strings_put(&strings, "second", &second);
+    schedr_hash_strings_put(&strings, "third", &third);
+    schedr_hash_strings_put(&strings, "second", &second);
+
+    ssct_assert_equals(strings.count, 3);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "first") == &first);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "second") == &second);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "third") == &third);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "fourth") == NULL);
+
+    // From the middle of the chain, its head and when it is the only one left
+    ssct_assert_equals(schedr_hash_strings_remove(&strings, "second"), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "second") == NULL);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "first") == &first);
+
+    ssct_assert_equals(schedr_hash_strings_remove(&strings, "third"), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "first") == &first);
+
+    ssct_assert_equals(schedr_hash_strings_remove(&strings, "first"), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_hash_strings_get(&strings, "first") == NULL);
+    ssct_assert_zero(strings.count);
+    ssct_assert_zero(strings.by_hash.count);
+
+    schedr_hash_strings_destroy(&strings);
+}
+
+static void map_should_match_reference_after_random_puts_and_removes()
+{
+    // The values are the addresses of 'present', so the map can be checked against it
+    bool *present = (bool *)calloc(STRESS_KEYS, sizeof (bool));
+    size_t expected_count = 0;
+    bool lookups_correct = true;
+
+    srand(7);
+
+    for (int i = 0; i < STRESS_OPERATIONS; i++)
+    {
+        uint64_t key = (uint64_t)(rand() % STRESS_KEYS);
+
+        if (rand() % 2 == 0)
+        {
+            if (!present[key]) { expected_count++; }
+
+            present[key] = true;
+            schedr_hash_put(&map, key, &(present[key]));
+        }
+        else
+        {
+            if (present[key]) { expected_count--; }
+
+            present[key] = false;
+            schedr_hash_remove(&map, key);
+        }
+    }
+
+    for (uint64_t key = 0; key < STRESS_KEYS; key++)
+    {
+        void *expected = present[key] ? &(present[key]) : NULL;
+
+        if (schedr_hash_get(&map, key) != expected) { lookups_correct = false; }
+    }
+
+    ssct_assert_true(lookups_correct);
+    ssct_assert_equals(map.count, expected_count);
+
+    free(present);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(hash_bytes_should_hash_with_fnv_1a_in_parts);
+    ssct_run(hash_string_should_tell_apart_strings_that_differ_in_last_character);
+    ssct_run(init_should_return_null_argument_error_when_map_is_null);
+
+    ssct_run(get_should_return_null_when_key_is_missing);
+    ssct_run(get_should_return_value_of_key);
+
+    ssct_run(put_should_replace_value_of_existing_key);
+    ssct_run(put_should_return_allocation_failed_error_when_map_can_not_grow);
+
+    ssct_run(remove_should_only_remove_key);
+    ssct_run(remove_should_return_success_when_key_is_missing);
+
+    ssct_run(strings_should_tell_apart_keys_of_same_hash);
+    ssct_run(map_should_match_reference_after_random_puts_and_removes);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
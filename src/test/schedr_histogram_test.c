@@ -0,0 +1,161 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <stdint.h>         // int64_t
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_histogram.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+
+static Histogram histogram;
+
+static void setup() { schedr_histogram_init(&histogram); }
+static void teardown() { schedr_histogram_forget_latency(NULL); }
+
+static void init_should_give_empty_histogram()
+{
+    ssct_assert_zero(histogram.count);
+    ssct_assert_zero(schedr_histogram_percentile(&histogram, 50.0));
+    ssct_assert_zero(schedr_histogram_percentile(NULL, 50.0));
+    ssct_assert_equals(schedr_histogram_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+
+    // Nothing to record into
+    schedr_histogram_record(NULL, 1);
+}
+
+static void record_should_keep_count_sum_min_and_max()
+{
+    schedr_histogram_record(&histogram, 300);
+    schedr_histogram_record(&histogram, 100);
+    schedr_histogram_record(&histogram, 200);
+
+    ssct_assert_equals(histogram.count, 3);
+    ssct_assert_equals(histogram.sum_ns, 600);
+    ssct_assert_equals(histogram.min_ns, 100);
+    ssct_assert_equals(histogram.max_ns, 300);
+}
+
+static void record_should_count_negative_values_as_zero()
+{
+    schedr_histogram_record(&histogram, -5);
+
+    ssct_assert_zero(histogram.min_ns);
+    ssct_assert_zero(histogram.max_ns);
+    ssct_assert_equals(histogram.buckets[0], 1);
+}
+
+static void percentile_should_be_exact_for_small_values()
+{
+    for (int64_t i = 1; i <= 10; i++) { schedr_histogram_record(&histogram, i); }
+
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 50.0), 5);
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 90.0), 9);
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 100.0), 10);
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 0.0), 1);
+}
+
+static void percentile_should_be_within_bucket_precision()
+{
+    static const int64_t VALUES[] = { 1000, 12345, 999999, 3 * NANOSECS_PER_SEC, 3600 * NANOSECS_PER_SEC };
+
+    for (int i = 0; i < 5; i++)
+    {
+        schedr_histogram_init(&histogram);
+
+        // A larger value keeps the maximum from capping the bucket
+        schedr_histogram_record(&histogram, VALUES[i]);
+        schedr_histogram_record(&histogram, VALUES[i] * 4);
+
+        int64_t value = schedr_histogram_percentile(&histogram, 50.0);
+
+        ssct_assert_true(value >= VALUES[i]);
+        ssct_assert_true(value - VALUES[i] <= VALUES[i] / SCHEDR_HISTOGRAM_SUB_BUCKETS);
+    }
+}
+
+static void percentile_should_not_exceed_max()
+{
+    schedr_histogram_record(&histogram, 1000);
+
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 50.0), 1000);
+}
+
+static void record_should_count_values_beyond_range_in_last_bucket()
+{
+    int64_t day_ns = 24 * 3600 * NANOSECS_PER_SEC;
+
+    schedr_histogram_record(&histogram, day_ns);
+    schedr_histogram_record(&histogram, INT64_MAX);
+
+    ssct_assert_equals(histogram.buckets[SCHEDR_HISTOGRAM_BUCKETS - 1], 2);
+    ssct_assert_equals(histogram.max_ns, INT64_MAX);
+    ssct_assert_equals(schedr_histogram_percentile(&histogram, 100.0), INT64_MAX);
+}
+
+static void count_at_or_below_should_count_values_up_to_every_bound()
+{
+    static const int64_t BOUNDS[] = { 5, 100, 1000, NANOSECS_PER_SEC, 10 * NANOSECS_PER_SEC };
+    uint64_t counts[5];
+
+    for (int64_t i = 1; i <= 10; i++) { schedr_histogram_record(&histogram, i); }
+
+    schedr_histogram_record(&histogram, 2 * NANOSECS_PER_SEC);
+    schedr_histogram_count_at_or_below(&histogram, BOUNDS, 5, counts);
+
+    ssct_assert_equals(counts[0], 5);
+    ssct_assert_equals(counts[1], 10);
+    ssct_assert_equals(counts[2], 10);
+    ssct_assert_equals(counts[3], 10);
+    ssct_assert_equals(counts[4], 11);
+
+    schedr_histogram_count_at_or_below(NULL, BOUNDS, 5, counts);
+
+    ssct_assert_zero(counts[4]);
+}
+
+static void record_start_should_count_run_for_job_and_for_every_job()
+{
+    Job job;
+    Job other;
+
+    ssct_assert_true(schedr_histogram_get_latency(NULL) == NULL);
+
+    schedr_histogram_record_start(&job, 10, 1);
+    schedr_histogram_record_start(&other, 20, 2);
+    schedr_histogram_record_runtime(&job, 100);
+
+    const JobLatency *latency = schedr_histogram_get_latency(&job);
+    const JobLatency *all = schedr_histogram_get_latency(NULL);
+
+    ssct_assert_true(latency != NULL && all != NULL);
+    ssct_assert_equals(latency->lag.count, 1);
+    ssct_assert_equals(latency->lag.max_ns, 10);
+    ssct_assert_equals(latency->runtime.count, 1);
+    ssct_assert_equals(all->spawn.count, 2);
+    ssct_assert_equals(all->spawn.sum_ns, 3);
+
+    schedr_histogram_forget_latency(&job);
+
+    ssct_assert_true(schedr_histogram_get_latency(&job) == NULL);
+    ssct_assert_true(schedr_histogram_get_latency(&other) != NULL);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(init_should_give_empty_histogram);
+    ssct_run(record_should_keep_count_sum_min_and_max);
+    ssct_run(record_should_count_negative_values_as_zero);
+    ssct_run(percentile_should_be_exact_for_small_values);
+    ssct_run(percentile_should_be_within_bucket_precision);
+    ssct_run(percentile_should_not_exceed_max);
+    ssct_run(record_should_count_values_beyond_range_in_last_bucket);
+    ssct_run(count_at_or_below_should_count_values_up_to_every_bound);
+    ssct_run(record_start_should_count_run_for_job_and_for_every_job);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include <stdlib.h>         // EXIT_SUCCESS, malloc()
+#include <stdio.h>          // snprintf()
+#include <stdint.h>         // uint64_t
+#include <string.h>         // strlen()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_job_index.h"
+#include "schedr_hash.h"
+#include "schedr_job.h"
+
+#define MANY_JOBS 1000
+
+static JobIndex job_index;
+
+static void setup() { schedr_job_index_init(&job_index); }
+
+static void teardown()
+{
+    schedr_job_index_destroy(&job_index);
+    schedr_hash_reset_string_hash();
+}
+
+static uint64_t same_hash(const char *name) { return 42; }
+
+static void init_job(Job *job_p, const char *name)
+{
+    schedr_job_init(job_p);
+    schedr_job_set_name(job_p, name, strlen(name));
+}
+
+static void add_should_make_job_findable_by_name()
+{
+    Job jobs[2];
+
+    init_job(&(jobs[0]), "Backup");
+    init_job(&(jobs[1]), "Cleanup");
+
+    ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[0]), false), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[1]), false), SCHEDR_SUCCESS);
+
+    ssct_assert_true(schedr_job_index_find(&job_index, "Backup") == &(jobs[0]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Cleanup") == &(jobs[1]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Nobody") == NULL);
+    ssct_assert_equals(job_index.len, 2);
+}
+
+static void add_should_return_invalid_argument_error_when_name_is_taken()
+{
+    Job jobs[2];
+
+    init_job(&(jobs[0]), "Backup");
+    init_job(&(jobs[1]), "Backup");
+
+    schedr_job_index_add(&job_index, &(jobs[0]), false);
+
+    ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[1]), false), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_true(schedr_job_index_find(&job_index, "Backup") == &(jobs[0]));
+}
+
+static void remove_should_move_last_job_into_place()
+{
+    Job jobs[3];
+
+    init_job(&(jobs[0]), "First");
+    init_job(&(jobs[1]), "Second");
+    init_job(&(jobs[2]), "Third");
+
+    for (int i = 0; i < 3; i++) { schedr_job_index_add(&job_index, &(jobs[i]), false); }
+
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[0])), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[0])), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    ssct_assert_equals(job_index.len, 2);
+    ssct_assert_true(schedr_job_index_at(&job_index, 0) == &(jobs[2]));
+    ssct_assert_true(schedr_job_index_at(&job_index, 1) == &(jobs[1]));
+    ssct_assert_true(schedr_job_index_at(&job_index, 2) == NULL);
+    ssct_assert_true(schedr_job_index_find(&job_index, "First") == NULL);
+
+    // The moved job can still be removed from its new place
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[2])), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_job_index_at(&job_index, 0) == &(jobs[1]));
+}
+
+static void index_should_tell_apart_names_with_same_hash()
+{
+    Job jobs[3];
+
+    schedr_hash_set_string_hash(same_hash);
+
+    init_job(&(jobs[0]), "First");
+    init_job(&(jobs[1]), "Second");
+    init_job(&(jobs[2]), "Third");
+
+    for (int i = 0; i < 3; i++) { ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[i]), false), SCHEDR_SUCCESS); }
+
+    ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[1]), false), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_true(schedr_job_index_find(&job_index, "First") == &(jobs[0]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Second") == &(jobs[1]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Third") == &(jobs[2]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Fourth") == NULL);
+
+    // From the middle of the chain and from its head
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[1])), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[2])), SCHEDR_SUCCESS);
+
+    ssct_assert_true(schedr_job_index_find(&job_index, "First") == &(jobs[0]));
+    ssct_assert_true(schedr_job_index_find(&job_index, "Second") == NULL);
+    ssct_assert_true(schedr_job_index_find(&job_index, "Third") == NULL);
+
+    ssct_assert_equals(schedr_job_index_remove(&job_index, &(jobs[0])), SCHEDR_SUCCESS);
+    ssct_assert_zero(job_index.by_name.count);
+}
+
+static void remove_should_free_owned_job()
+{
+    Job *job_p = (Job *)malloc(sizeof (Job));
+
+    init_job(job_p, "Owned");
+    schedr_job_index_add(&job_index, job_p, true);
+
+    ssct_assert_equals(schedr_job_index_remove(&job_index, job_p), SCHEDR_SUCCESS);
+    ssct_assert_zero(job_index.len);
+}
+
+static void index_should_hold_many_jobs()
+{
+    static Job jobs[MANY_JOBS];
+    char name[32];
+
+    for (int i = 0; i < MANY_JOBS; i++)
+    {
+        snprintf(name, sizeof (name), "Job %d", i);
+        init_job(&(jobs[i]), name);
+        ssct_assert_equals(schedr_job_index_add(&job_index, &(jobs[i]), false), SCHEDR_SUCCESS);
+    }
+
+    for (int i = 0; i < MANY_JOBS; i++)
+    {
+        snprintf(name, sizeof (name), "Job %d", i);
+        ssct_assert_true(schedr_job_index_find(&job_index, name) == &(jobs[i]));
+    }
+}
+
+static void functions_should_return_error_when_arguments_are_null()
+{
+    Job job;
+
+    init_job(&job, "Job");
+
+    ssct_assert_equals(schedr_job_index_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_index_add(NULL, &job, false), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_index_add(&job_index, NULL, false), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_index_remove(NULL, &job), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_index_remove(&job_index, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_true(schedr_job_index_find(NULL, "Job") == NULL);
+    ssct_assert_true(schedr_job_index_find(&job_index, NULL) == NULL);
+    ssct_assert_true(schedr_job_index_at(NULL, 0) == NULL);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(add_should_make_job_findable_by_name);
+    ssct_run(add_should_return_invalid_argument_error_when_name_is_taken);
+    ssct_run(remove_should_move_last_job_into_place);
+    ssct_run(index_should_tell_apart_names_with_same_hash);
+    ssct_run(remove_should_free_owned_job);
+    ssct_run(index_should_hold_many_jobs);
+    ssct_run(functions_should_return_error_when_arguments_are_null);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -38,6 +38,32 @@ static void set_state_should_return_null_argument_error_when_job_argument_is_nul
 static void set_state_should_return_invalid_argument_error_when_state_argument_is_negative();
 static void set_state_should_return_invalid_argument_error_when_state_argument_is_out_of_range();
 
+static void set_timing_should_set_timing_member();
+static void set_timing_should_return_null_argument_error_when_job_argument_is_null();
+static void set_timing_should_return_invalid_argument_error_when_timing_argument_is_out_of_range();
+static void set_weight_should_set_weight_member();
+static void set_weight_should_return_invalid_argument_error_when_weight_argument_is_less_than_one();
+static void set_overlap_should_set_overlap_members();
+static void set_splay_should_set_splay_and_discard_offset();
+static void set_retry_should_set_retry_policy_and_keep_failures();
+static void set_limits_should_set_limits_when_valid();
+static void set_trigger_should_set_monitor_and_pattern_when_valid();
+static void set_calendar_should_set_compiled_calendar_when_valid();
+static void set_overlap_should_return_invalid_argument_error_when_arguments_are_out_of_range();
+
+static void compile_command_should_return_null_argument_error_when_job_argument_is_null();
+static void compile_command_should_split_simple_command_into_arguments();
+static void compile_command_should_use_executable_path_containing_slash_as_it_is();
+static void compile_command_should_leave_commands_with_shell_syntax_to_the_shell();
+static void compile_command_should_leave_commands_with_unknown_executable_to_the_shell();
+static void compile_command_should_leave_commands_with_too_many_arguments_to_the_shell();
+static void set_command_should_discard_compiled_command();
+
+static void get_argv_should_return_invalid_argument_error_when_command_is_not_compiled();
+static void get_argv_should_return_null_terminated_arguments();
+
+static void fingerprint_should_change_with_configuration_but_not_with_state();
+
 int main(void)
 {
     ssct_run(should_set_all_job_members_when_setters_are_called);
@@ -70,6 +96,32 @@ int main(void)
     ssct_run(set_state_should_return_invalid_argument_error_when_state_argument_is_negative);
     ssct_run(set_state_should_return_invalid_argument_error_when_state_argument_is_out_of_range);
 
+    ssct_run(set_timing_should_set_timing_member);
+    ssct_run(set_timing_should_return_null_argument_error_when_job_argument_is_null);
+    ssct_run(set_timing_should_return_invalid_argument_error_when_timing_argument_is_out_of_range);
+    ssct_run(set_weight_should_set_weight_member);
+    ssct_run(set_weight_should_return_invalid_argument_error_when_weight_argument_is_less_than_one);
+    ssct_run(set_overlap_should_set_overlap_members);
+    ssct_run(set_splay_should_set_splay_and_discard_offset);
+    ssct_run(set_retry_should_set_retry_policy_and_keep_failures);
+    ssct_run(set_limits_should_set_limits_when_valid);
+    ssct_run(set_trigger_should_set_monitor_and_pattern_when_valid);
+    ssct_run(set_calendar_should_set_compiled_calendar_when_valid);
+    ssct_run(set_overlap_should_return_invalid_argument_error_when_arguments_are_out_of_range);
+
+    ssct_run(compile_command_should_return_null_argument_error_when_job_argument_is_null);
+    ssct_run(compile_command_should_split_simple_command_into_arguments);
+    ssct_run(compile_command_should_use_executable_path_containing_slash_as_it_is);
+    ssct_run(compile_command_should_leave_commands_with_shell_syntax_to_the_shell);
+    ssct_run(compile_command_should_leave_commands_with_unknown_executable_to_the_shell);
+    ssct_run(compile_command_should_leave_commands_with_too_many_arguments_to_the_shell);
+    ssct_run(set_command_should_discard_compiled_command);
+
+    ssct_run(get_argv_should_return_invalid_argument_error_when_command_is_not_compiled);
+    ssct_run(get_argv_should_return_null_terminated_arguments);
+
+    ssct_run(fingerprint_should_change_with_configuration_but_not_with_state);
+
     ssct_print_summary();
 
     return EXIT_SUCCESS;
@@ -90,8 +142,24 @@ static void init_should_set_members_to_default_values()
 
     ssct_assert_empty(job.name);
     ssct_assert_empty(job.command);
-    ssct_assert_zero(job.interval_seconds);
+    ssct_assert_zero(job.interval_ns);
     ssct_assert_equals(job.state, Stopped);
+    ssct_assert_equals(job.timing, FixedDelay);
+    ssct_assert_equals(job.weight, 1);
+    ssct_assert_equals(job.overlap, OverlapWait);
+    ssct_assert_equals(job.max_parallel, 1);
+    ssct_assert_zero(job.skipped_runs);
+    ssct_assert_zero(job.queued_runs);
+    ssct_assert_zero(job.splay_ns);
+    ssct_assert_zero(job.splay_offset_ns);
+    ssct_assert_zero(job.argc);
+    ssct_assert_equals(job.last_exit_status, -1);
+    ssct_assert_zero(job.last_duration_ns);
+    ssct_assert_zero(job.last_cpu_ns);
+    ssct_assert_zero(job.retry.max_attempts);
+    ssct_assert_zero(job.retry.cooldown_ns);
+    ssct_assert_zero(job.retry_state.failures);
+    ssct_assert_false(schedr_limits_are_set(&(job.limits)));
     ssct_assert_equals(status, SCHEDR_SUCCESS);
 }
 
@@ -118,7 +186,7 @@ static void should_set_all_job_members_when_setters_are_called()
 
     ssct_assert_equals(job.name, strlen(job.name), JOB_NAME, JOB_NAME_LEN);
     ssct_assert_equals(job.command, strlen(job.command), JOB_CMD, JOB_CMD_LEN);
-    ssct_assert_equals(job.interval_seconds, JOB_INTERVAL);
+    ssct_assert_equals(job.interval_ns, JOB_INTERVAL);
     ssct_assert_equals(job.state, JOB_STATE);
 }
 
@@ -145,7 +213,7 @@ static void job_setters_should_set_all_job_members_when_job_is_dynamically_alloc
 
     ssct_assert_equals(job_p->name, strlen(job_p->name), JOB_NAME, JOB_NAME_LEN);
     ssct_assert_equals(job_p->command, strlen(job_p->command), JOB_CMD, JOB_CMD_LEN);
-    ssct_assert_equals(job_p->interval_seconds, JOB_INTERVAL);
+    ssct_assert_equals(job_p->interval_ns, JOB_INTERVAL);
     ssct_assert_equals(job_p->state, JOB_STATE);
 
     free(job_p);
@@ -360,3 +428,356 @@ static void set_state_should_return_invalid_argument_error_when_state_argument_i
     ssct_assert_equals(status, SCHEDR_ERROR_INVALID_ARGUMENT);
 }
 
+static void set_timing_should_set_timing_member()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    Status status = schedr_job_set_timing(&job, FixedRate);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.timing, FixedRate);
+}
+
+static void set_timing_should_return_null_argument_error_when_job_argument_is_null()
+{
+    Status status = schedr_job_set_timing(NULL, FixedRate);
+
+    ssct_assert_equals(status, SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_timing_should_return_invalid_argument_error_when_timing_argument_is_out_of_range()
+{
+    Job job;
+
+    ssct_assert_equals(schedr_job_set_timing(&job, -1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_timing(&job, SCHEDR_JOB_TIMING_VALUES), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void set_weight_should_set_weight_member()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    Status status = schedr_job_set_weight(&job, 3);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.weight, 3);
+}
+
+static void set_weight_should_return_invalid_argument_error_when_weight_argument_is_less_than_one()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    ssct_assert_equals(schedr_job_set_weight(&job, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_weight(NULL, 1), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(job.weight, 1);
+}
+
+static void set_overlap_should_set_overlap_members()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    Status status = schedr_job_set_overlap(&job, OverlapParallel, 4);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.overlap, OverlapParallel);
+    ssct_assert_equals(job.max_parallel, 4);
+}
+
+static void set_splay_should_set_splay_and_discard_offset()
+{
+    Job job;
+    schedr_job_init(&job);
+    job.splay_offset_ns = 5;
+
+    Status status = schedr_job_set_splay(&job, 30 * 1000000000LL);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.splay_ns, 30 * 1000000000LL);
+    ssct_assert_zero(job.splay_offset_ns);
+    ssct_assert_equals(schedr_job_set_splay(&job, -1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_splay(NULL, 0), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_retry_should_set_retry_policy_and_keep_failures()
+{
+    Job job;
+    schedr_job_init(&job);
+    job.retry_state.failures = 3;
+
+    RetryPolicy policy = { .max_attempts = 5, .backoff_ns = 1000, .max_backoff_ns = 8000, .jitter_percent = 10, .cooldown_ns = 60 };
+    RetryPolicy invalid = policy;
+    invalid.max_backoff_ns = 999;
+
+    ssct_assert_equals(schedr_job_set_retry(&job, &policy), SCHEDR_SUCCESS);
+    ssct_assert_equals(job.retry.max_attempts, 5);
+    ssct_assert_equals(job.retry.max_backoff_ns, 8000);
+    ssct_assert_equals(job.retry.cooldown_ns, 60);
+    ssct_assert_equals(job.retry_state.failures, 3);
+    ssct_assert_equals(schedr_job_set_retry(&job, &invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(job.retry.max_backoff_ns, 8000);
+    ssct_assert_equals(schedr_job_set_retry(NULL, &policy), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_retry(&job, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_limits_should_set_limits_when_valid()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    Limits limits = { .cpu_percent = 50, .memory_bytes = 512 * 1024 * 1024, .io_weight = 100, .pids = 64 };
+    Limits invalid = limits;
+    invalid.io_weight = SCHEDR_LIMITS_MAX_IO_WEIGHT + 1;
+
+    ssct_assert_equals(schedr_job_set_limits(&job, &limits), SCHEDR_SUCCESS);
+    ssct_assert_equals(job.limits.cpu_percent, 50);
+    ssct_assert_equals(job.limits.memory_bytes, 512 * 1024 * 1024);
+    ssct_assert_equals(job.limits.pids, 64);
+    ssct_assert_equals(schedr_job_set_limits(&job, &invalid), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(job.limits.io_weight, 100);
+    ssct_assert_equals(schedr_job_set_limits(NULL, &limits), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_limits(&job, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_trigger_should_set_monitor_and_pattern_when_valid()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    ssct_assert_equals(schedr_job_set_trigger(&job, "tail -f log", strlen("tail -f log"), "^error", strlen("^error")), SCHEDR_SUCCESS);
+    ssct_assert_true(strcmp(job.monitor, "tail -f log") == 0);
+    ssct_assert_true(strcmp(job.pattern, "^error") == 0);
+    ssct_assert_equals(schedr_job_set_trigger(&job, "dmesg -w", strlen("dmesg -w"), "(error", strlen("(error")), 
+                       SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_true(strcmp(job.monitor, "tail -f log") == 0);
+    ssct_assert_equals(schedr_job_set_trigger(&job, "dmesg -w", strlen("dmesg -w"), "", 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_trigger(&job, "", 0, "error", strlen("error")), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_trigger(&job, "dmesg -w", strlen("dmesg -w"), "error", SCHEDR_JOB_MAX_PATTERN_LEN + 1), 
+                       SCHEDR_ERROR_BUFFER_OVERFLOW);
+    ssct_assert_equals(schedr_job_set_trigger(NULL, "dmesg -w", strlen("dmesg -w"), "error", strlen("error")), 
+                       SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_trigger(&job, NULL, 0, "error", strlen("error")), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_trigger(&job, "dmesg -w", strlen("dmesg -w"), NULL, 0), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_calendar_should_set_compiled_calendar_when_valid()
+{
+    Job job;
+    Calendar calendar = { .minutes = 1, .hours = 1, .days = SCHEDR_CALENDAR_ALL_DAYS, .months = SCHEDR_CALENDAR_ALL_MONTHS, 
+                          .weekdays = 1U << 5 };
+    schedr_job_init(&job);
+
+    ssct_assert_false(schedr_calendar_is_set(&(job.calendar)));
+    ssct_assert_equals(schedr_job_set_calendar(&job, &calendar), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_calendar_equal(&(job.calendar), &calendar));
+
+    // Months starting on a sunday have their fridays on the 6th, 13th, 20th and 27th
+    ssct_assert_true(job.calendar.days_by_first_weekday[0] == ((1U << 6) | (1U << 13) | (1U << 20) | (1U << 27)));
+
+    calendar.hours = 1U << 24;
+
+    ssct_assert_equals(schedr_job_set_calendar(&job, &calendar), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_true(job.calendar.hours == 1);
+    ssct_assert_equals(schedr_job_set_calendar(NULL, &calendar), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_calendar(&job, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_overlap_should_return_invalid_argument_error_when_arguments_are_out_of_range()
+{
+    Job job;
+    schedr_job_init(&job);
+
+    ssct_assert_equals(schedr_job_set_overlap(&job, -1, 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_overlap(&job, SCHEDR_JOB_OVERLAP_VALUES, 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_overlap(&job, OverlapParallel, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_overlap(&job, OverlapSkip, 2), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_job_set_overlap(NULL, OverlapSkip, 1), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(job.overlap, OverlapWait);
+}
+
+static void compile_command_should_return_null_argument_error_when_job_argument_is_null()
+{
+    Status status = schedr_job_compile_command(NULL);
+
+    ssct_assert_equals(status, SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void compile_command_should_split_simple_command_into_arguments()
+{
+    static const char CMD[] = "  sh   -c\ttrue ";
+    static const char ARGS[] = "sh\0-c\0true";
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, CMD, sizeof (CMD) - 1);
+
+    Status status = schedr_job_compile_command(&job);
+    size_t exec_path_len = strlen(job.exec_path);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.argc, 3);
+    ssct_assert_equals(job.args, sizeof (ARGS), ARGS, sizeof (ARGS));
+    ssct_assert_true(exec_path_len > 3 && strcmp(job.exec_path + exec_path_len - 3, "/sh") == 0);
+}
+
+static void compile_command_should_use_executable_path_containing_slash_as_it_is()
+{
+    static const char CMD[] = "/bin/sh -c true";
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, CMD, sizeof (CMD) - 1);
+
+    schedr_job_compile_command(&job);
+
+    ssct_assert_equals(job.argc, 3);
+    ssct_assert_equals(job.exec_path, strlen(job.exec_path), "/bin/sh", strlen("/bin/sh"));
+}
+
+static void compile_command_should_leave_commands_with_shell_syntax_to_the_shell()
+{
+    static const char *const CMDS[] = {
+        "echo $HOME", "ls | wc -l", "echo 'quoted'", "echo \"quoted\"", "date > file", "ls *.c",
+        "true && false", "true; false", "echo `date`", "echo \\n", "FOO=bar env", "ls ~", "echo {a,b}",
+        NULL
+    };
+
+    for (int i = 0; CMDS[i] != NULL; i++)
+    {
+        Job job;
+        schedr_job_init(&job);
+        schedr_job_set_command(&job, CMDS[i], strlen(CMDS[i]));
+
+        Status status = schedr_job_compile_command(&job);
+
+        if (status != SCHEDR_SUCCESS || job.argc != 0)
+        {
+            ssct_fail();
+        }
+    }
+}
+
+static void compile_command_should_leave_commands_with_unknown_executable_to_the_shell()
+{
+    static const char CMD[] = "no-such-command-in-path --flag";
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, CMD, sizeof (CMD) - 1);
+
+    schedr_job_compile_command(&job);
+
+    ssct_assert_zero(job.argc);
+}
+
+static void compile_command_should_leave_commands_with_too_many_arguments_to_the_shell()
+{
+    char cmd[SCHEDR_JOB_MAX_CMD_LEN + 1] = "sh";
+
+    for (int i = 0; i < SCHEDR_JOB_MAX_ARGS; i++) { strcat(cmd, " a"); }
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, cmd, strlen(cmd));
+
+    schedr_job_compile_command(&job);
+
+    ssct_assert_zero(job.argc);
+}
+
+static void set_command_should_discard_compiled_command()
+{
+    static const char CMD[] = "sh -c true";
+    static const char SHELL_CMD[] = "echo $HOME";
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, CMD, sizeof (CMD) - 1);
+    schedr_job_compile_command(&job);
+
+    schedr_job_set_command(&job, SHELL_CMD, sizeof (SHELL_CMD) - 1);
+
+    ssct_assert_zero(job.argc);
+}
+
+static void get_argv_should_return_invalid_argument_error_when_command_is_not_compiled()
+{
+    char *argv[SCHEDR_JOB_MAX_ARGS + 1];
+    Job job;
+    schedr_job_init(&job);
+
+    Status status = schedr_job_get_argv(&job, argv);
+
+    ssct_assert_equals(status, SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void get_argv_should_return_null_terminated_arguments()
+{
+    static const char CMD[] = "sh -c true";
+
+    char *argv[SCHEDR_JOB_MAX_ARGS + 1];
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, CMD, sizeof (CMD) - 1);
+    schedr_job_compile_command(&job);
+
+    Status status = schedr_job_get_argv(&job, argv);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(argv[0], strlen(argv[0]), "sh", 2);
+    ssct_assert_equals(argv[1], strlen(argv[1]), "-c", 2);
+    ssct_assert_equals(argv[2], strlen(argv[2]), "true", 4);
+    ssct_assert_true(argv[3] == NULL);
+}
+
+static void fingerprint_should_change_with_configuration_but_not_with_state()
+{
+    Job job;
+    Job other;
+    Limits limits;
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Backup", strlen("Backup"));
+    schedr_job_set_command(&job, "backup.sh", strlen("backup.sh"));
+    schedr_job_set_interval(&job, 60LL * 1000000000LL);
+    other = job;
+
+    uint64_t fingerprint = schedr_job_fingerprint(&job);
+
+    other.state = Running;
+    other.skipped_runs = 3;
+    other.last_exit_status = 1;
+    other.retry_state.failures = 2;
+    other.splay_offset_ns = 5;
+
+    ssct_assert_true(schedr_job_fingerprint(&other) == fingerprint);
+
+    schedr_job_set_command(&other, "backup.sh --all", strlen("backup.sh --all"));
+
+    ssct_assert_false(schedr_job_fingerprint(&other) == fingerprint);
+
+    other = job;
+    schedr_job_set_interval(&other, 30LL * 1000000000LL);
+
+    ssct_assert_false(schedr_job_fingerprint(&other) == fingerprint);
+
+    other = job;
+    limits = other.limits;
+    limits.pids = 10;
+    schedr_job_set_limits(&other, &limits);
+
+    ssct_assert_false(schedr_job_fingerprint(&other) == fingerprint);
+
+    other = job;
+    schedr_job_set_trigger(&other, "dmesg -w", strlen("dmesg -w"), "error", strlen("error"));
+
+    ssct_assert_false(schedr_job_fingerprint(&other) == fingerprint);
+
+    other = job;
+    other.calendar.minutes = 1;
+
+    ssct_assert_false(schedr_job_fingerprint(&other) == fingerprint);
+    ssct_assert_zero(schedr_job_fingerprint(NULL));
+}
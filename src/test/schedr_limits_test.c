@@ -0,0 +1,378 @@
+#define _GNU_SOURCE         // syscall()
+
+#include <stdlib.h>         // EXIT_SUCCESS, EXIT_FAILURE, mkdtemp()
+#include <stdio.h>          // snprintf(), fopen(), fclose(), fgets()
+#include <string.h>         // strstr(), strncmp(), strcmp(), memcmp()
+#include <stdbool.h>        // bool, true, false
+#include <unistd.h>         // getpid(), _exit(), access(), syscall()
+#include <sys/stat.h>       // mkdir()
+#include <sys/wait.h>       // waitpid()
+#include <sys/resource.h>   // getrlimit(), getpriority()
+#include <sys/syscall.h>    // SYS_sched_getaffinity, SYS_ioprio_get
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_limits.h"
+
+static char cgroup_dir[64];
+
+static void write_test_file(const char *name, const char *content)
+{
+    char path[128];
+    snprintf(path, sizeof (path), "%s/%s", cgroup_dir, name);
+
+    FILE *fp = fopen(path, "w");
+    fputs(content, fp);
+    fclose(fp);
+}
+
+static bool test_file_contains(const char *name, const char *content)
+{
+    char path[128], buf[256] = { 0 };
+    snprintf(path, sizeof (path), "%s/%s", cgroup_dir, name);
+
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) { return false; }
+
+    fread(buf, 1, sizeof (buf) - 1, fp);
+    fclose(fp);
+
+    return strstr(buf, content) != NULL;
+}
+
+static bool test_file_exists(const char *name)
+{
+    char path[128];
+    snprintf(path, sizeof (path), "%s/%s", cgroup_dir, name);
+
+    return access(path, F_OK) == 0;
+}
+
+/*
+ * Sets up a plain directory that looks like a cgroup v2 holding this process,
+ * with 'controllers' available.
+ */
+static void create_test_cgroup(const char *controllers)
+{
+    char procs[32];
+    snprintf(procs, sizeof (procs), "%d\n", (int)getpid());
+
+    write_test_file("cgroup.controllers", controllers);
+    write_test_file("cgroup.procs", procs);
+    write_test_file("cgroup.subtree_control", "");
+}
+
+static void setup()
+{
+    snprintf(cgroup_dir, sizeof (cgroup_dir), "/tmp/schedr_limits_test_XXXXXX");
+    mkdtemp(cgroup_dir);
+}
+
+static void teardown()
+{
+    char command[128];
+
+    schedr_limits_close_cgroup();
+    snprintf(command, sizeof (command), "rm -rf %s", cgroup_dir);
+    system(command);
+}
+
+static void init_should_not_limit_anything()
+{
+    Limits limits = { .cpu_percent = 10, .memory_bytes = 10, .io_weight = 10, .pids = 10 };
+
+    ssct_assert_equals(schedr_limits_init(&limits), SCHEDR_SUCCESS);
+    ssct_assert_false(schedr_limits_are_set(&limits));
+    ssct_assert_equals(schedr_limits_validate(&limits), SCHEDR_SUCCESS);
+    ssct_assert_false(schedr_limits_are_set(NULL));
+    ssct_assert_false(schedr_limits_have_placement(&limits));
+    ssct_assert_false(schedr_limits_have_placement(NULL));
+    ssct_assert_equals(schedr_limits_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+
+    limits.pids = 1;
+
+    ssct_assert_true(schedr_limits_are_set(&limits));
+}
+
+static void validate_should_return_invalid_argument_error_when_limits_are_out_of_range()
+{
+    Limits invalid[8];
+
+    for (int i = 0; i < 8; i++) { schedr_limits_init(&(invalid[i])); }
+
+    invalid[0].cpu_percent = SCHEDR_LIMITS_MAX_CPU_PERCENT + 1;
+    invalid[1].memory_bytes = -1;
+    invalid[2].io_weight = SCHEDR_LIMITS_MAX_IO_WEIGHT + 1;
+    invalid[3].pids = -1;
+    invalid[4].cpu_percent = -1;
+    invalid[5].nice_set = true;
+    invalid[5].nice = SCHEDR_LIMITS_MAX_NICE + 1;
+    invalid[6].io_priority_class = IoPriorityIdle + 1;
+    invalid[7].io_priority_level = SCHEDR_LIMITS_MAX_IO_PRIORITY_LEVEL + 1;
+
+    for (int i = 0; i < 8; i++) { ssct_assert_equals(schedr_limits_validate(&(invalid[i])), SCHEDR_ERROR_INVALID_ARGUMENT); }
+
+    ssct_assert_equals(schedr_limits_validate(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void open_cgroup_should_return_failure_when_path_is_not_a_cgroup()
+{
+    ssct_assert_equals(schedr_limits_open_cgroup("/nonexistent"), SCHEDR_FAILURE);
+    ssct_assert_equals(schedr_limits_open_cgroup(cgroup_dir), SCHEDR_FAILURE);
+    ssct_assert_false(schedr_limits_have_cgroup());
+}
+
+static void open_cgroup_should_move_processes_to_daemon_leaf_and_enable_controllers()
+{
+    char pid[32], stale_leaf[128];
+    snprintf(pid, sizeof (pid), "%d", (int)getpid());
+    snprintf(stale_leaf, sizeof (stale_leaf), "%s/job-old-1", cgroup_dir);
+
+    create_test_cgroup("cpuset cpu io memory hugetlb pids\n");
+    mkdir(stale_leaf, 0755);
+
+    ssct_assert_equals(schedr_limits_open_cgroup(cgroup_dir), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_limits_have_cgroup());
+    ssct_assert_true(test_file_contains("daemon/cgroup.procs", pid));
+    ssct_assert_true(test_file_contains("cgroup.subtree_control", "+cpu +memory +io +pids"));
+    ssct_assert_false(test_file_exists("job-old-1"));
+
+    // Already open
+    ssct_assert_equals(schedr_limits_open_cgroup("/nonexistent"), SCHEDR_SUCCESS);
+}
+
+static void create_leaf_should_write_limits_of_enabled_controllers()
+{
+    Limits limits = { .cpu_percent = 50, .memory_bytes = 512 * 1024 * 1024, .io_weight = 100, .pids = 64 };
+    CgroupLeaf leaf = { .fd = -1 };
+    char path[256];
+
+    create_test_cgroup("cpu memory pids\n");
+    schedr_limits_open_cgroup(cgroup_dir);
+
+    ssct_assert_equals(schedr_limits_create_leaf(&leaf, "nightly backup/db", &limits), SCHEDR_SUCCESS);
+    ssct_assert_true(leaf.fd >= 0);
+    ssct_assert_zero(strncmp(leaf.name, "job-nightly_backup_db-", strlen("job-nightly_backup_db-")));
+
+    snprintf(path, sizeof (path), "%s/cpu.max", leaf.name);
+    ssct_assert_true(test_file_contains(path, "50000 100000"));
+    snprintf(path, sizeof (path), "%s/memory.max", leaf.name);
+    ssct_assert_true(test_file_contains(path, "536870912"));
+    snprintf(path, sizeof (path), "%s/pids.max", leaf.name);
+    ssct_assert_true(test_file_contains(path, "64"));
+
+    // The io controller is not available
+    snprintf(path, sizeof (path), "%s/io.weight", leaf.name);
+    ssct_assert_false(test_file_exists(path));
+
+    schedr_limits_remove_leaf(&leaf);
+
+    ssct_assert_equals(leaf.fd, -1);
+}
+
+static void create_leaf_should_give_unique_names_and_fail_without_cgroup()
+{
+    Limits limits = { .pids = 64 };
+    CgroupLeaf leaves[2] = { { .fd = -1 }, { .fd = -1 } };
+
+    ssct_assert_equals(schedr_limits_create_leaf(&(leaves[0]), "job", &limits), SCHEDR_FAILURE);
+    ssct_assert_equals(schedr_limits_create_leaf(NULL, "job", &limits), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_limits_create_leaf(&(leaves[0]), NULL, &limits), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_limits_create_leaf(&(leaves[0]), "job", NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+
+    create_test_cgroup("pids\n");
+    schedr_limits_open_cgroup(cgroup_dir);
+
+    ssct_assert_equals(schedr_limits_create_leaf(&(leaves[0]), "job", &limits), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_limits_create_leaf(&(leaves[1]), "job", &limits), SCHEDR_SUCCESS);
+    ssct_assert_true(strcmp(leaves[0].name, leaves[1].name) != 0);
+
+    schedr_limits_remove_leaf(&(leaves[0]));
+    schedr_limits_remove_leaf(&(leaves[1]));
+}
+
+static void apply_should_set_memory_and_pids_rlimits()
+{
+    Limits limits = { .memory_bytes = 64 * 1024 * 1024, .pids = 100 };
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        struct rlimit memory, pids;
+
+        if (schedr_limits_apply(&limits) != SCHEDR_SUCCESS) { _exit(EXIT_FAILURE); }
+
+        getrlimit(RLIMIT_AS, &memory);
+        getrlimit(RLIMIT_NPROC, &pids);
+
+        _exit((memory.rlim_cur == 64 * 1024 * 1024 && pids.rlim_cur <= 100) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    ssct_assert_true(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    ssct_assert_equals(schedr_limits_apply(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void set_cpus_should_parse_lists_of_cpus_and_ranges()
+{
+    Limits limits;
+    const char *invalid[] = { "", "a", "1-", "3-1", "1,", "1;2", "0-1024", NULL };
+
+    schedr_limits_init(&limits);
+
+    ssct_assert_equals(schedr_limits_set_cpus(&limits, "0,2-3,64"), SCHEDR_SUCCESS);
+    ssct_assert_equals(limits.cpus[0], 0xDULL);
+    ssct_assert_equals(limits.cpus[1], 0x1ULL);
+    ssct_assert_true(schedr_limits_have_cpus(&limits));
+    ssct_assert_true(schedr_limits_have_placement(&limits));
+    ssct_assert_false(schedr_limits_are_set(&limits));
+
+    // A malformed list leaves the CPUs as they were
+    for (int i = 0; invalid[i] != NULL; i++) { ssct_assert_equals(schedr_limits_set_cpus(&limits, invalid[i]), SCHEDR_ERROR_INVALID_ARGUMENT); }
+
+    ssct_assert_equals(limits.cpus[0], 0xDULL);
+    ssct_assert_equals(schedr_limits_set_cpus(&limits, "1023"), SCHEDR_SUCCESS);
+    ssct_assert_zero(limits.cpus[0]);
+    ssct_assert_equals(limits.cpus[15], 1ULL << 63);
+    ssct_assert_equals(schedr_limits_set_cpus(NULL, "1"), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_limits_set_cpus(&limits, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void equal_should_compare_every_limit()
+{
+    Limits a;
+    Limits b;
+
+    schedr_limits_init(&a);
+    schedr_limits_init(&b);
+
+    ssct_assert_true(schedr_limits_equal(&a, &b));
+
+    a.memory_bytes = 1024 * 1024;
+
+    ssct_assert_false(schedr_limits_equal(&a, &b));
+
+    b.memory_bytes = 1024 * 1024;
+    schedr_limits_set_cpus(&b, "1");
+
+    ssct_assert_false(schedr_limits_equal(&a, &b));
+
+    schedr_limits_set_cpus(&a, "1");
+    a.nice = 5;
+
+    // The nice value only counts once it is set
+    ssct_assert_true(schedr_limits_equal(&a, &b));
+    ssct_assert_false(schedr_limits_equal(&a, NULL));
+    ssct_assert_true(schedr_limits_equal(NULL, NULL));
+}
+
+static void set_numa_node_should_take_cpus_of_node_unless_cpus_are_set()
+{
+    Limits limits;
+    char node_path[128];
+
+    snprintf(node_path, sizeof (node_path), "%s/node2", cgroup_dir);
+    mkdir(node_path, 0755);
+    write_test_file("node2/cpulist", "8-11\n");
+    schedr_limits_set_node_dir(cgroup_dir);
+    schedr_limits_init(&limits);
+
+    ssct_assert_equals(schedr_limits_set_numa_node(&limits, 2), SCHEDR_SUCCESS);
+    ssct_assert_equals(limits.numa_nodes, 0x4ULL);
+    ssct_assert_equals(limits.cpus[0], 0xF00ULL);
+
+    schedr_limits_set_cpus(&limits, "1");
+
+    ssct_assert_equals(schedr_limits_set_numa_node(&limits, 2), SCHEDR_SUCCESS);
+    ssct_assert_equals(limits.cpus[0], 0x2ULL);
+    ssct_assert_equals(schedr_limits_set_numa_node(&limits, 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_limits_set_numa_node(&limits, SCHEDR_LIMITS_MAX_NUMA_NODES), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_limits_set_numa_node(NULL, 2), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(limits.numa_nodes, 0x4ULL);
+
+    schedr_limits_reset_node_dir();
+}
+
+static void place_should_set_cpus_nice_and_io_priority()
+{
+    Limits limits, allowed;
+
+    schedr_limits_init(&limits);
+    schedr_limits_init(&allowed);
+
+    ssct_assert_equals(schedr_limits_get_cpus(&allowed), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_limits_have_cpus(&allowed));
+
+    // The lowest CPU the test may run on, the nice value and io class any user may take
+    for (int i = 0; limits.cpus[i / 64] == 0; i++)
+    {
+        if (allowed.cpus[i / 64] & (1ULL << (i % 64))) { limits.cpus[i / 64] = 1ULL << (i % 64); }
+    }
+
+    limits.nice_set = true;
+    limits.nice = SCHEDR_LIMITS_MAX_NICE;
+    limits.io_priority_class = IoPriorityIdle;
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        uint64_t cpus[SCHEDR_LIMITS_MAX_CPUS / 64] = { 0 };
+
+        if (schedr_limits_place(0, &limits) != SCHEDR_SUCCESS) { _exit(EXIT_FAILURE); }
+
+        syscall(SYS_sched_getaffinity, 0, sizeof (cpus), cpus);
+
+        bool placed = memcmp(cpus, limits.cpus, sizeof (cpus)) == 0 &&
+                      getpriority(PRIO_PROCESS, 0) == SCHEDR_LIMITS_MAX_NICE &&
+                      syscall(SYS_ioprio_get, 1, 0) >> 13 == IoPriorityIdle;
+
+        _exit(placed ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    ssct_assert_true(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    ssct_assert_equals(schedr_limits_place(0, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_limits_get_cpus(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void clone_should_start_child_that_can_be_waited_for()
+{
+    pid_t pid = schedr_limits_clone(-1, true);
+
+    if (pid == 0) { _exit(3); }
+
+    int status;
+
+    ssct_assert_true(pid > 0);
+    ssct_assert_equals(waitpid(pid, &status, 0), pid);
+    ssct_assert_equals(WEXITSTATUS(status), 3);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(init_should_not_limit_anything);
+    ssct_run(validate_should_return_invalid_argument_error_when_limits_are_out_of_range);
+    ssct_run(open_cgroup_should_return_failure_when_path_is_not_a_cgroup);
+    ssct_run(open_cgroup_should_move_processes_to_daemon_leaf_and_enable_controllers);
+    ssct_run(create_leaf_should_write_limits_of_enabled_controllers);
+    ssct_run(create_leaf_should_give_unique_names_and_fail_without_cgroup);
+    ssct_run(apply_should_set_memory_and_pids_rlimits);
+    ssct_run(clone_should_start_child_that_can_be_waited_for);
+    ssct_run(set_cpus_should_parse_lists_of_cpus_and_ranges);
+    ssct_run(equal_should_compare_every_limit);
+    ssct_run(set_numa_node_should_take_cpus_of_node_unless_cpus_are_set);
+    ssct_run(place_should_set_cpus_nice_and_io_priority);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+#include <stdlib.h>         // EXIT_SUCCESS, setenv(), free()
+#include <stdio.h>          // FILE, fopen(), fread(), snprintf()
+#include <string.h>         // strcmp(), strstr(), memset(), memcpy()
+#include <stdbool.h>        // bool
+#include <unistd.h>         // getpid(), unlink(), usleep()
+#include <time.h>           // tzset()
+#include <poll.h>           // poll()
+#include <sys/stat.h>       // stat()
+#include <sys/uio.h>        // writev()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_log.h"
+
+// 2017-07-14 02:40:00.123 UTC
+#define TEST_TIME_NS 1500000000123456789LL
+#define MAX_FILE_LEN 4096
+
+static char log_path[64];
+static char contents[MAX_FILE_LEN];
+static LogRotation no_rotation = { .max_file_len = 0, .max_age_ns = 0, .keep = 2 };
+static volatile bool writer_released;
+
+static void setup()
+{
+    snprintf(log_path, sizeof (log_path), "/tmp/schedr_log_test_%d.log", (int)getpid());
+    writer_released = true;
+}
+
+static void teardown()
+{
+    char rotated_path[80];
+
+    writer_released = true;
+    schedr_log_close();
+    schedr_log_reset_writer();
+    unlink(log_path);
+
+    for (int i = 1; i <= 3; i++)
+    {
+        snprintf(rotated_path, sizeof (rotated_path), "%s.%d", log_path, i);
+        unlink(rotated_path);
+    }
+}
+
+/*
+ * Reads the file at 'path', or the log file if it is NULL, into 'contents'.
+ * Returns the length of the file, or -1 if it does not exist.
+ */
+static long read_file(const char *path)
+{
+    FILE *fp = fopen((path != NULL) ? path : log_path, "r");
+
+    if (fp == NULL) { return -1; }
+
+    size_t len = fread(contents, 1, sizeof (contents) - 1, fp);
+    contents[len] = '\0';
+    fclose(fp);
+
+    return (long)len;
+}
+
+static long read_rotated_file(int number)
+{
+    char rotated_path[80];
+    snprintf(rotated_path, sizeof (rotated_path), "%s.%d", log_path, number);
+
+    return read_file(rotated_path);
+}
+
+static ssize_t mock_writev_will_wait_until_released(int fd, const struct iovec *iov, int iovcnt)
+{
+    while (!writer_released) { usleep(1000); }
+
+    return writev(fd, iov, iovcnt);
+}
+
+static void open_should_return_error_when_arguments_are_invalid()
+{
+    LogRotation negative_age = { .max_file_len = 0, .max_age_ns = -1, .keep = 1 };
+    char long_path[4096];
+
+    memset(long_path, 'a', sizeof (long_path) - 1);
+    long_path[sizeof (long_path) - 1] = '\0';
+
+    ssct_assert_equals(schedr_log_open(NULL, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_log_open(log_path, NULL, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_log_open(log_path, &negative_age, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN - 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_log_open(long_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_ERROR_BUFFER_OVERFLOW);
+    ssct_assert_equals(schedr_log_open("/nonexistent/dir/jobs.log", &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_FAILURE);
+    ssct_assert_false(schedr_log_is_open());
+}
+
+static void open_should_return_invalid_argument_error_when_log_is_already_open()
+{
+    ssct_assert_equals(schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_true(schedr_log_is_open());
+}
+
+static void append_should_return_error_when_arguments_are_invalid()
+{
+    ssct_assert_equals(schedr_log_append("Test", OutputStdout, 0, "a\n", 2), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+
+    ssct_assert_equals(schedr_log_append(NULL, OutputStdout, 0, "a\n", 2), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_log_append("Test", OutputStdout, 0, NULL, 2), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_log_append("Test", 2, 0, "a\n", 2), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void flush_should_write_lines_prefixed_with_time_job_and_stream()
+{
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "hello\nworld\n", 12);
+    schedr_log_append("Other", OutputStderr, TEST_TIME_NS, "oops", 4);
+    schedr_log_flush();
+
+    read_file(NULL);
+
+    ssct_assert_equals(strcmp(contents, "2017-07-14 02:40:00.123 Test out hello\n"
+                                        "2017-07-14 02:40:00.123 Test out world\n"
+                                        "2017-07-14 02:40:00.123 Other err oops\n"), 0);
+}
+
+static void append_lines_should_keep_unfinished_line_back_until_it_is_finished()
+{
+    char buf[SCHEDR_LOG_MAX_LINE_LEN + 16];
+    char *data = buf + SCHEDR_LOG_MAX_LINE_LEN;
+    LogLine line = { .kept = NULL, .kept_len = 0 };
+
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+
+    memcpy(data, "one\ntw", 6);
+    schedr_log_append_lines(&line, "Test", OutputStdout, TEST_TIME_NS, data, 6);
+    schedr_log_append("Other", OutputStderr, TEST_TIME_NS, "oops\n", 5);
+    memcpy(data, "o\nthr", 5);
+    schedr_log_append_lines(&line, "Test", OutputStdout, TEST_TIME_NS, data, 5);
+    schedr_log_finish_lines(&line, "Test", OutputStdout, TEST_TIME_NS);
+    schedr_log_flush();
+    free(line.kept);
+
+    read_file(NULL);
+
+    ssct_assert_equals(strcmp(contents, "2017-07-14 02:40:00.123 Test out one\n"
+                                        "2017-07-14 02:40:00.123 Other err oops\n"
+                                        "2017-07-14 02:40:00.123 Test out two\n"
+                                        "2017-07-14 02:40:00.123 Test out thr\n"), 0);
+}
+
+static void close_should_write_what_is_left_in_buffer()
+{
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "last words\n", 11);
+    schedr_log_close();
+
+    read_file(NULL);
+
+    ssct_assert_equals(strcmp(contents, "2017-07-14 02:40:00.123 Test out last words\n"), 0);
+    ssct_assert_false(schedr_log_is_open());
+}
+
+static void open_should_continue_existing_log_file()
+{
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "first\n", 6);
+    schedr_log_close();
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "second\n", 7);
+    schedr_log_flush();
+
+    read_file(NULL);
+
+    ssct_assert_true(strstr(contents, "out first\n") != NULL);
+    ssct_assert_true(strstr(contents, "out second\n") != NULL);
+}
+
+static void log_should_rotate_file_when_it_would_grow_too_large()
+{
+    LogRotation by_size = { .max_file_len = 100, .max_age_ns = 0, .keep = 2 };
+    LogStats stats;
+
+    schedr_log_open(log_path, &by_size, SCHEDR_LOG_MIN_BUFFER_LEN);
+
+    // Every line is 44 bytes, so two of them fit in a file
+    for (int i = 0; i < 8; i++)
+    {
+        schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "0123456789\n", 11);
+        schedr_log_flush();
+    }
+
+    schedr_log_get_stats(&stats);
+
+    ssct_assert_equals(stats.rotations, 3);
+    ssct_assert_equals(read_file(NULL), 88);
+    ssct_assert_equals(read_rotated_file(1), 88);
+    ssct_assert_equals(read_rotated_file(2), 88);
+    ssct_assert_equals(read_rotated_file(3), -1);
+}
+
+static void log_should_rotate_file_when_it_is_too_old()
+{
+    LogRotation by_age = { .max_file_len = 0, .max_age_ns = 1, .keep = 1 };
+
+    schedr_log_open(log_path, &by_age, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "old\n", 4);
+    schedr_log_flush();
+    schedr_log_append("Test", OutputStdout, TEST_TIME_NS, "new\n", 4);
+    schedr_log_flush();
+
+    read_file(NULL);
+    ssct_assert_true(strstr(contents, "out new\n") != NULL && strstr(contents, "out old\n") == NULL);
+
+    read_rotated_file(1);
+    ssct_assert_true(strstr(contents, "out old\n") != NULL);
+}
+
+static void append_should_refuse_output_until_writer_has_caught_up()
+{
+    char line[100];
+    LogStats stats;
+    Status status = SCHEDR_SUCCESS;
+    struct pollfd event = { .fd = -1, .events = POLLIN };
+
+    memset(line, 'x', sizeof (line) - 1);
+    line[sizeof (line) - 1] = '\n';
+
+    writer_released = false;
+    schedr_log_set_writer(mock_writev_will_wait_until_released);
+    schedr_log_open(log_path, &no_rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    event.fd = schedr_log_event_fd();
+
+    // One buffer is stuck being written, the other fills up
+    for (int i = 0; i < 10000 && status == SCHEDR_SUCCESS; i++)
+    {
+        status = schedr_log_append("Test", OutputStdout, TEST_TIME_NS, line, sizeof (line));
+    }
+
+    ssct_assert_equals(status, SCHEDR_ERROR_BUFFER_OVERFLOW);
+    ssct_assert_false(schedr_log_has_room(4, sizeof (line)));
+    ssct_assert_zero(poll(&event, 1, 0));
+
+    writer_released = true;
+
+    ssct_assert_equals(poll(&event, 1, 5000), 1);
+
+    schedr_log_clear_event();
+    schedr_log_get_stats(&stats);
+
+    ssct_assert_zero(poll(&event, 1, 0));
+    ssct_assert_true(schedr_log_has_room(4, sizeof (line)));
+    ssct_assert_true(stats.stalls >= 2);
+}
+
+static void has_room_should_return_true_when_log_is_not_open()
+{
+    ssct_assert_true(schedr_log_has_room(4, 1000000000));
+    ssct_assert_equals(schedr_log_event_fd(), -1);
+}
+
+int main(void)
+{
+    // The times are written in local time
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(open_should_return_error_when_arguments_are_invalid);
+    ssct_run(open_should_return_invalid_argument_error_when_log_is_already_open);
+    ssct_run(append_should_return_error_when_arguments_are_invalid);
+    ssct_run(flush_should_write_lines_prefixed_with_time_job_and_stream);
+    ssct_run(append_lines_should_keep_unfinished_line_back_until_it_is_finished);
+    ssct_run(close_should_write_what_is_left_in_buffer);
+    ssct_run(open_should_continue_existing_log_file);
+    ssct_run(log_should_rotate_file_when_it_would_grow_too_large);
+    ssct_run(log_should_rotate_file_when_it_is_too_old);
+    ssct_run(append_should_refuse_output_until_writer_has_caught_up);
+    ssct_run(has_room_should_return_true_when_log_is_not_open);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+#include <stdlib.h>         // rand(), srand(), EXIT_SUCCESS
+#include <stdio.h>          // snprintf()
+#include <string.h>         // strlen(), strcmp()
+#include <stdbool.h>        // bool
+#include <regex.h>          // regcomp(), regexec(), regfree()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_matcher.h"
+
+#define STRESS_PATTERNS 200
+#define STRESS_LINES 2000
+#define MAX_MATCHES 256
+
+static Matcher matcher;
+static int ids[MAX_MATCHES];
+static int matched[MAX_MATCHES];
+static int matched_len;
+
+static void setup()
+{
+    schedr_matcher_init(&matcher);
+    matched_len = 0;
+
+    for (int i = 0; i < MAX_MATCHES; i++) { ids[i] = i; }
+}
+
+static void teardown()
+{
+    schedr_matcher_destroy(&matcher);
+}
+
+static void record_match(void *data)
+{
+    if (matched_len < MAX_MATCHES) { matched[matched_len++] = *(int *)data; }
+}
+
+static bool was_matched(int id)
+{
+    for (int i = 0; i < matched_len; i++)
+    {
+        if (matched[i] == id) { return true; }
+    }
+
+    return false;
+}
+
+static void match(const char *line)
+{
+    matched_len = 0;
+    schedr_matcher_match(&matcher, line, strlen(line), record_match);
+}
+
+static bool literal_is(const char *pattern, const char *expected)
+{
+    char literal[SCHEDR_MATCHER_MAX_PATTERN_LEN + 1];
+    size_t len = schedr_matcher_literal_of(pattern, literal);
+
+    return len == strlen(expected) && strcmp(literal, expected) == 0;
+}
+
+static void literal_of_should_find_longest_literal_every_match_contains()
+{
+    ssct_assert_true(literal_is("error", "error"));
+    ssct_assert_true(literal_is("^wlan0: (connected|disconnected)$", "wlan0: "));
+    ssct_assert_true(literal_is("[0-9]+ failed login attempts", " failed login attempts"));
+    ssct_assert_true(literal_is("colou?r changed", "r changed"));
+    ssct_assert_true(literal_is("ab*cdef", "cdef"));
+    ssct_assert_true(literal_is("x+yz", "yz"));
+    ssct_assert_true(literal_is("disk\\.full", "disk.full"));
+    ssct_assert_true(literal_is("a{2,3}bcd", "bcd"));
+    ssct_assert_true(literal_is("[[:alpha:]]]abc", "]abc"));
+    ssct_assert_true(literal_is("[]x]yz", "yz"));
+    ssct_assert_true(literal_is("ab.cde", "cde"));
+}
+
+static void literal_of_should_find_no_literal_when_pattern_has_alternatives()
+{
+    ssct_assert_true(literal_is("error|warning", ""));
+    ssct_assert_true(literal_is("[0-9]+", ""));
+    ssct_assert_true(literal_is("a?", ""));
+    ssct_assert_true(literal_is(".*", ""));
+}
+
+static void match_should_call_handler_once_for_every_matching_pattern()
+{
+    ssct_assert_equals(schedr_matcher_add(&matcher, "wlan0: connected$", &ids[0]), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_matcher_add(&matcher, "wlan0: (connected|disconnected)$", &ids[1]), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_matcher_add(&matcher, "eth0", &ids[2]), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_matcher_add(&matcher, "con|dis", &ids[3]), SCHEDR_SUCCESS);
+
+    match("wlan0: connected");
+
+    ssct_assert_equals(matched_len, 3);
+    ssct_assert_true(was_matched(0) && was_matched(1) && was_matched(3));
+
+    // The literal is in the line, but the pattern does not match
+    match("wlan0: connected to eth0 bridge");
+
+    ssct_assert_equals(matched_len, 2);
+    ssct_assert_true(was_matched(2) && was_matched(3));
+
+    match("nothing to see");
+
+    ssct_assert_equals(matched_len, 0);
+}
+
+static void match_should_find_overlapping_and_shared_literals()
+{
+    schedr_matcher_add(&matcher, "she", &ids[0]);
+    schedr_matcher_add(&matcher, "he", &ids[1]);
+    schedr_matcher_add(&matcher, "hers", &ids[2]);
+    schedr_matcher_add(&matcher, "his", &ids[3]);
+    schedr_matcher_add(&matcher, "^he", &ids[4]);
+
+    match("ushers");
+
+    ssct_assert_equals(matched_len, 3);
+    ssct_assert_true(was_matched(0) && was_matched(1) && was_matched(2));
+
+    match("hehe");
+
+    ssct_assert_equals(matched_len, 2);
+    ssct_assert_true(was_matched(1) && was_matched(4));
+}
+
+static void remove_should_stop_matching_pattern()
+{
+    schedr_matcher_add(&matcher, "error", &ids[0]);
+    schedr_matcher_add(&matcher, "err", &ids[1]);
+    schedr_matcher_add(&matcher, "fatal", &ids[1]);
+
+    match("error");
+
+    ssct_assert_equals(matched_len, 2);
+    ssct_assert_equals(schedr_matcher_remove(&matcher, &ids[1]), SCHEDR_SUCCESS);
+    ssct_assert_equals(matcher.len, 1);
+
+    match("fatal error");
+
+    ssct_assert_equals(matched_len, 1);
+    ssct_assert_true(was_matched(0));
+    ssct_assert_equals(schedr_matcher_remove(&matcher, &ids[1]), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void match_should_agree_with_regexec_on_many_patterns()
+{
+    static const char *WORDS[] = { "disk", "full", "error", "eth0", "up", "down", "sda", "42", "fail", "ed" };
+    static const int WORDS_LEN = sizeof (WORDS) / sizeof (WORDS[0]);
+
+    regex_t regexes[STRESS_PATTERNS];
+    char pattern[64];
+    char line[128];
+    bool agrees = true;
+
+    srand(7);
+
+    for (int i = 0; i < STRESS_PATTERNS; i++)
+    {
+        const char *forms[] = { "%s %s", "%s[0-9]*%s", "^%s.*%s$", "%s|%s", "(%s)+ %s" };
+
+        snprintf(pattern, sizeof (pattern), forms[i % 5], WORDS[rand() % WORDS_LEN], WORDS[rand() % WORDS_LEN]);
+        regcomp(&(regexes[i]), pattern, REG_EXTENDED | REG_NOSUB);
+        schedr_matcher_add(&matcher, pattern, &ids[i]);
+    }
+
+    for (int i = 0; i < STRESS_LINES && agrees; i++)
+    {
+        snprintf(line, sizeof (line), "%s %s%d%s %s", WORDS[rand() % WORDS_LEN], WORDS[rand() % WORDS_LEN], rand() % 3,
+                 WORDS[rand() % WORDS_LEN], WORDS[rand() % WORDS_LEN]);
+        match(line);
+
+        int expected = 0;
+
+        for (int j = 0; j < STRESS_PATTERNS; j++)
+        {
+            bool matches = regexec(&(regexes[j]), line, 0, NULL, 0) == 0;
+
+            expected += matches ? 1 : 0;
+            agrees = agrees && matches == was_matched(j);
+        }
+
+        agrees = agrees && expected == matched_len;
+    }
+
+    for (int i = 0; i < STRESS_PATTERNS; i++) { regfree(&(regexes[i])); }
+
+    ssct_assert_true(agrees);
+}
+
+static void functions_should_return_error_when_arguments_are_invalid()
+{
+    char too_long[SCHEDR_MATCHER_MAX_PATTERN_LEN + 2];
+
+    memset(too_long, 'a', sizeof (too_long) - 1);
+    too_long[sizeof (too_long) - 1] = '\0';
+
+    ssct_assert_equals(schedr_matcher_init(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_add(NULL, "a", NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_add(&matcher, NULL, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_add(&matcher, "(a", NULL), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_add(&matcher, too_long, NULL), SCHEDR_ERROR_BUFFER_OVERFLOW);
+    ssct_assert_equals(schedr_matcher_remove(NULL, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_match(NULL, "a", 1, record_match), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_match(&matcher, NULL, 0, record_match), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_matcher_match(&matcher, "a", 1, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(matcher.len, 0);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(literal_of_should_find_longest_literal_every_match_contains);
+    ssct_run(literal_of_should_find_no_literal_when_pattern_has_alternatives);
+    ssct_run(match_should_call_handler_once_for_every_matching_pattern);
+    ssct_run(match_should_find_overlapping_and_shared_literals);
+    ssct_run(remove_should_stop_matching_pattern);
+    ssct_run(match_should_agree_with_regexec_on_many_patterns);
+    ssct_run(functions_should_return_error_when_arguments_are_invalid);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+#include <stdlib.h>         // EXIT_SUCCESS, free()
+#include <stdio.h>          // FILE, open_memstream(), fclose(), snprintf()
+#include <string.h>         // strlen(), strstr(), memset()
+#include <stdbool.h>        // bool
+#include <unistd.h>         // fork(), getpid(), usleep(), _exit(), read(), write(), close()
+#include <signal.h>         // kill(), SIGTERM
+#include <sys/wait.h>       // waitpid()
+#include <sys/socket.h>     // socket(), connect()
+#include <sys/un.h>         // struct sockaddr_un
+#include <netinet/in.h>     // struct sockaddr_in, INADDR_LOOPBACK, htons(), htonl()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_metrics.h"
+#include "schedr_scheduler.h"
+#include "schedr_job.h"
+#include "schedr_job_index.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define SCRAPE_ATTEMPTS 500
+#define SCRAPE_RETRY_US 10000
+#define RESPONSE_LEN 65536
+#define REQUEST "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n"
+
+static char socket_path[64];
+static int port;
+static char response[RESPONSE_LEN];
+static pid_t daemon_pid;
+
+static void setup()
+{
+    snprintf(socket_path, sizeof (socket_path), "/tmp/schedr_metrics_test_%d.sock", (int)getpid());
+    port = 20000 + (int)getpid() % 20000;
+    response[0] = '\0';
+    daemon_pid = 0;
+}
+
+static void teardown()
+{
+    if (daemon_pid > 0)
+    {
+        kill(daemon_pid, SIGTERM);
+        waitpid(daemon_pid, NULL, 0);
+    }
+
+    unlink(socket_path);
+}
+
+/*
+ * Starts a daemon serving the metrics of a job running "/bin/echo hello" every
+ * 50 milliseconds, on the socket and on the port.
+ */
+static void start_daemon()
+{
+    daemon_pid = fork();
+
+    if (daemon_pid != 0) { return; }
+
+    static Job job;
+    static JobIndex jobs;
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Greeter", strlen("Greeter"));
+    schedr_job_set_command(&job, "/bin/echo hello", strlen("/bin/echo hello"));
+    schedr_job_compile_command(&job);
+    schedr_job_set_interval(&job, NANOSECS_PER_SEC / 20);
+
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_job_index_init(&jobs);
+    schedr_job_index_add(&jobs, &job, false);
+
+    if (schedr_metrics_open(socket_path, port, &jobs) != SCHEDR_SUCCESS) { _exit(EXIT_FAILURE); }
+
+    schedr_scheduler_run();
+
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Sends 'request' over a new connection to 'addr' and reads the whole response.
+ */
+static bool scrape_once(const struct sockaddr *addr, socklen_t addr_len, const char *request)
+{
+    int fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    size_t len = 0;
+    ssize_t read_len;
+
+    if (fd == -1) { return false; }
+
+    if (connect(fd, addr, addr_len) != 0 || write(fd, request, strlen(request)) != (ssize_t)strlen(request))
+    {
+        close(fd);
+        return false;
+    }
+
+    while ((read_len = read(fd, response + len, RESPONSE_LEN - 1 - len)) > 0) { len += (size_t)read_len; }
+
+    response[len] = '\0';
+    close(fd);
+
+    return len > 0;
+}
+
+/*
+ * Scrapes the socket, or the port if 'over_port' is true, until the daemon has
+ * started and the response contains 'expected'.
+ */
+static bool scrape_until(bool over_port, const char *request, const char *expected)
+{
+    struct sockaddr_un unix_addr;
+    struct sockaddr_in inet_addr;
+
+    memset(&unix_addr, 0, sizeof (unix_addr));
+    unix_addr.sun_family = AF_UNIX;
+    strcpy(unix_addr.sun_path, socket_path);
+
+    memset(&inet_addr, 0, sizeof (inet_addr));
+    inet_addr.sin_family = AF_INET;
+    inet_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    inet_addr.sin_port = htons((uint16_t)port);
+
+    for (int i = 0; i < SCRAPE_ATTEMPTS; i++)
+    {
+        bool scraped = over_port ? scrape_once((struct sockaddr *)&inet_addr, sizeof (inet_addr), request)
+                                 : scrape_once((struct sockaddr *)&unix_addr, sizeof (unix_addr), request);
+
+        if (scraped && strstr(response, expected) != NULL) { return true; }
+
+        usleep(SCRAPE_RETRY_US);
+    }
+
+    return false;
+}
+
+static void open_should_return_error_when_arguments_are_invalid()
+{
+    JobIndex jobs;
+    char long_path[256];
+
+    schedr_job_index_init(&jobs);
+
+    memset(long_path, 'a', sizeof (long_path) - 1);
+    long_path[sizeof (long_path) - 1] = '\0';
+
+    ssct_assert_equals(schedr_metrics_open(NULL, 0, &jobs), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_open(socket_path, 0, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_open(socket_path, -1, &jobs), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_open(socket_path, SCHEDR_METRICS_MAX_PORT + 1, &jobs), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_open(long_path, 0, &jobs), SCHEDR_ERROR_BUFFER_OVERFLOW);
+}
+
+static void write_should_write_counters_and_histograms_of_jobs()
+{
+    Job job;
+    JobIndex jobs;
+    char *out_buf = NULL;
+    size_t out_len = 0;
+    FILE *out = open_memstream(&out_buf, &out_len);
+
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Say \"hi\"", strlen("Say \"hi\""));
+    job.skipped_runs = 3;
+    job.retry_state.failures = 2;
+    schedr_job_index_init(&jobs);
+    schedr_job_index_add(&jobs, &job, false);
+
+    ssct_assert_equals(schedr_metrics_write(NULL, out), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_write(&jobs, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_metrics_write(&jobs, out), SCHEDR_SUCCESS);
+
+    fclose(out);
+    schedr_job_index_destroy(&jobs);
+
+    ssct_assert_true(strstr(out_buf, "# TYPE schedr_job_runs_total counter\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_job_runs_total{job=\"Say \\\"hi\\\"\"} 0\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_job_failures_total{job=\"Say \\\"hi\\\"\"} 2\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_job_skipped_runs_total{job=\"Say \\\"hi\\\"\"} 3\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "# TYPE schedr_job_lag_seconds histogram\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_job_runtime_seconds_bucket{job=\"Say \\\"hi\\\"\",le=\"0.001\"} 0\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_job_runtime_seconds_bucket{job=\"Say \\\"hi\\\"\",le=\"+Inf\"} 0\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "schedr_commands_in_flight 0\n") != NULL);
+    ssct_assert_true(strstr(out_buf, "process_open_fds ") != NULL);
+    ssct_assert_false(strstr(out_buf, "process_resident_memory_bytes 0\n") != NULL);
+
+    free(out_buf);
+}
+
+static void scrape_should_return_metrics_over_socket()
+{
+    start_daemon();
+
+    bool ran = false;
+
+    // The first scrapes may come before the first run
+    for (int i = 0; i < SCRAPE_ATTEMPTS && !ran; i++)
+    {
+        ssct_assert_true(scrape_until(false, REQUEST, "schedr_job_runs_total{job=\"Greeter\"} "));
+
+        ran = (strstr(response, "schedr_job_runs_total{job=\"Greeter\"} 0\n") == NULL);
+
+        if (!ran) { usleep(SCRAPE_RETRY_US); }
+    }
+
+    ssct_assert_true(ran);
+    ssct_assert_true(strstr(response, "HTTP/1.0 200 OK\r\n") == response);
+    ssct_assert_true(strstr(response, "Content-Type: text/plain; version=0.0.4\r\n") != NULL);
+    ssct_assert_true(strstr(response, "schedr_job_lag_seconds_bucket{job=\"Greeter\",le=\"+Inf\"} ") != NULL);
+}
+
+static void scrape_should_return_metrics_over_port()
+{
+    start_daemon();
+
+    ssct_assert_true(scrape_until(true, REQUEST, "schedr_job_runs_total{job=\"Greeter\"} "));
+}
+
+static void scrape_should_refuse_methods_other_than_get()
+{
+    start_daemon();
+
+    ssct_assert_true(scrape_until(false, "POST /metrics HTTP/1.1\r\n\r\n", "HTTP/1.0 405 Method Not Allowed\r\n"));
+    ssct_assert_true(strstr(response, "schedr_job_runs_total") == NULL);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(open_should_return_error_when_arguments_are_invalid);
+    ssct_run(write_should_write_counters_and_histograms_of_jobs);
+    ssct_run(scrape_should_return_metrics_over_socket);
+    ssct_run(scrape_should_return_metrics_over_port);
+    ssct_run(scrape_should_refuse_methods_other_than_get);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
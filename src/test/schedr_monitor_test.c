@@ -0,0 +1,262 @@
+#include <stdlib.h>         // EXIT_SUCCESS, setenv()
+#include <string.h>         // strlen()
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint64_t
+#include <unistd.h>         // usleep()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_monitor.h"
+#include "schedr_hash.h"
+#include "schedr_scheduler.h"
+#include "schedr_job.h"
+
+#define WAIT_ATTEMPTS 300
+#define WAIT_US 10000
+
+static Job job;
+
+static void setup()
+{
+    setenv("SHELL", "/bin/sh", 0);
+    schedr_scheduler_set_mode(EventLoop);
+}
+
+static void teardown()
+{
+    schedr_scheduler_kill_children();
+    schedr_scheduler_set_mode(Supervised);
+    schedr_hash_reset_string_hash();
+    schedr_monitor_reset_restart_backoff();
+}
+
+static uint64_t same_hash(const char *command) { return 42; }
+
+/*
+ * Makes 'job' run /bin/true whenever 'monitor' writes a line matching 'pattern'.
+ */
+static void init_job(const char *monitor, const char *pattern)
+{
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Triggered", strlen("Triggered"));
+    schedr_job_set_command(&job, "/bin/true", strlen("/bin/true"));
+    schedr_job_compile_command(&job);
+    schedr_job_set_trigger(&job, monitor, strlen(monitor), pattern, strlen(pattern));
+}
+
+/*
+ * Runs the loop until the job has run or the attempts are used up.
+ */
+static bool wait_for_run()
+{
+    for (int i = 0; i < WAIT_ATTEMPTS && job.last_exit_status == -1; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+
+    return job.last_exit_status != -1;
+}
+
+static void run_loop(int iterations)
+{
+    for (int i = 0; i < iterations; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+}
+
+static void start_job_should_run_job_when_monitor_outputs_matching_line()
+{
+    init_job("echo noise; echo 'wlan0: connected'; sleep 5", "wlan0: (connected|disconnected)$");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_monitor_is_running(&job));
+    ssct_assert_true(wait_for_run());
+    ssct_assert_equals(job.last_exit_status, 0);
+}
+
+static void start_job_should_not_run_triggered_job_without_match_or_interval()
+{
+    init_job("echo noise; echo 'wlan0: connecting'; sleep 5", "wlan0: connected$");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+
+    run_loop(30);
+
+    ssct_assert_equals(job.last_exit_status, -1);
+    ssct_assert_true(schedr_monitor_is_running(&job));
+}
+
+static void monitor_should_match_line_written_in_parts()
+{
+    init_job("printf 'wlan0: '; sleep 0.1; printf 'connected\\n'; sleep 5", "^wlan0: connected$");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_true(wait_for_run());
+}
+
+static void monitor_should_not_run_paused_job()
+{
+    init_job("sleep 0.1; echo up; sleep 5", "up");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_scheduler_pause_job(&job), SCHEDR_SUCCESS);
+
+    run_loop(30);
+
+    ssct_assert_equals(job.last_exit_status, -1);
+}
+
+static void monitor_should_wait_for_backoff_when_it_exits_right_away()
+{
+    init_job("echo up", "up");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_true(wait_for_run());
+
+    run_loop(10);
+
+    ssct_assert_false(schedr_monitor_is_running(&job));
+    ssct_assert_equals(job.state, Running);
+}
+
+static void monitor_should_be_started_again_after_backoff()
+{
+    schedr_monitor_set_restart_backoff(WAIT_US * 1000LL);
+    init_job("echo up", "up");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_true(wait_for_run());
+
+    // The line is only written again by the restarted monitor
+    job.last_exit_status = -1;
+
+    ssct_assert_true(wait_for_run());
+}
+
+static void stop_job_should_stop_monitor()
+{
+    init_job("sleep 5", "up");
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_scheduler_stop_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_false(schedr_monitor_is_running(&job));
+}
+
+static void jobs_with_same_monitor_command_should_share_one_monitor()
+{
+    Job other;
+    Job third;
+
+    init_job("echo 'eth0: up'; sleep 5", "wlan0");
+    other = job;
+    third = job;
+    schedr_job_set_trigger(&other, job.monitor, strlen(job.monitor), "^eth0: (up|down)$", strlen("^eth0: (up|down)$"));
+    schedr_job_set_trigger(&third, "sleep 5", strlen("sleep 5"), "up", strlen("up"));
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_scheduler_start_job(&other), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_scheduler_start_job(&third), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_monitor_count(), 2);
+
+    for (int i = 0; i < WAIT_ATTEMPTS && other.last_exit_status == -1; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+
+    ssct_assert_equals(other.last_exit_status, 0);
+    ssct_assert_equals(job.last_exit_status, -1);
+
+    // The monitor is killed with the last job that shares it
+    schedr_scheduler_stop_job(&other);
+
+    ssct_assert_true(schedr_monitor_is_running(&job));
+    ssct_assert_equals(schedr_monitor_count(), 2);
+
+    schedr_scheduler_stop_job(&job);
+    schedr_scheduler_stop_job(&third);
+
+    ssct_assert_equals(schedr_monitor_count(), 0);
+}
+
+static void jobs_with_monitor_commands_of_same_hash_should_get_monitors_of_their_own()
+{
+    Job other;
+
+    schedr_hash_set_string_hash(same_hash);
+
+    init_job("echo 'wlan0: up'; sleep 5", "up");
+    other = job;
+    schedr_job_set_trigger(&other, "sleep 0.1; echo 'eth0: up'; sleep 5", strlen("sleep 0.1; echo 'eth0: up'; sleep 5"), "eth0",
+                           strlen("eth0"));
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_scheduler_start_job(&other), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_monitor_count(), 2);
+
+    for (int i = 0; i < WAIT_ATTEMPTS && (job.last_exit_status == -1 || other.last_exit_status == -1); i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+
+    ssct_assert_equals(job.last_exit_status, 0);
+    ssct_assert_equals(other.last_exit_status, 0);
+
+    // Stopping a job kills its own monitor only
+    schedr_scheduler_stop_job(&job);
+
+    ssct_assert_true(schedr_monitor_is_running(&other));
+    ssct_assert_equals(schedr_monitor_count(), 1);
+
+    schedr_scheduler_stop_job(&other);
+
+    ssct_assert_equals(schedr_monitor_count(), 0);
+}
+
+static void functions_should_return_error_when_arguments_are_invalid()
+{
+    Job untriggered;
+
+    schedr_job_init(&untriggered);
+    init_job("sleep 5", "up");
+
+    ssct_assert_equals(schedr_monitor_start(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_monitor_start(&untriggered), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_monitor_start(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_monitor_start(&job), SCHEDR_ERROR_INVALID_ARGUMENT);
+
+    schedr_monitor_stop(&job);
+    schedr_monitor_stop(&untriggered);
+
+    ssct_assert_false(schedr_monitor_is_running(&job));
+
+    // Only the event loop reads monitors
+    schedr_scheduler_set_mode(Supervised);
+
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(start_job_should_run_job_when_monitor_outputs_matching_line);
+    ssct_run(start_job_should_not_run_triggered_job_without_match_or_interval);
+    ssct_run(monitor_should_match_line_written_in_parts);
+    ssct_run(monitor_should_not_run_paused_job);
+    ssct_run(monitor_should_wait_for_backoff_when_it_exits_right_away);
+    ssct_run(monitor_should_be_started_again_after_backoff);
+    ssct_run(stop_job_should_stop_monitor);
+    ssct_run(jobs_with_same_monitor_command_should_share_one_monitor);
+    ssct_run(jobs_with_monitor_commands_of_same_hash_should_get_monitors_of_their_own);
+    ssct_run(functions_should_return_error_when_arguments_are_invalid);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
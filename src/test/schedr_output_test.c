@@ -0,0 +1,167 @@
+#include <stdlib.h>         // EXIT_SUCCESS, setenv(), free()
+#include <stdio.h>          // FILE, open_memstream(), fclose(), snprintf()
+#include <string.h>         // strcmp(), strstr(), memset()
+#include <time.h>           // tzset()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_output.h"
+
+// 2017-07-14 02:40:00.123 UTC
+#define TEST_TIME_NS 1500000000123456789LL
+
+static OutputRing ring;
+static char *written;
+static size_t written_len;
+
+static void setup()
+{
+    schedr_output_init(&ring, SCHEDR_OUTPUT_MIN_RING_LEN);
+    written = NULL;
+}
+
+static void teardown()
+{
+    schedr_output_destroy(&ring);
+    free(written);
+}
+
+static Status write_ring()
+{
+    free(written);
+
+    FILE *fp = open_memstream(&written, &written_len);
+    Status status = schedr_output_write(&ring, fp);
+
+    fclose(fp);
+
+    return status;
+}
+
+static void init_should_return_error_when_arguments_are_invalid()
+{
+    OutputRing small;
+
+    ssct_assert_equals(schedr_output_init(NULL, SCHEDR_OUTPUT_MIN_RING_LEN), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_output_init(&small, SCHEDR_OUTPUT_MIN_RING_LEN - 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void append_should_return_error_when_arguments_are_invalid()
+{
+    ssct_assert_equals(schedr_output_append(NULL, OutputStdout, 0, "a", 1), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_output_append(&ring, OutputStdout, 0, NULL, 1), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_output_append(&ring, 2, 0, "a", 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void write_should_prefix_every_line_with_time_and_stream()
+{
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, "hello\nworld\n", 12);
+    schedr_output_append(&ring, OutputStderr, TEST_TIME_NS, "oops\n", 5);
+
+    ssct_assert_equals(write_ring(), SCHEDR_SUCCESS);
+    ssct_assert_equals(strcmp(written, "2017-07-14 02:40:00.123 out hello\n"
+                                       "2017-07-14 02:40:00.123 out world\n"
+                                       "2017-07-14 02:40:00.123 err oops\n"), 0);
+}
+
+static void write_should_write_nothing_when_ring_is_empty()
+{
+    ssct_assert_equals(write_ring(), SCHEDR_SUCCESS);
+    ssct_assert_zero(written_len);
+}
+
+static void append_should_continue_unfinished_line()
+{
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, "hel", 3);
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS + 1000000000LL, "lo\nnext", 7);
+
+    write_ring();
+
+    ssct_assert_equals(strcmp(written, "2017-07-14 02:40:00.123 out hello\n"
+                                       "2017-07-14 02:40:01.123 out next\n"), 0);
+}
+
+static void append_should_not_continue_line_of_other_stream()
+{
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, "abc", 3);
+    schedr_output_append(&ring, OutputStderr, TEST_TIME_NS, "def\n", 4);
+
+    write_ring();
+
+    ssct_assert_equals(strcmp(written, "2017-07-14 02:40:00.123 out abc\n"
+                                       "2017-07-14 02:40:00.123 err def\n"), 0);
+}
+
+static void append_should_drop_oldest_lines_when_ring_is_full()
+{
+    char line[32];
+
+    for (int i = 0; i < 1000; i++)
+    {
+        int len = snprintf(line, sizeof (line), "line %d\n", i);
+        schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, line, (size_t)len);
+    }
+
+    write_ring();
+
+    ssct_assert_true(ring.used <= ring.capacity);
+    ssct_assert_true(ring.dropped_bytes > 0);
+    ssct_assert_true(strstr(written, "out line 999\n") != NULL);
+    ssct_assert_true(strstr(written, "out line 0\n") == NULL);
+}
+
+static void append_should_keep_end_of_line_longer_than_ring()
+{
+    char long_line[3 * SCHEDR_OUTPUT_MIN_RING_LEN];
+
+    memset(long_line, 'a', sizeof (long_line));
+    memcpy(long_line + sizeof (long_line) - 5, "tail\n", 5);
+
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, "first\n", 6);
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, long_line, sizeof (long_line));
+
+    write_ring();
+
+    ssct_assert_true(ring.used <= ring.capacity);
+    ssct_assert_true(strstr(written, "first") == NULL);
+    ssct_assert_true(strstr(written, "aaaatail\n") != NULL);
+}
+
+static void append_should_keep_growing_line_within_ring()
+{
+    char chunk[100];
+
+    memset(chunk, 'b', sizeof (chunk));
+
+    for (int i = 0; i < 50; i++) { schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, chunk, sizeof (chunk)); }
+
+    schedr_output_append(&ring, OutputStdout, TEST_TIME_NS, "end\n", 4);
+
+    ssct_assert_equals(write_ring(), SCHEDR_SUCCESS);
+    ssct_assert_true(ring.used <= ring.capacity);
+    ssct_assert_true(strstr(written, "bend\n") != NULL);
+}
+
+int main(void)
+{
+    // The times are written in local time
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(init_should_return_error_when_arguments_are_invalid);
+    ssct_run(append_should_return_error_when_arguments_are_invalid);
+    ssct_run(write_should_prefix_every_line_with_time_and_stream);
+    ssct_run(write_should_write_nothing_when_ring_is_empty);
+    ssct_run(append_should_continue_unfinished_line);
+    ssct_run(append_should_not_continue_line_of_other_stream);
+    ssct_run(append_should_drop_oldest_lines_when_ring_is_full);
+    ssct_run(append_should_keep_end_of_line_longer_than_ring);
+    ssct_run(append_should_keep_growing_line_within_ring);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
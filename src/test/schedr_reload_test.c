@@ -0,0 +1,288 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <stdio.h>          // FILE, fopen(), fputs(), fclose(), snprintf(), rename()
+#include <string.h>         // strlen(), strcmp()
+#include <stdbool.h>        // bool
+#include <unistd.h>         // getpid(), usleep(), unlink(), rmdir()
+#include <sys/stat.h>       // mkdir()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_reload.h"
+#include "schedr_scheduler.h"
+#include "schedr_job_index.h"
+#include "schedr_job.h"
+#include "schedr_splay.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define WAIT_ATTEMPTS 200
+#define WAIT_US 10000
+
+static JobIndex jobs;
+static ReloadStats stats;
+static char dir[64];
+static char config_path[96];
+static int times_reloaded;
+
+static void setup()
+{
+    schedr_job_index_init(&jobs);
+    schedr_scheduler_set_mode(EventLoop);
+    times_reloaded = 0;
+
+    snprintf(dir, sizeof (dir), "/tmp/schedr_reload_test_%d", (int)getpid());
+    snprintf(config_path, sizeof (config_path), "%s/schedr.conf", dir);
+    mkdir(dir, 0700);
+}
+
+static void teardown()
+{
+    schedr_reload_unwatch();
+    schedr_scheduler_kill_children();
+    schedr_scheduler_set_mode(Supervised);
+    schedr_job_index_destroy(&jobs);
+
+    char path[128];
+    const char *files[] = { "schedr.conf", "schedr.conf.new", "other.conf" };
+
+    for (int i = 0; i < 3; i++)
+    {
+        snprintf(path, sizeof (path), "%s/%s", dir, files[i]);
+        unlink(path);
+    }
+
+    rmdir(dir);
+}
+
+static void init_job(Job *job_p, const char *name, const char *command)
+{
+    schedr_job_init(job_p);
+    schedr_job_set_name(job_p, name, strlen(name));
+    schedr_job_set_command(job_p, command, strlen(command));
+    schedr_job_compile_command(job_p);
+    schedr_job_set_interval(job_p, 3600 * NANOSECS_PER_SEC);
+}
+
+/*
+ * Starts 'job_p' and indexes it, like the daemon does with the jobs of the config file.
+ */
+static void start_job(Job *job_p)
+{
+    schedr_scheduler_start_job(job_p);
+    schedr_job_index_add(&jobs, job_p, false);
+}
+
+static void reload() { times_reloaded++; }
+
+static void write_file(const char *path, const char *contents)
+{
+    FILE *fp = fopen(path, "w");
+
+    fputs(contents, fp);
+    fclose(fp);
+}
+
+static bool wait_for_reloads(int expected)
+{
+    for (int i = 0; i < WAIT_ATTEMPTS && times_reloaded < expected; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+
+    return times_reloaded >= expected;
+}
+
+static void apply_should_start_new_jobs_and_remove_missing_ones()
+{
+    Job running;
+    Job configured;
+
+    init_job(&running, "Old", "/bin/true");
+    init_job(&configured, "New", "/bin/true");
+    start_job(&running);
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.started, 1);
+    ssct_assert_equals(stats.removed, 1);
+    ssct_assert_equals(jobs.len, 1);
+    ssct_assert_equals(running.state, Stopped);
+    ssct_assert_true(schedr_job_index_find(&jobs, "Old") == NULL);
+
+    Job *started = schedr_job_index_find(&jobs, "New");
+
+    // The job is a copy, so the loaded jobs can be freed
+    ssct_assert_true(started != NULL && started != &configured);
+    ssct_assert_equals(started->state, Running);
+}
+
+static void apply_should_leave_unchanged_jobs_alone()
+{
+    Job running;
+    Job configured;
+
+    init_job(&running, "Same", "/bin/true");
+    configured = running;
+    start_job(&running);
+    running.skipped_runs = 2;
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.unchanged, 1);
+    ssct_assert_true(schedr_job_index_find(&jobs, "Same") == &running);
+    ssct_assert_equals(running.state, Running);
+    ssct_assert_equals(running.skipped_runs, 2);
+}
+
+static void apply_should_update_changed_job_where_it_runs()
+{
+    Job running;
+    Job configured;
+
+    init_job(&running, "Changed", "/bin/true");
+    init_job(&configured, "Changed", "/bin/echo changed");
+    start_job(&running);
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.updated, 1);
+    ssct_assert_true(schedr_job_index_find(&jobs, "Changed") == &running);
+    ssct_assert_true(strcmp(running.command, "/bin/echo changed") == 0);
+    ssct_assert_equals(running.argc, 2);
+    ssct_assert_equals(running.state, Running);
+}
+
+static void apply_should_move_splay_offset_of_job_when_its_splay_changes()
+{
+    Job running;
+    Job configured;
+
+    init_job(&running, "Splayed", "/bin/true");
+    configured = running;
+    schedr_job_set_splay(&configured, 600 * NANOSECS_PER_SEC);
+    schedr_splay_assign_offsets(&configured, 1, SplayHashed, NULL);
+    start_job(&running);
+
+    // From no splay, the job takes the offset it would have been started with
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.updated, 1);
+    ssct_assert_true(running.splay_ns == configured.splay_ns);
+    ssct_assert_true(running.splay_offset_ns == configured.splay_offset_ns);
+    ssct_assert_true(running.splay_offset_ns > 0);
+
+    // A shorter splay never leaves an offset longer than itself, even one that was not assigned again
+    schedr_job_set_splay(&configured, NANOSECS_PER_SEC);
+    configured.splay_offset_ns = running.splay_offset_ns;
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.updated, 1);
+    ssct_assert_true(running.splay_ns == NANOSECS_PER_SEC);
+    ssct_assert_true(running.splay_offset_ns >= 0 && running.splay_offset_ns < NANOSECS_PER_SEC);
+
+    // Without a splay there is no offset
+    schedr_job_set_splay(&configured, 0);
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.updated, 1);
+    ssct_assert_zero(running.splay_offset_ns);
+    ssct_assert_equals(running.state, Running);
+}
+
+static void apply_should_start_job_again_when_its_limits_change()
+{
+    Job running;
+    Job configured;
+    Limits limits;
+
+    init_job(&running, "Limited", "/bin/true");
+    configured = running;
+    limits = configured.limits;
+    limits.pids = 10;
+    schedr_job_set_limits(&configured, &limits);
+    start_job(&running);
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, &configured, 1, &stats), SCHEDR_SUCCESS);
+    ssct_assert_equals(stats.restarted, 1);
+    ssct_assert_equals(running.state, Stopped);
+
+    Job *restarted = schedr_job_index_find(&jobs, "Limited");
+
+    ssct_assert_true(restarted != NULL && restarted != &running);
+    ssct_assert_equals(restarted->limits.pids, 10);
+    ssct_assert_equals(restarted->state, Running);
+}
+
+static void apply_should_reject_jobs_with_same_name()
+{
+    Job configured[2];
+
+    init_job(&(configured[0]), "Twice", "/bin/true");
+    init_job(&(configured[1]), "Twice", "/bin/false");
+
+    ssct_assert_equals(schedr_reload_apply(&jobs, configured, 2, &stats), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_zero(stats.started);
+    ssct_assert_true(schedr_job_index_find(&jobs, "Twice") == NULL);
+}
+
+static void watch_should_reload_when_config_file_is_written_or_replaced()
+{
+    char path[128];
+
+    write_file(config_path, "Job \"A\" run `true` every 1 h\n");
+
+    ssct_assert_equals(schedr_reload_watch(config_path, reload), SCHEDR_SUCCESS);
+
+    write_file(config_path, "Job \"A\" run `false` every 1 h\n");
+
+    ssct_assert_true(wait_for_reloads(1));
+
+    snprintf(path, sizeof (path), "%s/schedr.conf.new", dir);
+    write_file(path, "Job \"A\" run `true` every 1 h\n");
+    rename(path, config_path);
+
+    ssct_assert_true(wait_for_reloads(2));
+
+    // Other files of the directory are not the config file
+    snprintf(path, sizeof (path), "%s/other.conf", dir);
+    write_file(path, "");
+
+    for (int i = 0; i < 10; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(WAIT_US);
+    }
+
+    ssct_assert_equals(times_reloaded, 2);
+}
+
+static void functions_should_return_error_when_arguments_are_invalid()
+{
+    Job job;
+
+    init_job(&job, "Job", "/bin/true");
+
+    ssct_assert_equals(schedr_reload_apply(NULL, &job, 1, &stats), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_reload_apply(&jobs, NULL, 1, &stats), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_reload_apply(&jobs, &job, 1, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_reload_apply(&jobs, &job, -1, &stats), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_reload_watch(NULL, reload), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_reload_watch(config_path, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_reload_watch("/tmp/", reload), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_reload_watch("/nonexistent/dir/schedr.conf", reload), SCHEDR_FAILURE);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(apply_should_start_new_jobs_and_remove_missing_ones);
+    ssct_run(apply_should_leave_unchanged_jobs_alone);
+    ssct_run(apply_should_update_changed_job_where_it_runs);
+    ssct_run(apply_should_move_splay_offset_of_job_when_its_splay_changes);
+    ssct_run(apply_should_start_job_again_when_its_limits_change);
+    ssct_run(apply_should_reject_jobs_with_same_name);
+    ssct_run(watch_should_reload_when_config_file_is_written_or_replaced);
+    ssct_run(functions_should_return_error_when_arguments_are_invalid);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool, true, false
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_retry.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+
+static RetryPolicy policy;
+static RetryState state;
+static uint64_t next_random;
+
+static uint64_t mock_random_will_return_next() { return next_random; }
+
+static void setup()
+{
+    schedr_retry_init(&policy, &state);
+    policy.max_attempts = 3;
+    policy.backoff_ns = NANOSECS_PER_SEC;
+    policy.max_backoff_ns = 3 * NANOSECS_PER_SEC;
+    policy.jitter_percent = 0;
+
+    next_random = 0;
+    schedr_retry_set_random(mock_random_will_return_next);
+}
+
+static void teardown() { schedr_retry_reset_random(); }
+
+static void init_should_give_up_on_first_failure()
+{
+    int64_t delay_ns;
+
+    schedr_retry_init(&policy, &state);
+
+    ssct_assert_equals(schedr_retry_validate(&policy), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryGiveUp);
+    ssct_assert_zero(delay_ns);
+    ssct_assert_equals(state.failures, 1);
+    ssct_assert_equals(schedr_retry_init(NULL, &state), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_retry_init(&policy, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void validate_should_return_invalid_argument_error_when_policy_is_out_of_range()
+{
+    RetryPolicy invalid[5] = { policy, policy, policy, policy, policy };
+
+    invalid[0].max_attempts = -1;
+    invalid[1].backoff_ns = 0;
+    invalid[2].max_backoff_ns = policy.backoff_ns - 1;
+    invalid[3].jitter_percent = 101;
+    invalid[4].cooldown_ns = -1;
+
+    for (int i = 0; i < 5; i++) { ssct_assert_equals(schedr_retry_validate(&(invalid[i])), SCHEDR_ERROR_INVALID_ARGUMENT); }
+
+    ssct_assert_equals(schedr_retry_validate(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void record_should_double_backoff_up_to_cap()
+{
+    int64_t delay_ns;
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_equals(delay_ns, NANOSECS_PER_SEC);
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_equals(delay_ns, 2 * NANOSECS_PER_SEC);
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_equals(delay_ns, 3 * NANOSECS_PER_SEC);
+    ssct_assert_equals(state.backoff_ns, 3 * NANOSECS_PER_SEC);
+    ssct_assert_equals(state.failures_in_row, 3);
+}
+
+static void record_should_take_jitter_off_backoff()
+{
+    int64_t delay_ns;
+
+    policy.jitter_percent = 50;
+    next_random = 250000000ULL;
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_equals(delay_ns, 750000000LL);
+
+    // Never more than the jitter
+    next_random = NANOSECS_PER_SEC;
+    schedr_retry_record(&policy, &state, false, &delay_ns);
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_true(delay_ns >= NANOSECS_PER_SEC / 2 && delay_ns <= NANOSECS_PER_SEC);
+}
+
+static void record_should_give_up_after_max_attempts_without_cooldown()
+{
+    int64_t delay_ns;
+
+    for (int i = 0; i < 3; i++) { schedr_retry_record(&policy, &state, true, &delay_ns); }
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryGiveUp);
+    ssct_assert_equals(state.failures, 4);
+    ssct_assert_zero(state.breaker_trips);
+}
+
+static void record_should_open_breaker_after_max_attempts_and_close_it_on_success()
+{
+    int64_t delay_ns;
+
+    policy.cooldown_ns = 60 * NANOSECS_PER_SEC;
+
+    for (int i = 0; i < 3; i++) { schedr_retry_record(&policy, &state, true, &delay_ns); }
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterCooldown);
+    ssct_assert_equals(delay_ns, 60 * NANOSECS_PER_SEC);
+    ssct_assert_true(state.breaker_open);
+    ssct_assert_equals(state.breaker_trips, 1);
+
+    // A failed trial opens the breaker again right away
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterCooldown);
+    ssct_assert_equals(state.breaker_trips, 1);
+
+    ssct_assert_equals(schedr_retry_record(&policy, &state, false, &delay_ns), RetryOnSchedule);
+    ssct_assert_zero(delay_ns);
+    ssct_assert_false(state.breaker_open);
+    ssct_assert_zero(state.failures_in_row);
+    ssct_assert_zero(state.backoff_ns);
+    ssct_assert_equals(state.failures, 5);
+
+    // The backoff starts over
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, &delay_ns), RetryAfterBackoff);
+    ssct_assert_equals(delay_ns, NANOSECS_PER_SEC);
+}
+
+static void record_should_give_up_when_arguments_are_null()
+{
+    int64_t delay_ns;
+
+    ssct_assert_equals(schedr_retry_record(NULL, &state, true, &delay_ns), RetryGiveUp);
+    ssct_assert_equals(schedr_retry_record(&policy, NULL, true, &delay_ns), RetryGiveUp);
+    ssct_assert_equals(schedr_retry_record(&policy, &state, true, NULL), RetryGiveUp);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(init_should_give_up_on_first_failure);
+    ssct_run(validate_should_return_invalid_argument_error_when_policy_is_out_of_range);
+    ssct_run(record_should_double_backoff_up_to_cap);
+    ssct_run(record_should_take_jitter_off_backoff);
+    ssct_run(record_should_give_up_after_max_attempts_without_cooldown);
+    ssct_run(record_should_open_breaker_after_max_attempts_and_close_it_on_success);
+    ssct_run(record_should_give_up_when_arguments_are_null);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
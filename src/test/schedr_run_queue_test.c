@@ -0,0 +1,138 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <stdbool.h>        // bool, true, false
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_run_queue.h"
+
+static RunQueue queue;
+static RunQueueNode nodes[4];
+
+static void setup()
+{
+    schedr_run_queue_init(&queue, 0);
+
+    for (int i = 0; i < 4; i++) { schedr_run_queue_node_init(&(nodes[i]), &(nodes[i])); }
+}
+
+static void init_should_return_invalid_argument_error_when_max_slots_is_negative()
+{
+    ssct_assert_equals(schedr_run_queue_init(&queue, -1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_run_queue_init(NULL, 1), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void pop_should_return_nodes_in_the_order_they_were_pushed()
+{
+    schedr_run_queue_push(&queue, &(nodes[2]), 1, 0);
+    schedr_run_queue_push(&queue, &(nodes[0]), 1, 0);
+    schedr_run_queue_push(&queue, &(nodes[1]), 1, 0);
+
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[2]));
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[0]));
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[1]));
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == NULL);
+}
+
+static void pop_should_wait_until_first_node_has_enough_free_slots()
+{
+    schedr_run_queue_set_max_slots(&queue, 3);
+    schedr_run_queue_push(&queue, &(nodes[0]), 2, 0);
+    schedr_run_queue_push(&queue, &(nodes[1]), 2, 0);
+    schedr_run_queue_push(&queue, &(nodes[2]), 1, 0);
+
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[0]));
+
+    // The lighter node behind the first one does not get to go ahead of it
+    ssct_assert_false(schedr_run_queue_can_pop(&queue));
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == NULL);
+
+    schedr_run_queue_release(&queue, nodes[0].weight);
+
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[1]));
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[2]));
+    ssct_assert_equals(queue.stats.slots_in_use, 3);
+}
+
+static void pop_should_lower_weight_larger_than_max_slots()
+{
+    schedr_run_queue_set_max_slots(&queue, 2);
+    schedr_run_queue_push(&queue, &(nodes[0]), 5, 0);
+
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[0]));
+    ssct_assert_equals(nodes[0].weight, 2);
+    ssct_assert_equals(queue.stats.slots_in_use, 2);
+}
+
+static void push_should_return_invalid_argument_error_when_node_is_queued()
+{
+    schedr_run_queue_push(&queue, &(nodes[0]), 1, 0);
+
+    ssct_assert_equals(schedr_run_queue_push(&queue, &(nodes[0]), 1, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_run_queue_push(&queue, &(nodes[1]), 0, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(queue.stats.depth, 1);
+}
+
+static void remove_should_take_node_out_of_queue()
+{
+    schedr_run_queue_push(&queue, &(nodes[0]), 1, 0);
+    schedr_run_queue_push(&queue, &(nodes[1]), 1, 0);
+
+    ssct_assert_equals(schedr_run_queue_remove(&queue, &(nodes[0])), SCHEDR_SUCCESS);
+    ssct_assert_equals(schedr_run_queue_remove(&queue, &(nodes[0])), SCHEDR_SUCCESS);
+    ssct_assert_false(nodes[0].queued);
+    ssct_assert_equals(queue.stats.depth, 1);
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[1]));
+}
+
+static void requeue_should_put_node_first_and_free_its_slots()
+{
+    schedr_run_queue_set_max_slots(&queue, 1);
+    schedr_run_queue_push(&queue, &(nodes[0]), 1, 0);
+    schedr_run_queue_push(&queue, &(nodes[1]), 1, 0);
+
+    RunQueueNode *node = schedr_run_queue_pop(&queue, 0);
+
+    ssct_assert_equals(schedr_run_queue_requeue(&queue, node), SCHEDR_SUCCESS);
+    ssct_assert_zero(queue.stats.slots_in_use);
+    ssct_assert_zero(queue.stats.runs_admitted);
+    ssct_assert_true(schedr_run_queue_pop(&queue, 0) == &(nodes[0]));
+}
+
+static void stats_should_record_depth_and_wait_time()
+{
+    schedr_run_queue_set_max_slots(&queue, 1);
+    schedr_run_queue_push(&queue, &(nodes[0]), 1, 100);
+    schedr_run_queue_push(&queue, &(nodes[1]), 1, 200);
+    schedr_run_queue_push(&queue, &(nodes[2]), 1, 300);
+
+    schedr_run_queue_pop(&queue, 400);
+    schedr_run_queue_release(&queue, 1);
+    schedr_run_queue_pop(&queue, 1200);
+
+    ssct_assert_equals(queue.stats.depth, 1);
+    ssct_assert_equals(queue.stats.max_depth, 3);
+    ssct_assert_equals(queue.stats.runs_admitted, 2);
+    ssct_assert_equals(queue.stats.total_wait_ns, 300 + 1000);
+    ssct_assert_equals(queue.stats.max_wait_ns, 1000);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+
+    ssct_run(init_should_return_invalid_argument_error_when_max_slots_is_negative);
+
+    ssct_run(pop_should_return_nodes_in_the_order_they_were_pushed);
+    ssct_run(pop_should_wait_until_first_node_has_enough_free_slots);
+    ssct_run(pop_should_lower_weight_larger_than_max_slots);
+
+    ssct_run(push_should_return_invalid_argument_error_when_node_is_queued);
+    ssct_run(remove_should_take_node_out_of_queue);
+    ssct_run(requeue_should_put_node_first_and_free_its_slots);
+
+    ssct_run(stats_should_record_depth_and_wait_time);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -6,13 +6,33 @@
 #include <unistd.h>         // sleep()
 #include <sys/stat.h>       // stat()
 #include <errno.h>          // errno
+#include <time.h>           // clock_gettime(), TIMER_ABSTIME
+#include <stdint.h>         // int64_t
+#include <stdio.h>          // snprintf(), open_memstream()
+#include <string.h>         // strstr()
 
 #include "ssct.h"
 #include "schedr_status_codes.h"
 #include "schedr_scheduler.h"
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+#include "schedr_log.h"
+#include "schedr_uring.h"
+#include "schedr_time.h"
 
 #define mock_exec_expected_params "echo 'should call exec'"
 #define mock_sleep_expected_param 3600
+#define NANOSECS_PER_SEC 1000000000LL
+#define DRIFT_TEST_TICKS 10000
+#define DRIFT_TEST_RUNTIME_NS 37000000LL
+#define DRIFT_TEST_OVERSLEEP_NS 500000LL
+#define STRESS_TEST_JOBS 100000
+#define IN_FLIGHT_TEST_JOBS 2000
+#define IN_FLIGHT_TEST_RUNTIME_US 200000
+#define RUN_QUEUE_TEST_RUNTIME_US 50000
+#define OVERLAP_TEST_INTERVAL_NS 10000000LL
+#define OVERLAP_TEST_DURATION_NS 300000000LL
+#define SPLAY_TEST_OFFSET_NS 200000000LL
 
 const int DEFAULT_WAIT_TIMEOUT = 5000;
 const int MICROSECS_PER_MILLISEC = 1000;
@@ -25,6 +45,27 @@ static bool *mock_sleep_correct_params;
 static bool *mock_exec_file_exists;
 static bool *mock_exec_file_is_executable;
 
+/*
+ * A clock shared between the test, the process supervising the job and the
+ * processes running the command. Commands move it forward by their runtime
+ * and the sleeper by the time slept, plus some latency.
+ */
+struct FakeClock
+{
+    int64_t now_ns;
+    int64_t first_run_ns;
+    int64_t last_run_ns;
+    int runs;
+    bool sleeps_are_absolute;
+};
+
+static struct FakeClock *fake_clock;
+static pid_t *mock_exec_pid;
+
+// Slots occupied by the commands running right now, and the most that have been occupied at once
+static int *slots_in_use;
+static int *peak_slots_in_use;
+
 #define wait_until(expression, timeout) do {                    \
     int time_waited_millis = 0;                                 \
                                                                 \
@@ -70,6 +111,59 @@ static int mock_exec_will_verify_params(const char *file_name, char *const argv[
     _exit(EXIT_FAILURE);
 }
 
+static int mock_exec_will_verify_compiled_command(const char *file_name, char *const argv[], char *const envp[])
+{
+    *mock_exec_called = true;
+    *mock_exec_correct_params = (strcmp(file_name, "/bin/echo") == 0 && strcmp(argv[0], "/bin/echo") == 0 
+                                 && strcmp(argv[1], "compiled") == 0 && argv[2] == NULL);
+
+    _exit(EXIT_FAILURE);
+}
+
+static int mock_exec_will_ignore_sigterm(const char *file_name, char *const argv[], char *const envp[])
+{
+    signal(SIGTERM, SIG_IGN);
+    *mock_exec_pid = getpid();
+    
+    while (true) { pause(); }
+    
+    _exit(EXIT_FAILURE);
+}
+
+static int mock_exec_will_wait_forever(const char *file_name, char *const argv[], char *const envp[])
+{
+    *mock_exec_pid = getpid();
+    
+    while (true) { pause(); }
+    
+    _exit(EXIT_FAILURE);
+}
+
+static int mock_exec_will_run_for_a_while(const char *file_name, char *const argv[], char *const envp[])
+{
+    usleep(IN_FLIGHT_TEST_RUNTIME_US);
+    
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * The shell command of the job is the number of slots the command occupies.
+ */
+static int mock_exec_will_occupy_slots_for_a_while(const char *file_name, char *const argv[], char *const envp[])
+{
+    int slots = atoi(argv[2]);
+    int in_use = __atomic_add_fetch(slots_in_use, slots, __ATOMIC_SEQ_CST);
+    int peak = __atomic_load_n(peak_slots_in_use, __ATOMIC_SEQ_CST);
+    
+    while (in_use > peak && !__atomic_compare_exchange_n(peak_slots_in_use, &peak, in_use, false, 
+                                                         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) { }
+    
+    usleep(RUN_QUEUE_TEST_RUNTIME_US);
+    __atomic_sub_fetch(slots_in_use, slots, __ATOMIC_SEQ_CST);
+    
+    _exit(EXIT_SUCCESS);
+}
+
 static int mock_exec_will_exit_unsuccessfully(const char *file_name, char *const argv[], char *const envp[])
 {
     _exit(EXIT_FAILURE);
@@ -82,6 +176,13 @@ static int mock_exec_will_count_times_called(const char *file_name, char *const
     _exit(EXIT_SUCCESS);
 }
 
+static int mock_exec_will_count_times_called_and_fail(const char *file_name, char *const argv[], char *const envp[])
+{
+    *times_exec_called += 1;
+    
+    _exit(EXIT_FAILURE);
+}
+
 static int mock_exec_will_check_if_file_exists_and_is_executable(const char *file_name, char *const argv[], char *const envp[]) 
 {
     struct stat file_stat;
@@ -126,9 +227,15 @@ static void will_wait_forever()
 
 static pid_t mock_fork_will_fail(void) { return -1; }
 
-static unsigned int mock_sleep(unsigned int seconds) 
+static int mock_sleep(clockid_t clock_id, int flags, const struct timespec *request, struct timespec *remain) 
 {
-    if (seconds == mock_sleep_expected_param)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    time_t seconds = request->tv_sec - now.tv_sec;
+    
+    if (clock_id == CLOCK_MONOTONIC && flags == TIMER_ABSTIME 
+        && seconds <= mock_sleep_expected_param && seconds >= mock_sleep_expected_param - 1)
     {
         *mock_sleep_correct_params = true; 
     }
@@ -136,6 +243,54 @@ static unsigned int mock_sleep(unsigned int seconds)
     return 0;
 }
 
+static int mock_clock_will_read_fake_clock(clockid_t clock_id, struct timespec *now)
+{
+    now->tv_sec = fake_clock->now_ns / NANOSECS_PER_SEC;
+    now->tv_nsec = fake_clock->now_ns % NANOSECS_PER_SEC;
+    
+    return 0;
+}
+
+static int mock_sleep_will_advance_fake_clock(clockid_t clock_id, int flags, const struct timespec *request, struct timespec *remain)
+{
+    int64_t request_ns = (int64_t)request->tv_sec * NANOSECS_PER_SEC + request->tv_nsec;
+    
+    if (flags != TIMER_ABSTIME) { fake_clock->sleeps_are_absolute = false; }
+    if (request_ns > fake_clock->now_ns) { fake_clock->now_ns = request_ns; }
+    
+    fake_clock->now_ns += DRIFT_TEST_OVERSLEEP_NS;
+    
+    return 0;
+}
+
+static int mock_exec_will_take_time_to_run(const char *file_name, char *const argv[], char *const envp[])
+{
+    if (fake_clock->runs == 0) { fake_clock->first_run_ns = fake_clock->now_ns; }
+    
+    fake_clock->last_run_ns = fake_clock->now_ns;
+    fake_clock->runs++;
+    fake_clock->now_ns += DRIFT_TEST_RUNTIME_NS;
+    
+    _exit(fake_clock->runs < DRIFT_TEST_TICKS ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static void run_job_on_fake_clock(JobTiming timing, int ticks_timeout)
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 1 * NANOSECS_PER_SEC, .state = Stopped, .timing = timing };
+    
+    fake_clock = (struct FakeClock *)create_shared_memory(sizeof (struct FakeClock));
+    fake_clock->now_ns = 1000 * NANOSECS_PER_SEC;
+    fake_clock->runs = 0;
+    fake_clock->sleeps_are_absolute = true;
+    
+    schedr_scheduler_set_exec(mock_exec_will_take_time_to_run);
+    schedr_scheduler_set_sleeper(mock_sleep_will_advance_fake_clock);
+    schedr_time_set_clock(mock_clock_will_read_fake_clock);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until(fake_clock->runs >= DRIFT_TEST_TICKS, ticks_timeout);
+}
+
 static void setup() 
 {
     schedr_scheduler_set_exec(mock_exec_will_exit_unsuccessfully);
@@ -144,9 +299,14 @@ static void setup()
 static void teardown()
 {
     schedr_scheduler_kill_children();
+    schedr_scheduler_set_mode(Supervised);
+    schedr_scheduler_set_max_concurrent(0);
     schedr_scheduler_reset_exec();
     schedr_scheduler_reset_forker();
     schedr_scheduler_reset_sleeper();
+    schedr_time_reset_clock();
+    schedr_spawn_set_backend(ForkExec);
+    schedr_zygote_stop();
 }
 
 static void start_job_should_call_exec_with_correct_params()
@@ -156,7 +316,7 @@ static void start_job_should_call_exec_with_correct_params()
     *mock_exec_called = false;
     *mock_exec_correct_params = false; 
 
-    Job job = { .name = "Test", .command = mock_exec_expected_params, .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = mock_exec_expected_params, .interval_ns = 0, .state = Stopped };
     schedr_scheduler_set_exec(mock_exec_will_verify_params);
 
     schedr_scheduler_start_job(&job);
@@ -172,7 +332,7 @@ static void start_job_should_call_exec_with_correct_params()
 
 static void start_job_should_return_success_when_job_starts_successfully()
 {
-    Job job = { .name = "Test", .command = "echo hello", .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = "echo hello", .interval_ns = 0, .state = Stopped };
 
     Status status = schedr_scheduler_start_job(&job);
 
@@ -181,7 +341,7 @@ static void start_job_should_return_success_when_job_starts_successfully()
 
 static void start_job_should_set_job_state_to_running()
 {
-    Job job = { .name = "Test", .command = "echo hello", .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = "echo hello", .interval_ns = 0, .state = Stopped };
 
     schedr_scheduler_start_job(&job);
 
@@ -190,7 +350,7 @@ static void start_job_should_set_job_state_to_running()
 
 static void start_job_should_return_fork_failed_error()
 {
-    Job job = { .name = "Test", .command = "ehco", .interval_seconds = 1, .state = Stopped };
+    Job job = { .name = "Test", .command = "ehco", .interval_ns = 1 * NANOSECS_PER_SEC, .state = Stopped };
 
     schedr_scheduler_set_forker(mock_fork_will_fail);
     Status status = schedr_scheduler_start_job(&job);
@@ -200,7 +360,7 @@ static void start_job_should_return_fork_failed_error()
 
 static void start_job_should_call_exec_repeatedly()
 {
-    Job job = { .name = "Test", .command = "echo", .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
     times_exec_called = (int *)create_shared_memory(sizeof (int));
     *times_exec_called = 0;
     
@@ -217,21 +377,56 @@ static void start_job_should_call_exec_repeatedly()
 
 static void start_job_should_pass_3600_seconds_to_sleep()
 {
-    Job job = { .name = "Test", .command = "echo", .interval_seconds = mock_sleep_expected_param, .state = Stopped };
+    Job job = { .name = "Test", .command = "echo", .interval_ns = mock_sleep_expected_param * NANOSECS_PER_SEC, .state = Stopped };
     
     mock_sleep_correct_params = (bool *)create_shared_memory(sizeof (bool));
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *mock_sleep_correct_params = false;
+    *times_exec_called = 0;
     
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
     schedr_scheduler_set_sleeper(mock_sleep);
     schedr_scheduler_start_job(&job);
     
-    ssct_assert_true(mock_sleep_correct_params);
+    wait_until(*mock_sleep_correct_params, DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(*mock_sleep_correct_params);
     
     munmap(mock_sleep_correct_params, sizeof (bool));
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void start_job_should_keep_fixed_rate_job_on_its_grid()
+{
+    run_job_on_fake_clock(FixedRate, DEFAULT_WAIT_TIMEOUT * 12);
+    
+    // Every run is late by at most the latency of a single sleep, no matter how many runs came before it
+    int64_t grid_ns = fake_clock->first_run_ns + (int64_t)(fake_clock->runs - 1) * NANOSECS_PER_SEC;
+    int64_t drift_ns = fake_clock->last_run_ns - grid_ns;
+    
+    ssct_assert_equals(fake_clock->runs, DRIFT_TEST_TICKS);
+    ssct_assert_true(fake_clock->sleeps_are_absolute);
+    ssct_assert_true(drift_ns >= 0 && drift_ns <= DRIFT_TEST_OVERSLEEP_NS);
+    
+    munmap(fake_clock, sizeof (struct FakeClock));
+}
+
+static void start_job_should_wait_interval_after_run_of_fixed_delay_job()
+{
+    run_job_on_fake_clock(FixedDelay, DEFAULT_WAIT_TIMEOUT * 12);
+    
+    int64_t period_ns = NANOSECS_PER_SEC + DRIFT_TEST_RUNTIME_NS + DRIFT_TEST_OVERSLEEP_NS;
+    int64_t expected_ns = fake_clock->first_run_ns + (int64_t)(fake_clock->runs - 1) * period_ns;
+    
+    ssct_assert_equals(fake_clock->runs, DRIFT_TEST_TICKS);
+    ssct_assert_equals(fake_clock->last_run_ns, expected_ns);
+    
+    munmap(fake_clock, sizeof (struct FakeClock));
 }
 
 static void start_job_should_exec_executable_file_with_absolute_path()
 {
-    Job job = { .name = "Test", .command = "/home/danalm/git/schedr/res/debug/test/test_script.sh", .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = "/home/danalm/git/schedr/res/debug/test/test_script.sh", .interval_ns = 0, .state = Stopped };
     
     mock_exec_file_exists = (bool *)create_shared_memory(sizeof (bool));
     mock_exec_file_is_executable = (bool *)create_shared_memory(sizeof (bool));
@@ -256,7 +451,7 @@ static void start_job_should_exec_executable_file_with_relative_path()
 {
     system("mkdir -p $HOME/.config/schedr/bin");
     system("cp res/debug/test/test_script.sh $HOME/.config/schedr/bin");
-    Job job = { .name = "Test", .command = "test_script.sh", .interval_seconds = 0, .state = Stopped };
+    Job job = { .name = "Test", .command = "test_script.sh", .interval_ns = 0, .state = Stopped };
     
     mock_exec_file_exists = (bool *)create_shared_memory(sizeof (bool));
     mock_exec_file_is_executable = (bool *)create_shared_memory(sizeof (bool));
@@ -293,7 +488,7 @@ static void set_path_should_create_config_dirs_when_they_do_not_exist()
 
 static void stop_job_should_set_state_to_stopped()
 {
-    Job job = { .name = "Test", .command = "echo", .interval_seconds = 0, .state = Running };
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Running };
     
     schedr_scheduler_stop_job(&job);
     
@@ -302,7 +497,7 @@ static void stop_job_should_set_state_to_stopped()
 
 static void stop_job_should_stop_process_associated_with_job()
 {
-    Job job = { .name = "Test", .command = "echo", .interval_seconds = 0, .state = Running };
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Running };
     
     pid_t child_pid;
     
@@ -328,28 +523,1128 @@ static void stop_job_should_stop_process_associated_with_job()
     }
 }
 
-int main(void)
+static void start_job_should_return_invalid_argument_error_when_job_is_already_started()
 {
-    system("rm -rf $HOME/.config/schedr");
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
     
-    ssct_run(set_path_should_create_config_dirs_when_they_do_not_exist);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
     
-    schedr_scheduler_set_path();
+    ssct_assert_equals(schedr_scheduler_start_job(&job), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void shuffle(int *values, int len)
+{
+    for (int i = len - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        int tmp = values[i];
+        values[i] = values[j];
+        values[j] = tmp;
+    }
+}
+
+static void start_and_stop_job_should_keep_track_of_jobs_started_and_stopped_in_random_order()
+{
+    Job *jobs = (Job *)malloc(sizeof (Job) * STRESS_TEST_JOBS);
+    int *order = (int *)malloc(sizeof (int) * STRESS_TEST_JOBS);
+    bool tracked_correctly = true;
     
-    ssct_setup = setup;
-    ssct_teardown = teardown;
+    srand(11);
+    
+    schedr_scheduler_set_mode(EventLoop);
+    
+    for (int i = 0; i < STRESS_TEST_JOBS; i++)
+    {
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_interval(&(jobs[i]), 3600 * NANOSECS_PER_SEC);
+        order[i] = i;
+        
+        if (schedr_scheduler_start_job(&(jobs[i])) != SCHEDR_SUCCESS) { tracked_correctly = false; }
+    }
+    
+    // Stop half of the jobs, start them again and then stop every job, all in random order
+    shuffle(order, STRESS_TEST_JOBS);
+    
+    for (int i = 0; i < STRESS_TEST_JOBS / 2; i++) { schedr_scheduler_stop_job(&(jobs[order[i]])); }
+    
+    for (int i = 0; i < STRESS_TEST_JOBS; i++)
+    {
+        bool should_be_started = (jobs[i].state == Running);
+        
+        if (schedr_scheduler_job_is_started(&(jobs[i])) != should_be_started) { tracked_correctly = false; }
+    }
+    
+    shuffle(order, STRESS_TEST_JOBS);
+    
+    for (int i = 0; i < STRESS_TEST_JOBS; i++)
+    {
+        if (jobs[order[i]].state == Stopped) { schedr_scheduler_start_job(&(jobs[order[i]])); }
+    }
+    
+    shuffle(order, STRESS_TEST_JOBS);
+    
+    for (int i = 0; i < STRESS_TEST_JOBS; i++) { schedr_scheduler_stop_job(&(jobs[order[i]])); }
+    
+    for (int i = 0; i < STRESS_TEST_JOBS; i++)
+    {
+        if (schedr_scheduler_job_is_started(&(jobs[i])) || jobs[i].state != Stopped) { tracked_correctly = false; }
+    }
+    
+    ssct_assert_true(tracked_correctly);
+    
+    free(jobs);
+    free(order);
+}
 
-    ssct_run(start_job_should_call_exec_with_correct_params);
-    ssct_run(start_job_should_return_success_when_job_starts_successfully);
-    ssct_run(start_job_should_set_job_state_to_running);
-    ssct_run(start_job_should_return_fork_failed_error);
-    ssct_run(start_job_should_call_exec_repeatedly);
-    ssct_run(start_job_should_pass_3600_seconds_to_sleep);
-    ssct_run(start_job_should_exec_executable_file_with_absolute_path);
-    ssct_run(start_job_should_exec_executable_file_with_relative_path);
+static void set_mode_should_return_invalid_argument_error_when_mode_is_out_of_range()
+{
+    ssct_assert_equals(schedr_scheduler_set_mode(-1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_set_mode(SCHEDR_SCHEDULER_MODE_VALUES), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void set_mode_should_return_invalid_argument_error_when_jobs_are_started()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
     
-    ssct_run(stop_job_should_set_state_to_stopped);
-    ssct_run(stop_job_should_stop_process_associated_with_job);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    ssct_assert_equals(schedr_scheduler_set_mode(Supervised), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void event_loop_start_job_should_not_fork()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    
+    schedr_scheduler_set_forker(mock_fork_will_fail);
+    schedr_scheduler_set_mode(EventLoop);
+    
+    Status status = schedr_scheduler_start_job(&job);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.state, Running);
+}
+
+static void event_loop_run_once_should_call_exec_with_correct_params()
+{
+    mock_exec_called = (bool *)create_shared_memory(sizeof (bool));
+    mock_exec_correct_params = (bool *)create_shared_memory(sizeof (bool));
+    *mock_exec_called = false;
+    *mock_exec_correct_params = false; 
+
+    Job job = { .name = "Test", .command = mock_exec_expected_params, .interval_ns = 0, .state = Stopped };
+    schedr_scheduler_set_exec(mock_exec_will_verify_params);
+    schedr_scheduler_set_mode(EventLoop);
+
+    schedr_scheduler_start_job(&job);
+    schedr_scheduler_run_once();
+    
+    wait_until(*mock_exec_called && *mock_exec_correct_params, DEFAULT_WAIT_TIMEOUT);
+
+    ssct_assert_true(*mock_exec_called);
+    ssct_assert_true(*mock_exec_correct_params);
+    
+    munmap(mock_exec_called, sizeof (bool));
+    munmap(mock_exec_correct_params, sizeof(bool));
+}
+
+static void event_loop_run_once_should_return_fork_failed_error()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    
+    schedr_scheduler_set_forker(mock_fork_will_fail);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    ssct_assert_equals(schedr_scheduler_run_once(), SCHEDR_ERROR_FORK_FAILED);
+}
+
+static void event_loop_should_call_exec_repeatedly()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 10), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(*times_exec_called >= 10);
+
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_should_run_job_with_sub_second_interval()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 50 * 1000000LL, .state = Stopped, .timing = FixedRate };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    struct timespec start, now;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    do
+    {
+        schedr_scheduler_run_once();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * NANOSECS_PER_SEC + (now.tv_nsec - start.tv_nsec) < 500 * 1000000LL);
+    
+    // Ten runs fit in half a second, give some room for a slow machine
+    ssct_assert_true(*times_exec_called >= 5);
+    ssct_assert_true(*times_exec_called <= 11);
+
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_should_record_exit_status_and_duration_of_command()
+{
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "echo", strlen("echo"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    schedr_scheduler_set_exec(mock_exec_will_run_for_a_while);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_zero(job.last_exit_status);
+    ssct_assert_true(job.last_duration_ns >= IN_FLIGHT_TEST_RUNTIME_US * 1000LL);
+    ssct_assert_true(job.last_cpu_ns >= 0);
+    ssct_assert_equals(job.state, Running);
+}
+
+static void event_loop_should_record_latency_of_runs()
+{
+    Job jobs[2];
+    
+    for (int i = 0; i < 2; i++)
+    {
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_command(&(jobs[i]), "echo", strlen("echo"));
+        schedr_job_set_interval(&(jobs[i]), 3600 * NANOSECS_PER_SEC);
+    }
+    
+    ssct_assert_true(schedr_scheduler_get_latency(NULL) == NULL);
+    
+    schedr_scheduler_set_exec(mock_exec_will_run_for_a_while);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&(jobs[0]));
+    schedr_scheduler_start_job(&(jobs[1]));
+    
+    wait_until((schedr_scheduler_run_once(), jobs[0].last_exit_status != -1 && jobs[1].last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    const JobLatency *latency = schedr_scheduler_get_latency(&(jobs[0]));
+    const JobLatency *all = schedr_scheduler_get_latency(NULL);
+    
+    ssct_assert_true(latency != NULL && all != NULL);
+    ssct_assert_equals(latency->lag.count, 1);
+    ssct_assert_equals(latency->spawn.count, 1);
+    ssct_assert_equals(latency->runtime.count, 1);
+    ssct_assert_true(latency->lag.max_ns >= 0 && latency->lag.max_ns < NANOSECS_PER_SEC);
+    ssct_assert_true(latency->spawn.max_ns > 0);
+    ssct_assert_equals(latency->runtime.max_ns, jobs[0].last_duration_ns);
+    ssct_assert_equals(all->lag.count, 2);
+    ssct_assert_equals(all->runtime.count, 2);
+}
+
+static void event_loop_stop_job_should_not_wait_for_command_to_exit()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    mock_exec_pid = (pid_t *)create_shared_memory(sizeof (pid_t));
+    *mock_exec_pid = 0;
+    struct timespec start, end;
+    
+    schedr_scheduler_set_exec(mock_exec_will_ignore_sigterm);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_scheduler_run_once();
+    
+    wait_until(*mock_exec_pid != 0, DEFAULT_WAIT_TIMEOUT);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    schedr_scheduler_stop_job(&job);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    ssct_assert_true(end.tv_sec - start.tv_sec < 1);
+    ssct_assert_false(schedr_scheduler_job_is_started(&job));
+    ssct_assert_true(kill(*mock_exec_pid, 0) == 0);
+    
+    munmap(mock_exec_pid, sizeof (pid_t));
+}
+
+static void event_loop_should_reap_command_of_stopped_job()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    mock_exec_pid = (pid_t *)create_shared_memory(sizeof (pid_t));
+    *mock_exec_pid = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_wait_forever);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_scheduler_run_once();
+    
+    wait_until(*mock_exec_pid != 0, DEFAULT_WAIT_TIMEOUT);
+    
+    pid_t cmd_pid = *mock_exec_pid;
+    schedr_scheduler_stop_job(&job);
+    
+    // A zombie can still be signalled, so the process is only gone once it has been reaped
+    wait_until((schedr_scheduler_run_once(), kill(cmd_pid, 0) < 0 && errno == ESRCH), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(kill(cmd_pid, 0) < 0 && errno == ESRCH);
+    
+    munmap(mock_exec_pid, sizeof (pid_t));
+}
+
+static void event_loop_should_track_thousands_of_commands_in_flight()
+{
+    Job *jobs = (Job *)malloc(sizeof (Job) * IN_FLIGHT_TEST_JOBS);
+    int reaped = 0;
+    bool succeeded = true;
+    
+    schedr_scheduler_set_exec(mock_exec_will_run_for_a_while);
+    schedr_scheduler_set_mode(EventLoop);
+    
+    for (int i = 0; i < IN_FLIGHT_TEST_JOBS; i++)
+    {
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_command(&(jobs[i]), "echo", strlen("echo"));
+        schedr_job_set_interval(&(jobs[i]), 3600 * NANOSECS_PER_SEC);
+        schedr_scheduler_start_job(&(jobs[i]));
+    }
+    
+    // Every command is run once, the next runs are an hour away
+    while (reaped < IN_FLIGHT_TEST_JOBS)
+    {
+        schedr_scheduler_run_once();
+        reaped = 0;
+        
+        for (int i = 0; i < IN_FLIGHT_TEST_JOBS; i++)
+        {
+            if (jobs[i].last_exit_status != -1) { reaped++; }
+            if (jobs[i].last_exit_status != -1 && jobs[i].last_exit_status != EXIT_SUCCESS) { succeeded = false; }
+        }
+    }
+    
+    ssct_assert_true(succeeded);
+    
+    ssct_assert_equals(reaped, IN_FLIGHT_TEST_JOBS);
+    
+    schedr_scheduler_kill_children();
+    free(jobs);
+}
+
+/*
+ * Runs every job once with the command occupying as many slots as the weight
+ * of the job, returning false if any run failed.
+ */
+static bool run_weighted_jobs_once(Job *jobs, const int *weights, int jobs_len)
+{
+    bool succeeded = true;
+    int reaped = 0;
+    
+    slots_in_use = (int *)create_shared_memory(sizeof (int));
+    peak_slots_in_use = (int *)create_shared_memory(sizeof (int));
+    *slots_in_use = 0;
+    *peak_slots_in_use = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_occupy_slots_for_a_while);
+    schedr_scheduler_set_mode(EventLoop);
+    
+    for (int i = 0; i < jobs_len; i++)
+    {
+        char command[16];
+        snprintf(command, sizeof (command), "%d", weights[i]);
+        
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_command(&(jobs[i]), command, strlen(command));
+        schedr_job_set_interval(&(jobs[i]), 3600 * NANOSECS_PER_SEC);
+        schedr_job_set_weight(&(jobs[i]), weights[i]);
+        schedr_scheduler_start_job(&(jobs[i]));
+    }
+    
+    for (int iteration = 0; reaped < jobs_len && iteration < DEFAULT_WAIT_TIMEOUT; iteration++)
+    {
+        schedr_scheduler_run_once();
+        reaped = 0;
+        
+        for (int i = 0; i < jobs_len; i++)
+        {
+            if (jobs[i].last_exit_status != -1) { reaped++; }
+            if (jobs[i].last_exit_status != -1 && jobs[i].last_exit_status != EXIT_SUCCESS) { succeeded = false; }
+        }
+    }
+    
+    return succeeded && reaped == jobs_len;
+}
+
+static void event_loop_should_not_run_more_commands_than_max_concurrent()
+{
+    const int weights[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+    const int jobs_len = sizeof (weights) / sizeof (weights[0]);
+    Job jobs[sizeof (weights) / sizeof (weights[0])];
+    RunQueueStats stats;
+    
+    ssct_assert_equals(schedr_scheduler_set_max_concurrent(2), SCHEDR_SUCCESS);
+    ssct_assert_true(run_weighted_jobs_once(jobs, weights, jobs_len));
+    ssct_assert_equals(*peak_slots_in_use, 2);
+    
+    // Every job was due at once, the last two had to wait for three rounds of commands
+    schedr_scheduler_get_run_queue_stats(&stats);
+    
+    ssct_assert_zero(stats.depth);
+    ssct_assert_equals(stats.max_depth, jobs_len);
+    ssct_assert_equals(stats.runs_admitted, jobs_len);
+    ssct_assert_true(stats.max_wait_ns >= 3 * RUN_QUEUE_TEST_RUNTIME_US * 1000LL);
+    ssct_assert_true(stats.total_wait_ns >= stats.max_wait_ns);
+    
+    munmap(slots_in_use, sizeof (int));
+    munmap(peak_slots_in_use, sizeof (int));
+}
+
+static void event_loop_should_count_weight_of_job_against_max_concurrent()
+{
+    const int weights[] = { 2, 1, 2, 1, 3, 2 };
+    const int jobs_len = sizeof (weights) / sizeof (weights[0]);
+    Job jobs[sizeof (weights) / sizeof (weights[0])];
+    
+    schedr_scheduler_set_max_concurrent(3);
+    
+    ssct_assert_true(run_weighted_jobs_once(jobs, weights, jobs_len));
+    ssct_assert_equals(*peak_slots_in_use, 3);
+    
+    munmap(slots_in_use, sizeof (int));
+    munmap(peak_slots_in_use, sizeof (int));
+}
+
+/*
+ * Runs a job taking five intervals to run, with the given overlap policy, for
+ * thirty intervals. The peak number of slots in use is the number of commands
+ * of the job that ran at the same time.
+ */
+static void run_overlapping_job(Job *job, OverlapPolicy overlap, int max_parallel)
+{
+    struct timespec start, now;
+    
+    slots_in_use = (int *)create_shared_memory(sizeof (int));
+    peak_slots_in_use = (int *)create_shared_memory(sizeof (int));
+    *slots_in_use = 0;
+    *peak_slots_in_use = 0;
+    
+    schedr_job_init(job);
+    schedr_job_set_command(job, "1", strlen("1"));
+    schedr_job_set_interval(job, OVERLAP_TEST_INTERVAL_NS);
+    schedr_job_set_timing(job, FixedRate);
+    schedr_job_set_overlap(job, overlap, max_parallel);
+    
+    schedr_scheduler_set_exec(mock_exec_will_occupy_slots_for_a_while);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(job);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    do
+    {
+        schedr_scheduler_run_once();
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } 
+    while ((now.tv_sec - start.tv_sec) * NANOSECS_PER_SEC + (now.tv_nsec - start.tv_nsec) < OVERLAP_TEST_DURATION_NS);
+}
+
+static void event_loop_should_skip_runs_due_while_job_is_running()
+{
+    Job job;
+    
+    run_overlapping_job(&job, OverlapSkip, 1);
+    
+    ssct_assert_equals(*peak_slots_in_use, 1);
+    ssct_assert_true(job.skipped_runs >= 10);
+    ssct_assert_zero(job.queued_runs);
+    ssct_assert_equals(job.state, Running);
+    
+    munmap(slots_in_use, sizeof (int));
+    munmap(peak_slots_in_use, sizeof (int));
+}
+
+static void event_loop_should_hold_one_run_due_while_job_is_running()
+{
+    Job job;
+    
+    run_overlapping_job(&job, OverlapQueue, 1);
+    
+    // Every run but the first was held while the one before it was running
+    ssct_assert_equals(*peak_slots_in_use, 1);
+    ssct_assert_true(job.queued_runs >= 3);
+    ssct_assert_true(job.skipped_runs >= 3 * job.queued_runs);
+    
+    munmap(slots_in_use, sizeof (int));
+    munmap(peak_slots_in_use, sizeof (int));
+}
+
+static void event_loop_should_run_up_to_max_parallel_commands_of_job()
+{
+    Job job;
+    
+    run_overlapping_job(&job, OverlapParallel, 3);
+    
+    ssct_assert_equals(*peak_slots_in_use, 3);
+    ssct_assert_true(job.skipped_runs >= 1);
+    ssct_assert_zero(job.queued_runs);
+    
+    schedr_scheduler_stop_job(&job);
+    
+    ssct_assert_false(schedr_scheduler_job_is_started(&job));
+    
+    munmap(slots_in_use, sizeof (int));
+    munmap(peak_slots_in_use, sizeof (int));
+}
+
+static void event_loop_should_delay_first_run_by_splay_offset()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped, 
+                .last_exit_status = -1, .splay_ns = 2 * SPLAY_TEST_OFFSET_NS, .splay_offset_ns = SPLAY_TEST_OFFSET_NS };
+    struct timespec start, ran;
+    
+    schedr_scheduler_set_mode(EventLoop);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    clock_gettime(CLOCK_MONOTONIC, &ran);
+    
+    ssct_assert_true(job.last_exit_status != -1);
+    ssct_assert_true((ran.tv_sec - start.tv_sec) * NANOSECS_PER_SEC + (ran.tv_nsec - start.tv_nsec) >= SPLAY_TEST_OFFSET_NS);
+}
+
+static void set_max_concurrent_should_return_invalid_argument_error_when_max_is_negative()
+{
+    ssct_assert_equals(schedr_scheduler_set_max_concurrent(-1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_get_run_queue_stats(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void event_loop_should_stop_job_when_command_fails()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.state == Stopped), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(job.state, Stopped);
+}
+
+static void start_job_should_retry_failed_command_until_max_attempts()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    RetryPolicy policy = { .max_attempts = 2, .backoff_ns = NANOSECS_PER_SEC / 100, .max_backoff_ns = NANOSECS_PER_SEC / 50, 
+                           .jitter_percent = 0, .cooldown_ns = 0 };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_job_set_retry(&job, &policy);
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called_and_fail);
+    schedr_scheduler_start_job(&job);
+    
+    // The supervisor exits once it has given up on the job
+    wait_until(*times_exec_called >= 3, DEFAULT_WAIT_TIMEOUT);
+    usleep(100000);
+    
+    ssct_assert_equals(*times_exec_called, 3);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_should_retry_failed_command_and_open_breaker_after_max_attempts()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 3600 * NANOSECS_PER_SEC, .state = Stopped };
+    RetryPolicy policy = { .max_attempts = 2, .backoff_ns = NANOSECS_PER_SEC / 100, .max_backoff_ns = NANOSECS_PER_SEC / 50, 
+                           .jitter_percent = 0, .cooldown_ns = NANOSECS_PER_SEC / 20 };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_job_set_retry(&job, &policy);
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called_and_fail);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    // The first run, two retries and a trial after the cooldown, long before the interval is up
+    wait_until((schedr_scheduler_run_once(), job.retry_state.failures >= 4), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(*times_exec_called, 4);
+    ssct_assert_equals(job.state, Running);
+    ssct_assert_true(job.retry_state.breaker_open);
+    ssct_assert_equals(job.retry_state.breaker_trips, 1);
+    ssct_assert_equals(job.retry_state.backoff_ns, NANOSECS_PER_SEC / 20);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_should_not_run_stopped_job()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_scheduler_stop_job(&job);
+    schedr_scheduler_run_once();
+    
+    usleep(MICROSECS_PER_MILLISEC * WAIT_MILLISEC * 10);
+    
+    ssct_assert_zero(*times_exec_called);
+    ssct_assert_equals(job.state, Stopped);
+
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_should_not_run_paused_job_until_it_is_resumed()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = NANOSECS_PER_SEC / 100, .state = Stopped };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 2), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(schedr_scheduler_pause_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(job.state, Paused);
+    
+    // The command that was running when the job was paused still finishes
+    wait_until((schedr_scheduler_run_once(), schedr_scheduler_get_cmds_in_flight() == 0), DEFAULT_WAIT_TIMEOUT);
+    
+    int times_called = *times_exec_called;
+    
+    for (int i = 0; i < 10; i++)
+    {
+        schedr_scheduler_run_once();
+        usleep(MICROSECS_PER_MILLISEC * WAIT_MILLISEC);
+    }
+    
+    ssct_assert_equals(*times_exec_called, times_called);
+    ssct_assert_equals(schedr_scheduler_resume_job(&job), SCHEDR_SUCCESS);
+    ssct_assert_equals(job.state, Running);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called > times_called), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(*times_exec_called > times_called);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_run_job_now_should_run_job_before_it_is_due()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = NANOSECS_PER_SEC * 3600, .state = Stopped };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    
+    ssct_assert_equals(schedr_scheduler_run_job_now(&job), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_run_job_now(NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+    
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 1 && schedr_scheduler_get_cmds_in_flight() == 0),
+               DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(schedr_scheduler_run_job_now(&job), SCHEDR_SUCCESS);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 2), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(*times_exec_called, 2);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static void event_loop_remove_job_should_stop_job_and_free_its_output()
+{
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "/bin/echo removed", strlen("/bin/echo removed"));
+    schedr_job_compile_command(&job);
+    schedr_job_set_interval(&job, NANOSECS_PER_SEC * 3600);
+    
+    schedr_scheduler_reset_exec();
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), schedr_scheduler_get_output(&job) != NULL), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(schedr_scheduler_get_output(&job) != NULL);
+    
+    schedr_scheduler_remove_job(&job);
+    
+    ssct_assert_equals(job.state, Stopped);
+    ssct_assert_true(schedr_scheduler_get_output(&job) == NULL);
+    ssct_assert_true(schedr_scheduler_get_latency(&job) == NULL);
+    ssct_assert_equals(schedr_scheduler_pause_job(&job), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void event_loop_update_job_should_move_waiting_run_to_new_interval()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = NANOSECS_PER_SEC * 3600, .state = Stopped, .max_parallel = 1 };
+    Job updated = job;
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    
+    ssct_assert_equals(schedr_scheduler_update_job(&job, &updated), SCHEDR_ERROR_INVALID_ARGUMENT);
+    
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 1 && schedr_scheduler_get_cmds_in_flight() == 0),
+               DEFAULT_WAIT_TIMEOUT);
+    
+    // The next run is an hour away until the interval is shortened
+    updated.interval_ns = NANOSECS_PER_SEC / 100;
+    
+    ssct_assert_equals(schedr_scheduler_update_job(&job, &updated), SCHEDR_SUCCESS);
+    ssct_assert_true(job.interval_ns == NANOSECS_PER_SEC / 100);
+    
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 3), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(*times_exec_called >= 3);
+    
+    // The runs of the job are set up for one command at a time
+    updated.overlap = OverlapParallel;
+    updated.max_parallel = 2;
+    
+    ssct_assert_equals(schedr_scheduler_update_job(&job, &updated), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_update_job(NULL, &updated), SCHEDR_ERROR_NULL_ARGUMENT);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static int times_reload_handler_called = 0;
+
+static void count_reloads() { times_reload_handler_called++; }
+
+static void event_loop_should_call_reload_handler_on_sighup()
+{
+    times_reload_handler_called = 0;
+    
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_set_reload_handler(count_reloads);
+    
+    // The loop signals are blocked by the first iteration
+    schedr_scheduler_run_once();
+    kill(getpid(), SIGHUP);
+    
+    wait_until((schedr_scheduler_run_once(), times_reload_handler_called > 0), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_equals(times_reload_handler_called, 1);
+    
+    schedr_scheduler_set_reload_handler(NULL);
+}
+
+static void event_loop_should_exec_compiled_command_without_shell()
+{
+    mock_exec_called = (bool *)create_shared_memory(sizeof (bool));
+    mock_exec_correct_params = (bool *)create_shared_memory(sizeof (bool));
+    *mock_exec_called = false;
+    *mock_exec_correct_params = false; 
+
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "/bin/echo compiled", strlen("/bin/echo compiled"));
+    schedr_job_compile_command(&job);
+    
+    schedr_scheduler_set_exec(mock_exec_will_verify_compiled_command);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    schedr_scheduler_run_once();
+    
+    wait_until(*mock_exec_called, DEFAULT_WAIT_TIMEOUT);
+
+    ssct_assert_true(*mock_exec_called);
+    ssct_assert_true(*mock_exec_correct_params);
+    
+    munmap(mock_exec_called, sizeof (bool));
+    munmap(mock_exec_correct_params, sizeof(bool));
+}
+
+static void event_loop_should_stop_job_when_shell_can_not_be_executed()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    char *shell = strdup(getenv("SHELL"));
+    
+    setenv("SHELL", "/nonexistent/shell", true);
+    schedr_spawn_set_backend(PosixSpawn);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    Status status = schedr_scheduler_run_once();
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(job.state, Stopped);
+    
+    setenv("SHELL", shell, true);
+    free(shell);
+}
+
+static void event_loop_should_wake_up_when_zygote_reports_finished_command()
+{
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "sleep 0.05", strlen("sleep 0.05"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_zero(job.last_exit_status);
+    ssct_assert_true(job.last_duration_ns >= 50000000LL);
+    ssct_assert_equals(job.state, Running);
+}
+
+static void event_loop_should_capture_output_of_command()
+{
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "echo hello; echo oops >&2", strlen("echo hello; echo oops >&2"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    char *written = NULL;
+    size_t written_len = 0;
+    FILE *fp = open_memstream(&written, &written_len);
+    
+    schedr_scheduler_reset_exec();
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    const OutputRing *ring = schedr_scheduler_get_output(&job);
+    
+    ssct_assert_true(ring != NULL);
+    
+    if (ring != NULL) { schedr_output_write(ring, fp); }
+    
+    fclose(fp);
+    
+    ssct_assert_true(written != NULL && strstr(written, " out hello\n") != NULL);
+    ssct_assert_true(written != NULL && strstr(written, " err oops\n") != NULL);
+    
+    free(written);
+}
+
+static void event_loop_should_run_command_with_limits_of_job()
+{
+    Limits limits = { .memory_bytes = 64 * 1024 * 1024 };
+    
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "ulimit -v", strlen("ulimit -v"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    schedr_job_set_limits(&job, &limits);
+    
+    char *written = NULL;
+    size_t written_len = 0;
+    FILE *fp = open_memstream(&written, &written_len);
+    
+    // Without cgroups the limits are set with setrlimit()
+    schedr_scheduler_reset_exec();
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    const OutputRing *ring = schedr_scheduler_get_output(&job);
+    
+    if (ring != NULL) { schedr_output_write(ring, fp); }
+    
+    fclose(fp);
+    
+    ssct_assert_zero(job.last_exit_status);
+    ssct_assert_true(written != NULL && strstr(written, " out 65536\n") != NULL);
+    
+    free(written);
+}
+
+static void event_loop_should_write_output_of_command_to_log()
+{
+    static const char LOG_PATH[] = "/tmp/schedr_scheduler_test.log";
+    LogRotation rotation = { .max_file_len = 0, .max_age_ns = 0, .keep = 1 };
+    char contents[256] = { 0 };
+    
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Logged", strlen("Logged"));
+    schedr_job_set_command(&job, "printf 'hel'; sleep 0.05; echo lo", strlen("printf 'hel'; sleep 0.05; echo lo"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    unlink(LOG_PATH);
+    schedr_log_open(LOG_PATH, &rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_scheduler_reset_exec();
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    schedr_log_close();
+    
+    FILE *fp = fopen(LOG_PATH, "r");
+    
+    if (fp != NULL)
+    {
+        fread(contents, 1, sizeof (contents) - 1, fp);
+        fclose(fp);
+    }
+    
+    // The line written in two parts is logged as one
+    ssct_assert_true(strstr(contents, " Logged out hello\n") != NULL);
+    
+    unlink(LOG_PATH);
+}
+
+static void event_loop_should_capture_and_log_output_through_io_uring()
+{
+    static const char LOG_PATH[] = "/tmp/schedr_scheduler_uring_test.log";
+    LogRotation rotation = { .max_file_len = 0, .max_age_ns = 0, .keep = 1 };
+    char contents[256] = { 0 };
+    
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_name(&job, "Logged", strlen("Logged"));
+    schedr_job_set_command(&job, "printf 'hel'; sleep 0.05; echo lo; echo oops >&2", 
+                           strlen("printf 'hel'; sleep 0.05; echo lo; echo oops >&2"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    // The kernel may not support io_uring, the loop then stays on epoll
+    if (schedr_scheduler_set_loop_backend(LoopUring) == SCHEDR_ERROR_NOT_IMPLEMENTED) { return; }
+    
+    unlink(LOG_PATH);
+    schedr_log_open(LOG_PATH, &rotation, SCHEDR_LOG_MIN_BUFFER_LEN);
+    schedr_scheduler_reset_exec();
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    wait_until((schedr_scheduler_run_once(), job.last_exit_status != -1), DEFAULT_WAIT_TIMEOUT);
+    
+    schedr_log_close();
+    
+    FILE *fp = fopen(LOG_PATH, "r");
+    
+    if (fp != NULL)
+    {
+        fread(contents, 1, sizeof (contents) - 1, fp);
+        fclose(fp);
+    }
+    
+    ssct_assert_zero(job.last_exit_status);
+    ssct_assert_true(schedr_scheduler_get_output(&job) != NULL);
+    ssct_assert_true(strstr(contents, " Logged out hello\n") != NULL);
+    ssct_assert_true(strstr(contents, " Logged err oops\n") != NULL);
+    
+    unlink(LOG_PATH);
+}
+
+static void event_loop_should_run_jobs_repeatedly_through_io_uring()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = NANOSECS_PER_SEC / 100, .state = Stopped };
+    times_exec_called = (int *)create_shared_memory(sizeof (int));
+    *times_exec_called = 0;
+    
+    if (schedr_scheduler_set_loop_backend(LoopUring) == SCHEDR_ERROR_NOT_IMPLEMENTED) { return; }
+    
+    schedr_scheduler_set_exec(mock_exec_will_count_times_called);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    // Every run is timed by the ring and reaped after SIGCHLD has been read through it
+    wait_until((schedr_scheduler_run_once(), *times_exec_called >= 10), DEFAULT_WAIT_TIMEOUT);
+    
+    ssct_assert_true(*times_exec_called >= 10);
+    ssct_assert_equals(job.state, Running);
+    
+    munmap(times_exec_called, sizeof (int));
+}
+
+static int failing_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    (void)entries;
+    (void)params;
+    errno = ENOSYS;
+    
+    return -1;
+}
+
+static void set_loop_backend_should_return_not_implemented_error_when_kernel_lacks_io_uring()
+{
+    schedr_uring_set_setup(failing_uring_setup);
+    
+    ssct_assert_equals(schedr_scheduler_set_loop_backend(LoopUring), SCHEDR_ERROR_NOT_IMPLEMENTED);
+    
+    schedr_uring_reset_setup();
+}
+
+static void set_loop_backend_should_return_invalid_argument_error()
+{
+    Job job;
+    schedr_job_init(&job);
+    schedr_job_set_command(&job, "true", strlen("true"));
+    schedr_job_set_interval(&job, 3600 * NANOSECS_PER_SEC);
+    
+    ssct_assert_equals(schedr_scheduler_set_loop_backend((LoopBackend)-1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_set_loop_backend((LoopBackend)SCHEDR_SCHEDULER_LOOP_BACKEND_VALUES), 
+                       SCHEDR_ERROR_INVALID_ARGUMENT);
+    
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_start_job(&job);
+    
+    ssct_assert_equals(schedr_scheduler_set_loop_backend(LoopUring), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void get_output_should_return_null_when_job_has_not_written_anything()
+{
+    Job job = { .name = "Test", .command = "echo", .interval_ns = 0, .state = Stopped };
+    
+    ssct_assert_true(schedr_scheduler_get_output(&job) == NULL);
+}
+
+static void set_output_len_should_return_invalid_argument_error_when_len_is_too_small()
+{
+    ssct_assert_equals(schedr_scheduler_set_output_len(SCHEDR_OUTPUT_MIN_RING_LEN - 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_set_output_len(SCHEDR_OUTPUT_MIN_RING_LEN), SCHEDR_SUCCESS);
+}
+
+static void watched_fd_handler(int fd, void *data)
+{
+    char byte;
+    
+    if (read(fd, &byte, 1) == 1) { (*(int *)data)++; }
+}
+
+static void watch_fd_should_call_handler_when_fd_is_readable()
+{
+    int fds[2];
+    int times_called = 0;
+    
+    pipe(fds);
+    
+    ssct_assert_equals(schedr_scheduler_watch_fd(fds[0], false, watched_fd_handler, &times_called), SCHEDR_SUCCESS);
+    
+    write(fds[1], "x", 1);
+    schedr_scheduler_set_mode(EventLoop);
+    schedr_scheduler_run_once();
+    
+    ssct_assert_equals(times_called, 1);
+    
+    schedr_scheduler_unwatch_fd(fds[0]);
+    write(fds[1], "x", 1);
+    schedr_scheduler_run_once();
+    
+    ssct_assert_equals(times_called, 1);
+    
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void watch_fd_should_return_error_when_arguments_are_invalid()
+{
+    int data = 0;
+    
+    ssct_assert_equals(schedr_scheduler_watch_fd(0, false, NULL, &data), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_scheduler_watch_fd(-1, false, watched_fd_handler, &data), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void run_should_return_invalid_argument_error_when_not_in_event_loop_mode()
+{
+    ssct_assert_equals(schedr_scheduler_run(), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+int main(void)
+{
+    system("rm -rf $HOME/.config/schedr");
+    
+    ssct_run(set_path_should_create_config_dirs_when_they_do_not_exist);
+    
+    schedr_scheduler_set_path();
+    
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(start_job_should_call_exec_with_correct_params);
+    ssct_run(start_job_should_return_success_when_job_starts_successfully);
+    ssct_run(start_job_should_set_job_state_to_running);
+    ssct_run(start_job_should_return_fork_failed_error);
+    ssct_run(start_job_should_call_exec_repeatedly);
+    ssct_run(start_job_should_pass_3600_seconds_to_sleep);
+    ssct_run(start_job_should_keep_fixed_rate_job_on_its_grid);
+    ssct_run(start_job_should_wait_interval_after_run_of_fixed_delay_job);
+    ssct_run(start_job_should_exec_executable_file_with_absolute_path);
+    ssct_run(start_job_should_exec_executable_file_with_relative_path);
+    
+    ssct_run(stop_job_should_set_state_to_stopped);
+    ssct_run(stop_job_should_stop_process_associated_with_job);
+    
+    ssct_run(start_job_should_return_invalid_argument_error_when_job_is_already_started);
+    ssct_run(start_and_stop_job_should_keep_track_of_jobs_started_and_stopped_in_random_order);
+    ssct_run(set_mode_should_return_invalid_argument_error_when_mode_is_out_of_range);
+    ssct_run(set_mode_should_return_invalid_argument_error_when_jobs_are_started);
+    ssct_run(event_loop_start_job_should_not_fork);
+    ssct_run(event_loop_run_once_should_call_exec_with_correct_params);
+    ssct_run(event_loop_run_once_should_return_fork_failed_error);
+    ssct_run(event_loop_should_call_exec_repeatedly);
+    ssct_run(event_loop_should_run_job_with_sub_second_interval);
+    ssct_run(event_loop_should_record_exit_status_and_duration_of_command);
+    ssct_run(event_loop_should_record_latency_of_runs);
+    ssct_run(event_loop_stop_job_should_not_wait_for_command_to_exit);
+    ssct_run(event_loop_should_reap_command_of_stopped_job);
+    ssct_run(event_loop_should_track_thousands_of_commands_in_flight);
+    ssct_run(event_loop_should_not_run_more_commands_than_max_concurrent);
+    ssct_run(event_loop_should_count_weight_of_job_against_max_concurrent);
+    ssct_run(set_max_concurrent_should_return_invalid_argument_error_when_max_is_negative);
+    ssct_run(event_loop_should_delay_first_run_by_splay_offset);
+    ssct_run(event_loop_should_wake_up_when_zygote_reports_finished_command);
+    ssct_run(event_loop_should_capture_output_of_command);
+    ssct_run(event_loop_should_run_command_with_limits_of_job);
+    ssct_run(event_loop_should_write_output_of_command_to_log);
+    ssct_run(event_loop_should_capture_and_log_output_through_io_uring);
+    ssct_run(event_loop_should_run_jobs_repeatedly_through_io_uring);
+    ssct_run(set_loop_backend_should_return_not_implemented_error_when_kernel_lacks_io_uring);
+    ssct_run(set_loop_backend_should_return_invalid_argument_error);
+    ssct_run(get_output_should_return_null_when_job_has_not_written_anything);
+    ssct_run(set_output_len_should_return_invalid_argument_error_when_len_is_too_small);
+    ssct_run(watch_fd_should_call_handler_when_fd_is_readable);
+    ssct_run(watch_fd_should_return_error_when_arguments_are_invalid);
+    ssct_run(event_loop_should_skip_runs_due_while_job_is_running);
+    ssct_run(event_loop_should_hold_one_run_due_while_job_is_running);
+    ssct_run(event_loop_should_run_up_to_max_parallel_commands_of_job);
+    ssct_run(event_loop_should_stop_job_when_command_fails);
+    ssct_run(start_job_should_retry_failed_command_until_max_attempts);
+    ssct_run(event_loop_should_retry_failed_command_and_open_breaker_after_max_attempts);
+    ssct_run(event_loop_should_not_run_stopped_job);
+    ssct_run(event_loop_should_not_run_paused_job_until_it_is_resumed);
+    ssct_run(event_loop_run_job_now_should_run_job_before_it_is_due);
+    ssct_run(event_loop_remove_job_should_stop_job_and_free_its_output);
+    ssct_run(event_loop_update_job_should_move_waiting_run_to_new_interval);
+    ssct_run(event_loop_should_call_reload_handler_on_sighup);
+    ssct_run(event_loop_should_exec_compiled_command_without_shell);
+    ssct_run(event_loop_should_stop_job_when_shell_can_not_be_executed);
+    ssct_run(run_should_return_invalid_argument_error_when_not_in_event_loop_mode);
     
     ssct_print_summary();
 
@@ -0,0 +1,379 @@
+#include <stdlib.h>         // EXIT_SUCCESS, EXIT_FAILURE
+#include <stdbool.h>        // bool, true, false
+#include <sys/types.h>      // pid_t
+#include <sys/wait.h>       // waitpid()
+#include <sys/mman.h>       // mmap(), munmap()
+#include <unistd.h>         // _exit()
+#include <errno.h>          // EAGAIN, ENOENT
+#include <poll.h>           // poll()
+#include <fcntl.h>          // fcntl()
+#include <string.h>         // strcmp()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_spawn.h"
+#include "schedr_zygote.h"
+
+static bool *mock_exec_called;
+
+static void *create_shared_memory(size_t bytes) 
+{
+    int protection = PROT_READ | PROT_WRITE;
+    int visibility = MAP_ANONYMOUS | MAP_SHARED;
+    return mmap(NULL, bytes, protection, visibility, 0, 0);
+}
+
+static int exit_status_of(pid_t pid)
+{
+    int status;
+    waitpid(pid, &status, 0);
+    
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int mock_exec_will_set_called(const char *file_name, char *const argv[], char *const envp[])
+{
+    *mock_exec_called = (strcmp(file_name, "/bin/sh") == 0 && strcmp(argv[2], "true") == 0);
+    
+    _exit(EXIT_SUCCESS);
+}
+
+static pid_t mock_fork_will_fail(void) { return -1; }
+
+static int mock_spawn_will_fail_with_eagain(pid_t *pid, const char *path, const posix_spawn_file_actions_t *file_actions,
+                                            const posix_spawnattr_t *attr, char *const argv[], char *const envp[])
+{
+    return EAGAIN;
+}
+
+/*
+ * Collects commands with schedr_spawn_reap() until 'pid' has exited, or gives up after a second.
+ */
+static int reaped_exit_status_of(pid_t pid)
+{
+    int status;
+    struct rusage usage;
+    pid_t reaped = 0;
+    
+    for (int waits = 0; reaped != pid && waits < 100; waits++)
+    {
+        schedr_spawn_reap(&reaped, &status, &usage);
+        
+        if (reaped != pid) { poll(NULL, 0, 10); }
+    }
+    
+    return (reaped == pid && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+}
+
+static void teardown()
+{
+    schedr_spawn_set_backend(ForkExec);
+    schedr_spawn_reset_exec();
+    schedr_spawn_reset_forker();
+    schedr_spawn_reset_spawner();
+    schedr_zygote_stop();
+}
+
+static void set_backend_should_return_invalid_argument_error_when_backend_is_out_of_range()
+{
+    ssct_assert_equals(schedr_spawn_set_backend(-1), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_spawn_set_backend(SCHEDR_SPAWN_BACKEND_VALUES), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void spawn_should_return_null_argument_error_when_arguments_are_null()
+{
+    char *argv[] = { "/bin/true", NULL };
+    pid_t pid;
+    
+    ssct_assert_equals(schedr_spawn(NULL, argv, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_spawn("/bin/true", NULL, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_spawn("/bin/true", argv, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void fork_exec_should_call_exec_with_correct_params()
+{
+    char *argv[] = { "/bin/sh", "-c", "true", NULL };
+    pid_t pid;
+    mock_exec_called = (bool *)create_shared_memory(sizeof (bool));
+    *mock_exec_called = false;
+    
+    schedr_spawn_set_exec(mock_exec_will_set_called);
+    Status status = schedr_spawn(argv[0], argv, &pid);
+    exit_status_of(pid);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_true(*mock_exec_called);
+    
+    munmap(mock_exec_called, sizeof (bool));
+}
+
+static void fork_exec_should_return_fork_failed_error()
+{
+    char *argv[] = { "/bin/true", NULL };
+    pid_t pid;
+    
+    schedr_spawn_set_forker(mock_fork_will_fail);
+    
+    ssct_assert_equals(schedr_spawn(argv[0], argv, &pid), SCHEDR_ERROR_FORK_FAILED);
+}
+
+static void posix_spawn_should_run_command()
+{
+    char *argv[] = { "/bin/sh", "-c", "exit 3", NULL };
+    pid_t pid;
+    
+    schedr_spawn_set_backend(PosixSpawn);
+    Status status = schedr_spawn(argv[0], argv, &pid);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(exit_status_of(pid), 3);
+}
+
+static void posix_spawn_should_return_failure_when_file_can_not_be_executed()
+{
+    char *argv[] = { "/nonexistent/command", NULL };
+    pid_t pid;
+    
+    schedr_spawn_set_backend(PosixSpawn);
+    
+    ssct_assert_equals(schedr_spawn(argv[0], argv, &pid), SCHEDR_FAILURE);
+}
+
+static void posix_spawn_should_return_fork_failed_error_when_out_of_processes()
+{
+    char *argv[] = { "/bin/true", NULL };
+    pid_t pid;
+    
+    schedr_spawn_set_backend(PosixSpawn);
+    schedr_spawn_set_spawner(mock_spawn_will_fail_with_eagain);
+    
+    ssct_assert_equals(schedr_spawn(argv[0], argv, &pid), SCHEDR_ERROR_FORK_FAILED);
+}
+
+static void spawned_process_should_not_inherit_blocked_signals(SpawnBackend backend)
+{
+    char *argv[] = { "/bin/sh", "-c", "grep -q 'SigBlk:.0000000000000000' /proc/self/status", NULL };
+    sigset_t blocked, original;
+    pid_t pid;
+    
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &blocked, &original);
+    
+    schedr_spawn_set_backend(backend);
+    schedr_spawn(argv[0], argv, &pid);
+    
+    ssct_assert_equals(exit_status_of(pid), EXIT_SUCCESS);
+    
+    sigprocmask(SIG_SETMASK, &original, NULL);
+}
+
+static void zygote_should_run_command_that_is_not_a_child_of_the_daemon()
+{
+    char *argv[] = { "/bin/sh", "-c", "exit 3", NULL };
+    pid_t pid;
+    
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    Status status = schedr_spawn(argv[0], argv, &pid);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(waitpid(pid, NULL, WNOHANG), -1);
+    ssct_assert_equals(reaped_exit_status_of(pid), 3);
+}
+
+static void zygote_should_fall_back_on_posix_spawn_when_zygote_is_not_running()
+{
+    char *argv[] = { "/bin/sh", "-c", "exit 4", NULL };
+    pid_t pid;
+    
+    schedr_spawn_set_backend(Zygote);
+    Status status = schedr_spawn(argv[0], argv, &pid);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(exit_status_of(pid), 4);
+}
+
+static void spawn_reap_should_collect_commands_left_by_stopped_zygote()
+{
+    char *argv[] = { "/bin/sh", "-c", "sleep 0.1; exit 5", NULL };
+    pid_t pid;
+    
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    schedr_spawn(argv[0], argv, &pid);
+    schedr_zygote_stop();
+    
+    ssct_assert_equals(reaped_exit_status_of(pid), 5);
+}
+
+static void spawn_reap_should_store_zero_when_no_command_has_exited()
+{
+    pid_t pid = 1;
+    int status;
+    struct rusage usage;
+    
+    ssct_assert_equals(schedr_spawn_reap(&pid, &status, &usage), SCHEDR_SUCCESS);
+    ssct_assert_zero(pid);
+    ssct_assert_equals(schedr_spawn_reap(NULL, &status, &usage), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void spawned_process_should_write_to_redirected_stdout(SpawnBackend backend)
+{
+    char *argv[] = { "/bin/sh", "-c", "echo hello", NULL };
+    char output[16] = { 0 };
+    int pipe_fds[2];
+    pid_t pid;
+    
+    pipe(pipe_fds);
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+    
+    int fds[] = { 0, pipe_fds[1], 2 };
+    
+    schedr_spawn_set_backend(backend);
+    Status status = schedr_spawn_redirected(argv[0], argv, fds, &pid);
+    close(pipe_fds[1]);
+    
+    // The write end must not be left open in the process, or the read would not end when it exits
+    ssize_t len = read(pipe_fds[0], output, sizeof (output) - 1);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_equals(len, 6);
+    ssct_assert_equals(strcmp(output, "hello\n"), 0);
+    ssct_assert_zero(read(pipe_fds[0], output, sizeof (output)));
+    
+    close(pipe_fds[0]);
+    reaped_exit_status_of(pid);
+}
+
+static void fork_exec_should_redirect_stdout() { spawned_process_should_write_to_redirected_stdout(ForkExec); }
+static void posix_spawn_should_redirect_stdout() { spawned_process_should_write_to_redirected_stdout(PosixSpawn); }
+
+static void zygote_should_redirect_stdout()
+{
+    schedr_zygote_start();
+    spawned_process_should_write_to_redirected_stdout(Zygote);
+}
+
+/*
+ * Runs 'argv' with 'limits' and reads what it writes to stdout into 'output',
+ * returning the number of bytes read.
+ */
+static ssize_t output_of_limited(SpawnBackend backend, char *argv[], const Limits *limits, char *output, size_t len)
+{
+    int pipe_fds[2];
+    pid_t pid;
+    
+    pipe(pipe_fds);
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+    
+    int fds[] = { 0, pipe_fds[1], 2 };
+    
+    schedr_spawn_set_backend(backend);
+    Status status = schedr_spawn_limited(argv[0], argv, fds, limits, -1, &pid);
+    close(pipe_fds[1]);
+    
+    ssize_t read_len = read(pipe_fds[0], output, len - 1);
+    
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    
+    close(pipe_fds[0]);
+    reaped_exit_status_of(pid);
+    
+    return read_len;
+}
+
+static void spawned_process_should_run_with_limits(SpawnBackend backend)
+{
+    char *argv[] = { "/bin/sh", "-c", "ulimit -v", NULL };
+    char output[16] = { 0 };
+    Limits limits = { .memory_bytes = 64 * 1024 * 1024 };
+    
+    ssct_assert_equals(output_of_limited(backend, argv, &limits, output, sizeof (output)), 6);
+    ssct_assert_equals(strcmp(output, "65536\n"), 0);
+}
+
+static void spawned_process_should_run_with_placement(SpawnBackend backend)
+{
+    char *argv[] = { "/bin/sh", "-c", "nice", NULL };
+    char output[16] = { 0 };
+    Limits limits = { .nice_set = true, .nice = SCHEDR_LIMITS_MAX_NICE };
+    
+    ssct_assert_equals(output_of_limited(backend, argv, &limits, output, sizeof (output)), 3);
+    ssct_assert_equals(strcmp(output, "19\n"), 0);
+}
+
+static void fork_exec_should_run_command_with_limits() { spawned_process_should_run_with_limits(ForkExec); }
+static void posix_spawn_should_run_command_with_limits() { spawned_process_should_run_with_limits(PosixSpawn); }
+
+static void zygote_should_run_command_with_limits()
+{
+    schedr_zygote_start();
+    spawned_process_should_run_with_limits(Zygote);
+}
+
+static void fork_exec_should_run_command_with_placement() { spawned_process_should_run_with_placement(ForkExec); }
+static void posix_spawn_should_run_command_with_placement() { spawned_process_should_run_with_placement(PosixSpawn); }
+
+static void zygote_should_run_command_with_placement()
+{
+    schedr_zygote_start();
+    spawned_process_should_run_with_placement(Zygote);
+}
+
+static void zygote_should_return_failure_when_limited_file_can_not_be_executed()
+{
+    char *argv[] = { "/nonexistent", NULL };
+    Limits limits = { .pids = 1000 };
+    pid_t pid;
+    
+    schedr_zygote_start();
+    schedr_spawn_set_backend(Zygote);
+    
+    ssct_assert_equals(schedr_spawn_limited(argv[0], argv, NULL, &limits, -1, &pid), SCHEDR_FAILURE);
+    ssct_assert_true(schedr_zygote_is_running());
+}
+
+static void fork_exec_should_not_inherit_blocked_signals() { spawned_process_should_not_inherit_blocked_signals(ForkExec); }
+static void posix_spawn_should_not_inherit_blocked_signals() { spawned_process_should_not_inherit_blocked_signals(PosixSpawn); }
+
+int main(void)
+{
+    ssct_teardown = teardown;
+    
+    ssct_run(set_backend_should_return_invalid_argument_error_when_backend_is_out_of_range);
+    ssct_run(spawn_should_return_null_argument_error_when_arguments_are_null);
+    
+    ssct_run(fork_exec_should_call_exec_with_correct_params);
+    ssct_run(fork_exec_should_return_fork_failed_error);
+    ssct_run(fork_exec_should_not_inherit_blocked_signals);
+    ssct_run(fork_exec_should_redirect_stdout);
+    
+    ssct_run(posix_spawn_should_run_command);
+    ssct_run(posix_spawn_should_return_failure_when_file_can_not_be_executed);
+    ssct_run(posix_spawn_should_return_fork_failed_error_when_out_of_processes);
+    ssct_run(posix_spawn_should_not_inherit_blocked_signals);
+    ssct_run(posix_spawn_should_redirect_stdout);
+    
+    ssct_run(zygote_should_run_command_that_is_not_a_child_of_the_daemon);
+    ssct_run(zygote_should_fall_back_on_posix_spawn_when_zygote_is_not_running);
+    ssct_run(zygote_should_redirect_stdout);
+    
+    ssct_run(fork_exec_should_run_command_with_limits);
+    ssct_run(posix_spawn_should_run_command_with_limits);
+    ssct_run(zygote_should_run_command_with_limits);
+    ssct_run(fork_exec_should_run_command_with_placement);
+    ssct_run(posix_spawn_should_run_command_with_placement);
+    ssct_run(zygote_should_run_command_with_placement);
+    ssct_run(zygote_should_return_failure_when_limited_file_can_not_be_executed);
+    
+    ssct_run(spawn_reap_should_collect_commands_left_by_stopped_zygote);
+    ssct_run(spawn_reap_should_store_zero_when_no_command_has_exited);
+    
+    ssct_print_summary();
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <stdio.h>          // snprintf(), remove()
+#include <string.h>         // strlen()
+#include <stdint.h>         // int64_t, uint64_t
+#include <stdbool.h>        // bool, true, false
+#include <unistd.h>         // getpid()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_job.h"
+#include "schedr_splay.h"
+#include "schedr_job_index.h"
+
+#define NANOSECS_PER_SEC 1000000000LL
+#define TEST_JOBS 16
+#define TEST_SPLAY_NS (10 * NANOSECS_PER_SEC)
+
+static Job jobs[TEST_JOBS];
+static char state_path[64];
+static uint64_t next_random;
+
+static uint64_t mock_random_will_count_up() { return next_random++; }
+
+static void setup()
+{
+    for (int i = 0; i < TEST_JOBS; i++)
+    {
+        char name[16];
+        snprintf(name, sizeof (name), "job%d", i);
+
+        schedr_job_init(&(jobs[i]));
+        schedr_job_set_name(&(jobs[i]), name, strlen(name));
+        schedr_job_set_splay(&(jobs[i]), TEST_SPLAY_NS);
+    }
+
+    snprintf(state_path, sizeof (state_path), "/tmp/schedr_splay_test_%d.state", (int)getpid());
+    next_random = 1000;
+}
+
+static void teardown()
+{
+    remove(state_path);
+    schedr_splay_reset_random();
+}
+
+static void assign_offsets_should_return_invalid_argument_error_when_mode_is_out_of_range()
+{
+    ssct_assert_equals(schedr_splay_assign_offsets(jobs, TEST_JOBS, -1, NULL), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_splay_assign_offsets(jobs, TEST_JOBS, SCHEDR_SPLAY_MODE_VALUES, NULL), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_splay_assign_offsets(NULL, TEST_JOBS, SplayHashed, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void assign_offsets_should_spread_hashed_offsets_within_splay()
+{
+    int64_t first_offsets[TEST_JOBS];
+    bool within_splay = true, same_every_time = true, all_equal = true;
+
+    ssct_assert_equals(schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayHashed, NULL), SCHEDR_SUCCESS);
+
+    for (int i = 0; i < TEST_JOBS; i++) { first_offsets[i] = jobs[i].splay_offset_ns; }
+
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayHashed, NULL);
+
+    for (int i = 0; i < TEST_JOBS; i++)
+    {
+        if (jobs[i].splay_offset_ns < 0 || jobs[i].splay_offset_ns >= TEST_SPLAY_NS) { within_splay = false; }
+        if (jobs[i].splay_offset_ns != first_offsets[i]) { same_every_time = false; }
+        if (jobs[i].splay_offset_ns != first_offsets[0]) { all_equal = false; }
+    }
+
+    ssct_assert_true(within_splay);
+    ssct_assert_true(same_every_time);
+    ssct_assert_false(all_equal);
+}
+
+static void assign_offsets_should_not_delay_jobs_without_splay()
+{
+    schedr_job_set_splay(&(jobs[0]), 0);
+    jobs[0].splay_offset_ns = 5;
+
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, NULL);
+
+    ssct_assert_zero(jobs[0].splay_offset_ns);
+}
+
+static void assign_offsets_should_reuse_saved_random_offsets()
+{
+    int64_t first_offsets[TEST_JOBS];
+    bool reused = true;
+
+    schedr_splay_set_random(mock_random_will_count_up);
+
+    ssct_assert_equals(schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, state_path), SCHEDR_SUCCESS);
+
+    for (int i = 0; i < TEST_JOBS; i++) { first_offsets[i] = jobs[i].splay_offset_ns; }
+
+    // The offsets that would be drawn now all differ from the saved ones
+    next_random = 5000;
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, state_path);
+
+    for (int i = 0; i < TEST_JOBS; i++)
+    {
+        if (jobs[i].splay_offset_ns != first_offsets[i]) { reused = false; }
+    }
+
+    ssct_assert_equals(first_offsets[0], 1000);
+    ssct_assert_true(reused);
+}
+
+static void assign_offsets_should_draw_new_offset_when_saved_one_exceeds_splay()
+{
+    schedr_splay_set_random(mock_random_will_count_up);
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, state_path);
+
+    schedr_job_set_splay(&(jobs[3]), 500);
+    next_random = 4321;
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, state_path);
+
+    ssct_assert_equals(jobs[3].splay_offset_ns, 4321 % 500);
+    ssct_assert_equals(jobs[4].splay_offset_ns, 1004);
+}
+
+static void assign_offsets_should_return_failure_when_state_can_not_be_saved()
+{
+    schedr_splay_set_random(mock_random_will_count_up);
+
+    Status status = schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, "/nonexistent/dir/splay.state");
+
+    ssct_assert_equals(status, SCHEDR_FAILURE);
+    ssct_assert_equals(jobs[1].splay_offset_ns, 1001);
+}
+
+/*
+ * Indexes copies of the jobs, as the jobs running before a reload.
+ */
+static void index_running_jobs(JobIndex *running, Job running_jobs[])
+{
+    schedr_job_index_init(running);
+
+    for (int i = 0; i < TEST_JOBS; i++)
+    {
+        running_jobs[i] = jobs[i];
+        schedr_job_index_add(running, &(running_jobs[i]), false);
+    }
+}
+
+static bool state_exists()
+{
+    FILE *fp = fopen(state_path, "r");
+
+    if (fp != NULL) { fclose(fp); }
+
+    return fp != NULL;
+}
+
+static void reassign_offsets_should_keep_offsets_of_running_jobs_and_not_save_unchanged_state()
+{
+    JobIndex running;
+    Job running_jobs[TEST_JOBS];
+    bool kept = true;
+
+    schedr_splay_set_random(mock_random_will_count_up);
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, state_path);
+    index_running_jobs(&running, running_jobs);
+    remove(state_path);
+
+    // Without a state file every offset would be drawn again
+    next_random = 5000;
+    ssct_assert_equals(schedr_splay_reassign_offsets(jobs, TEST_JOBS, SplayRandom, &running, state_path), SCHEDR_SUCCESS);
+
+    for (int i = 0; i < TEST_JOBS; i++)
+    {
+        if (jobs[i].splay_offset_ns != running_jobs[i].splay_offset_ns) { kept = false; }
+    }
+
+    ssct_assert_true(kept);
+    ssct_assert_false(state_exists());
+
+    // One job less changes the state
+    ssct_assert_equals(schedr_splay_reassign_offsets(jobs, TEST_JOBS - 1, SplayRandom, &running, state_path), SCHEDR_SUCCESS);
+    ssct_assert_true(state_exists());
+
+    schedr_job_index_destroy(&running);
+}
+
+static void reassign_offsets_should_draw_new_offsets_for_jobs_whose_splay_changed()
+{
+    JobIndex running;
+    Job running_jobs[TEST_JOBS];
+
+    schedr_splay_set_random(mock_random_will_count_up);
+    schedr_splay_assign_offsets(jobs, TEST_JOBS, SplayRandom, NULL);
+    index_running_jobs(&running, running_jobs);
+
+    schedr_job_set_splay(&(jobs[3]), 500);
+    next_random = 4321;
+    schedr_splay_reassign_offsets(jobs, TEST_JOBS, SplayRandom, &running, state_path);
+
+    ssct_assert_equals(jobs[3].splay_offset_ns, 4321 % 500);
+    ssct_assert_equals(jobs[4].splay_offset_ns, 1004);
+    ssct_assert_true(state_exists());
+    ssct_assert_equals(schedr_splay_reassign_offsets(jobs, TEST_JOBS, SplayRandom, NULL, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+
+    schedr_job_index_destroy(&running);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(assign_offsets_should_return_invalid_argument_error_when_mode_is_out_of_range);
+    ssct_run(assign_offsets_should_spread_hashed_offsets_within_splay);
+    ssct_run(assign_offsets_should_not_delay_jobs_without_splay);
+    ssct_run(assign_offsets_should_reuse_saved_random_offsets);
+    ssct_run(assign_offsets_should_draw_new_offset_when_saved_one_exceeds_splay);
+    ssct_run(assign_offsets_should_return_failure_when_state_can_not_be_saved);
+    ssct_run(reassign_offsets_should_keep_offsets_of_running_jobs_and_not_save_unchanged_state);
+    ssct_run(reassign_offsets_should_draw_new_offsets_for_jobs_whose_splay_changed);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,263 @@
+#include <stdlib.h>         // malloc(), free(), rand(), srand(), EXIT_SUCCESS
+#include <stdint.h>         // int64_t
+#include <stdbool.h>        // bool, true, false
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_timer.h"
+
+#define TICK_NS 1000
+#define MANY_TIMERS 1000000
+
+static TimerWheel wheel;
+
+static int count_expired(Timer *expired)
+{
+    int count = 0;
+
+    for (Timer *timer = expired; timer != NULL; timer = timer->next) { count++; }
+
+    return count;
+}
+
+static void setup()
+{
+    schedr_timer_wheel_init(&wheel, TICK_NS, 0);
+}
+
+static void wheel_init_should_return_null_argument_error_when_wheel_is_null()
+{
+    ssct_assert_equals(schedr_timer_wheel_init(NULL, TICK_NS, 0), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void wheel_init_should_return_invalid_argument_error_when_tick_is_not_positive()
+{
+    ssct_assert_equals(schedr_timer_wheel_init(&wheel, 0, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_timer_wheel_init(&wheel, -1, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void add_should_return_null_argument_error_when_timer_is_null()
+{
+    ssct_assert_equals(schedr_timer_add(&wheel, NULL, 0), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_timer_add(NULL, NULL, 0), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void add_should_return_invalid_argument_error_when_timer_is_pending()
+{
+    Timer timer;
+    schedr_timer_init(&timer, NULL);
+
+    schedr_timer_add(&wheel, &timer, 10 * TICK_NS);
+
+    ssct_assert_equals(schedr_timer_add(&wheel, &timer, 20 * TICK_NS), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(wheel.pending, 1);
+}
+
+static void advance_should_not_expire_timer_before_deadline()
+{
+    Timer timer;
+    Timer *expired = NULL;
+    schedr_timer_init(&timer, NULL);
+
+    schedr_timer_add(&wheel, &timer, 100 * TICK_NS + 1);
+    schedr_timer_advance(&wheel, 100 * TICK_NS, &expired);
+
+    ssct_assert_true(expired == NULL);
+    ssct_assert_true(timer.pending);
+}
+
+static void advance_should_expire_timer_at_deadline()
+{
+    int data = 0;
+    Timer timer;
+    Timer *expired = NULL;
+    schedr_timer_init(&timer, &data);
+
+    schedr_timer_add(&wheel, &timer, 100 * TICK_NS);
+    schedr_timer_advance(&wheel, 100 * TICK_NS, &expired);
+
+    ssct_assert_true(expired == &timer);
+    ssct_assert_true(expired->data == &data);
+    ssct_assert_true(expired->next == NULL);
+    ssct_assert_false(timer.pending);
+    ssct_assert_zero(wheel.pending);
+}
+
+static void advance_should_expire_timer_with_passed_deadline()
+{
+    Timer timer;
+    Timer *expired = NULL;
+    schedr_timer_init(&timer, NULL);
+
+    schedr_timer_advance(&wheel, 500 * TICK_NS, &expired);
+    schedr_timer_add(&wheel, &timer, 100 * TICK_NS);
+    schedr_timer_advance(&wheel, 501 * TICK_NS, &expired);
+
+    ssct_assert_true(expired == &timer);
+}
+
+static void advance_should_expire_timer_added_with_passed_deadline_without_moving_forward()
+{
+    Timer timer;
+    Timer *expired = NULL;
+    schedr_timer_init(&timer, NULL);
+
+    schedr_timer_advance(&wheel, 500 * TICK_NS, &expired);
+    schedr_timer_add(&wheel, &timer, 0);
+
+    ssct_assert_true(schedr_timer_next_deadline(&wheel) <= 500 * TICK_NS);
+
+    schedr_timer_advance(&wheel, 500 * TICK_NS, &expired);
+
+    ssct_assert_true(expired == &timer);
+    ssct_assert_zero(wheel.pending);
+}
+
+static void advance_should_expire_timers_in_deadline_order_on_every_level()
+{
+    static const int TIMERS = 5000;
+    Timer *timers = (Timer *)malloc(sizeof (Timer) * TIMERS);
+    int64_t *deadlines = (int64_t *)malloc(sizeof (int64_t) * TIMERS);
+    bool in_order = true;
+    bool on_time = true;
+    int expired_count = 0;
+    int64_t last_deadline = 0;
+
+    srand(37);
+
+    for (int i = 0; i < TIMERS; i++)
+    {
+        // Spread the deadlines from a few ticks to past the range of the wheel
+        int level = rand() % (SCHEDR_TIMER_LEVELS + 1);
+        int64_t range = 1LL << (SCHEDR_TIMER_SLOT_BITS * level + 3);
+
+        deadlines[i] = ((int64_t)rand() * rand() % range) * TICK_NS;
+        schedr_timer_init(&(timers[i]), &(deadlines[i]));
+        schedr_timer_add(&wheel, &(timers[i]), deadlines[i]);
+    }
+
+    int64_t now = 0;
+    int64_t step = TICK_NS;
+
+    while (wheel.pending > 0)
+    {
+        Timer *expired = NULL;
+
+        now += step;
+        step += step / 2;   // Take longer and longer steps to cover the range of the wheel
+
+        schedr_timer_advance(&wheel, now, &expired);
+
+        for (Timer *timer = expired; timer != NULL; timer = timer->next)
+        {
+            int64_t deadline = *(int64_t *)timer->data;
+
+            if (deadline > now) { on_time = false; }
+            if (deadline < last_deadline) { in_order = false; }
+
+            last_deadline = deadline;
+            expired_count++;
+        }
+    }
+
+    ssct_assert_equals(expired_count, TIMERS);
+    ssct_assert_true(on_time);
+    ssct_assert_true(in_order);
+
+    free(timers);
+    free(deadlines);
+}
+
+static void cancel_should_prevent_timer_from_expiring()
+{
+    Timer timer;
+    Timer *expired = NULL;
+    schedr_timer_init(&timer, NULL);
+
+    schedr_timer_add(&wheel, &timer, 5000 * TICK_NS);
+    Status status = schedr_timer_cancel(&wheel, &timer);
+    schedr_timer_advance(&wheel, 10000 * TICK_NS, &expired);
+
+    ssct_assert_equals(status, SCHEDR_SUCCESS);
+    ssct_assert_true(expired == NULL);
+    ssct_assert_false(timer.pending);
+    ssct_assert_zero(wheel.pending);
+}
+
+static void cancel_should_return_success_when_timer_is_not_pending()
+{
+    Timer timer;
+    schedr_timer_init(&timer, NULL);
+
+    ssct_assert_equals(schedr_timer_cancel(&wheel, &timer), SCHEDR_SUCCESS);
+}
+
+static void next_deadline_should_return_minus_one_when_no_timer_is_pending()
+{
+    ssct_assert_equals(schedr_timer_next_deadline(&wheel), -1);
+}
+
+static void next_deadline_should_not_be_later_than_earliest_timer()
+{
+    Timer early, late;
+    schedr_timer_init(&early, NULL);
+    schedr_timer_init(&late, NULL);
+
+    schedr_timer_add(&wheel, &late, 900000 * TICK_NS);
+    schedr_timer_add(&wheel, &early, 70 * TICK_NS);
+
+    int64_t next = schedr_timer_next_deadline(&wheel);
+
+    ssct_assert_true(next >= 0);
+    ssct_assert_true(next <= 70 * TICK_NS);
+}
+
+static void wheel_should_hold_a_million_pending_timers()
+{
+    Timer *timers = (Timer *)malloc(sizeof (Timer) * MANY_TIMERS);
+    Timer *expired = NULL;
+
+    for (int i = 0; i < MANY_TIMERS; i++)
+    {
+        schedr_timer_init(&(timers[i]), NULL);
+        schedr_timer_add(&wheel, &(timers[i]), (int64_t)(i % 86400) * 1000 * TICK_NS);
+    }
+
+    ssct_assert_equals(wheel.pending, MANY_TIMERS);
+
+    schedr_timer_advance(&wheel, 86400LL * 1000 * TICK_NS, &expired);
+
+    ssct_assert_equals(count_expired(expired), MANY_TIMERS);
+    ssct_assert_zero(wheel.pending);
+
+    free(timers);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+
+    ssct_run(wheel_init_should_return_null_argument_error_when_wheel_is_null);
+    ssct_run(wheel_init_should_return_invalid_argument_error_when_tick_is_not_positive);
+
+    ssct_run(add_should_return_null_argument_error_when_timer_is_null);
+    ssct_run(add_should_return_invalid_argument_error_when_timer_is_pending);
+
+    ssct_run(advance_should_not_expire_timer_before_deadline);
+    ssct_run(advance_should_expire_timer_at_deadline);
+    ssct_run(advance_should_expire_timer_with_passed_deadline);
+    ssct_run(advance_should_expire_timer_added_with_passed_deadline_without_moving_forward);
+    ssct_run(advance_should_expire_timers_in_deadline_order_on_every_level);
+
+    ssct_run(cancel_should_prevent_timer_from_expiring);
+    ssct_run(cancel_should_return_success_when_timer_is_not_pending);
+
+    ssct_run(next_deadline_should_return_minus_one_when_no_timer_is_pending);
+    ssct_run(next_deadline_should_not_be_later_than_earliest_timer);
+
+    ssct_run(wheel_should_hold_a_million_pending_timers);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <string.h>         // memset(), memcmp()
+#include <stdbool.h>        // bool, true, false
+#include <stdint.h>         // uintptr_t, INT32_MAX
+#include <errno.h>          // errno, ENOSYS, ENOMEM, ECANCELED
+#include <unistd.h>         // pipe(), write(), close()
+#include <fcntl.h>          // fcntl()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_uring.h"
+
+static Uring ring;
+static bool supported;
+
+static void setup() { supported = (schedr_uring_init(&ring, 8) == SCHEDR_SUCCESS); }
+static void teardown() { schedr_uring_destroy(&ring); }
+
+static int setup_failing_with_enosys(unsigned entries, struct io_uring_params *params)
+{
+    (void)entries;
+    (void)params;
+    errno = ENOSYS;
+
+    return -1;
+}
+
+static int setup_failing_with_enomem(unsigned entries, struct io_uring_params *params)
+{
+    (void)entries;
+    (void)params;
+    errno = ENOMEM;
+
+    return -1;
+}
+
+/*
+ * Submits what is queued and waits for the completion of 'user_data'. 
+ * Returns its result, or 1 if it did not complete.
+ */
+static int wait_for(uint64_t user_data)
+{
+    struct io_uring_cqe *cqe;
+
+    for (int waits = 0; waits < 8; waits++)
+    {
+        if (schedr_uring_submit(&ring, true) != SCHEDR_SUCCESS) { return 1; }
+
+        while ((cqe = schedr_uring_peek(&ring)) != NULL)
+        {
+            bool found = (cqe->user_data == user_data);
+            int res = cqe->res;
+
+            schedr_uring_seen(&ring);
+
+            if (found) { return res; }
+        }
+    }
+
+    return 1;
+}
+
+static void init_should_return_null_argument_error_when_ring_is_null()
+{
+    ssct_assert_equals(schedr_uring_init(NULL, 8), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void init_should_return_invalid_argument_error_when_entries_are_out_of_range()
+{
+    Uring other;
+
+    ssct_assert_equals(schedr_uring_init(&other, 0), SCHEDR_ERROR_INVALID_ARGUMENT);
+    ssct_assert_equals(schedr_uring_init(&other, SCHEDR_URING_MAX_ENTRIES + 1), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void init_should_return_not_implemented_error_when_kernel_lacks_io_uring()
+{
+    Uring other;
+
+    schedr_uring_set_setup(setup_failing_with_enosys);
+
+    ssct_assert_equals(schedr_uring_init(&other, 8), SCHEDR_ERROR_NOT_IMPLEMENTED);
+
+    schedr_uring_set_setup(setup_failing_with_enomem);
+
+    ssct_assert_equals(schedr_uring_init(&other, 8), SCHEDR_FAILURE);
+
+    schedr_uring_reset_setup();
+}
+
+static void submit_should_complete_nop()
+{
+    if (!supported) { return; }
+
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(&ring);
+
+    ssct_assert_true(sqe != NULL);
+
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 42;
+
+    ssct_assert_zero(wait_for(42));
+    ssct_assert_true(schedr_uring_peek(&ring) == NULL);
+}
+
+static void submit_should_complete_read_once_pipe_is_written()
+{
+    if (!supported) { return; }
+
+    int fds[2];
+    char buf[8] = { 0 };
+
+    pipe(fds);
+
+    struct io_uring_sqe *sqe = schedr_uring_get_sqe(&ring);
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fds[0];
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = sizeof (buf);
+    sqe->off = (uint64_t)-1;
+    sqe->user_data = 7;
+
+    // The read waits for the pipe in the kernel, nothing completes yet
+    ssct_assert_equals(schedr_uring_submit(&ring, false), SCHEDR_SUCCESS);
+    ssct_assert_true(schedr_uring_peek(&ring) == NULL);
+
+    write(fds[1], "hello", 5);
+
+    ssct_assert_equals(wait_for(7), 5);
+    ssct_assert_zero(memcmp(buf, "hello", 5));
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void queue_read_should_read_into_provided_buffer()
+{
+    if (!supported) { return; }
+
+    int fds[2];
+    char buffers[2][8] = { { 0 } };
+
+    pipe(fds);
+
+    ssct_assert_true(schedr_uring_provide_buffer(&ring, buffers[1], sizeof (buffers[1]), 1, 1));
+    ssct_assert_true(schedr_uring_queue_read(&ring, fds[0], NULL, sizeof (buffers[1]), 1, 7));
+
+    write(fds[1], "hello", 5);
+
+    ssct_assert_equals(wait_for(7), 5);
+    ssct_assert_zero(memcmp(buffers[1], "hello", 5));
+
+    ssct_assert_true(schedr_uring_queue_close(&ring, fds[0]));
+    ssct_assert_equals(wait_for(SCHEDR_URING_IGNORED), 0);
+    ssct_assert_true(fcntl(fds[0], F_GETFD) == -1);
+
+    close(fds[1]);
+}
+
+static void remove_timeout_should_cancel_timeout()
+{
+    if (!supported) { return; }
+
+    struct __kernel_timespec deadline = { .tv_sec = INT32_MAX, .tv_nsec = 0 };
+
+    ssct_assert_true(schedr_uring_queue_timeout(&ring, &deadline, 9));
+    ssct_assert_true(schedr_uring_remove_timeout(&ring, 9));
+    ssct_assert_equals(wait_for(9), -ECANCELED);
+}
+
+static void get_sqe_should_submit_queued_requests_when_queue_is_full()
+{
+    if (!supported) { return; }
+
+    for (unsigned i = 0; i <= ring.sq_entries; i++)
+    {
+        struct io_uring_sqe *sqe = schedr_uring_get_sqe(&ring);
+
+        ssct_assert_true(sqe != NULL);
+
+        if (sqe == NULL) { return; }
+
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = i;
+    }
+
+    ssct_assert_zero(wait_for(ring.sq_entries));
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(init_should_return_null_argument_error_when_ring_is_null);
+    ssct_run(init_should_return_invalid_argument_error_when_entries_are_out_of_range);
+    ssct_run(init_should_return_not_implemented_error_when_kernel_lacks_io_uring);
+    ssct_run(submit_should_complete_nop);
+    ssct_run(submit_should_complete_read_once_pipe_is_written);
+    ssct_run(queue_read_should_read_into_provided_buffer);
+    ssct_run(remove_timeout_should_cancel_timeout);
+    ssct_run(get_sqe_should_submit_queued_requests_when_queue_is_full);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+#include <stdlib.h>         // EXIT_SUCCESS
+#include <string.h>         // memset(), strcmp()
+#include <stdbool.h>        // bool, true, false
+#include <sys/types.h>      // pid_t
+#include <sys/wait.h>       // waitpid(), WEXITSTATUS()
+#include <unistd.h>         // pipe(), read(), close(), fork(), _exit()
+#include <poll.h>           // poll()
+
+#include "ssct.h"
+#include "schedr_status_codes.h"
+#include "schedr_zygote.h"
+
+static const int stdio_fds[] = { 0, 1, 2 };
+static char *empty_env[] = { NULL };
+
+static void setup() { schedr_zygote_start(); }
+static void teardown() { schedr_zygote_stop(); }
+
+/*
+ * Waits for the zygote to report that 'pid' has exited, or gives up after a second.
+ */
+static int exit_status_of(pid_t pid)
+{
+    struct pollfd zygote = { .fd = schedr_zygote_fd(), .events = POLLIN };
+    struct rusage usage;
+    pid_t reaped = 0;
+    int status;
+
+    for (int waits = 0; reaped != pid && waits < 100; waits++)
+    {
+        schedr_zygote_reap(&reaped, &status, &usage);
+
+        if (reaped != pid) { poll(&zygote, 1, 10); }
+    }
+
+    return (reaped == pid && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+}
+
+static void spawn_should_return_null_argument_error_when_arguments_are_null()
+{
+    char *argv[] = { "/bin/true", NULL };
+    pid_t pid;
+
+    ssct_assert_equals(schedr_zygote_spawn(NULL, argv, empty_env, stdio_fds, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], NULL, empty_env, stdio_fds, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, NULL, stdio_fds, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, NULL, &pid), SCHEDR_ERROR_NULL_ARGUMENT);
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, NULL), SCHEDR_ERROR_NULL_ARGUMENT);
+}
+
+static void spawn_should_return_invalid_argument_error_when_fd_is_negative()
+{
+    char *argv[] = { "/bin/true", NULL };
+    int fds[] = { 0, -1, 2 };
+    pid_t pid;
+
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, fds, &pid), SCHEDR_ERROR_INVALID_ARGUMENT);
+}
+
+static void spawn_should_return_failure_when_zygote_is_not_running()
+{
+    char *argv[] = { "/bin/true", NULL };
+    pid_t pid;
+
+    schedr_zygote_stop();
+
+    ssct_assert_false(schedr_zygote_is_running());
+    ssct_assert_equals(schedr_zygote_fd(), -1);
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, &pid), SCHEDR_FAILURE);
+}
+
+static void spawn_should_report_exit_status_of_command()
+{
+    char *argv[] = { "/bin/sh", "-c", "exit 3", NULL };
+    pid_t pid;
+
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, &pid), SCHEDR_SUCCESS);
+    ssct_assert_equals(exit_status_of(pid), 3);
+}
+
+static void spawn_should_return_failure_when_file_can_not_be_executed()
+{
+    char *argv[] = { "/nonexistent/command", NULL };
+    pid_t pid;
+
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, &pid), SCHEDR_FAILURE);
+    ssct_assert_true(schedr_zygote_is_running());
+}
+
+static void spawn_should_return_buffer_overflow_error_when_request_is_too_long()
+{
+    static char long_arg[SCHEDR_ZYGOTE_MAX_REQUEST_LEN];
+    char *argv[] = { "/bin/true", long_arg, NULL };
+    pid_t pid;
+
+    memset(long_arg, 'a', sizeof (long_arg) - 1);
+
+    ssct_assert_equals(schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, &pid), SCHEDR_ERROR_BUFFER_OVERFLOW);
+}
+
+static void spawn_should_pass_environment_to_command()
+{
+    char *argv[] = { "/bin/sh", "-c", "exit $SCHEDR_TEST_STATUS", NULL };
+    char *envp[] = { "SCHEDR_TEST_STATUS=42", NULL };
+    pid_t pid;
+
+    schedr_zygote_spawn(argv[0], argv, envp, stdio_fds, &pid);
+
+    ssct_assert_equals(exit_status_of(pid), 42);
+}
+
+static void spawn_should_pass_fds_to_command()
+{
+    char *argv[] = { "/bin/sh", "-c", "echo hello", NULL };
+    char output[16] = { 0 };
+    int pipe_fds[2];
+    pid_t pid;
+
+    pipe(pipe_fds);
+
+    int fds[] = { 0, pipe_fds[1], 2 };
+
+    schedr_zygote_spawn(argv[0], argv, empty_env, fds, &pid);
+    close(pipe_fds[1]);
+    exit_status_of(pid);
+
+    read(pipe_fds[0], output, sizeof (output) - 1);
+    close(pipe_fds[0]);
+
+    ssct_assert_equals(strcmp(output, "hello\n"), 0);
+}
+
+static void spawn_should_keep_exits_reported_while_waiting_for_pid()
+{
+    char *quick_argv[] = { "/bin/sh", "-c", "exit 7", NULL };
+    char *argv[] = { "/bin/true", NULL };
+    pid_t quick_pid, pid;
+
+    schedr_zygote_spawn(quick_argv[0], quick_argv, empty_env, stdio_fds, &quick_pid);
+    poll(NULL, 0, 100);
+    schedr_zygote_spawn(argv[0], argv, empty_env, stdio_fds, &pid);
+
+    ssct_assert_equals(exit_status_of(quick_pid), 7);
+    ssct_assert_equals(exit_status_of(pid), 0);
+}
+
+static void forked_process_should_not_use_zygote()
+{
+    pid_t child = fork();
+
+    if (child == 0) { _exit(schedr_zygote_is_running() ? EXIT_FAILURE : EXIT_SUCCESS); }
+
+    int status;
+    waitpid(child, &status, 0);
+
+    ssct_assert_true(schedr_zygote_is_running());
+    ssct_assert_equals(WEXITSTATUS(status), EXIT_SUCCESS);
+}
+
+int main(void)
+{
+    ssct_setup = setup;
+    ssct_teardown = teardown;
+
+    ssct_run(spawn_should_return_null_argument_error_when_arguments_are_null);
+    ssct_run(spawn_should_return_invalid_argument_error_when_fd_is_negative);
+    ssct_run(spawn_should_return_failure_when_zygote_is_not_running);
+    ssct_run(spawn_should_report_exit_status_of_command);
+    ssct_run(spawn_should_return_failure_when_file_can_not_be_executed);
+    ssct_run(spawn_should_return_buffer_overflow_error_when_request_is_too_long);
+    ssct_run(spawn_should_pass_environment_to_command);
+    ssct_run(spawn_should_pass_fds_to_command);
+    ssct_run(spawn_should_keep_exits_reported_while_waiting_for_pid);
+    ssct_run(forked_process_should_not_use_zygote);
+
+    ssct_print_summary();
+
+    return EXIT_SUCCESS;
+}